@@ -1191,6 +1191,7 @@ hal_imumc_status_t HAL_ImuReceive(uint8_t imuLink)
     hal_imumc_state_t *ept;
     struct imumc_std_msg *imumc_msg;
     hal_imumc_status_t imumcStatus = kStatus_HAL_ImumcSuccess;
+    uint8_t i, freeCnt;
 
     assert((uint8_t)kIMU_LinkMax > imuLink);
     imuHandle = &imuHandleCh[imuLink];
@@ -1268,8 +1269,21 @@ hal_imumc_status_t HAL_ImuReceive(uint8_t imuLink)
                     {
                         imumcStatus = imuHandle->imuHandler[IMU_MSG_RX_DATA]((IMU_Msg_t *)pMsg, pMsg->Hdr.length);
                     }
-                    pMsg        = &localImuMsgRx;
-                    imumcStatus = HAL_ImuFreeRxBuf(imuHandle, (uint8_t *)&pMsg->PayloadPtr[0], pMsg->Hdr.length);
+                    /* Buffers the handler cleared in the message are kept by it and freed later with
+                     * HAL_ImuFreeWlanRxBuf(), only the rest goes back to the firmware now. */
+                    freeCnt = 0U;
+                    for (i = 0U; i < localImuMsgRx.Hdr.length; i++)
+                    {
+                        if (pMsg->PayloadPtr[i] != 0U)
+                        {
+                            localImuMsgRx.PayloadPtr[freeCnt++] = pMsg->PayloadPtr[i];
+                        }
+                    }
+                    pMsg = &localImuMsgRx;
+                    if (freeCnt != 0U)
+                    {
+                        imumcStatus = HAL_ImuFreeRxBuf(imuHandle, (uint8_t *)&pMsg->PayloadPtr[0], freeCnt);
+                    }
                     break;
                 case IMU_MSG_IMUMC:
                     imumc_msg = (struct imumc_std_msg *)&pMsg->PayloadPtr[0];
@@ -1942,6 +1956,10 @@ void WL_MCI_WAKEUP0_DriverIRQHandler(void)
     irq_num = IRQ_IMU_CPU13;
 #endif
 
+#ifdef traceISR_HANDLER_ENTER
+    traceISR_HANDLER_ENTER();
+#endif
+
     /* Mask IMU ICU interrupt */
     (void)os_InterruptMaskClear(irq_num);
 
@@ -1954,6 +1972,10 @@ void WL_MCI_WAKEUP0_DriverIRQHandler(void)
         IMU_ClearPendingInterrupts(kIMU_LinkCpu1Cpu3, IMU_MSG_FIFO_CNTL_MSG_RDY_INT_CLR_MASK);
         (void)os_InterruptMaskSet(irq_num);
     }
+
+#ifdef traceISR_HANDLER_EXIT
+    traceISR_HANDLER_EXIT();
+#endif
 }
 
 void BLE_MCI_WAKEUP0_DriverIRQHandler(void)
@@ -2033,6 +2055,16 @@ hal_imumc_status_t HAL_ImumcFreeRxBuffer(hal_imumc_handle_t handle, uint8_t *dat
     return HAL_ImuSendImumcFreeBuf(imuHandle, data);
 }
 
+hal_imumc_status_t HAL_ImuFreeWlanRxBuf(uint8_t imuLink, uint8_t *rxBuf)
+{
+    uint32_t rxBufAddr = (uint32_t)rxBuf;
+
+    assert((uint8_t)kIMU_LinkMax > imuLink);
+    assert(NULL != rxBuf);
+
+    return HAL_ImuFreeRxBuf(&imuHandleCh[imuLink], (uint8_t *)&rxBufAddr, 1U);
+}
+
 bool HAL_ImuIsTxBufQueueEmpty(uint8_t imuLink)
 {
     hal_imu_handle_t *imuHandle;
@@ -795,6 +795,19 @@ hal_imumc_status_t HAL_ImuReturnAllTxBuf(imu_link_t link);
  */
 hal_imumc_status_t HAL_ImuReceive(uint8_t imuLink);
 
+/*!
+ * @brief Free a WLAN rx buffer kept by the rx data handler.
+ *
+ * The IMU_MSG_RX_DATA handler may keep rx buffers after it returns by setting
+ * their PayloadPtr entries in the message to 0. Such a buffer is not freed by
+ * HAL_ImuReceive and must be returned to the firmware with this function.
+ *
+ * @param imuLink              IMU link ID.
+ * @param rxBuf                Rx buffer kept by the handler.
+ * @retval kStatus_HAL_ImumcSuccess or kStatus_HAL_ImumcError.
+ */
+hal_imumc_status_t HAL_ImuFreeWlanRxBuf(uint8_t imuLink, uint8_t *rxBuf);
+
 /*!
  * @brief Check if tx buffer queue empty.
  *
@@ -15,6 +15,7 @@
 #include "dhcp-server.h"
 #include <stdio.h>
 #include "event_groups.h"
+#include "heap_tlsf.h"
 
 /*******************************************************************************
  * Definitions
@@ -450,82 +451,107 @@ wpl_ret_t WPL_Stop_AP(void)
     return status;
 }
 
-static int WLP_process_results(unsigned int count)
+/* Appends one network to ssids_json, returns false if it does not fit */
+static bool WLP_add_json_record(const struct wlan_scan_result *scan_result,
+                                uint32_t *ssids_json_idx,
+                                uint32_t ssids_json_len)
 {
-    int ret                             = 0;
-    struct wlan_scan_result scan_result = {0};
-    uint32_t ssids_json_len             = count * MAX_JSON_NETWORK_RECORD_LENGTH;
+    int ret;
+    char security[40];
+
+    PRINTF("%s\r\n", scan_result->ssid);
+    PRINTF("     BSSID         : %02X:%02X:%02X:%02X:%02X:%02X\r\n", (unsigned int)scan_result->bssid[0],
+           (unsigned int)scan_result->bssid[1], (unsigned int)scan_result->bssid[2],
+           (unsigned int)scan_result->bssid[3], (unsigned int)scan_result->bssid[4],
+           (unsigned int)scan_result->bssid[5]);
+    PRINTF("     RSSI          : %ddBm\r\n", -(int)scan_result->rssi);
+    PRINTF("     Channel       : %d\r\n", (int)scan_result->channel);
+
+    security[0] = '\0';
+
+    if (scan_result->wpa2_entp == 1U)
+    {
+        (void)strcat(security, "WPA2_ENTP ");
+    }
+    if (scan_result->wep == 1U)
+    {
+        (void)strcat(security, "WEP ");
+    }
+    if (scan_result->wpa == 1U)
+    {
+        (void)strcat(security, "WPA ");
+    }
+    if (scan_result->wpa2 == 1U)
+    {
+        (void)strcat(security, "WPA2 ");
+    }
+    if (scan_result->wpa3_sae == 1U)
+    {
+        (void)strcat(security, "WPA3_SAE ");
+    }
+
+    if (ssids_json[*ssids_json_idx - 1U] != '[')
+    {
+        /* Add ',' separator before next entry */
+        ssids_json[(*ssids_json_idx)++] = ',';
+    }
+
+    ret = snprintf(
+        ssids_json + *ssids_json_idx, ssids_json_len - *ssids_json_idx - 1U,
+        "{\"ssid\":\"%s\",\"bssid\":\"%02X:%02X:%02X:%02X:%02X:%02X\",\"signal\":\"%ddBm\",\"channel\":%d,"
+        "\"security\":\"%s\"}",
+        scan_result->ssid, (unsigned int)scan_result->bssid[0], (unsigned int)scan_result->bssid[1],
+        (unsigned int)scan_result->bssid[2], (unsigned int)scan_result->bssid[3], (unsigned int)scan_result->bssid[4],
+        (unsigned int)scan_result->bssid[5], -(int)scan_result->rssi, (int)scan_result->channel, security);
+    if (ret <= 0)
+    {
+        return false;
+    }
+
+    *ssids_json_idx += (uint32_t)ret;
+    return true;
+}
+
+/* Allocates ssids_json for count networks and opens the list */
+static bool WLP_start_json(unsigned int count, uint32_t *ssids_json_idx, uint32_t *ssids_json_len)
+{
+    *ssids_json_len = count * MAX_JSON_NETWORK_RECORD_LENGTH;
 
     /* Add length of "{"networks":[]}" */
-    ssids_json_len += 15U;
+    *ssids_json_len += 15U;
 
-    ssids_json = pvPortMalloc(ssids_json_len);
+    ssids_json = pvPortMallocTagged(*ssids_json_len, heapTAG_WIFI);
     if (ssids_json == NULL)
     {
         PRINTF("[!] Memory allocation failed\r\n");
-        (void)xEventGroupSetBits(s_wplSyncEvent, EVENT_BIT(EVENT_SCAN_DONE));
-        return WM_FAIL;
+        return false;
     }
 
     /* Start building JSON */
     (void)strcpy(ssids_json, "{\"networks\":[");
-    uint32_t ssids_json_idx = strlen(ssids_json);
+    *ssids_json_idx = strlen(ssids_json);
+    return true;
+}
+
+static int WLP_process_results(unsigned int count)
+{
+    int ret                             = 0;
+    struct wlan_scan_result scan_result = {0};
+    uint32_t ssids_json_len;
+    uint32_t ssids_json_idx;
+
+    if (!WLP_start_json(count, &ssids_json_idx, &ssids_json_len))
+    {
+        (void)xEventGroupSetBits(s_wplSyncEvent, EVENT_BIT(EVENT_SCAN_DONE));
+        return WM_FAIL;
+    }
 
     for (uint32_t i = 0; i < count; i++)
     {
         ret = wlan_get_scan_result(i, &scan_result);
         if (ret == WM_SUCCESS)
         {
-            PRINTF("%s\r\n", scan_result.ssid);
-            PRINTF("     BSSID         : %02X:%02X:%02X:%02X:%02X:%02X\r\n", (unsigned int)scan_result.bssid[0],
-                   (unsigned int)scan_result.bssid[1], (unsigned int)scan_result.bssid[2],
-                   (unsigned int)scan_result.bssid[3], (unsigned int)scan_result.bssid[4],
-                   (unsigned int)scan_result.bssid[5]);
-            PRINTF("     RSSI          : %ddBm\r\n", -(int)scan_result.rssi);
-            PRINTF("     Channel       : %d\r\n", (int)scan_result.channel);
-
-            char security[40];
-            security[0] = '\0';
-
-            if (scan_result.wpa2_entp == 1U)
-            {
-                (void)strcat(security, "WPA2_ENTP ");
-            }
-            if (scan_result.wep == 1U)
-            {
-                (void)strcat(security, "WEP ");
-            }
-            if (scan_result.wpa == 1U)
-            {
-                (void)strcat(security, "WPA ");
-            }
-            if (scan_result.wpa2 == 1U)
-            {
-                (void)strcat(security, "WPA2 ");
-            }
-            if (scan_result.wpa3_sae == 1U)
-            {
-                (void)strcat(security, "WPA3_SAE ");
-            }
-
-            if (i != 0U)
-            {
-                /* Add ',' separator before next entry */
-                ssids_json[ssids_json_idx++] = ',';
-            }
-
-            ret = snprintf(
-                ssids_json + ssids_json_idx, ssids_json_len - ssids_json_idx - 1U,
-                "{\"ssid\":\"%s\",\"bssid\":\"%02X:%02X:%02X:%02X:%02X:%02X\",\"signal\":\"%ddBm\",\"channel\":%d,"
-                "\"security\":\"%s\"}",
-                scan_result.ssid, (unsigned int)scan_result.bssid[0], (unsigned int)scan_result.bssid[1],
-                (unsigned int)scan_result.bssid[2], (unsigned int)scan_result.bssid[3], (unsigned int)scan_result.bssid[4],
-                (unsigned int)scan_result.bssid[5], -(int)scan_result.rssi, (int)scan_result.channel, security);
-            if (ret > 0)
-            {
-                ssids_json_idx += (uint32_t)ret;
-            }
-            else
+            if (!WLP_add_json_record(&scan_result, &ssids_json_idx, ssids_json_len))
             {
                 PRINTF("[!] JSON creation failed\r\n");
                 vPortFree(ssids_json);
@@ -543,6 +569,52 @@ static int WLP_process_results(unsigned int count)
     return WM_SUCCESS;
 }
 
+#if CONFIG_WLAN_BSS_CACHE
+/* Builds ssids_json from the BSS cache if a scan filled it recently,
+ * returns false if a new scan is needed */
+static bool WLP_process_cache(void)
+{
+    struct wlan_bss_cache_entry *entries;
+    unsigned int count;
+    uint32_t ssids_json_len;
+    uint32_t ssids_json_idx;
+    bool done = false;
+
+    entries = pvPortMallocTagged(CONFIG_WLAN_BSS_CACHE_SIZE * sizeof(*entries), heapTAG_WIFI);
+    if (entries == NULL)
+    {
+        return false;
+    }
+
+    count = wlan_get_bss_cache(entries, CONFIG_WLAN_BSS_CACHE_SIZE, CONFIG_WLAN_BSS_CACHE_MAX_AGE_MS);
+    if ((count != 0U) && WLP_start_json(count, &ssids_json_idx, &ssids_json_len))
+    {
+        done = true;
+        for (unsigned int i = 0; (i < count) && done; i++)
+        {
+            /* Report the RSSI averaged over the last scans */
+            entries[i].res.rssi = entries[i].rssi_avg;
+            done                = WLP_add_json_record(&entries[i].res, &ssids_json_idx, ssids_json_len);
+        }
+
+        if (done)
+        {
+            /* End of JSON "]}" */
+            (void)strcpy(ssids_json + ssids_json_idx, "]}");
+        }
+        else
+        {
+            PRINTF("[!] JSON creation failed\r\n");
+            vPortFree(ssids_json);
+            ssids_json = NULL;
+        }
+    }
+
+    vPortFree(entries);
+    return done;
+}
+#endif
+
 char *WPL_Scan(void)
 {
     wpl_ret_t status = WPLRET_SUCCESS;
@@ -554,6 +626,14 @@ char *WPL_Scan(void)
         status = WPLRET_NOT_READY;
     }
 
+#if CONFIG_WLAN_BSS_CACHE
+    /* Networks found by a scan a few seconds ago are still there */
+    if ((status == WPLRET_SUCCESS) && WLP_process_cache())
+    {
+        return ssids_json;
+    }
+#endif
+
     if (status == WPLRET_SUCCESS)
     {
         ret = wlan_scan(&WLP_process_results);
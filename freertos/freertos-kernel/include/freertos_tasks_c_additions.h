@@ -45,12 +45,19 @@
  *          absolute address placement option
  * heap_5 - as per heap_4, with the ability to span the heap across
  *          multiple nonOadjacent memory areas
+ *
+ * 0 is used for a heap that is none of these (heap_tlsf.c), debuggers do not
+ * interpret its data structures then.
  */
 #ifndef configFRTOS_MEMORY_SCHEME
+#if defined(configUSE_HEAP_TLSF) && (configUSE_HEAP_TLSF == 1)
+#define configFRTOS_MEMORY_SCHEME 0 /* heap_tlsf.c */
+#else
 #define configFRTOS_MEMORY_SCHEME 3 /* thread safe malloc */
 #endif
+#endif
 
-#if ((configFRTOS_MEMORY_SCHEME > 5) || (configFRTOS_MEMORY_SCHEME < 1))
+#if ((configFRTOS_MEMORY_SCHEME > 5) || (configFRTOS_MEMORY_SCHEME < 0))
 #error "Invalid configFRTOS_MEMORY_SCHEME setting!"
 #endif
 
@@ -0,0 +1,60 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Tagged allocation and fragmentation API of heap_tlsf.c.
+ *
+ * pvPortMalloc() allocations are accounted to heapTAG_OTHER, subsystems that
+ * want their own line in the statistics allocate with pvPortMallocTagged().
+ * Blocks from either function are released with vPortFree().
+ */
+
+#ifndef HEAP_TLSF_H
+#define HEAP_TLSF_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Allocation tags */
+#define heapTAG_OTHER    0U /* pvPortMalloc(), kernel objects, drivers */
+#define heapTAG_LWIP     1U /* lwIP heap (MEM_CUSTOM_ALLOCATOR) */
+#define heapTAG_HTTP     2U /* HTTP server sessions and CGI buffers */
+#define heapTAG_WIFI     3U /* Wi-Fi connection manager, scan results */
+#define heapNUM_TAGS     4U
+
+/* Used to pass information about one allocation tag out of vPortGetHeapTagStats(). */
+typedef struct xHeapTagStats
+{
+    size_t xBytesInUse;                    /* Sum of the sizes of the blocks currently allocated with the tag, including block headers. */
+    size_t xPeakBytesInUse;                /* The highest value xBytesInUse has reached. */
+    size_t xBlocksInUse;                   /* The number of blocks currently allocated with the tag. */
+    size_t xNumberOfFailedAllocations;     /* The number of allocations with the tag that returned NULL. */
+} HeapTagStats_t;
+
+void * pvPortMallocTagged( size_t xWantedSize,
+                           uint8_t ucTag );
+void * pvPortCallocTagged( size_t xNum,
+                           size_t xSize,
+                           uint8_t ucTag );
+void vPortGetHeapTagStats( uint8_t ucTag,
+                           HeapTagStats_t * pxTagStats );
+
+/*
+ * Returns the external fragmentation of the heap in percent: the share of the
+ * free memory that cannot be returned by a single allocation.
+ */
+uint32_t ulPortGetHeapFragmentation( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HEAP_TLSF_H */
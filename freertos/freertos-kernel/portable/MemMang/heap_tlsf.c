@@ -0,0 +1,620 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+
+/*
+ * Two-Level Segregated Fit (TLSF) implementation of pvPortMalloc() and
+ * vPortFree(), after M. Masmano et al., "TLSF: a New Dynamic Memory Allocator
+ * for Real-Time Systems".
+ *
+ * Free blocks are kept in segregated lists indexed by a first level (power of
+ * two) and a second level (heapSL_COUNT linear subdivisions of that power of
+ * two). Two bitmaps record which lists are non-empty, so both allocation and
+ * free run in constant time, independent of the number of free blocks.
+ * Adjacent free blocks are merged immediately on free.
+ *
+ * Every block carries an allocation tag (see heap_tlsf.h) so the heap usage
+ * can be broken down per subsystem, and vPortGetHeapStats() reports the
+ * largest free block for fragmentation monitoring.
+ *
+ * The heap is the ucHeap array of configTOTAL_HEAP_SIZE bytes, or an array
+ * provided by the application when configAPPLICATION_ALLOCATED_HEAP is 1.
+ */
+
+#include <string.h>
+
+/* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from redefining
+ * all the API functions to use the MPU wrappers.  That should only be done when
+ * task.h is included from an application file. */
+#define MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "heap_tlsf.h"
+
+#undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#if ( configSUPPORT_DYNAMIC_ALLOCATION == 0 )
+    #error This file must not be used if configSUPPORT_DYNAMIC_ALLOCATION is 0
+#endif
+
+#if !defined( configUSE_HEAP_TLSF ) || ( configUSE_HEAP_TLSF == 0 )
+    #error This file must not be used if configUSE_HEAP_TLSF is 0, build heap_3.c instead
+#endif
+
+#ifndef configHEAP_CLEAR_MEMORY_ON_FREE
+    #define configHEAP_CLEAR_MEMORY_ON_FREE    0
+#endif
+
+/* Block sizes and payload addresses are multiples of heapALIGNMENT. */
+#define heapALIGNMENT_LOG2      3U
+#define heapALIGNMENT           ( 1U << heapALIGNMENT_LOG2 )
+#define heapALIGNMENT_MASK      ( heapALIGNMENT - 1U )
+
+/* log2 of the number of second level lists per first level. */
+#define heapSL_COUNT_LOG2       4U
+#define heapSL_COUNT            ( 1U << heapSL_COUNT_LOG2 )
+
+/* Blocks below heapSMALL_BLOCK_SIZE are all kept in first level 0, split
+ * linearly into heapSL_COUNT lists of heapALIGNMENT bytes each. */
+#define heapFL_SHIFT            ( heapSL_COUNT_LOG2 + heapALIGNMENT_LOG2 )
+#define heapSMALL_BLOCK_SIZE    ( 1U << heapFL_SHIFT )
+
+/* Largest supported block is just below 2^heapFL_MAX bytes. */
+#define heapFL_MAX              24U
+#define heapFL_COUNT            ( heapFL_MAX - heapFL_SHIFT + 1U )
+#define heapMAX_BLOCK_SIZE      ( ( 1U << heapFL_MAX ) - heapALIGNMENT )
+
+/* Layout of the xSizeAndFlags member of a block header. */
+#define heapBLOCK_FREE          0x1U
+#define heapSIZE_MASK           ( ( ( size_t ) 1U << heapFL_MAX ) - heapALIGNMENT )
+#define heapTAG_SHIFT           24U
+
+/* Header in front of every block. The free list links overlay the payload
+ * and are only valid while the block is free. */
+typedef struct xTLSF_BLOCK
+{
+    struct xTLSF_BLOCK * pxPrevPhysBlock; /* Block directly below this one in memory, NULL for the first block. */
+    size_t xSizeAndFlags;                 /* Payload size, heapBLOCK_FREE and the allocation tag. */
+    struct xTLSF_BLOCK * pxNextFreeBlock;
+    struct xTLSF_BLOCK * pxPrevFreeBlock;
+} TLSFBlock_t;
+
+#define heapBLOCK_HEADER_SIZE   ( ( size_t ) offsetof( TLSFBlock_t, pxNextFreeBlock ) )
+#define heapMIN_BLOCK_SIZE      ( sizeof( TLSFBlock_t ) - heapBLOCK_HEADER_SIZE )
+
+/* Allocate the memory for the heap. */
+#if ( configAPPLICATION_ALLOCATED_HEAP == 1 )
+
+/* The application writer has already defined the array used for the heap -
+ * probably so it can be placed in a special segment or address. */
+    extern uint8_t ucHeap[ configTOTAL_HEAP_SIZE ];
+#else
+    PRIVILEGED_DATA static uint8_t ucHeap[ configTOTAL_HEAP_SIZE ] __attribute__( ( aligned( heapALIGNMENT ) ) );
+#endif /* configAPPLICATION_ALLOCATED_HEAP */
+
+/*-----------------------------------------------------------*/
+
+/* Free list heads and the bitmaps of the non-empty lists. */
+PRIVILEGED_DATA static uint32_t ulFirstLevelBitmap = 0;
+PRIVILEGED_DATA static uint32_t ulSecondLevelBitmap[ heapFL_COUNT ];
+PRIVILEGED_DATA static TLSFBlock_t * pxFreeLists[ heapFL_COUNT ][ heapSL_COUNT ];
+
+/* Keeps track of the heap usage for vPortGetHeapStats(). The free bytes
+ * include the headers of the free blocks. */
+PRIVILEGED_DATA static size_t xFreeBytesRemaining = 0U;
+PRIVILEGED_DATA static size_t xMinimumEverFreeBytesRemaining = 0U;
+PRIVILEGED_DATA static size_t xNumberOfFreeBlocks = 0U;
+PRIVILEGED_DATA static size_t xNumberOfSuccessfulAllocations = 0U;
+PRIVILEGED_DATA static size_t xNumberOfSuccessfulFrees = 0U;
+PRIVILEGED_DATA static HeapTagStats_t xTagStats[ heapNUM_TAGS ];
+
+PRIVILEGED_DATA static BaseType_t xHeapInitialised = pdFALSE;
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Lays out the heap as one free block followed by a zero sized, allocated
+ * sentinel block that stops merging at the end of the heap.
+ */
+static void prvHeapInit( void ) PRIVILEGED_FUNCTION;
+
+/*-----------------------------------------------------------*/
+
+static inline size_t prvBlockSize( const TLSFBlock_t * pxBlock )
+{
+    return pxBlock->xSizeAndFlags & heapSIZE_MASK;
+}
+
+static inline BaseType_t prvBlockIsFree( const TLSFBlock_t * pxBlock )
+{
+    return ( ( pxBlock->xSizeAndFlags & heapBLOCK_FREE ) != 0U ) ? pdTRUE : pdFALSE;
+}
+
+static inline uint8_t prvBlockTag( const TLSFBlock_t * pxBlock )
+{
+    return ( uint8_t ) ( pxBlock->xSizeAndFlags >> heapTAG_SHIFT );
+}
+
+static inline TLSFBlock_t * prvNextPhysBlock( const TLSFBlock_t * pxBlock )
+{
+    return ( TLSFBlock_t * ) ( ( ( uint8_t * ) pxBlock ) + heapBLOCK_HEADER_SIZE + prvBlockSize( pxBlock ) );
+}
+
+/* Index of the most significant set bit, ulValue must not be 0. */
+static inline uint32_t prvFls( uint32_t ulValue )
+{
+    return 31U - ( uint32_t ) __builtin_clz( ulValue );
+}
+
+/* Index of the least significant set bit, ulValue must not be 0. */
+static inline uint32_t prvFfs( uint32_t ulValue )
+{
+    return ( uint32_t ) __builtin_ctz( ulValue );
+}
+
+/* Finds the list a free block of xSize bytes belongs to. */
+static void prvMappingInsert( size_t xSize,
+                              uint32_t * pulFirstLevel,
+                              uint32_t * pulSecondLevel )
+{
+    uint32_t ulFl;
+
+    if( xSize < heapSMALL_BLOCK_SIZE )
+    {
+        *pulFirstLevel = 0U;
+        *pulSecondLevel = ( uint32_t ) xSize / ( heapSMALL_BLOCK_SIZE / heapSL_COUNT );
+    }
+    else
+    {
+        ulFl = prvFls( ( uint32_t ) xSize );
+        *pulSecondLevel = ( ( uint32_t ) xSize >> ( ulFl - heapSL_COUNT_LOG2 ) ) ^ heapSL_COUNT;
+        *pulFirstLevel = ulFl - ( heapFL_SHIFT - 1U );
+    }
+}
+
+/* Finds the first list whose blocks are all at least xSize bytes. */
+static void prvMappingSearch( size_t xSize,
+                              uint32_t * pulFirstLevel,
+                              uint32_t * pulSecondLevel )
+{
+    if( xSize >= heapSMALL_BLOCK_SIZE )
+    {
+        xSize += ( ( size_t ) 1U << ( prvFls( ( uint32_t ) xSize ) - heapSL_COUNT_LOG2 ) ) - 1U;
+    }
+
+    prvMappingInsert( xSize, pulFirstLevel, pulSecondLevel );
+}
+
+static void prvInsertFreeBlock( TLSFBlock_t * pxBlock )
+{
+    uint32_t ulFl;
+    uint32_t ulSl;
+    TLSFBlock_t * pxHead;
+
+    prvMappingInsert( prvBlockSize( pxBlock ), &ulFl, &ulSl );
+
+    pxHead = pxFreeLists[ ulFl ][ ulSl ];
+    pxBlock->pxNextFreeBlock = pxHead;
+    pxBlock->pxPrevFreeBlock = NULL;
+
+    if( pxHead != NULL )
+    {
+        pxHead->pxPrevFreeBlock = pxBlock;
+    }
+
+    pxFreeLists[ ulFl ][ ulSl ] = pxBlock;
+    ulFirstLevelBitmap |= ( 1UL << ulFl );
+    ulSecondLevelBitmap[ ulFl ] |= ( 1UL << ulSl );
+
+    pxBlock->xSizeAndFlags |= heapBLOCK_FREE;
+    xNumberOfFreeBlocks++;
+}
+
+static void prvRemoveFreeBlock( TLSFBlock_t * pxBlock )
+{
+    uint32_t ulFl;
+    uint32_t ulSl;
+
+    prvMappingInsert( prvBlockSize( pxBlock ), &ulFl, &ulSl );
+
+    if( pxBlock->pxPrevFreeBlock != NULL )
+    {
+        pxBlock->pxPrevFreeBlock->pxNextFreeBlock = pxBlock->pxNextFreeBlock;
+    }
+    else
+    {
+        pxFreeLists[ ulFl ][ ulSl ] = pxBlock->pxNextFreeBlock;
+
+        if( pxBlock->pxNextFreeBlock == NULL )
+        {
+            ulSecondLevelBitmap[ ulFl ] &= ~( 1UL << ulSl );
+
+            if( ulSecondLevelBitmap[ ulFl ] == 0U )
+            {
+                ulFirstLevelBitmap &= ~( 1UL << ulFl );
+            }
+        }
+    }
+
+    if( pxBlock->pxNextFreeBlock != NULL )
+    {
+        pxBlock->pxNextFreeBlock->pxPrevFreeBlock = pxBlock->pxPrevFreeBlock;
+    }
+
+    pxBlock->xSizeAndFlags &= ~heapBLOCK_FREE;
+    xNumberOfFreeBlocks--;
+}
+
+/* Returns the head of the first non-empty list at or above (ulFl, ulSl). */
+static TLSFBlock_t * prvSearchSuitableBlock( uint32_t ulFl,
+                                             uint32_t ulSl )
+{
+    uint32_t ulMap;
+
+    ulMap = ulSecondLevelBitmap[ ulFl ] & ( ~0UL << ulSl );
+
+    if( ulMap == 0U )
+    {
+        /* No block in this first level is large enough, take the next
+         * non-empty first level. */
+        ulMap = ( ulFl + 1U < 32U ) ? ( ulFirstLevelBitmap & ( ~0UL << ( ulFl + 1U ) ) ) : 0U;
+
+        if( ulMap == 0U )
+        {
+            return NULL;
+        }
+
+        ulFl = prvFfs( ulMap );
+        ulMap = ulSecondLevelBitmap[ ulFl ];
+    }
+
+    return pxFreeLists[ ulFl ][ prvFfs( ulMap ) ];
+}
+
+/* Splits the tail of an allocated block off as a new free block when it is
+ * large enough to hold one. */
+static void prvTrimBlock( TLSFBlock_t * pxBlock,
+                          size_t xWantedSize )
+{
+    TLSFBlock_t * pxRemainder;
+    TLSFBlock_t * pxNext;
+    size_t xBlockSize = prvBlockSize( pxBlock );
+
+    if( xBlockSize >= ( xWantedSize + heapBLOCK_HEADER_SIZE + heapMIN_BLOCK_SIZE ) )
+    {
+        pxRemainder = ( TLSFBlock_t * ) ( ( ( uint8_t * ) pxBlock ) + heapBLOCK_HEADER_SIZE + xWantedSize );
+        pxRemainder->pxPrevPhysBlock = pxBlock;
+        pxRemainder->xSizeAndFlags = xBlockSize - xWantedSize - heapBLOCK_HEADER_SIZE;
+
+        pxNext = prvNextPhysBlock( pxRemainder );
+        pxNext->pxPrevPhysBlock = pxRemainder;
+
+        pxBlock->xSizeAndFlags = ( pxBlock->xSizeAndFlags & ~heapSIZE_MASK ) | xWantedSize;
+
+        /* The remainder was taken out of the free bytes with the whole
+         * block, it is free memory again. */
+        xFreeBytesRemaining += heapBLOCK_HEADER_SIZE + prvBlockSize( pxRemainder );
+        prvInsertFreeBlock( pxRemainder );
+    }
+}
+
+static void prvHeapInit( void )
+{
+    TLSFBlock_t * pxFirstBlock;
+    TLSFBlock_t * pxSentinel;
+    size_t xAddress = ( size_t ) ucHeap;
+    size_t xTotalHeapSize = configTOTAL_HEAP_SIZE;
+
+    /* Ensure the heap starts on a correctly aligned boundary. */
+    if( ( xAddress & heapALIGNMENT_MASK ) != 0U )
+    {
+        xTotalHeapSize -= heapALIGNMENT - ( xAddress & heapALIGNMENT_MASK );
+        xAddress = ( xAddress + heapALIGNMENT_MASK ) & ~( ( size_t ) heapALIGNMENT_MASK );
+    }
+
+    xTotalHeapSize &= ~( ( size_t ) heapALIGNMENT_MASK );
+    configASSERT( xTotalHeapSize <= ( heapMAX_BLOCK_SIZE + heapBLOCK_HEADER_SIZE + sizeof( TLSFBlock_t ) ) );
+
+    /* The sentinel only uses its header, but is accessed as a whole block,
+     * so a whole block is left for it at the end of the heap. */
+    pxFirstBlock = ( TLSFBlock_t * ) xAddress;
+    pxFirstBlock->pxPrevPhysBlock = NULL;
+    pxFirstBlock->xSizeAndFlags = xTotalHeapSize - heapBLOCK_HEADER_SIZE - sizeof( TLSFBlock_t );
+
+    pxSentinel = prvNextPhysBlock( pxFirstBlock );
+    pxSentinel->pxPrevPhysBlock = pxFirstBlock;
+    pxSentinel->xSizeAndFlags = 0U;
+
+    xFreeBytesRemaining = heapBLOCK_HEADER_SIZE + prvBlockSize( pxFirstBlock );
+    xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
+    prvInsertFreeBlock( pxFirstBlock );
+
+    xHeapInitialised = pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+void * pvPortMallocTagged( size_t xWantedSize,
+                           uint8_t ucTag )
+{
+    TLSFBlock_t * pxBlock = NULL;
+    void * pvReturn = NULL;
+    uint32_t ulFl;
+    uint32_t ulSl;
+    size_t xBlockBytes;
+
+    configASSERT( ucTag < heapNUM_TAGS );
+
+    vTaskSuspendAll();
+    {
+        if( xHeapInitialised == pdFALSE )
+        {
+            prvHeapInit();
+        }
+
+        if( ( xWantedSize > 0U ) && ( xWantedSize <= heapMAX_BLOCK_SIZE ) )
+        {
+            /* Round the request up to the alignment and to the space the free
+             * list links need once the block is freed again. */
+            xWantedSize = ( xWantedSize + heapALIGNMENT_MASK ) & ~( ( size_t ) heapALIGNMENT_MASK );
+
+            if( xWantedSize < heapMIN_BLOCK_SIZE )
+            {
+                xWantedSize = heapMIN_BLOCK_SIZE;
+            }
+
+            prvMappingSearch( xWantedSize, &ulFl, &ulSl );
+
+            if( ulFl < heapFL_COUNT )
+            {
+                pxBlock = prvSearchSuitableBlock( ulFl, ulSl );
+            }
+        }
+
+        if( pxBlock != NULL )
+        {
+            prvRemoveFreeBlock( pxBlock );
+            xFreeBytesRemaining -= heapBLOCK_HEADER_SIZE + prvBlockSize( pxBlock );
+            prvTrimBlock( pxBlock, xWantedSize );
+
+            /* The block costs its header as well. */
+            xBlockBytes = heapBLOCK_HEADER_SIZE + prvBlockSize( pxBlock );
+
+            if( xFreeBytesRemaining < xMinimumEverFreeBytesRemaining )
+            {
+                xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
+            }
+
+            pxBlock->xSizeAndFlags = prvBlockSize( pxBlock ) | ( ( size_t ) ucTag << heapTAG_SHIFT );
+
+            xTagStats[ ucTag ].xBytesInUse += xBlockBytes;
+            xTagStats[ ucTag ].xBlocksInUse++;
+
+            if( xTagStats[ ucTag ].xBytesInUse > xTagStats[ ucTag ].xPeakBytesInUse )
+            {
+                xTagStats[ ucTag ].xPeakBytesInUse = xTagStats[ ucTag ].xBytesInUse;
+            }
+
+            xNumberOfSuccessfulAllocations++;
+            pvReturn = ( void * ) ( ( ( uint8_t * ) pxBlock ) + heapBLOCK_HEADER_SIZE );
+        }
+        else
+        {
+            xTagStats[ ucTag ].xNumberOfFailedAllocations++;
+        }
+
+        traceMALLOC( pvReturn, xWantedSize );
+    }
+    ( void ) xTaskResumeAll();
+
+    #if ( configUSE_MALLOC_FAILED_HOOK == 1 )
+    {
+        if( pvReturn == NULL )
+        {
+            vApplicationMallocFailedHook();
+        }
+    }
+    #endif
+
+    configASSERT( ( ( ( size_t ) pvReturn ) & ( size_t ) heapALIGNMENT_MASK ) == 0U );
+    return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+void * pvPortMalloc( size_t xWantedSize )
+{
+    return pvPortMallocTagged( xWantedSize, heapTAG_OTHER );
+}
+/*-----------------------------------------------------------*/
+
+void vPortFree( void * pv )
+{
+    TLSFBlock_t * pxBlock;
+    TLSFBlock_t * pxNeighbour;
+    uint8_t ucTag;
+
+    if( pv == NULL )
+    {
+        return;
+    }
+
+    pxBlock = ( TLSFBlock_t * ) ( ( ( uint8_t * ) pv ) - heapBLOCK_HEADER_SIZE );
+
+    /* Check the block is actually allocated. */
+    configASSERT( prvBlockIsFree( pxBlock ) == pdFALSE );
+    configASSERT( prvBlockTag( pxBlock ) < heapNUM_TAGS );
+
+    vTaskSuspendAll();
+    {
+        ucTag = prvBlockTag( pxBlock );
+        xTagStats[ ucTag ].xBytesInUse -= heapBLOCK_HEADER_SIZE + prvBlockSize( pxBlock );
+        xTagStats[ ucTag ].xBlocksInUse--;
+
+        xFreeBytesRemaining += heapBLOCK_HEADER_SIZE + prvBlockSize( pxBlock );
+        pxBlock->xSizeAndFlags = prvBlockSize( pxBlock );
+
+        #if ( configHEAP_CLEAR_MEMORY_ON_FREE == 1 )
+        {
+            ( void ) memset( pv, 0, prvBlockSize( pxBlock ) );
+        }
+        #endif
+
+        /* Merge with the block below. */
+        pxNeighbour = pxBlock->pxPrevPhysBlock;
+
+        if( ( pxNeighbour != NULL ) && ( prvBlockIsFree( pxNeighbour ) != pdFALSE ) )
+        {
+            prvRemoveFreeBlock( pxNeighbour );
+            pxNeighbour->xSizeAndFlags += heapBLOCK_HEADER_SIZE + prvBlockSize( pxBlock );
+            pxBlock = pxNeighbour;
+            prvNextPhysBlock( pxBlock )->pxPrevPhysBlock = pxBlock;
+        }
+
+        /* Merge with the block above, the sentinel is never free. */
+        pxNeighbour = prvNextPhysBlock( pxBlock );
+
+        if( prvBlockIsFree( pxNeighbour ) != pdFALSE )
+        {
+            prvRemoveFreeBlock( pxNeighbour );
+            pxBlock->xSizeAndFlags += heapBLOCK_HEADER_SIZE + prvBlockSize( pxNeighbour );
+            prvNextPhysBlock( pxBlock )->pxPrevPhysBlock = pxBlock;
+        }
+
+        prvInsertFreeBlock( pxBlock );
+
+        xNumberOfSuccessfulFrees++;
+        traceFREE( pv, 0 );
+    }
+    ( void ) xTaskResumeAll();
+}
+/*-----------------------------------------------------------*/
+
+void * pvPortCallocTagged( size_t xNum,
+                           size_t xSize,
+                           uint8_t ucTag )
+{
+    void * pv = NULL;
+
+    if( ( xSize == 0U ) || ( xNum <= ( SIZE_MAX / xSize ) ) )
+    {
+        pv = pvPortMallocTagged( xNum * xSize, ucTag );
+
+        if( pv != NULL )
+        {
+            ( void ) memset( pv, 0, xNum * xSize );
+        }
+    }
+
+    return pv;
+}
+/*-----------------------------------------------------------*/
+
+void * pvPortCalloc( size_t xNum,
+                     size_t xSize )
+{
+    return pvPortCallocTagged( xNum, xSize, heapTAG_OTHER );
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetFreeHeapSize( void )
+{
+    return xFreeBytesRemaining;
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetMinimumEverFreeHeapSize( void )
+{
+    return xMinimumEverFreeBytesRemaining;
+}
+/*-----------------------------------------------------------*/
+
+void vPortInitialiseBlocks( void )
+{
+    /* This just exists to keep the linker quiet. */
+}
+/*-----------------------------------------------------------*/
+
+void vPortGetHeapStats( HeapStats_t * pxHeapStats )
+{
+    TLSFBlock_t * pxBlock;
+    uint32_t ulFl;
+    uint32_t ulSl;
+    size_t xMaxSize = 0;
+    size_t xMinSize = portMAX_DELAY;
+
+    vTaskSuspendAll();
+    {
+        if( ulFirstLevelBitmap != 0U )
+        {
+            /* The largest block is in the highest non-empty list, the smallest
+             * in the lowest one. Only those two lists are walked. */
+            ulFl = prvFls( ulFirstLevelBitmap );
+            ulSl = prvFls( ulSecondLevelBitmap[ ulFl ] );
+
+            for( pxBlock = pxFreeLists[ ulFl ][ ulSl ]; pxBlock != NULL; pxBlock = pxBlock->pxNextFreeBlock )
+            {
+                if( prvBlockSize( pxBlock ) > xMaxSize )
+                {
+                    xMaxSize = prvBlockSize( pxBlock );
+                }
+            }
+
+            ulFl = prvFfs( ulFirstLevelBitmap );
+            ulSl = prvFfs( ulSecondLevelBitmap[ ulFl ] );
+
+            for( pxBlock = pxFreeLists[ ulFl ][ ulSl ]; pxBlock != NULL; pxBlock = pxBlock->pxNextFreeBlock )
+            {
+                if( prvBlockSize( pxBlock ) < xMinSize )
+                {
+                    xMinSize = prvBlockSize( pxBlock );
+                }
+            }
+        }
+        else
+        {
+            xMinSize = 0;
+        }
+
+        pxHeapStats->xSizeOfLargestFreeBlockInBytes = xMaxSize;
+        pxHeapStats->xSizeOfSmallestFreeBlockInBytes = xMinSize;
+        pxHeapStats->xNumberOfFreeBlocks = xNumberOfFreeBlocks;
+        pxHeapStats->xAvailableHeapSpaceInBytes = xFreeBytesRemaining;
+        pxHeapStats->xNumberOfSuccessfulAllocations = xNumberOfSuccessfulAllocations;
+        pxHeapStats->xNumberOfSuccessfulFrees = xNumberOfSuccessfulFrees;
+        pxHeapStats->xMinimumEverFreeBytesRemaining = xMinimumEverFreeBytesRemaining;
+    }
+    ( void ) xTaskResumeAll();
+}
+/*-----------------------------------------------------------*/
+
+void vPortGetHeapTagStats( uint8_t ucTag,
+                           HeapTagStats_t * pxTagStats )
+{
+    configASSERT( ucTag < heapNUM_TAGS );
+
+    vTaskSuspendAll();
+    {
+        *pxTagStats = xTagStats[ ucTag ];
+    }
+    ( void ) xTaskResumeAll();
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulPortGetHeapFragmentation( void )
+{
+    HeapStats_t xHeapStats;
+
+    vPortGetHeapStats( &xHeapStats );
+
+    if( xHeapStats.xAvailableHeapSpaceInBytes == 0U )
+    {
+        return 0U;
+    }
+
+    /* The free bytes include the block headers, so does the largest block. */
+    return ( uint32_t ) ( 100U - ( ( ( xHeapStats.xSizeOfLargestFreeBlockInBytes + heapBLOCK_HEADER_SIZE ) * 100U ) / xHeapStats.xAvailableHeapSpaceInBytes ) );
+}
@@ -0,0 +1,281 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Port specific Internet checksum routines, hooked into lwIP through
+ * LWIP_CHKSUM and LWIP_CHKSUM_COPY in lwipopts.h.
+ *
+ * The data is summed one 32-bit word at a time, four words per loop
+ * iteration. On cores with the DSP extension (__ARM_FEATURE_DSP) the two
+ * halfwords of each word are added in parallel with __UADD16 and the lane
+ * carries are collected with __SEL; otherwise the words are added into a
+ * 64-bit accumulator, which the compiler turns into an ADDS/ADC pair.
+ *
+ * Both variants return the same value as lwip_standard_chksum(): the host
+ * order, non-inverted Internet sum of the buffer, for any start alignment.
+ */
+
+#include "lwip/opt.h"
+#include "lwip/def.h"
+#include "lwip/inet_chksum.h"
+
+#include "cmsis_compiler.h"
+
+#include <string.h>
+
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+#define LWIP_PORT_CHKSUM_DSP 1
+#else
+#define LWIP_PORT_CHKSUM_DSP 0
+#endif
+
+#if LWIP_PORT_CHKSUM_DSP
+/* Per lane carry increment, selected by the GE flags after __UADD16 */
+#define CHKSUM_LANE_CARRY 0x00010001UL
+
+/* Adds one word to the lane sums and counts the carries out of each lane */
+#define CHKSUM_ADD_WORD(lanes, carries, w)                          \
+    do                                                              \
+    {                                                               \
+        (lanes)   = __UADD16((lanes), (w));                         \
+        (carries) = __UADD16((carries), __SEL(CHKSUM_LANE_CARRY, 0U)); \
+    } while (0)
+
+/*
+ * Sums nwords aligned words. Each lane holds the 16-bit sum of one halfword
+ * position, the carry counters hold how many times that lane wrapped. The
+ * counters cannot wrap because a pbuf is never longer than 0xFFFF bytes.
+ */
+static u32_t chksum_words(const u32_t *pw, u32_t nwords)
+{
+    u32_t lanes   = 0;
+    u32_t carries = 0;
+
+    while (nwords >= 4U)
+    {
+        CHKSUM_ADD_WORD(lanes, carries, pw[0]);
+        CHKSUM_ADD_WORD(lanes, carries, pw[1]);
+        CHKSUM_ADD_WORD(lanes, carries, pw[2]);
+        CHKSUM_ADD_WORD(lanes, carries, pw[3]);
+        pw += 4;
+        nwords -= 4U;
+    }
+
+    while (nwords > 0U)
+    {
+        CHKSUM_ADD_WORD(lanes, carries, *pw++);
+        nwords--;
+    }
+
+    /* Every carry out of a lane is worth 0x10000, i.e. 1 after folding */
+    return (lanes & 0xFFFFUL) + (lanes >> 16) + (carries & 0xFFFFUL) + (carries >> 16);
+}
+
+/* Same as chksum_words(), storing every word to dst as it is summed */
+static u32_t chksum_copy_words(u32_t *dst, const u32_t *src, u32_t nwords)
+{
+    u32_t lanes   = 0;
+    u32_t carries = 0;
+    u32_t w;
+
+    while (nwords > 0U)
+    {
+        w      = *src++;
+        *dst++ = w;
+        CHKSUM_ADD_WORD(lanes, carries, w);
+        nwords--;
+    }
+
+    return (lanes & 0xFFFFUL) + (lanes >> 16) + (carries & 0xFFFFUL) + (carries >> 16);
+}
+#else
+/* Adds nwords aligned words into a 64-bit accumulator and folds it to 32 bits */
+static u32_t chksum_words(const u32_t *pw, u32_t nwords)
+{
+    u64_t acc = 0;
+
+    while (nwords >= 4U)
+    {
+        acc += pw[0];
+        acc += pw[1];
+        acc += pw[2];
+        acc += pw[3];
+        pw += 4;
+        nwords -= 4U;
+    }
+
+    while (nwords > 0U)
+    {
+        acc += *pw++;
+        nwords--;
+    }
+
+    acc = (acc >> 32) + (acc & 0xFFFFFFFFUL);
+    acc = (acc >> 32) + (acc & 0xFFFFFFFFUL);
+    return FOLD_U32T((u32_t)acc);
+}
+
+/* Same as chksum_words(), storing every word to dst as it is summed */
+static u32_t chksum_copy_words(u32_t *dst, const u32_t *src, u32_t nwords)
+{
+    u64_t acc = 0;
+    u32_t w;
+
+    while (nwords > 0U)
+    {
+        w      = *src++;
+        *dst++ = w;
+        acc += w;
+        nwords--;
+    }
+
+    acc = (acc >> 32) + (acc & 0xFFFFFFFFUL);
+    acc = (acc >> 32) + (acc & 0xFFFFFFFFUL);
+    return FOLD_U32T((u32_t)acc);
+}
+#endif /* LWIP_PORT_CHKSUM_DSP */
+
+/* Folds a 32-bit partial sum to 16 bits and undoes the odd start swap */
+static u16_t chksum_finish(u32_t sum, int odd)
+{
+    sum = FOLD_U32T(sum);
+    sum = FOLD_U32T(sum);
+
+    if (odd)
+    {
+        sum = SWAP_BYTES_IN_WORD(sum);
+    }
+
+    return (u16_t)sum;
+}
+
+/**
+ * Calculates the Internet checksum over a buffer.
+ *
+ * @param dataptr start of the data, any alignment
+ * @param len length of the data in bytes
+ * @return host order (!) lwip checksum (non-inverted Internet sum)
+ */
+u16_t lwip_port_chksum(const void *dataptr, int len)
+{
+    const u8_t *pb = (const u8_t *)dataptr;
+    u16_t t        = 0;
+    u32_t sum      = 0;
+    int odd        = ((mem_ptr_t)pb & 1);
+
+    /* Get aligned to u16_t */
+    if (odd && (len > 0))
+    {
+        ((u8_t *)&t)[1] = *pb++;
+        len--;
+    }
+
+    /* Get aligned to u32_t */
+    if (((mem_ptr_t)pb & 2) && (len > 1))
+    {
+        sum += *(const u16_t *)(const void *)pb;
+        pb += 2;
+        len -= 2;
+    }
+
+    if (len >= 4)
+    {
+        sum += chksum_words((const u32_t *)(const void *)pb, (u32_t)len >> 2);
+        pb += len & ~3;
+        len &= 3;
+    }
+
+    /* 16-bit aligned word remaining? */
+    if (len > 1)
+    {
+        sum += *(const u16_t *)(const void *)pb;
+        pb += 2;
+        len -= 2;
+    }
+
+    /* Dangling tail byte remaining? */
+    if (len > 0)
+    {
+        ((u8_t *)&t)[0] = *pb;
+    }
+
+    sum += t;
+
+    return chksum_finish(sum, odd);
+}
+
+/**
+ * Copies a buffer like MEMCPY and calculates its checksum in the same pass.
+ *
+ * The fused loop runs when source and destination share their word
+ * alignment, which is the case for the TCP/UDP copy paths (both sides are
+ * MEM_ALIGNMENT aligned pbuf payloads or application buffers). Otherwise the
+ * data is copied first and summed from the destination.
+ *
+ * @param dst destination buffer
+ * @param src source buffer
+ * @param len number of bytes to copy
+ * @return host order (!) lwip checksum (non-inverted Internet sum) of the data
+ */
+u16_t lwip_port_chksum_copy(void *dst, const void *src, u16_t len)
+{
+    const u8_t *ps = (const u8_t *)src;
+    u8_t *pd       = (u8_t *)dst;
+    u32_t head;
+    u32_t nwords;
+    u32_t sum;
+    u32_t i;
+    u16_t tail;
+
+    if ((((mem_ptr_t)ps ^ (mem_ptr_t)pd) & 3U) != 0U)
+    {
+        MEMCPY(dst, src, len);
+        return lwip_port_chksum(dst, len);
+    }
+
+    /* Copy up to the first word boundary */
+    head = (u32_t)((4U - ((mem_ptr_t)ps & 3U)) & 3U);
+    if (head > len)
+    {
+        head = len;
+    }
+    for (i = 0; i < head; i++)
+    {
+        pd[i] = ps[i];
+    }
+
+    nwords = ((u32_t)len - head) >> 2;
+    sum    = chksum_copy_words((u32_t *)(void *)(pd + head), (const u32_t *)(const void *)(ps + head), nwords);
+
+    tail = (u16_t)((u32_t)len - head - (nwords << 2));
+    for (i = 0; i < tail; i++)
+    {
+        pd[head + (nwords << 2) + i] = ps[head + (nwords << 2) + i];
+    }
+
+    if (head == 0U)
+    {
+        sum += lwip_port_chksum(pd + (nwords << 2), tail);
+        return chksum_finish(sum, 0);
+    }
+
+    /*
+     * The word part starts at offset head, so its partial sum (and the one of
+     * the tail that follows it) is byte swapped when head is odd, the same way
+     * inet_chksum_pbuf() combines the pbufs of a chain.
+     */
+    sum += lwip_port_chksum(pd + head + (nwords << 2), tail);
+    sum = FOLD_U32T(sum);
+    sum = FOLD_U32T(sum);
+    if ((head & 1U) != 0U)
+    {
+        sum = SWAP_BYTES_IN_WORD(sum);
+    }
+    sum += lwip_port_chksum(pd, (int)head);
+
+    return chksum_finish(sum, 0);
+}
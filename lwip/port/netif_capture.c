@@ -0,0 +1,180 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Packet capture ring, see netif_capture.h.
+ *
+ * Frame n goes to record n % NETIF_CAPTURE_RECORDS. Its writer clears the
+ * record sequence number, fills the record and then stores n + 1; a reader
+ * accepts a copy only if it saw n + 1 both before and after copying.
+ */
+
+#include "netif_capture.h"
+
+#if LWIP_NETIF_CAPTURE
+
+#include "lwip/def.h"
+#include "lwip/prot/ethernet.h"
+#include "lwip/prot/ieee.h"
+#include "lwip/prot/ip.h"
+#include "lwip/sys.h"
+
+#include "cmsis_compiler.h"
+
+#include <string.h>
+
+#if (NETIF_CAPTURE_RECORDS & (NETIF_CAPTURE_RECORDS - 1)) != 0
+#error "NETIF_CAPTURE_RECORDS must be a power of two"
+#endif
+
+static struct netif_capture_record capture_ring[NETIF_CAPTURE_RECORDS];
+static volatile u32_t capture_next;
+static struct netif_capture_filter capture_filter = {0, 0, 0, NETIF_CAPTURE_SNAPLEN};
+
+/* Claims the sequence number of the next frame */
+static u32_t capture_claim(void)
+{
+    u32_t seq;
+
+    do
+    {
+        seq = __LDREXW(&capture_next);
+    } while (__STREXW(seq + 1U, &capture_next) != 0U);
+
+    return seq;
+}
+
+static u16_t capture_get_u16(const struct pbuf *p, u16_t offset)
+{
+    return (u16_t)(((u16_t)pbuf_get_at(p, offset) << 8) | pbuf_get_at(p, (u16_t)(offset + 1U)));
+}
+
+/* Matches the IP protocol and TCP/UDP ports of an Ethernet frame against the filter */
+static int capture_match(const struct pbuf *p, const struct netif_capture_filter *filter)
+{
+    u16_t type;
+    u16_t l4;
+    u8_t proto;
+
+    if ((filter->proto == 0U) && (filter->port == 0U))
+    {
+        return 1;
+    }
+
+    if (p->tot_len < SIZEOF_ETH_HDR)
+    {
+        return 0;
+    }
+
+    type = capture_get_u16(p, 12);
+    if (type == ETHTYPE_IP)
+    {
+        proto = pbuf_get_at(p, SIZEOF_ETH_HDR + 9U);
+        l4    = (u16_t)(SIZEOF_ETH_HDR + ((pbuf_get_at(p, SIZEOF_ETH_HDR) & 0x0FU) * 4U));
+    }
+#if LWIP_IPV6
+    else if (type == ETHTYPE_IPV6)
+    {
+        /* Extension headers are not followed */
+        proto = pbuf_get_at(p, SIZEOF_ETH_HDR + 6U);
+        l4    = SIZEOF_ETH_HDR + 40U;
+    }
+#endif
+    else
+    {
+        return 0;
+    }
+
+    if ((filter->proto != 0U) && (proto != filter->proto))
+    {
+        return 0;
+    }
+
+    if (filter->port != 0U)
+    {
+        if (((proto != IP_PROTO_TCP) && (proto != IP_PROTO_UDP)) || (p->tot_len < l4 + 4U))
+        {
+            return 0;
+        }
+        if ((capture_get_u16(p, l4) != filter->port) && (capture_get_u16(p, (u16_t)(l4 + 2U)) != filter->port))
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * Captures an Ethernet frame if it passes the filter. Called by the netif
+ * driver for every received and sent frame, from any task.
+ */
+void netif_capture(const struct pbuf *p, enum netif_capture_dir dir)
+{
+    struct netif_capture_filter filter = capture_filter;
+    struct netif_capture_record *record;
+    u32_t seq;
+
+    if (!filter.enabled || !capture_match(p, &filter))
+    {
+        return;
+    }
+
+    seq    = capture_claim();
+    record = &capture_ring[seq & (NETIF_CAPTURE_RECORDS - 1U)];
+
+    record->seq = 0;
+    __DMB();
+    record->time_ms  = sys_now();
+    record->orig_len = p->tot_len;
+    record->cap_len  = pbuf_copy_partial(p, record->data, LWIP_MIN(filter.snaplen, NETIF_CAPTURE_SNAPLEN), 0);
+    record->dir      = (u8_t)dir;
+    __DMB();
+    record->seq = seq + 1U;
+}
+
+/** Sets the capture filter, takes effect with the next frame */
+void netif_capture_set_filter(const struct netif_capture_filter *filter)
+{
+    capture_filter = *filter;
+    if ((capture_filter.snaplen == 0U) || (capture_filter.snaplen > NETIF_CAPTURE_SNAPLEN))
+    {
+        capture_filter.snaplen = NETIF_CAPTURE_SNAPLEN;
+    }
+}
+
+void netif_capture_get_filter(struct netif_capture_filter *filter)
+{
+    *filter = capture_filter;
+}
+
+/** Returns the number of frames captured so far, the newest has sequence number count - 1 */
+u32_t netif_capture_count(void)
+{
+    return capture_next;
+}
+
+/**
+ * Copies the record of frame seq. Returns 0 if the frame has been overwritten
+ * or is still being written.
+ */
+int netif_capture_read(u32_t seq, struct netif_capture_record *record)
+{
+    const struct netif_capture_record *src = &capture_ring[seq & (NETIF_CAPTURE_RECORDS - 1U)];
+
+    if (src->seq != seq + 1U)
+    {
+        return 0;
+    }
+    __DMB();
+    memcpy(record, (const void *)src, sizeof(*record));
+    __DMB();
+
+    return (src->seq == seq + 1U) && (record->seq == seq + 1U);
+}
+
+#endif /* LWIP_NETIF_CAPTURE */
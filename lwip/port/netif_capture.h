@@ -0,0 +1,83 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * In-RAM packet capture ring.
+ *
+ * The netif driver calls netif_capture() for every frame it receives or
+ * sends. Frames that pass the filter have their first snaplen bytes copied
+ * into a fixed ring of records together with a timestamp, the oldest records
+ * are overwritten. Writers claim records with an atomic increment and never
+ * block, so the hooks can run in any task. Readers copy records out with
+ * netif_capture_read(), which detects records overwritten during the copy.
+ */
+
+#ifndef NETIF_CAPTURE_H
+#define NETIF_CAPTURE_H
+
+#include "lwip/opt.h"
+#include "lwip/pbuf.h"
+
+/** LWIP_NETIF_CAPTURE==1: Compile the packet capture ring */
+#ifndef LWIP_NETIF_CAPTURE
+#define LWIP_NETIF_CAPTURE 0
+#endif
+
+/** Number of records in the ring, must be a power of two */
+#ifndef NETIF_CAPTURE_RECORDS
+#define NETIF_CAPTURE_RECORDS 64
+#endif
+
+/** Maximum number of bytes kept of each frame, enough for Ethernet, IPv4 and TCP headers with options */
+#ifndef NETIF_CAPTURE_SNAPLEN
+#define NETIF_CAPTURE_SNAPLEN 96
+#endif
+
+#if LWIP_NETIF_CAPTURE
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum netif_capture_dir
+{
+    NETIF_CAPTURE_IN = 0,
+    NETIF_CAPTURE_OUT
+};
+
+/* Frames are captured if they match every non-zero field */
+struct netif_capture_filter
+{
+    u8_t enabled; /* 0 pauses the capture, the default */
+    u8_t proto;   /* IP protocol number, 0 for any frame */
+    u16_t port;   /* TCP or UDP source or destination port, 0 for any */
+    u16_t snaplen; /* Bytes to keep of each frame, at most NETIF_CAPTURE_SNAPLEN */
+};
+
+struct netif_capture_record
+{
+    volatile u32_t seq; /* Sequence number of the frame plus one, 0 while being written */
+    u32_t time_ms;      /* sys_now() when the frame was captured */
+    u16_t orig_len;     /* Length of the frame on the wire */
+    u16_t cap_len;      /* Number of bytes in data */
+    u8_t dir;           /* enum netif_capture_dir */
+    u8_t data[NETIF_CAPTURE_SNAPLEN];
+};
+
+void netif_capture(const struct pbuf *p, enum netif_capture_dir dir);
+void netif_capture_set_filter(const struct netif_capture_filter *filter);
+void netif_capture_get_filter(struct netif_capture_filter *filter);
+u32_t netif_capture_count(void);
+int netif_capture_read(u32_t seq, struct netif_capture_record *record);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LWIP_NETIF_CAPTURE */
+
+#endif /* NETIF_CAPTURE_H */
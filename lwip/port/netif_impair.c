@@ -0,0 +1,396 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Link impairment shim, see netif_impair.h.
+ *
+ * Received frames are moved to the tcpip thread first, so both delay lines
+ * are only touched with the core lock held and need no locking of their own.
+ * Each line is a small array of frames with their due time; one sys_timeout
+ * fires at the earliest due time and hands the due frames on in order. Frames
+ * due at the same time keep their arrival order.
+ */
+
+#include "netif_impair.h"
+
+#if LWIP_NETIF_IMPAIR
+
+#include "lwip/ip.h"
+#include "lwip/pbuf.h"
+#include "lwip/sys.h"
+#include "lwip/tcpip.h"
+#include "lwip/timeouts.h"
+#include "netif/ethernet.h"
+
+#include <string.h>
+
+struct impair_slot
+{
+    struct pbuf *p;
+    u32_t due; /* sys_now() time to hand the frame on */
+    u32_t seq; /* Arrival order, breaks ties between equal due times */
+};
+
+struct impair_line
+{
+    struct netif_impair_profile profile;
+    struct netif_impair_stats stats;
+    struct impair_slot slots[NETIF_IMPAIR_QUEUE_LEN];
+    u32_t queued;
+    u32_t seq;
+    u32_t link_free_us; /* Time the rate limited link finishes the previous frame */
+};
+
+static struct
+{
+    struct netif *netif;
+    netif_input_fn input;
+    netif_linkoutput_fn linkoutput;
+    struct impair_line line[NETIF_IMPAIR_DIRS];
+} impair;
+
+static void impair_timer(void *arg);
+
+static int impair_passthrough(const struct impair_line *line)
+{
+    const struct netif_impair_profile *profile = &line->profile;
+
+    /* Queued frames go first, otherwise clearing a profile would reorder them */
+    return (line->queued == 0U) && (profile->rate_kbps == 0U) && (profile->delay_ms == 0U) &&
+           (profile->jitter_ms == 0U) && (profile->loss_permille == 0U) && (profile->reorder_permille == 0U);
+}
+
+static void impair_deliver(enum netif_impair_dir dir, struct pbuf *p)
+{
+    struct impair_line *line = &impair.line[dir];
+
+    line->stats.packets++;
+    line->stats.bytes += p->tot_len;
+
+    if (dir == NETIF_IMPAIR_TX)
+    {
+        (void)impair.linkoutput(impair.netif, p);
+        /* Drop the reference taken in impair_linkoutput() */
+        pbuf_free(p);
+    }
+    else
+    {
+#if LWIP_ETHERNET
+        if ((impair.netif->flags & (NETIF_FLAG_ETHARP | NETIF_FLAG_ETHERNET)) != 0U)
+        {
+            (void)ethernet_input(p, impair.netif);
+        }
+        else
+#endif
+        if (ip_input(p, impair.netif) != ERR_OK)
+        {
+            pbuf_free(p);
+        }
+    }
+}
+
+/* Re-arms the timer for the earliest queued frame */
+static void impair_schedule(void)
+{
+    u32_t now  = sys_now();
+    u32_t wait = 0xFFFFFFFFUL;
+    u32_t dir;
+    u32_t i;
+
+    sys_untimeout(impair_timer, NULL);
+
+    for (dir = 0; dir < (u32_t)NETIF_IMPAIR_DIRS; dir++)
+    {
+        for (i = 0; i < NETIF_IMPAIR_QUEUE_LEN; i++)
+        {
+            const struct impair_slot *slot = &impair.line[dir].slots[i];
+
+            if (slot->p == NULL)
+            {
+                continue;
+            }
+            if ((s32_t)(slot->due - now) <= 0)
+            {
+                wait = 0;
+            }
+            else if ((slot->due - now) < wait)
+            {
+                wait = slot->due - now;
+            }
+        }
+    }
+
+    if (wait != 0xFFFFFFFFUL)
+    {
+        sys_timeout(wait, impair_timer, NULL);
+    }
+}
+
+/* Returns the slot of the next frame of the line that is due at now, or NULL */
+static struct impair_slot *impair_next_due(struct impair_line *line, u32_t now)
+{
+    struct impair_slot *next = NULL;
+    u32_t i;
+
+    for (i = 0; i < NETIF_IMPAIR_QUEUE_LEN; i++)
+    {
+        struct impair_slot *slot = &line->slots[i];
+
+        if ((slot->p == NULL) || ((s32_t)(slot->due - now) > 0))
+        {
+            continue;
+        }
+        if ((next == NULL) || ((s32_t)(slot->due - next->due) < 0) ||
+            ((slot->due == next->due) && ((s32_t)(slot->seq - next->seq) < 0)))
+        {
+            next = slot;
+        }
+    }
+
+    return next;
+}
+
+static void impair_timer(void *arg)
+{
+    struct impair_slot *slot;
+    struct pbuf *p;
+    u32_t now = sys_now();
+    u32_t dir;
+
+    LWIP_UNUSED_ARG(arg);
+
+    for (dir = 0; dir < (u32_t)NETIF_IMPAIR_DIRS; dir++)
+    {
+        while ((slot = impair_next_due(&impair.line[dir], now)) != NULL)
+        {
+            p       = slot->p;
+            slot->p = NULL;
+            impair.line[dir].queued--;
+            impair_deliver((enum netif_impair_dir)dir, p);
+        }
+    }
+
+    impair_schedule();
+}
+
+/* Draws a random number below range */
+static u32_t impair_rand(u32_t range)
+{
+    return ((u32_t)LWIP_RAND()) % range;
+}
+
+/* Queues a frame in the delay line, returns 0 if the frame is dropped instead */
+static int impair_enqueue(enum netif_impair_dir dir, struct pbuf *p)
+{
+    struct impair_line *line                   = &impair.line[dir];
+    const struct netif_impair_profile *profile = &line->profile;
+    u32_t now                                  = sys_now();
+    u32_t now_us                               = now * 1000U;
+    u32_t start_us                             = now_us;
+    u32_t tx_us                                = 0;
+    u32_t delay_us;
+    s32_t delay_ms;
+    u32_t i;
+
+    if ((profile->loss_permille != 0U) && (impair_rand(1000U) < profile->loss_permille))
+    {
+        line->stats.lost++;
+        return 0;
+    }
+
+    if (line->queued >= NETIF_IMPAIR_QUEUE_LEN)
+    {
+        line->stats.overflow++;
+        return 0;
+    }
+
+    /* Serialization: the frame starts when the link has sent the previous one */
+    if (profile->rate_kbps != 0U)
+    {
+        if ((s32_t)(line->link_free_us - now_us) > 0)
+        {
+            start_us = line->link_free_us;
+        }
+        tx_us              = ((u32_t)p->tot_len * 8000U) / profile->rate_kbps;
+        line->link_free_us = start_us + tx_us;
+    }
+
+    delay_ms = (s32_t)profile->delay_ms;
+    if (profile->jitter_ms != 0U)
+    {
+        delay_ms += (s32_t)impair_rand(2U * profile->jitter_ms + 1U) - (s32_t)profile->jitter_ms;
+        if (delay_ms < 0)
+        {
+            delay_ms = 0;
+        }
+    }
+    if ((profile->reorder_permille != 0U) && (impair_rand(1000U) < profile->reorder_permille))
+    {
+        /* Overtakes the frames that are still in flight */
+        delay_ms = 0;
+        line->stats.reordered++;
+    }
+    delay_us = (u32_t)delay_ms * 1000U;
+
+    for (i = 0; i < NETIF_IMPAIR_QUEUE_LEN; i++)
+    {
+        if (line->slots[i].p == NULL)
+        {
+            break;
+        }
+    }
+
+    line->slots[i].p   = p;
+    line->slots[i].due = now + ((start_us - now_us) + tx_us + delay_us + 999U) / 1000U;
+    line->slots[i].seq = line->seq++;
+    line->queued++;
+    if (line->queued > line->stats.max_queued)
+    {
+        line->stats.max_queued = line->queued;
+    }
+
+    impair_schedule();
+
+    return 1;
+}
+
+/* Input function of the tcpip thread message posted by impair_input() */
+static err_t impair_input_core(struct pbuf *p, struct netif *inp)
+{
+    LWIP_UNUSED_ARG(inp);
+
+    if (impair_passthrough(&impair.line[NETIF_IMPAIR_RX]))
+    {
+        impair_deliver(NETIF_IMPAIR_RX, p);
+    }
+    else if (!impair_enqueue(NETIF_IMPAIR_RX, p))
+    {
+        pbuf_free(p);
+    }
+
+    return ERR_OK;
+}
+
+/* Replaces netif->input (tcpip_input) of the attached netif */
+static err_t impair_input(struct pbuf *p, struct netif *inp)
+{
+    return tcpip_inpkt(p, inp, impair_input_core);
+}
+
+/* Replaces netif->linkoutput of the attached netif */
+static err_t impair_linkoutput(struct netif *netif, struct pbuf *p)
+{
+    if (impair_passthrough(&impair.line[NETIF_IMPAIR_TX]))
+    {
+        impair.line[NETIF_IMPAIR_TX].stats.packets++;
+        impair.line[NETIF_IMPAIR_TX].stats.bytes += p->tot_len;
+        return impair.linkoutput(netif, p);
+    }
+
+    /* The caller frees p after we return, keep it alive until it is sent */
+    pbuf_ref(p);
+    if (!impair_enqueue(NETIF_IMPAIR_TX, p))
+    {
+        pbuf_free(p);
+    }
+
+    /* Dropped frames are lost on the air as far as the stack can tell */
+    return ERR_OK;
+}
+
+/**
+ * Hooks the impairment shim into a netif. Must be called with the core lock
+ * held, after netif->input and netif->linkoutput are set.
+ */
+err_t netif_impair_attach(struct netif *netif)
+{
+    LWIP_ASSERT_CORE_LOCKED();
+    LWIP_ERROR("netif_impair_attach: netif != NULL", netif != NULL, return ERR_ARG);
+
+    if (impair.netif != NULL)
+    {
+        return ERR_USE;
+    }
+
+    memset(impair.line, 0, sizeof(impair.line));
+    impair.netif      = netif;
+    impair.input      = netif->input;
+    impair.linkoutput = netif->linkoutput;
+    netif->input      = impair_input;
+    netif->linkoutput = impair_linkoutput;
+
+    return ERR_OK;
+}
+
+/** Drops the queued frames and restores the netif. Must be called with the core lock held. */
+void netif_impair_detach(void)
+{
+    u32_t dir;
+    u32_t i;
+
+    LWIP_ASSERT_CORE_LOCKED();
+
+    if (impair.netif == NULL)
+    {
+        return;
+    }
+
+    sys_untimeout(impair_timer, NULL);
+
+    for (dir = 0; dir < (u32_t)NETIF_IMPAIR_DIRS; dir++)
+    {
+        for (i = 0; i < NETIF_IMPAIR_QUEUE_LEN; i++)
+        {
+            if (impair.line[dir].slots[i].p != NULL)
+            {
+                pbuf_free(impair.line[dir].slots[i].p);
+                impair.line[dir].slots[i].p = NULL;
+            }
+        }
+        impair.line[dir].queued = 0;
+    }
+
+    impair.netif->input      = impair.input;
+    impair.netif->linkoutput = impair.linkoutput;
+    impair.netif             = NULL;
+}
+
+/** Sets the impairment of one direction. Must be called with the core lock held. */
+err_t netif_impair_set_profile(enum netif_impair_dir dir, const struct netif_impair_profile *profile)
+{
+    LWIP_ASSERT_CORE_LOCKED();
+    LWIP_ERROR("netif_impair_set_profile: invalid arguments",
+               (dir < NETIF_IMPAIR_DIRS) && (profile != NULL) && (profile->loss_permille <= 1000U) &&
+                   (profile->reorder_permille <= 1000U),
+               return ERR_ARG);
+
+    impair.line[dir].profile = *profile;
+    /* Frames already queued keep their due time */
+    impair.line[dir].link_free_us = sys_now() * 1000U;
+
+    return ERR_OK;
+}
+
+/** Gets the impairment of one direction. Must be called with the core lock held. */
+void netif_impair_get_profile(enum netif_impair_dir dir, struct netif_impair_profile *profile)
+{
+    LWIP_ASSERT_CORE_LOCKED();
+    LWIP_ASSERT("netif_impair_get_profile: invalid dir", dir < NETIF_IMPAIR_DIRS);
+
+    *profile = impair.line[dir].profile;
+}
+
+/** Gets the counters of one direction. Must be called with the core lock held. */
+void netif_impair_get_stats(enum netif_impair_dir dir, struct netif_impair_stats *stats)
+{
+    LWIP_ASSERT_CORE_LOCKED();
+    LWIP_ASSERT("netif_impair_get_stats: invalid dir", dir < NETIF_IMPAIR_DIRS);
+
+    *stats = impair.line[dir].stats;
+}
+
+#endif /* LWIP_NETIF_IMPAIR */
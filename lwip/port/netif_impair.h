@@ -0,0 +1,79 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Link impairment shim for benchmarking the stack over a degraded link.
+ *
+ * netif_impair_attach() hooks the input and linkoutput functions of a netif
+ * and passes every frame through a delay line in each direction, which
+ * applies a rate limit, a fixed delay with jitter, random loss and random
+ * reordering. With the default all zero profile frames pass straight
+ * through. Only one netif can be attached at a time.
+ */
+
+#ifndef NETIF_IMPAIR_H
+#define NETIF_IMPAIR_H
+
+#include "lwip/opt.h"
+#include "lwip/netif.h"
+
+/** LWIP_NETIF_IMPAIR==1: Compile the link impairment shim */
+#ifndef LWIP_NETIF_IMPAIR
+#define LWIP_NETIF_IMPAIR 0
+#endif
+
+/** Number of frames each direction can hold in its delay line */
+#ifndef NETIF_IMPAIR_QUEUE_LEN
+#define NETIF_IMPAIR_QUEUE_LEN 16
+#endif
+
+#if LWIP_NETIF_IMPAIR
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum netif_impair_dir
+{
+    NETIF_IMPAIR_RX = 0,
+    NETIF_IMPAIR_TX,
+    NETIF_IMPAIR_DIRS
+};
+
+/* Impairment of one direction, all zero means no impairment */
+struct netif_impair_profile
+{
+    u32_t rate_kbps;        /* Link rate, 0 for unlimited */
+    u16_t delay_ms;         /* Fixed one way delay */
+    u16_t jitter_ms;        /* Uniform random delay variation, +/- */
+    u16_t loss_permille;    /* Probability of dropping a frame */
+    u16_t reorder_permille; /* Probability of sending a frame without the delay */
+};
+
+struct netif_impair_stats
+{
+    u32_t packets;      /* Frames delivered */
+    u32_t bytes;        /* Bytes delivered */
+    u32_t lost;         /* Frames dropped by loss_permille */
+    u32_t overflow;     /* Frames dropped because the delay line was full */
+    u32_t reordered;    /* Frames that skipped the delay */
+    u32_t max_queued;   /* High water mark of the delay line */
+};
+
+err_t netif_impair_attach(struct netif *netif);
+void netif_impair_detach(void);
+err_t netif_impair_set_profile(enum netif_impair_dir dir, const struct netif_impair_profile *profile);
+void netif_impair_get_profile(enum netif_impair_dir dir, struct netif_impair_profile *profile);
+void netif_impair_get_stats(enum netif_impair_dir dir, struct netif_impair_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LWIP_NETIF_IMPAIR */
+
+#endif /* NETIF_IMPAIR_H */
@@ -53,13 +53,56 @@
 
 #endif
 
+/**
+ * SYS_MBOX_RING==1: Implement sys_mbox_t with a ring of message pointers and
+ * task notification wakeups instead of a FreeRTOS queue. Requires
+ * configTASK_NOTIFICATION_ARRAY_ENTRIES > SYS_MBOX_NOTIFY_INDEX.
+ */
+#ifndef SYS_MBOX_RING
+#define SYS_MBOX_RING 0
+#endif
+
+/** Task notification index the ring mailbox consumer sleeps on */
+#ifndef SYS_MBOX_NOTIFY_INDEX
+#define SYS_MBOX_NOTIFY_INDEX 1
+#endif
+
+/** Messages the ring mailbox consumer takes from the ring at a time */
+#ifndef SYS_MBOX_FETCH_BATCH
+#define SYS_MBOX_FETCH_BATCH 8
+#endif
+
+/**
+ * SYS_CORE_LOCK_PROFILE==1: Record wait and hold time histograms of the tcpip
+ * core lock per LOCK_TCPIP_CORE() call site, using the DWT cycle counter.
+ */
+#ifndef SYS_CORE_LOCK_PROFILE
+#define SYS_CORE_LOCK_PROFILE 0
+#endif
+
+/** Number of distinct call sites tracked, later sites are summed into one extra slot */
+#ifndef SYS_CORE_LOCK_PROFILE_SITES
+#define SYS_CORE_LOCK_PROFILE_SITES 8
+#endif
+
+/** Histogram bucket i counts durations below 2^i us, the last one everything longer */
+#define SYS_CORE_LOCK_PROFILE_BUCKETS 12
+
+#if SYS_MBOX_RING
+#define SYS_MBOX_NULL                  ((struct sys_mbox_ring *)NULL)
+#else
 #define SYS_MBOX_NULL                  ((QueueHandle_t)NULL)
+#endif
 #define SYS_SEM_NULL                   ((SemaphoreHandle_t)NULL)
 #define SYS_DEFAULT_THREAD_STACK_DEPTH configMINIMAL_STACK_SIZE
 #if !NO_SYS
 typedef SemaphoreHandle_t sys_sem_t;
 typedef SemaphoreHandle_t sys_mutex_t;
+#if SYS_MBOX_RING
+typedef struct sys_mbox_ring *sys_mbox_t;
+#else
 typedef QueueHandle_t sys_mbox_t;
+#endif
 typedef TaskHandle_t sys_thread_t;
 
 #define sys_mbox_valid(x)       (((*x) == NULL) ? pdFALSE : pdTRUE)
@@ -89,6 +132,32 @@ extern "C" {
 #endif /* __cplusplus */
 
 void sys_assert(const char *pcMessage);
+uint32_t sys_now_us(void);
+
+#if !NO_SYS && LWIP_TCPIP_CORE_LOCKING && SYS_CORE_LOCK_PROFILE
+/** Core lock statistics of one LOCK_TCPIP_CORE() call site */
+struct sys_core_lock_site
+{
+    void *caller; /* Return address of the locking call, NULL for the overflow slot */
+    uint32_t count;
+    uint32_t contended;
+    uint32_t max_hold_us;
+    uint32_t wait_hist[SYS_CORE_LOCK_PROFILE_BUCKETS];
+    uint32_t hold_hist[SYS_CORE_LOCK_PROFILE_BUCKETS];
+};
+
+/** Longest core lock hold seen since the last reset */
+struct sys_core_lock_max_hold
+{
+    void *caller;
+    uint32_t hold_us;
+    char task[configMAX_TASK_NAME_LEN];
+};
+
+uint8_t sys_core_lock_profile_site(uint32_t index, struct sys_core_lock_site *site);
+void sys_core_lock_profile_max_hold(struct sys_core_lock_max_hold *max_hold);
+void sys_core_lock_profile_reset(void);
+#endif
 
 #if defined(__cplusplus)
 }
@@ -63,6 +63,10 @@
 /* ------------------------ SDK includes --------------------------------- */
 #include "fsl_common.h"
 
+#if !NO_SYS && SYS_MBOX_RING
+#include "sys_mbox_ring.h"
+#endif
+
 #ifndef errno
 int errno = 0;
 #endif
@@ -96,6 +100,387 @@ u32_t lwip_rand(void)
 }
 
 #if !NO_SYS
+#if SYS_MBOX_RING
+/*
+ * Ring mailbox.
+ *
+ * The messages are kept in the ring of sys_mbox_ring.h. Producers push with
+ * the interrupt mask raised for a few stores, which is cheaper than a queue
+ * send and never leaves the consumer waiting behind a preempted producer.
+ * The consumer pops without masking interrupts.
+ *
+ * A mailbox has one consumer at a time, like all lwIP mailboxes. The consumer
+ * only blocks when the ring is empty: it publishes its task handle in
+ * "waiter" and sleeps on task notification SYS_MBOX_NOTIFY_INDEX. Producers
+ * send a notification only when a waiter is published, so a burst of posts
+ * costs one wakeup and the consumer drains the ring without kernel calls.
+ * The consumer takes up to SYS_MBOX_FETCH_BATCH messages from the ring at a
+ * time and hands them out from "batch" on the following fetches.
+ *
+ * sys_mbox_post() blocks on the counting "space" semaphore while the ring is
+ * full. Once the consumer has drained the ring to half, it gives one count
+ * per blocked producer, so producers refill the ring in bursts instead of
+ * waking for every freed cell. "space_given" counts the gives not taken yet.
+ */
+struct sys_mbox_ring
+{
+    TaskHandle_t volatile waiter;
+    SemaphoreHandle_t space;
+    volatile u32_t full_waiters;
+    u32_t space_given;
+    u32_t batch_next;
+    u32_t batch_len;
+    void *batch[SYS_MBOX_FETCH_BATCH];
+    struct sys_mbox_cells *cells;
+};
+
+/* Pushes a message, returns false if the ring is full. Counts a waiting producer if wait is set. */
+static bool sys_mbox_push(struct sys_mbox_ring *ring, void *msg, bool wait)
+{
+    u32_t ulMask;
+    int pushed;
+
+    ulMask = portSET_INTERRUPT_MASK_FROM_ISR();
+    pushed = sys_mbox_ring_push(ring->cells, msg);
+    if (!pushed && wait)
+    {
+        ring->full_waiters++;
+    }
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(ulMask);
+
+    return (pushed != 0);
+}
+
+/* Wakes the consumer if it sleeps (or is about to sleep) on an empty ring */
+static void sys_mbox_wake(struct sys_mbox_ring *ring)
+{
+    TaskHandle_t waiter;
+
+    /* Pairs with the barrier between publishing the waiter and checking the ring */
+    __DMB();
+    waiter = ring->waiter;
+    if (waiter == NULL)
+    {
+        return;
+    }
+
+#ifdef __CA7_REV
+    if (SystemGetIRQNestingLevel())
+#else
+    if (__get_IPSR())
+#endif
+    {
+        portBASE_TYPE taskToWake = pdFALSE;
+
+        vTaskNotifyGiveIndexedFromISR(waiter, SYS_MBOX_NOTIFY_INDEX, &taskToWake);
+        portYIELD_FROM_ISR(taskToWake);
+    }
+    else
+    {
+        (void)xTaskNotifyGiveIndexed(waiter, SYS_MBOX_NOTIFY_INDEX);
+    }
+}
+
+/* Lets the producers blocked on a full ring retry once it has drained to half */
+static void sys_mbox_release_space(struct sys_mbox_ring *ring)
+{
+    u32_t ulMask;
+    u32_t gives = 0U;
+
+    ulMask = portSET_INTERRUPT_MASK_FROM_ISR();
+    if ((ring->full_waiters > ring->space_given) && sys_mbox_ring_drained(ring->cells))
+    {
+        gives             = ring->full_waiters - ring->space_given;
+        ring->space_given = ring->full_waiters;
+    }
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(ulMask);
+
+    while (gives-- > 0U)
+    {
+        (void)xSemaphoreGive(ring->space);
+    }
+}
+
+/* Fetches the next message of the batch, taking a new batch from the ring when it is used up */
+static bool sys_mbox_pop(struct sys_mbox_ring *ring, void **msg)
+{
+    if (ring->batch_next == ring->batch_len)
+    {
+        ring->batch_next = 0U;
+        ring->batch_len  = sys_mbox_ring_pop_batch(ring->cells, ring->batch, SYS_MBOX_FETCH_BATCH);
+        if (ring->batch_len == 0U)
+        {
+            return false;
+        }
+        sys_mbox_release_space(ring);
+    }
+
+    *msg = ring->batch[ring->batch_next++];
+    return true;
+}
+
+/*---------------------------------------------------------------------------*
+ * Routine:  sys_mbox_new
+ *---------------------------------------------------------------------------*
+ * Description:
+ *      Creates a new mailbox. The ring is rounded up to a power of two
+ *      number of cells.
+ * Inputs:
+ *      int size                -- Size of elements in the mailbox
+ * Outputs:
+ *      sys_mbox_t              -- Handle to new mailbox
+ *---------------------------------------------------------------------------*/
+err_t sys_mbox_new(sys_mbox_t *pxMailBox, int iSize)
+{
+    struct sys_mbox_ring *ring;
+    u32_t cells = sys_mbox_ring_cells((u32_t)iSize);
+
+    ring = (struct sys_mbox_ring *)pvPortMalloc(sizeof(struct sys_mbox_ring) + sizeof(struct sys_mbox_cells) +
+                                                (cells * sizeof(void *)));
+    if (ring == NULL)
+    {
+        *pxMailBox = SYS_MBOX_NULL;
+        SYS_STATS_INC(mbox.err);
+        return ERR_MEM;
+    }
+
+    /* One count per blocked producer */
+    ring->space = xSemaphoreCreateCounting(0xFFFFU, 0U);
+    if (ring->space == NULL)
+    {
+        vPortFree(ring);
+        *pxMailBox = SYS_MBOX_NULL;
+        SYS_STATS_INC(mbox.err);
+        return ERR_MEM;
+    }
+
+    ring->waiter       = NULL;
+    ring->full_waiters = 0U;
+    ring->space_given  = 0U;
+    ring->batch_next   = 0U;
+    ring->batch_len    = 0U;
+    ring->cells        = (struct sys_mbox_cells *)(ring + 1);
+    sys_mbox_ring_init(ring->cells, cells);
+
+    *pxMailBox = ring;
+    SYS_STATS_INC_USED(mbox);
+    return ERR_OK;
+}
+
+/*---------------------------------------------------------------------------*
+ * Routine:  sys_mbox_free
+ *---------------------------------------------------------------------------*
+ * Description:
+ *      Deallocates a mailbox. If there are messages still present in the
+ *      mailbox when the mailbox is deallocated, it is an indication of a
+ *      programming error in lwIP and the developer should be notified.
+ * Inputs:
+ *      sys_mbox_t mbox         -- Handle of mailbox
+ *---------------------------------------------------------------------------*/
+void sys_mbox_free(sys_mbox_t *pxMailBox)
+{
+    struct sys_mbox_ring *ring = *pxMailBox;
+    u32_t ulMessagesWaiting    = sys_mbox_ring_count(ring->cells) + (ring->batch_len - ring->batch_next);
+
+    configASSERT((ulMessagesWaiting == 0));
+
+#if SYS_STATS
+    {
+        if (ulMessagesWaiting != 0UL)
+        {
+            SYS_STATS_INC(mbox.err);
+        }
+
+        SYS_STATS_DEC(mbox.used);
+    }
+#endif /* SYS_STATS */
+
+    vSemaphoreDelete(ring->space);
+    vPortFree(ring);
+}
+
+/*---------------------------------------------------------------------------*
+ * Routine:  sys_mbox_post
+ *---------------------------------------------------------------------------*
+ * Description:
+ *      Post the "msg" to the mailbox. If the ring is full, the caller
+ *      blocks until the consumer has drained it to half.
+ * Inputs:
+ *      sys_mbox_t mbox         -- Handle of mailbox
+ *      void *data              -- Pointer to data to post
+ *---------------------------------------------------------------------------*/
+void sys_mbox_post(sys_mbox_t *pxMailBox, void *pxMessageToPost)
+{
+    struct sys_mbox_ring *ring = *pxMailBox;
+    u32_t ulMask;
+
+    while (!sys_mbox_push(ring, pxMessageToPost, true))
+    {
+        /* Counted in full_waiters before the ring could drain, so the give is not missed */
+        (void)xSemaphoreTake(ring->space, portMAX_DELAY);
+
+        ulMask = portSET_INTERRUPT_MASK_FROM_ISR();
+        ring->full_waiters--;
+        ring->space_given--;
+        portCLEAR_INTERRUPT_MASK_FROM_ISR(ulMask);
+    }
+    sys_mbox_wake(ring);
+}
+
+/*---------------------------------------------------------------------------*
+ * Routine:  sys_mbox_trypost
+ *---------------------------------------------------------------------------*
+ * Description:
+ *      Try to post the "msg" to the mailbox.  Returns immediately with
+ *      error if cannot. Safe to call from ISR.
+ * Inputs:
+ *      sys_mbox_t mbox         -- Handle of mailbox
+ *      void *msg               -- Pointer to data to post
+ * Outputs:
+ *      err_t                   -- ERR_OK if message posted, else ERR_MEM
+ *                                  if not.
+ *---------------------------------------------------------------------------*/
+err_t sys_mbox_trypost(sys_mbox_t *pxMailBox, void *pxMessageToPost)
+{
+    if (!sys_mbox_push(*pxMailBox, pxMessageToPost, false))
+    {
+        /* The ring was already full. */
+        SYS_STATS_INC(mbox.err);
+        return ERR_MEM;
+    }
+    sys_mbox_wake(*pxMailBox);
+    return ERR_OK;
+}
+
+/*---------------------------------------------------------------------------*
+ * Routine:  sys_mbox_trypost_fromisr
+ *---------------------------------------------------------------------------*
+ * Description:
+ *      Try to post the "msg" to the mailbox.  Returns immediately with
+ *      error if cannot. To be be used from ISR.
+ * Inputs:
+ *      sys_mbox_t mbox         -- Handle of mailbox
+ *      void *msg               -- Pointer to data to post
+ * Outputs:
+ *      err_t                   -- ERR_OK if message posted, else ERR_MEM
+ *                                  if not.
+ *---------------------------------------------------------------------------*/
+err_t sys_mbox_trypost_fromisr(sys_mbox_t *mbox, void *msg)
+{
+    return sys_mbox_trypost(mbox, msg);
+}
+
+/*---------------------------------------------------------------------------*
+ * Routine:  sys_arch_mbox_fetch
+ *---------------------------------------------------------------------------*
+ * Description:
+ *      Blocks the thread until a message arrives in the mailbox, but does
+ *      not block the thread longer than "timeout" milliseconds (similar to
+ *      the sys_arch_sem_wait() function). The "msg" argument is a result
+ *      parameter that is set by the function (i.e., by doing "*msg =
+ *      ptr"). The "msg" parameter maybe NULL to indicate that the message
+ *      should be dropped.
+ *
+ *      The return values are the same as for the sys_arch_sem_wait() function:
+ *      Number of milliseconds spent waiting or SYS_ARCH_TIMEOUT if there was a
+ *      timeout.
+ * Inputs:
+ *      sys_mbox_t mbox         -- Handle of mailbox
+ *      void **msg              -- Pointer to pointer to msg received
+ *      u32_t timeout           -- Number of milliseconds until timeout
+ * Outputs:
+ *      u32_t                   -- SYS_ARCH_TIMEOUT if timeout, else number
+ *                                  of milliseconds until received.
+ *---------------------------------------------------------------------------*/
+u32_t sys_arch_mbox_fetch(sys_mbox_t *pxMailBox, void **ppvBuffer, u32_t ulTimeOut)
+{
+    struct sys_mbox_ring *ring = *pxMailBox;
+    void *pvDummy;
+    TickType_t xStartTime, xElapsed;
+    TickType_t xTimeOutTicks = ulTimeOut / portTICK_PERIOD_MS;
+    bool received;
+
+    xStartTime = xTaskGetTickCount();
+
+    if (NULL == ppvBuffer)
+    {
+        ppvBuffer = &pvDummy;
+    }
+
+    received = sys_mbox_pop(ring, ppvBuffer);
+    if (!received)
+    {
+        LWIP_ASSERT("sys_arch_mbox_fetch: mailbox has another consumer",
+                    (ring->waiter == NULL) || (ring->waiter == xTaskGetCurrentTaskHandle()));
+
+        ring->waiter = xTaskGetCurrentTaskHandle();
+        /* Pairs with the barrier in sys_mbox_wake() */
+        __DMB();
+
+        while (!(received = sys_mbox_pop(ring, ppvBuffer)))
+        {
+            TickType_t xWait = portMAX_DELAY;
+
+            if (ulTimeOut != 0UL)
+            {
+                xElapsed = xTaskGetTickCount() - xStartTime;
+                if (xElapsed >= xTimeOutTicks)
+                {
+                    break;
+                }
+                xWait = xTimeOutTicks - xElapsed;
+            }
+
+            /* Notifications left over from messages already fetched just cause another pass */
+            (void)ulTaskNotifyTakeIndexed(SYS_MBOX_NOTIFY_INDEX, pdTRUE, xWait);
+        }
+
+        ring->waiter = NULL;
+    }
+
+    if (!received)
+    {
+        /* Timed out. */
+        *ppvBuffer = NULL;
+        return SYS_ARCH_TIMEOUT;
+    }
+
+    xElapsed = (xTaskGetTickCount() - xStartTime) * portTICK_PERIOD_MS;
+    if ((ulTimeOut == 0UL) && (xElapsed == 0UL))
+    {
+        xElapsed = 1UL;
+    }
+
+    return xElapsed;
+}
+
+/*---------------------------------------------------------------------------*
+ * Routine:  sys_arch_mbox_tryfetch
+ *---------------------------------------------------------------------------*
+ * Description:
+ *      Similar to sys_arch_mbox_fetch, but if message is not ready
+ *      immediately, we'll return with SYS_MBOX_EMPTY.  On success, 0 is
+ *      returned.
+ * Inputs:
+ *      sys_mbox_t mbox         -- Handle of mailbox
+ *      void **msg              -- Pointer to pointer to msg received
+ * Outputs:
+ *      u32_t                   -- SYS_MBOX_EMPTY if no messages.  Otherwise,
+ *                                  return ERR_OK.
+ *---------------------------------------------------------------------------*/
+u32_t sys_arch_mbox_tryfetch(sys_mbox_t *pxMailBox, void **ppvBuffer)
+{
+    void *pvDummy;
+
+    if (ppvBuffer == NULL)
+    {
+        ppvBuffer = &pvDummy;
+    }
+
+    return sys_mbox_pop(*pxMailBox, ppvBuffer) ? ERR_OK : SYS_MBOX_EMPTY;
+}
+
+#else /* SYS_MBOX_RING */
 /*---------------------------------------------------------------------------*
  * Routine:  sys_mbox_new
  *---------------------------------------------------------------------------*
@@ -344,6 +729,8 @@ u32_t sys_arch_mbox_tryfetch(sys_mbox_t *pxMailBox, void **ppvBuffer)
     return ulReturn;
 }
 
+#endif /* SYS_MBOX_RING */
+
 /*---------------------------------------------------------------------------*
  * Routine:  sys_sem_new
  *---------------------------------------------------------------------------*
@@ -530,6 +917,11 @@ void sys_sem_free(sys_sem_t *pxSemaphore)
  *---------------------------------------------------------------------------*/
 void sys_init(void)
 {
+#if LWIP_TCPIP_CORE_LOCKING && SYS_CORE_LOCK_PROFILE
+    /* Core lock profiler timestamps */
+    DCB->DEMCR |= DCB_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
 }
 
 u32_t sys_now(void)
@@ -537,6 +929,32 @@ u32_t sys_now(void)
     return xTaskGetTickCount() * portTICK_PERIOD_MS;
 }
 
+/* Microsecond time from the tick count and the SysTick down counter, wraps
+ * after about 71 minutes. Used for the lwiperf round trip times. */
+uint32_t sys_now_us(void)
+{
+    TickType_t ticks;
+    uint32_t load = SysTick->LOAD + 1U;
+    uint32_t val;
+
+    /* Read again if the tick count changed while sampling the counter */
+    do
+    {
+        ticks = xTaskGetTickCount();
+        val   = SysTick->VAL;
+    } while (ticks != xTaskGetTickCount());
+
+    /* The counter reloaded but the tick interrupt is still pending */
+    if ((SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) != 0U)
+    {
+        ticks++;
+        val = SysTick->VAL;
+    }
+
+    return (uint32_t)ticks * portTICK_PERIOD_MS * 1000U +
+           (uint32_t)(((uint64_t)(load - val) * portTICK_PERIOD_MS * 1000U) / load);
+}
+
 /*---------------------------------------------------------------------------*
  * Routine:  sys_thread_new
  *---------------------------------------------------------------------------*
@@ -649,6 +1067,148 @@ void sys_arch_unprotect(sys_prot_t xValue)
 static u8_t lwip_core_lock_count;
 static TaskHandle_t lwip_core_lock_holder_thread;
 
+#if SYS_CORE_LOCK_PROFILE
+/*
+ * Core lock profiler. The statistics are only updated by the task holding the
+ * core lock, so the lock itself protects them. Wait time is measured around
+ * the blocking take (an uncontended lock is counted as zero wait), hold time
+ * from the outermost lock to the matching unlock. Both are read from the DWT
+ * cycle counter, enabled in sys_init().
+ */
+static struct sys_core_lock_site lwip_core_lock_sites[SYS_CORE_LOCK_PROFILE_SITES + 1];
+static struct sys_core_lock_max_hold lwip_core_lock_max_hold;
+static struct sys_core_lock_site *lwip_core_lock_site;
+static u32_t lwip_core_lock_start;
+
+static u32_t sys_core_lock_cycles_to_us(u32_t cycles)
+{
+    extern uint32_t SystemCoreClock;
+
+    return cycles / (SystemCoreClock / 1000000U);
+}
+
+static u32_t sys_core_lock_bucket(u32_t us)
+{
+    u32_t bucket = 32U - __CLZ(us);
+
+    return (bucket < SYS_CORE_LOCK_PROFILE_BUCKETS) ? bucket : (SYS_CORE_LOCK_PROFILE_BUCKETS - 1U);
+}
+
+/* Finds or allocates the slot of a call site, the last slot collects the overflow */
+static struct sys_core_lock_site *sys_core_lock_site_get(void *caller)
+{
+    u32_t i;
+
+    for (i = 0; i < SYS_CORE_LOCK_PROFILE_SITES; i++)
+    {
+        if (lwip_core_lock_sites[i].caller == caller)
+        {
+            return &lwip_core_lock_sites[i];
+        }
+        if (lwip_core_lock_sites[i].caller == NULL)
+        {
+            lwip_core_lock_sites[i].caller = caller;
+            return &lwip_core_lock_sites[i];
+        }
+    }
+
+    return &lwip_core_lock_sites[SYS_CORE_LOCK_PROFILE_SITES];
+}
+
+void sys_lock_tcpip_core(void)
+{
+    void *caller = __builtin_return_address(0);
+    u32_t wait   = 0;
+    u8_t contended;
+
+    contended = (xSemaphoreTake(lock_tcpip_core, 0) != pdPASS);
+    if (contended)
+    {
+        u32_t start = DWT->CYCCNT;
+
+        sys_mutex_lock(&lock_tcpip_core);
+        wait = DWT->CYCCNT - start;
+    }
+
+    if (lwip_core_lock_count == 0U)
+    {
+        struct sys_core_lock_site *site = sys_core_lock_site_get(caller);
+
+        lwip_core_lock_holder_thread = xTaskGetCurrentTaskHandle();
+        site->count++;
+        site->contended += contended;
+        site->wait_hist[sys_core_lock_bucket(sys_core_lock_cycles_to_us(wait))]++;
+        lwip_core_lock_site  = site;
+        lwip_core_lock_start = DWT->CYCCNT;
+    }
+    lwip_core_lock_count++;
+}
+
+void sys_unlock_tcpip_core(void)
+{
+    lwip_core_lock_count--;
+    if (lwip_core_lock_count == 0)
+    {
+        struct sys_core_lock_site *site = lwip_core_lock_site;
+        u32_t hold                      = sys_core_lock_cycles_to_us(DWT->CYCCNT - lwip_core_lock_start);
+
+        site->hold_hist[sys_core_lock_bucket(hold)]++;
+        if (hold > site->max_hold_us)
+        {
+            site->max_hold_us = hold;
+        }
+        if (hold > lwip_core_lock_max_hold.hold_us)
+        {
+            lwip_core_lock_max_hold.hold_us = hold;
+            lwip_core_lock_max_hold.caller  = site->caller;
+            strncpy(lwip_core_lock_max_hold.task, pcTaskGetName(NULL), sizeof(lwip_core_lock_max_hold.task) - 1U);
+        }
+        lwip_core_lock_holder_thread = 0;
+    }
+    sys_mutex_unlock(&lock_tcpip_core);
+}
+
+/**
+ * Copies the statistics of one call site.
+ * @param index site index, SYS_CORE_LOCK_PROFILE_SITES is the overflow slot
+ * @param site receives the statistics
+ * @return 1 if the slot is in use, 0 otherwise
+ */
+uint8_t sys_core_lock_profile_site(uint32_t index, struct sys_core_lock_site *site)
+{
+    if (index > SYS_CORE_LOCK_PROFILE_SITES)
+    {
+        return 0;
+    }
+
+    sys_lock_tcpip_core();
+    *site = lwip_core_lock_sites[index];
+    sys_unlock_tcpip_core();
+
+    return (site->count != 0U) ? 1U : 0U;
+}
+
+/** Copies the longest hold seen since the last reset */
+void sys_core_lock_profile_max_hold(struct sys_core_lock_max_hold *max_hold)
+{
+    sys_lock_tcpip_core();
+    *max_hold = lwip_core_lock_max_hold;
+    sys_unlock_tcpip_core();
+}
+
+/** Clears all call site statistics */
+void sys_core_lock_profile_reset(void)
+{
+    sys_lock_tcpip_core();
+    memset(lwip_core_lock_sites, 0, sizeof(lwip_core_lock_sites));
+    memset(&lwip_core_lock_max_hold, 0, sizeof(lwip_core_lock_max_hold));
+    /* The reset call itself is still holding the lock */
+    lwip_core_lock_site = sys_core_lock_site_get(__builtin_return_address(0));
+    sys_unlock_tcpip_core();
+}
+
+#else /* SYS_CORE_LOCK_PROFILE */
+
 void sys_lock_tcpip_core(void)
 {
     sys_mutex_lock(&lock_tcpip_core);
@@ -669,6 +1229,8 @@ void sys_unlock_tcpip_core(void)
     sys_mutex_unlock(&lock_tcpip_core);
 }
 
+#endif /* SYS_CORE_LOCK_PROFILE */
+
 #endif /* LWIP_TCPIP_CORE_LOCKING */
 
 static TaskHandle_t lwip_tcpip_thread;
@@ -0,0 +1,113 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Message ring of the lwIP mailboxes (SYS_MBOX_RING in sys_arch.c).
+ *
+ * A bounded ring of message pointers with any number of producers and one
+ * consumer. Producers push with interrupts masked, so a message is published
+ * in one step and the consumer never finds a cell claimed by a producer that
+ * was preempted before it finished. The consumer pops without masking
+ * interrupts, it only reads head and is the only writer of tail. It takes
+ * all the messages ready, up to a batch, with one pair of barriers and one
+ * tail update.
+ *
+ * SYS_MBOX_RING_BARRIER() orders the cell accesses against the index
+ * updates, __DMB() on the target.
+ */
+
+#ifndef SYS_MBOX_RING_H
+#define SYS_MBOX_RING_H
+
+#include "lwip/arch.h"
+
+#ifndef SYS_MBOX_RING_BARRIER
+#define SYS_MBOX_RING_BARRIER() __DMB()
+#endif
+
+struct sys_mbox_cells
+{
+    volatile u32_t head; /* Next position to post to, written by the producers */
+    volatile u32_t tail; /* Next position to fetch from, written by the consumer */
+    u32_t mask;          /* Number of cells - 1 */
+    void *msgs[];
+};
+
+/* Number of cells for a mailbox of size messages, rounded up to a power of two */
+static inline u32_t sys_mbox_ring_cells(u32_t size)
+{
+    u32_t cells = 1U;
+
+    while (cells < size)
+    {
+        cells <<= 1;
+    }
+    return cells;
+}
+
+static inline void sys_mbox_ring_init(struct sys_mbox_cells *ring, u32_t cells)
+{
+    ring->head = 0U;
+    ring->tail = 0U;
+    ring->mask = cells - 1U;
+}
+
+static inline u32_t sys_mbox_ring_count(const struct sys_mbox_cells *ring)
+{
+    return ring->head - ring->tail;
+}
+
+/* Producers only, with interrupts masked. Returns 0 if the ring is full */
+static inline int sys_mbox_ring_push(struct sys_mbox_cells *ring, void *msg)
+{
+    u32_t head = ring->head;
+
+    if ((head - ring->tail) > ring->mask)
+    {
+        return 0;
+    }
+
+    ring->msgs[head & ring->mask] = msg;
+    SYS_MBOX_RING_BARRIER();
+    ring->head = head + 1U;
+    return 1;
+}
+
+/* Consumer only. Pops up to max messages in the order posted, returns the number popped */
+static inline u32_t sys_mbox_ring_pop_batch(struct sys_mbox_cells *ring, void **msgs, u32_t max)
+{
+    u32_t tail  = ring->tail;
+    u32_t count = ring->head - tail;
+    u32_t i;
+
+    if (count == 0U)
+    {
+        return 0U;
+    }
+    count = (count < max) ? count : max;
+
+    SYS_MBOX_RING_BARRIER();
+    for (i = 0U; i < count; i++)
+    {
+        msgs[i] = ring->msgs[(tail + i) & ring->mask];
+    }
+    SYS_MBOX_RING_BARRIER();
+    ring->tail = tail + count;
+    return count;
+}
+
+/*
+ * Non-zero once the ring has drained to half its cells. Producers blocked on
+ * a full ring are only let retry from then on, so that they refill it in a
+ * burst instead of taking turns with the consumer for every cell.
+ */
+static inline int sys_mbox_ring_drained(const struct sys_mbox_cells *ring)
+{
+    return sys_mbox_ring_count(ring) <= (ring->mask >> 1);
+}
+
+#endif /* SYS_MBOX_RING_H */
@@ -10,8 +10,9 @@
 #define __httpsrv_port_h__
 
 #include "FreeRTOS.h"
+#include "heap_tlsf.h"
 
-#define httpsrv_mem_alloc(x) pvPortMalloc(x)
+#define httpsrv_mem_alloc(x) pvPortMallocTagged((x), heapTAG_HTTP)
 #define httpsrv_mem_free(x)  vPortFree(x)
 
 #endif
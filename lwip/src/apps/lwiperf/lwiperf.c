@@ -87,6 +87,12 @@
 
 #define BLOCK_SIZE (1024 * 128)
 
+/** Microsecond clock for the request/response round trip times. The default
+ * has the resolution of sys_now(), ports can provide a finer one. */
+#ifndef LWIPERF_TIME_US
+#define LWIPERF_TIME_US()           (sys_now() * 1000U)
+#endif
+
 /** The IDs of clocks used by clock_gettime() */
 #define CLOCK_MONOTONIC 1
 
@@ -165,7 +171,7 @@ typedef struct _lwiperf_state_base lwiperf_state_base_t;
 struct _lwiperf_state_base {
   /* linked list */
   lwiperf_state_base_t *next;
-  /* 1=tcp, 0=udp */
+  /* 1=tcp, 0=udp, LWIPERF_BASE_RTT=tcp request/response */
   u8_t tcp;
   /* 1=server, 0=client */
   u8_t server;
@@ -177,6 +183,9 @@ struct _lwiperf_state_base {
   void *deallocated_master_state_address;
 };
 
+/** lwiperf_state_base_t.tcp of request/response sessions */
+#define LWIPERF_BASE_RTT 2
+
 /** Connection handle for a UDP iperf session */
 typedef struct _lwiperf_state_udp {
   lwiperf_state_base_t base;
@@ -201,6 +210,7 @@ typedef struct _lwiperf_state_udp {
   u32_t udp_rx_total_size;
   u32_t udp_last_transit;
   long jitter;
+  lwiperf_udp_stats_fn stats_fn;
 } lwiperf_state_udp_t;
 
 /** Connection handle for a TCP iperf session */
@@ -221,6 +231,26 @@ typedef struct _lwiperf_state_tcp {
   ip_addr_t remote_addr;
 } lwiperf_state_tcp_t;
 
+/** Connection handle for a TCP request/response session, or the listener of
+ * the echo server answering them (base.server=1) */
+typedef struct _lwiperf_state_rtt {
+  lwiperf_state_base_t base;
+  struct tcp_pcb *pcb;
+  lwiperf_rtt_report_fn report_fn;
+  void *report_arg;
+  /* number of exchanges to do */
+  u32_t count;
+  u16_t payload_len;
+  /* bytes of the current response still to receive */
+  u16_t rx_pending;
+  u8_t poll_count;
+  u32_t time_sent;
+  u32_t last_rtt;
+  u64_t rtt_sum;
+  u64_t rtt_diff_sum;
+  struct lwiperf_rtt_stats stats;
+} lwiperf_state_rtt_t;
+
 /** List of active iperf sessions */
 static lwiperf_state_base_t *lwiperf_all_connections;
 
@@ -688,7 +718,6 @@ lwiperf_tcp_recv(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err)
       return ERR_OK;
     }
     conn->have_settings_buf = 1;
-    LWIP_PLATFORM_DIAG(("New TCP client (settings flags 0x%x)\n", lwip_ntohl(conn->settings.base.flags)));
     if ((conn->settings.base.flags & PP_HTONL(LWIPERF_FLAGS_EXTEND)) &&
         (conn->settings.eflags & PP_HTONL(LWIPERF_EFLAGS_REVERSE))) {
       err_t err2 = lwiperf_tx_start_reverse(conn);
@@ -1021,6 +1050,7 @@ lwiperf_udp_new_client(lwiperf_state_udp_t *s)
   conn->time_started = sys_now();
   conn->report_fn = s->report_fn;
   conn->report_arg = s->report_arg;
+  conn->stats_fn = s->stats_fn;
   lwiperf_list_add(&conn->base);
   return conn;
 }
@@ -1076,6 +1106,17 @@ lwip_udp_conn_report(lwiperf_state_udp_t *conn, enum lwiperf_report_type report_
       }
     }
 
+    if (conn->stats_fn != NULL) {
+      struct lwiperf_udp_stats stats;
+
+      stats.sent = (conn->base.server || conn->base.reverse) ? 0 : conn->udp_seq;
+      stats.datagrams = conn->udp_rx_total_pkt;
+      stats.lost = conn->udp_rx_lost;
+      stats.out_of_order = conn->udp_rx_outorder;
+      stats.jitter_us = (u32_t)conn->jitter;
+      conn->stats_fn(conn->report_arg, &stats);
+    }
+
     conn->report_fn(conn->report_arg, report_type,
                     local_ip, local_port,
                     &conn->remote_addr, conn->remote_port,
@@ -1480,6 +1521,11 @@ lwiperf_udp_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p,
         LWIP_PLATFORM_DIAG(("Lost %u/%u datagrams, OoO %u\n",
                             ntohl(hdr->error_cnt), ntohl(hdr->datagrams), ntohl(hdr->outorder_cnt)));
         conn->bytes_transferred = (((u64_t)ntohl(hdr->total_len1)) << 32) + ntohl(hdr->total_len2);
+        /* keep the server side accounting for the stats function */
+        conn->udp_rx_total_pkt = ntohl(hdr->datagrams);
+        conn->udp_rx_lost = ntohl(hdr->error_cnt);
+        conn->udp_rx_outorder = ntohl(hdr->outorder_cnt);
+        conn->jitter = (long)(ntohl(hdr->jitter1) * 1000000U + ntohl(hdr->jitter2) * 1000U);
       }
       if (hdr->flags & PP_HTONL(LWIPERF_FLAGS_EXTEND)) {
         LWIP_PLATFORM_DIAG(("Extended report unsupported yet.\n"));
@@ -1807,6 +1853,8 @@ lwiperf_start_udp_client(const ip_addr_t *local_addr, u16_t local_port,
   {
     buf_len = (u32_t)(IP_IS_V6(remote_addr) ? 1450 : 1470);
   }
+  /* every datagram carries the header and the settings */
+  buf_len = LWIP_MAX(buf_len, (u32_t)(sizeof(struct UDP_datagram) + sizeof(lwiperf_settings_ext_t)));
   c->settings.base.buffer_len = lwip_htonl(buf_len);
   if (rate != (1024 * 1024)) { /* 1Mb/s is the default if not specified. */
     c->settings.rate = lwip_htonl(rate);
@@ -1872,6 +1920,330 @@ lwiperf_start_udp_client(const ip_addr_t *local_addr, u16_t local_port,
   return NULL;
 }
 
+/**
+ * @ingroup iperf
+ * Set the function that receives the datagram accounting of a UDP session
+ * (handle returned by `lwiperf_start_udp_(client|server)`). Sessions a server
+ * creates for its clients inherit the function.
+ */
+void
+lwiperf_set_udp_stats_fn(void *lwiperf_session, lwiperf_udp_stats_fn stats_fn)
+{
+  lwiperf_state_base_t *base = (lwiperf_state_base_t *)lwiperf_session;
+
+  LWIP_ASSERT_CORE_LOCKED();
+  LWIP_ASSERT("not a udp session", (base != NULL) && !base->tcp);
+
+  ((lwiperf_state_udp_t *)base)->stats_fn = stats_fn;
+}
+
+/** Close a request/response session or the echo server */
+static void
+lwiperf_rtt_close(lwiperf_state_rtt_t *conn, enum lwiperf_report_type report_type)
+{
+  err_t err;
+
+  lwiperf_list_remove(&conn->base);
+  if (!conn->base.server && (conn->report_fn != NULL)) {
+    conn->report_fn(conn->report_arg, report_type, &conn->stats);
+  }
+  if (conn->pcb != NULL) {
+    if (conn->base.server) {
+      err = tcp_close(conn->pcb);
+      LWIP_ASSERT("error", err == ERR_OK);
+    } else {
+      tcp_arg(conn->pcb, NULL);
+      tcp_poll(conn->pcb, NULL, 0);
+      tcp_recv(conn->pcb, NULL);
+      tcp_err(conn->pcb, NULL);
+      err = tcp_close(conn->pcb);
+      if (err != ERR_OK) {
+        tcp_abort(conn->pcb);
+      }
+    }
+  }
+  LWIPERF_FREE(lwiperf_state_rtt_t, conn);
+}
+
+/** Send the next request of a request/response session */
+static err_t
+lwiperf_rtt_send(lwiperf_state_rtt_t *conn)
+{
+  err_t err;
+
+  conn->rx_pending = conn->payload_len;
+  conn->time_sent = LWIPERF_TIME_US();
+  err = tcp_write(conn->pcb, &lwiperf_txbuf_const[0], conn->payload_len, 0);
+  if (err == ERR_OK) {
+    err = tcp_output(conn->pcb);
+  }
+  return err;
+}
+
+/** Account the round trip time of the exchange that just completed */
+static void
+lwiperf_rtt_sample(lwiperf_state_rtt_t *conn)
+{
+  u32_t rtt = LWIPERF_TIME_US() - conn->time_sent;
+
+  if (conn->stats.count == 0) {
+    conn->stats.min_us = rtt;
+    conn->stats.max_us = rtt;
+  } else {
+    conn->stats.min_us = LWIP_MIN(conn->stats.min_us, rtt);
+    conn->stats.max_us = LWIP_MAX(conn->stats.max_us, rtt);
+    conn->rtt_diff_sum += (rtt > conn->last_rtt) ? (rtt - conn->last_rtt) : (conn->last_rtt - rtt);
+    conn->stats.jitter_us = (u32_t)(conn->rtt_diff_sum / conn->stats.count);
+  }
+  conn->last_rtt = rtt;
+  conn->rtt_sum += rtt;
+  conn->stats.count++;
+  conn->stats.avg_us = (u32_t)(conn->rtt_sum / conn->stats.count);
+}
+
+/** Receive a response on a request/response session */
+static err_t
+lwiperf_rtt_recv(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err)
+{
+  lwiperf_state_rtt_t *conn = (lwiperf_state_rtt_t *)arg;
+  u16_t tot_len;
+
+  LWIP_ASSERT("pcb mismatch", conn->pcb == tpcb);
+
+  if ((err != ERR_OK) || (p == NULL)) {
+    if (p != NULL) {
+      pbuf_free(p);
+    }
+    lwiperf_rtt_close(conn, (conn->stats.count >= conn->count) ? LWIPERF_TCP_DONE_CLIENT_TX : LWIPERF_TCP_ABORTED_REMOTE);
+    return ERR_OK;
+  }
+
+  tot_len = p->tot_len;
+  tcp_recved(tpcb, tot_len);
+  pbuf_free(p);
+  conn->poll_count = 0;
+
+  if (tot_len < conn->rx_pending) {
+    conn->rx_pending -= tot_len;
+    return ERR_OK;
+  }
+
+  lwiperf_rtt_sample(conn);
+  if (conn->stats.count >= conn->count) {
+    lwiperf_rtt_close(conn, LWIPERF_TCP_DONE_CLIENT_TX);
+    return ERR_OK;
+  }
+  if (lwiperf_rtt_send(conn) != ERR_OK) {
+    lwiperf_rtt_close(conn, LWIPERF_TCP_ABORTED_LOCAL_TXERROR);
+  }
+  return ERR_OK;
+}
+
+/** Abort a request/response session that stopped getting responses */
+static err_t
+lwiperf_rtt_poll(void *arg, struct tcp_pcb *tpcb)
+{
+  lwiperf_state_rtt_t *conn = (lwiperf_state_rtt_t *)arg;
+
+  LWIP_ASSERT("pcb mismatch", conn->pcb == tpcb);
+  LWIP_UNUSED_ARG(tpcb);
+
+  if (++conn->poll_count >= LWIPERF_MAX_IDLE_SEC) {
+    lwiperf_rtt_close(conn, LWIPERF_TCP_ABORTED_LOCAL);
+  }
+  return ERR_OK;
+}
+
+/** The pcb of a request/response session has been freed */
+static void
+lwiperf_rtt_err(void *arg, err_t err)
+{
+  lwiperf_state_rtt_t *conn = (lwiperf_state_rtt_t *)arg;
+
+  LWIP_UNUSED_ARG(err);
+
+  conn->pcb = NULL;
+  lwiperf_rtt_close(conn, LWIPERF_TCP_ABORTED_REMOTE);
+}
+
+/** Request/response session connected, send the first request */
+static err_t
+lwiperf_rtt_connected(void *arg, struct tcp_pcb *tpcb, err_t err)
+{
+  lwiperf_state_rtt_t *conn = (lwiperf_state_rtt_t *)arg;
+
+  LWIP_ASSERT("pcb mismatch", conn->pcb == tpcb);
+
+  if (err != ERR_OK) {
+    lwiperf_rtt_close(conn, LWIPERF_TCP_ABORTED_REMOTE);
+    return ERR_OK;
+  }
+  /* every request is a single small segment, do not hold it back */
+  tcp_nagle_disable(tpcb);
+  if (lwiperf_rtt_send(conn) != ERR_OK) {
+    lwiperf_rtt_close(conn, LWIPERF_TCP_ABORTED_LOCAL_TXERROR);
+  }
+  return ERR_OK;
+}
+
+/**
+ * @ingroup iperf
+ * Start a TCP request/response client: sends payload_len bytes, waits until
+ * the same number of bytes came back and repeats that count times. The remote
+ * side must echo the data back, e.g. an RFC 862 echo server or
+ * @ref lwiperf_start_tcp_echo_server(). The report function receives the
+ * round trip times.
+ *
+ * @returns a connection handle that can be used to abort the client
+ *          by calling @ref lwiperf_abort()
+ */
+void *
+lwiperf_start_tcp_rtt_client(const ip_addr_t *remote_addr, u16_t remote_port,
+                             u32_t count, u16_t payload_len,
+                             lwiperf_rtt_report_fn report_fn, void *report_arg)
+{
+  lwiperf_state_rtt_t *conn;
+  err_t err;
+
+  LWIP_ASSERT_CORE_LOCKED();
+  LWIP_ERROR("lwiperf_start_tcp_rtt_client: invalid arguments",
+             (remote_addr != NULL) && (count > 0) && (payload_len > 0), return NULL);
+
+  conn = (lwiperf_state_rtt_t *)LWIPERF_ALLOC(lwiperf_state_rtt_t);
+  if (conn == NULL) {
+    return NULL;
+  }
+  memset(conn, 0, sizeof(lwiperf_state_rtt_t));
+  conn->base.tcp = LWIPERF_BASE_RTT;
+  conn->report_fn = report_fn;
+  conn->report_arg = report_arg;
+  conn->count = count;
+  conn->payload_len = (u16_t)LWIP_MIN(payload_len, sizeof(lwiperf_txbuf_const));
+
+  conn->pcb = tcp_new_ip_type(IP_GET_TYPE(remote_addr));
+  if (conn->pcb == NULL) {
+    LWIPERF_FREE(lwiperf_state_rtt_t, conn);
+    return NULL;
+  }
+  tcp_arg(conn->pcb, conn);
+  tcp_recv(conn->pcb, lwiperf_rtt_recv);
+  tcp_poll(conn->pcb, lwiperf_rtt_poll, 2U);
+  tcp_err(conn->pcb, lwiperf_rtt_err);
+
+  lwiperf_list_add(&conn->base);
+  err = tcp_connect(conn->pcb, remote_addr, remote_port, lwiperf_rtt_connected);
+  if (err != ERR_OK) {
+    conn->report_fn = NULL;
+    lwiperf_rtt_close(conn, LWIPERF_TCP_ABORTED_LOCAL);
+    return NULL;
+  }
+  return conn;
+}
+
+/** Echo server connection: send everything received back */
+static err_t
+lwiperf_echo_recv(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err)
+{
+  struct pbuf *q;
+
+  LWIP_UNUSED_ARG(arg);
+
+  if ((err != ERR_OK) || (p == NULL)) {
+    if (p != NULL) {
+      pbuf_free(p);
+    }
+    tcp_recv(tpcb, NULL);
+    if (tcp_close(tpcb) != ERR_OK) {
+      tcp_abort(tpcb);
+      return ERR_ABRT;
+    }
+    return ERR_OK;
+  }
+
+  if ((tcp_sndbuf(tpcb) < p->tot_len) || (tcp_sndqueuelen(tpcb) + pbuf_clen(p) > TCP_SND_QUEUELEN)) {
+    /* no room yet, lwIP hands the data in again later */
+    return ERR_MEM;
+  }
+  for (q = p; q != NULL; q = q->next) {
+    if (tcp_write(tpcb, q->payload, q->len, TCP_WRITE_FLAG_COPY | ((q->next != NULL) ? TCP_WRITE_FLAG_MORE : 0)) != ERR_OK) {
+      pbuf_free(p);
+      tcp_abort(tpcb);
+      return ERR_ABRT;
+    }
+  }
+  tcp_output(tpcb);
+  tcp_recved(tpcb, p->tot_len);
+  pbuf_free(p);
+  return ERR_OK;
+}
+
+/** Echo server accepted a connection */
+static err_t
+lwiperf_echo_accept(void *arg, struct tcp_pcb *newpcb, err_t err)
+{
+  LWIP_UNUSED_ARG(arg);
+
+  if ((err != ERR_OK) || (newpcb == NULL)) {
+    return ERR_VAL;
+  }
+  tcp_arg(newpcb, NULL);
+  tcp_recv(newpcb, lwiperf_echo_recv);
+  tcp_nagle_disable(newpcb);
+  return ERR_OK;
+}
+
+/**
+ * @ingroup iperf
+ * Start a TCP echo server on a specific IP address and port, answering the
+ * requests of @ref lwiperf_start_tcp_rtt_client().
+ *
+ * @returns a connection handle that can be used to abort the server
+ *          by calling @ref lwiperf_abort()
+ */
+void *
+lwiperf_start_tcp_echo_server(const ip_addr_t *local_addr, u16_t local_port)
+{
+  lwiperf_state_rtt_t *s;
+  struct tcp_pcb *pcb;
+  err_t err;
+
+  LWIP_ASSERT_CORE_LOCKED();
+
+  if (local_addr == NULL) {
+    return NULL;
+  }
+  s = (lwiperf_state_rtt_t *)LWIPERF_ALLOC(lwiperf_state_rtt_t);
+  if (s == NULL) {
+    return NULL;
+  }
+  memset(s, 0, sizeof(lwiperf_state_rtt_t));
+  s->base.tcp = LWIPERF_BASE_RTT;
+  s->base.server = 1;
+
+  pcb = tcp_new_ip_type(LWIPERF_SERVER_IP_TYPE);
+  if (pcb == NULL) {
+    LWIPERF_FREE(lwiperf_state_rtt_t, s);
+    return NULL;
+  }
+  err = tcp_bind(pcb, local_addr, local_port);
+  if (err != ERR_OK) {
+    tcp_close(pcb);
+    LWIPERF_FREE(lwiperf_state_rtt_t, s);
+    return NULL;
+  }
+  s->pcb = tcp_listen_with_backlog(pcb, 1);
+  if (s->pcb == NULL) {
+    tcp_close(pcb);
+    LWIPERF_FREE(lwiperf_state_rtt_t, s);
+    return NULL;
+  }
+  tcp_arg(s->pcb, s);
+  tcp_accept(s->pcb, lwiperf_echo_accept);
+
+  lwiperf_list_add(&s->base);
+  return s;
+}
+
 /**
  * @ingroup iperf
  * Poll all running UDP client to send more according to specified BW.
@@ -1905,7 +2277,9 @@ lwiperf_abort(void *lwiperf_session)
       if (last != NULL) {
         last->next = i;
       }
-      if (dealloc->tcp) {
+      if (dealloc->tcp == LWIPERF_BASE_RTT) {
+        lwiperf_rtt_close((lwiperf_state_rtt_t *)dealloc, LWIPERF_TCP_ABORTED_LOCAL);
+      } else if (dealloc->tcp) {
         lwiperf_tcp_close((lwiperf_state_tcp_t *)dealloc, LWIPERF_TCP_ABORTED_LOCAL);
       } else {
         lwiperf_udp_close((lwiperf_state_udp_t *)dealloc, LWIPERF_UDP_ABORTED_LOCAL);
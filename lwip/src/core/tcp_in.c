@@ -105,6 +105,16 @@ static void tcp_remove_sacks_gt(struct tcp_pcb *pcb, u32_t seq);
 #endif /* TCP_OOSEQ_BYTES_LIMIT || TCP_OOSEQ_PBUFS_LIMIT */
 #endif /* LWIP_TCP_SACK_OUT */
 
+#if LWIP_TCP_SACK_IN
+/* 40 bytes of options hold at most 4 SACK blocks */
+#define TCP_IN_SACK_BLOCKS 4
+/* SACK blocks of the segment being processed, see tcp_parseopt() */
+static struct tcp_sack_range tcp_in_sacks[TCP_IN_SACK_BLOCKS];
+static u8_t tcp_in_sack_num;
+
+static void tcp_sack_update(struct tcp_pcb *pcb);
+#endif /* LWIP_TCP_SACK_IN */
+
 /**
  * The initial input processing of TCP. It verifies the TCP header, demultiplexes
  * the segment between the PCBs and passes it on to tcp_process(), which implements
@@ -1162,6 +1172,12 @@ tcp_receive(struct tcp_pcb *pcb)
   if (flags & TCP_ACK) {
     right_wnd_edge = pcb->snd_wnd + pcb->snd_wl2;
 
+#if LWIP_TCP_SACK_IN
+    if (tcp_in_sack_num > 0) {
+      tcp_sack_update(pcb);
+    }
+#endif /* LWIP_TCP_SACK_IN */
+
     /* Update window. */
     if (TCP_SEQ_LT(pcb->snd_wl1, seqno) ||
         (pcb->snd_wl1 == seqno && TCP_SEQ_LT(pcb->snd_wl2, ackno)) ||
@@ -1237,8 +1253,16 @@ tcp_receive(struct tcp_pcb *pcb)
 
       /* Reset the "IN Fast Retransmit" flag, since we are no longer
          in fast retransmit. Also reset the congestion window to the
-         slow start threshold. */
-      if (pcb->flags & TF_INFR) {
+         slow start threshold. With SACK, recovery only ends once
+         everything sent before it started is acknowledged, or once no
+         SACKed data is left above the ACK: then there is no hole to
+         repair, as after a fast retransmit caused by reordering. */
+      if ((pcb->flags & TF_INFR)
+#if LWIP_TCP_SACK_IN
+          && (!(pcb->flags & TF_SACK) || TCP_SEQ_GEQ(ackno, pcb->sack_recover) ||
+              TCP_SEQ_GEQ(ackno, pcb->sack_high))
+#endif /* LWIP_TCP_SACK_IN */
+         ) {
         tcp_clear_flags(pcb, TF_INFR);
         pcb->cwnd = pcb->ssthresh;
         pcb->bytes_acked = 0;
@@ -1256,10 +1280,26 @@ tcp_receive(struct tcp_pcb *pcb)
       /* Reset the fast retransmit variables. */
       pcb->dupacks = 0;
       pcb->lastack = ackno;
+#if LWIP_TCP_SACK_IN
+      /* Keep the highest SACKed byte within the data in flight, a stale
+         value would look ahead of lastack once the sequence numbers wrap */
+      if (!TCP_SEQ_BETWEEN(pcb->sack_high, ackno, pcb->snd_nxt)) {
+        pcb->sack_high = ackno;
+      }
+#endif /* LWIP_TCP_SACK_IN */
 
       /* Update the congestion control variables (cwnd and
          ssthresh). */
       if (pcb->state >= ESTABLISHED) {
+#if LWIP_TCP_SACK_IN
+        if (pcb->flags & TF_INFR) {
+          /* Partial ACK during SACK recovery: deflate the window by the data
+             that left the network (RFC 6582) and keep counting dupacks */
+          pcb->cwnd = (pcb->cwnd > acked) ? (tcpwnd_size_t)(pcb->cwnd - acked) : 0;
+          TCP_WND_INC(pcb->cwnd, pcb->mss);
+          pcb->dupacks = 3;
+        } else
+#endif /* LWIP_TCP_SACK_IN */
         if (pcb->cwnd < pcb->ssthresh) {
           tcpwnd_size_t increase;
           /* limit to 1 SMSS segment during period following RTO */
@@ -1335,6 +1375,12 @@ tcp_receive(struct tcp_pcb *pcb)
           tcp_clear_flags(pcb, TF_RTO);
         }
       }
+#if LWIP_TCP_SACK_IN
+      if (pcb->flags & TF_INFR) {
+        /* Still in recovery: retransmit the next hole (tcp_input() calls tcp_output()) */
+        tcp_rexmit_sack(pcb);
+      }
+#endif /* LWIP_TCP_SACK_IN */
       /* End of ACK for new data processing. */
     } else {
       /* Out of sequence ACK, didn't really ack anything */
@@ -1900,6 +1946,51 @@ tcp_receive(struct tcp_pcb *pcb)
   }
 }
 
+#if LWIP_TCP_SACK_IN
+/**
+ * Marks the unacked segments covered by the SACK blocks of the incoming
+ * segment, so that fast recovery retransmits only the holes between them.
+ *
+ * @param pcb the tcp_pcb for which a segment arrived
+ */
+static void
+tcp_sack_update(struct tcp_pcb *pcb)
+{
+  struct tcp_seg *seg;
+  u32_t left, right, seg_seqno;
+  u8_t i;
+
+  /* sack_high is 0 until the first recovery, which need not be in the
+     same half of the sequence space as lastack */
+  if (!TCP_SEQ_BETWEEN(pcb->sack_high, pcb->lastack, pcb->snd_nxt)) {
+    pcb->sack_high = pcb->lastack;
+  }
+
+  for (i = 0; i < tcp_in_sack_num; i++) {
+    left = tcp_in_sacks[i].left;
+    right = tcp_in_sacks[i].right;
+    /* Skip D-SACKs (RFC 2883) and blocks outside of the data in flight */
+    if (!TCP_SEQ_LT(left, right) || TCP_SEQ_LEQ(right, ackno) || TCP_SEQ_GT(right, pcb->snd_nxt)) {
+      continue;
+    }
+    LWIP_DEBUGF(TCP_FR_DEBUG, ("tcp_sack_update: SACK %"U32_F":%"U32_F"\n", left, right));
+    /* unacked is sorted by sequence number */
+    for (seg = pcb->unacked; seg != NULL; seg = seg->next) {
+      seg_seqno = lwip_ntohl(seg->tcphdr->seqno);
+      if (TCP_SEQ_GEQ(seg_seqno, right)) {
+        break;
+      }
+      if (TCP_SEQ_GEQ(seg_seqno, left) && TCP_SEQ_LEQ(seg_seqno + TCP_TCPLEN(seg), right)) {
+        seg->flags |= TF_SEG_SACKED;
+      }
+    }
+    if (TCP_SEQ_GT(right, pcb->sack_high)) {
+      pcb->sack_high = right;
+    }
+  }
+}
+#endif /* LWIP_TCP_SACK_IN */
+
 static u8_t
 tcp_get_next_optbyte(void)
 {
@@ -1913,6 +2004,21 @@ tcp_get_next_optbyte(void)
   }
 }
 
+#if LWIP_TCP_SACK_IN
+/* Reads a 32 bit option value in network byte order */
+static u32_t
+tcp_get_next_optu32(void)
+{
+  u32_t value;
+
+  value = (u32_t)tcp_get_next_optbyte() << 24;
+  value |= (u32_t)tcp_get_next_optbyte() << 16;
+  value |= (u32_t)tcp_get_next_optbyte() << 8;
+  value |= tcp_get_next_optbyte();
+  return value;
+}
+#endif /* LWIP_TCP_SACK_IN */
+
 /**
  * Parses the options contained in the incoming segment.
  *
@@ -1932,6 +2038,10 @@ tcp_parseopt(struct tcp_pcb *pcb)
 
   LWIP_ASSERT("tcp_parseopt: invalid pcb", pcb != NULL);
 
+#if LWIP_TCP_SACK_IN
+  tcp_in_sack_num = 0;
+#endif /* LWIP_TCP_SACK_IN */
+
   /* Parse the TCP MSS option, if present. */
   if (tcphdr_optlen != 0) {
     for (tcp_optidx = 0; tcp_optidx < tcphdr_optlen; ) {
@@ -2024,6 +2134,27 @@ tcp_parseopt(struct tcp_pcb *pcb)
           }
           break;
 #endif /* LWIP_TCP_SACK_OUT */
+#if LWIP_TCP_SACK_IN
+        case LWIP_TCP_OPT_SACK:
+          LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_parseopt: SACK\n"));
+          data = tcp_get_next_optbyte();
+          if ((data < 2) || (((data - 2) % 8) != 0) || (tcp_optidx - 2 + data) > tcphdr_optlen) {
+            /* Bad length */
+            LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_parseopt: bad length\n"));
+            return;
+          }
+          /* TCP SACK option with valid length: up to 4 blocks of left and right edge */
+          for (data = (u8_t)((data - 2) / 8); data > 0; data--) {
+            u32_t left = tcp_get_next_optu32();
+            u32_t right = tcp_get_next_optu32();
+            if ((pcb->flags & TF_SACK) && (tcp_in_sack_num < TCP_IN_SACK_BLOCKS)) {
+              tcp_in_sacks[tcp_in_sack_num].left = left;
+              tcp_in_sacks[tcp_in_sack_num].right = right;
+              tcp_in_sack_num++;
+            }
+          }
+          break;
+#endif /* LWIP_TCP_SACK_IN */
         default:
           LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_parseopt: other\n"));
           data = tcp_get_next_optbyte();
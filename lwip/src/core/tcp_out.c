@@ -1676,6 +1676,16 @@ tcp_rexmit_rto_prepare(struct tcp_pcb *pcb)
   /* Don't take any RTT measurements after retransmitting. */
   pcb->rttest = 0;
 
+#if LWIP_TCP_SACK_IN
+  /* The receiver may have dropped SACKed data (RFC 2018), retransmit it
+     all and let no ACK count as partial until the next fast recovery */
+  for (seg = pcb->unsent; seg != NULL; seg = seg->next) {
+    seg->flags &= (u8_t)~(TF_SEG_SACKED | TF_SEG_SACK_REXMIT);
+  }
+  pcb->sack_high = pcb->lastack;
+  pcb->sack_recover = pcb->lastack;
+#endif /* LWIP_TCP_SACK_IN */
+
   return ERR_OK;
 }
 
@@ -1717,6 +1727,43 @@ tcp_rexmit_rto(struct tcp_pcb *pcb)
   }
 }
 
+/**
+ * Put a segment taken off the unacked queue back on the unsent queue for
+ * retransmission. Keeps the unsent queue sorted.
+ *
+ * @param pcb the tcp_pcb the segment belongs to
+ * @param seg the segment to retransmit
+ */
+static void
+tcp_rexmit_seg_queue(struct tcp_pcb *pcb, struct tcp_seg *seg)
+{
+  struct tcp_seg **cur_seg;
+
+  cur_seg = &(pcb->unsent);
+  while (*cur_seg &&
+         TCP_SEQ_LT(lwip_ntohl((*cur_seg)->tcphdr->seqno), lwip_ntohl(seg->tcphdr->seqno))) {
+    cur_seg = &((*cur_seg)->next );
+  }
+  seg->next = *cur_seg;
+  *cur_seg = seg;
+#if TCP_OVERSIZE
+  if (seg->next == NULL) {
+    /* the retransmitted segment is last in unsent, so reset unsent_oversize */
+    pcb->unsent_oversize = 0;
+  }
+#endif /* TCP_OVERSIZE */
+
+  if (pcb->nrtx < 0xFF) {
+    ++pcb->nrtx;
+  }
+
+  /* Don't take any rtt measurements after retransmitting. */
+  pcb->rttest = 0;
+
+  /* Do the actual retransmission. */
+  MIB2_STATS_INC(mib2.tcpretranssegs);
+}
+
 /**
  * Requeue the first unacked segment for retransmission
  *
@@ -1728,7 +1775,6 @@ err_t
 tcp_rexmit(struct tcp_pcb *pcb)
 {
   struct tcp_seg *seg;
-  struct tcp_seg **cur_seg;
 
   LWIP_ASSERT("tcp_rexmit: invalid pcb", pcb != NULL);
 
@@ -1746,32 +1792,9 @@ tcp_rexmit(struct tcp_pcb *pcb)
   }
 
   /* Move the first unacked segment to the unsent queue */
-  /* Keep the unsent queue sorted. */
   pcb->unacked = seg->next;
+  tcp_rexmit_seg_queue(pcb, seg);
 
-  cur_seg = &(pcb->unsent);
-  while (*cur_seg &&
-         TCP_SEQ_LT(lwip_ntohl((*cur_seg)->tcphdr->seqno), lwip_ntohl(seg->tcphdr->seqno))) {
-    cur_seg = &((*cur_seg)->next );
-  }
-  seg->next = *cur_seg;
-  *cur_seg = seg;
-#if TCP_OVERSIZE
-  if (seg->next == NULL) {
-    /* the retransmitted segment is last in unsent, so reset unsent_oversize */
-    pcb->unsent_oversize = 0;
-  }
-#endif /* TCP_OVERSIZE */
-
-  if (pcb->nrtx < 0xFF) {
-    ++pcb->nrtx;
-  }
-
-  /* Don't take any rtt measurements after retransmitting. */
-  pcb->rttest = 0;
-
-  /* Do the actual retransmission. */
-  MIB2_STATS_INC(mib2.tcpretranssegs);
   /* No need to call tcp_output: we are always called from tcp_input()
      and thus tcp_output directly returns. */
   return ERR_OK;
@@ -1786,6 +1809,10 @@ tcp_rexmit(struct tcp_pcb *pcb)
 void
 tcp_rexmit_fast(struct tcp_pcb *pcb)
 {
+#if LWIP_TCP_SACK_IN
+  struct tcp_seg *seg;
+#endif /* LWIP_TCP_SACK_IN */
+
   LWIP_ASSERT("tcp_rexmit_fast: invalid pcb", pcb != NULL);
 
   if (pcb->unacked != NULL && !(pcb->flags & TF_INFR)) {
@@ -1795,7 +1822,23 @@ tcp_rexmit_fast(struct tcp_pcb *pcb)
                  "), fast retransmit %"U32_F"\n",
                  (u16_t)pcb->dupacks, pcb->lastack,
                  lwip_ntohl(pcb->unacked->tcphdr->seqno)));
+#if LWIP_TCP_SACK_IN
+    /* A new recovery, every hole may be retransmitted once again. The
+       highest SACKed byte is taken from the scoreboard, from lastack up */
+    pcb->sack_high = pcb->lastack;
+    for (seg = pcb->unacked->next; seg != NULL; seg = seg->next) {
+      seg->flags &= (u8_t)~TF_SEG_SACK_REXMIT;
+      if (seg->flags & TF_SEG_SACKED) {
+        pcb->sack_high = lwip_ntohl(seg->tcphdr->seqno) + TCP_TCPLEN(seg);
+      }
+    }
+    seg = pcb->unacked;
+#endif /* LWIP_TCP_SACK_IN */
     if (tcp_rexmit(pcb) == ERR_OK) {
+#if LWIP_TCP_SACK_IN
+      seg->flags |= TF_SEG_SACK_REXMIT;
+      pcb->sack_recover = pcb->snd_nxt;
+#endif /* LWIP_TCP_SACK_IN */
       /* Set ssthresh to half of the minimum of the current
        * cwnd and the advertised window */
       pcb->ssthresh = LWIP_MIN(pcb->cwnd, pcb->snd_wnd) / 2;
@@ -1816,7 +1859,83 @@ tcp_rexmit_fast(struct tcp_pcb *pcb)
       pcb->rtime = 0;
     }
   }
+#if LWIP_TCP_SACK_IN
+  else if ((pcb->flags & TF_INFR) && (pcb->flags & TF_SACK)) {
+    /* Another dupack during recovery: retransmit the next hole */
+    tcp_rexmit_sack(pcb);
+  }
+#endif /* LWIP_TCP_SACK_IN */
+}
+
+#if LWIP_TCP_SACK_IN
+/**
+ * Requeue the next hole of the SACK scoreboard for retransmission: the
+ * oldest unacked segment that the remote host has not SACKed and that has
+ * not been retransmitted in this recovery yet. As in IsLost() of RFC 6675,
+ * a hole only counts as lost once as many segments are SACKed above it as
+ * dupacks start a fast retransmit (3), or more than 2 * MSS bytes: with fewer
+ * the segment may just be reordered, and a partial ACK alone does not make it
+ * lost either. The first unacked segment at the start of recovery is resent
+ * by tcp_rexmit_fast().
+ *
+ * Called by tcp_receive() for every dupack and partial ACK during fast
+ * recovery, so at most one hole is resent per ACK.
+ *
+ * @param pcb the tcp_pcb in fast recovery
+ * @return ERR_OK if a segment was queued, ERR_VAL if there is no hole
+ */
+err_t
+tcp_rexmit_sack(struct tcp_pcb *pcb)
+{
+  struct tcp_seg *seg;
+  struct tcp_seg *above;
+  struct tcp_seg **prev;
+  u32_t sacked_bytes = 0;
+  u8_t sacked_segs = 0;
+
+  LWIP_ASSERT("tcp_rexmit_sack: invalid pcb", pcb != NULL);
+
+  for (prev = &pcb->unacked; *prev != NULL; prev = &(*prev)->next) {
+    seg = *prev;
+    if (!TCP_SEQ_LT(lwip_ntohl(seg->tcphdr->seqno), pcb->sack_high)) {
+      /* Nothing SACKed behind this segment, it may still be in flight */
+      return ERR_VAL;
+    }
+    if (!(seg->flags & (TF_SEG_SACKED | TF_SEG_SACK_REXMIT))) {
+      break;
+    }
+  }
+  if (*prev == NULL) {
+    return ERR_VAL;
+  }
+
+  seg = *prev;
+  for (above = seg->next; above != NULL; above = above->next) {
+    if (above->flags & TF_SEG_SACKED) {
+      sacked_bytes += TCP_TCPLEN(above);
+      sacked_segs++;
+    }
+  }
+  if ((sacked_segs < 3) && (sacked_bytes <= 2 * (u32_t)pcb->mss)) {
+    /* Not enough SACKed above the hole to rule out reordering */
+    return ERR_VAL;
+  }
+
+  /* Give up if the segment is still referenced by the netif driver
+     due to deferred transmission. */
+  if (tcp_output_segment_busy(seg)) {
+    LWIP_DEBUGF(TCP_RTO_DEBUG, ("tcp_rexmit_sack busy\n"));
+    return ERR_VAL;
+  }
+
+  LWIP_DEBUGF(TCP_FR_DEBUG, ("tcp_rexmit_sack: hole %"U32_F", SACKed up to %"U32_F"\n",
+                             lwip_ntohl(seg->tcphdr->seqno), pcb->sack_high));
+  *prev = seg->next;
+  seg->flags |= TF_SEG_SACK_REXMIT;
+  tcp_rexmit_seg_queue(pcb, seg);
+  return ERR_OK;
 }
+#endif /* LWIP_TCP_SACK_IN */
 
 static struct pbuf *
 tcp_output_alloc_header_common(u32_t ackno, u16_t optlen, u16_t datalen,
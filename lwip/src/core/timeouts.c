@@ -118,11 +118,214 @@ const int lwip_num_cyclic_timers = LWIP_ARRAYSIZE(lwip_cyclic_timers);
 
 #if LWIP_TIMERS && !LWIP_TIMERS_CUSTOM
 
+static u32_t current_timeout_due_time;
+
+#if LWIP_TIMERS_WHEEL
+/*
+ * Hierarchical timer wheel.
+ *
+ * Level 0 has one slot per millisecond, every further level has slots
+ * TW_LVL_SLOTS times coarser. A timeout is put into the lowest level whose
+ * slot range still contains both its expiry time and the wheel time, so
+ * inserting is O(1). When the wheel time reaches the start of a slot at
+ * level n > 0, the timeouts in that slot are moved down ("cascaded"); each
+ * timeout is moved at most TW_LEVELS - 1 times before it expires.
+ *
+ * Occupied slots are tracked in per level bitmaps, so empty ranges of time
+ * are skipped without visiting every millisecond. Timeouts are additionally
+ * linked into a small hash table keyed by handler/arg, which makes
+ * sys_untimeout() independent of the number of active timeouts.
+ */
+#define TW_LVL_BITS   6
+#define TW_LVL_SLOTS  (1U << TW_LVL_BITS)
+#define TW_LEVELS     6 /* 6 * TW_LVL_BITS >= 32 bits of sys_now() */
+#define TW_BM_WORDS   (TW_LVL_SLOTS / 32)
+#define TW_HASH_SIZE  32
+
+#define TW_SHIFT(lvl) ((lvl) * TW_LVL_BITS)
+/* The top level only covers the remaining bits of the 32-bit time and wraps around */
+#define TW_NSLOTS(lvl) (((lvl) == (TW_LEVELS - 1)) ? (1U << (32 - TW_SHIFT(TW_LEVELS - 1))) : TW_LVL_SLOTS)
+#define TW_INDEX(time, lvl) (((time) >> TW_SHIFT(lvl)) & (TW_NSLOTS(lvl) - 1))
+
+/** Slot lists of all levels */
+static struct sys_timeo *tw_slots[TW_LEVELS][TW_LVL_SLOTS];
+/** Occupied slots, one bit per slot */
+static u32_t tw_bitmap[TW_LEVELS][TW_BM_WORDS];
+/** Timeouts hashed by handler and arg, for sys_untimeout() */
+static struct sys_timeo *tw_hash[TW_HASH_SIZE];
+/** Current wheel time, all milliseconds before it have been processed */
+static u32_t tw_time;
+
+/** Index of the lowest set bit of a non-zero word */
+static u32_t
+tw_lowest_bit(u32_t x)
+{
+  static const u8_t debruijn_pos[32] = {
+    0, 1, 28, 2, 29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4, 8,
+    31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6, 11, 5, 10, 9
+  };
+  return debruijn_pos[(u32_t)((x & (u32_t)(0U - x)) * 0x077CB531UL) >> 27];
+}
+
+/** Find the first occupied slot of a level at index >= from, or return -1 */
+static int
+tw_find_slot(u8_t lvl, u32_t from)
+{
+  u32_t w;
+  u32_t bits;
+
+  for (w = from / 32; w < TW_BM_WORDS; w++) {
+    bits = tw_bitmap[lvl][w];
+    if (w == from / 32) {
+      bits &= ~((1UL << (from % 32)) - 1UL);
+    }
+    if (bits != 0) {
+      return (int)(w * 32 + tw_lowest_bit(bits));
+    }
+  }
+  return -1;
+}
+
+static u32_t
+tw_hash_index(sys_timeout_handler handler, void *arg)
+{
+  mem_ptr_t key = (mem_ptr_t)handler ^ (mem_ptr_t)arg;
+  key ^= (key >> 5) ^ (key >> 11);
+  return (u32_t)(key & (TW_HASH_SIZE - 1));
+}
+
+/** Put a timeout into the slot matching its expiry time relative to tw_time */
+static void
+tw_link(struct sys_timeo *timeout)
+{
+  u32_t expires = timeout->time;
+  u32_t idx;
+  u8_t lvl;
+
+  /* overdue timeouts are handled with the next processed millisecond */
+  if (TIME_LESS_THAN(expires, tw_time)) {
+    expires = tw_time;
+  }
+
+  for (lvl = 0; lvl < (TW_LEVELS - 1); lvl++) {
+    if (((expires ^ tw_time) >> TW_SHIFT(lvl + 1)) == 0) {
+      break;
+    }
+  }
+  idx = TW_INDEX(expires, lvl);
+
+  timeout->level = lvl;
+  timeout->slot = (u8_t)idx;
+  timeout->next = tw_slots[lvl][idx];
+  if (timeout->next != NULL) {
+    timeout->next->pprev = &timeout->next;
+  }
+  timeout->pprev = &tw_slots[lvl][idx];
+  tw_slots[lvl][idx] = timeout;
+  tw_bitmap[lvl][idx / 32] |= (1UL << (idx % 32));
+}
+
+/** Remove a timeout from its slot */
+static void
+tw_unlink(struct sys_timeo *timeout)
+{
+  *timeout->pprev = timeout->next;
+  if (timeout->next != NULL) {
+    timeout->next->pprev = timeout->pprev;
+  }
+  if (tw_slots[timeout->level][timeout->slot] == NULL) {
+    tw_bitmap[timeout->level][timeout->slot / 32] &= ~(1UL << (timeout->slot % 32));
+  }
+}
+
+static void
+tw_hash_link(struct sys_timeo *timeout)
+{
+  struct sys_timeo **head = &tw_hash[tw_hash_index(timeout->h, timeout->arg)];
+
+  timeout->hnext = *head;
+  if (timeout->hnext != NULL) {
+    timeout->hnext->hpprev = &timeout->hnext;
+  }
+  timeout->hpprev = head;
+  *head = timeout;
+}
+
+static void
+tw_hash_unlink(struct sys_timeo *timeout)
+{
+  *timeout->hpprev = timeout->hnext;
+  if (timeout->hnext != NULL) {
+    timeout->hnext->hpprev = timeout->hpprev;
+  }
+}
+
+/** Move the timeouts of a slot one or more levels down */
+static void
+tw_cascade(u8_t lvl, u32_t idx)
+{
+  struct sys_timeo *t = tw_slots[lvl][idx];
+
+  tw_slots[lvl][idx] = NULL;
+  tw_bitmap[lvl][idx / 32] &= ~(1UL << (idx % 32));
+
+  while (t != NULL) {
+    struct sys_timeo *next = t->next;
+    tw_link(t);
+    t = next;
+  }
+}
+
+/**
+ * Find the next millisecond at or after tw_time that needs processing,
+ * either because timeouts expire or because a slot has to be cascaded.
+ *
+ * @param next receives the time found
+ * @return 1 if there is such a time, 0 if the wheel is empty
+ */
+static int
+tw_next_event(u32_t *next)
+{
+  u32_t best = 0;
+  int found = 0;
+  u8_t lvl;
+
+  for (lvl = 0; lvl < TW_LEVELS; lvl++) {
+    u32_t from = TW_INDEX(tw_time, lvl);
+    u32_t base;
+    u32_t time;
+    int idx;
+
+    /* at level > 0 the current slot is only pending while tw_time is at its start */
+    if ((lvl > 0) && ((tw_time & ((1UL << TW_SHIFT(lvl)) - 1UL)) != 0)) {
+      from++;
+    }
+    idx = (from < TW_NSLOTS(lvl)) ? tw_find_slot(lvl, from) : -1;
+    if (lvl == (TW_LEVELS - 1)) {
+      if (idx < 0) {
+        /* the top level wraps around with the 32-bit time */
+        idx = tw_find_slot(lvl, 0);
+      }
+      base = 0;
+    } else {
+      base = tw_time & ~((1UL << TW_SHIFT(lvl + 1)) - 1UL);
+    }
+    if (idx >= 0) {
+      time = base + ((u32_t)idx << TW_SHIFT(lvl));
+      if (!found || ((u32_t)(time - tw_time) < (u32_t)(best - tw_time))) {
+        best = time;
+        found = 1;
+      }
+    }
+  }
+
+  *next = best;
+  return found;
+}
+#else /* LWIP_TIMERS_WHEEL */
 /** The one and only timeout list */
 static struct sys_timeo *next_timeout;
 
-static u32_t current_timeout_due_time;
-
 #if LWIP_TESTMODE
 struct sys_timeo**
 sys_timeouts_get_next_timeout(void)
@@ -130,6 +333,7 @@ sys_timeouts_get_next_timeout(void)
   return &next_timeout;
 }
 #endif
+#endif /* LWIP_TIMERS_WHEEL */
 
 #if LWIP_TCP
 /** global variable that shows if the tcp timer is currently scheduled or not */
@@ -183,7 +387,10 @@ sys_timeout_abs(u32_t abs_time, sys_timeout_handler handler, void *arg, const ch
 sys_timeout_abs(u32_t abs_time, sys_timeout_handler handler, void *arg)
 #endif
 {
-  struct sys_timeo *timeout, *t;
+  struct sys_timeo *timeout;
+#if !LWIP_TIMERS_WHEEL
+  struct sys_timeo *t;
+#endif /* !LWIP_TIMERS_WHEEL */
 
   timeout = (struct sys_timeo *)memp_malloc(MEMP_SYS_TIMEOUT);
   if (timeout == NULL) {
@@ -202,6 +409,10 @@ sys_timeout_abs(u32_t abs_time, sys_timeout_handler handler, void *arg)
                              (void *)timeout, abs_time, handler_name, (void *)arg));
 #endif /* LWIP_DEBUG_TIMERNAMES */
 
+#if LWIP_TIMERS_WHEEL
+  tw_link(timeout);
+  tw_hash_link(timeout);
+#else /* LWIP_TIMERS_WHEEL */
   if (next_timeout == NULL) {
     next_timeout = timeout;
     return;
@@ -218,6 +429,7 @@ sys_timeout_abs(u32_t abs_time, sys_timeout_handler handler, void *arg)
       }
     }
   }
+#endif /* LWIP_TIMERS_WHEEL */
 }
 
 /**
@@ -264,6 +476,9 @@ lwip_cyclic_timer(void *arg)
 void sys_timeouts_init(void)
 {
   size_t i;
+#if LWIP_TIMERS_WHEEL
+  tw_time = sys_now();
+#endif /* LWIP_TIMERS_WHEEL */
   /* tcp_tmr() at index 0 is started on demand */
   for (i = (LWIP_TCP ? 1 : 0); i < LWIP_ARRAYSIZE(lwip_cyclic_timers); i++) {
     /* we have to cast via size_t to get rid of const warning
@@ -316,6 +531,25 @@ sys_timeout(u32_t msecs, sys_timeout_handler handler, void *arg)
 void
 sys_untimeout(sys_timeout_handler handler, void *arg)
 {
+#if LWIP_TIMERS_WHEEL
+  struct sys_timeo *t, *match = NULL;
+
+  LWIP_ASSERT_CORE_LOCKED();
+
+  /* the list based implementation removes the entry that expires first */
+  for (t = tw_hash[tw_hash_index(handler, arg)]; t != NULL; t = t->hnext) {
+    if ((t->h == handler) && (t->arg == arg)) {
+      if ((match == NULL) || TIME_LESS_THAN(t->time, match->time)) {
+        match = t;
+      }
+    }
+  }
+  if (match != NULL) {
+    tw_unlink(match);
+    tw_hash_unlink(match);
+    memp_free(MEMP_SYS_TIMEOUT, match);
+  }
+#else /* LWIP_TIMERS_WHEEL */
   struct sys_timeo *prev_t, *t;
 
   LWIP_ASSERT_CORE_LOCKED();
@@ -337,6 +571,7 @@ sys_untimeout(sys_timeout_handler handler, void *arg)
       return;
     }
   }
+#endif /* LWIP_TIMERS_WHEEL */
   return;
 }
 
@@ -358,6 +593,64 @@ sys_check_timeouts(void)
   /* Process only timers expired at the start of the function. */
   now = sys_now();
 
+#if LWIP_TIMERS_WHEEL
+  for (;;) {
+    u32_t next;
+    u32_t idx;
+    u8_t lvl;
+
+    if (!tw_next_event(&next) || TIME_LESS_THAN(now, next)) {
+      /* nothing left to do up to now */
+      if (TIME_LESS_THAN(tw_time, now)) {
+        tw_time = now;
+      }
+      return;
+    }
+    tw_time = next;
+
+    /* move timeouts of slots starting at this millisecond down, top level first */
+    for (lvl = TW_LEVELS - 1; lvl > 0; lvl--) {
+      if ((tw_time & ((1UL << TW_SHIFT(lvl)) - 1UL)) == 0) {
+        idx = TW_INDEX(tw_time, lvl);
+        if (tw_slots[lvl][idx] != NULL) {
+          tw_cascade(lvl, idx);
+        }
+      }
+    }
+
+    /* all timeouts in this level 0 slot expire now, including those added by the handlers */
+    idx = TW_INDEX(tw_time, 0);
+    while (tw_slots[0][idx] != NULL) {
+      struct sys_timeo *tmptimeout = tw_slots[0][idx];
+      sys_timeout_handler handler;
+      void *arg;
+
+      PBUF_CHECK_FREE_OOSEQ();
+
+      tw_unlink(tmptimeout);
+      tw_hash_unlink(tmptimeout);
+      handler = tmptimeout->h;
+      arg = tmptimeout->arg;
+      current_timeout_due_time = tmptimeout->time;
+#if LWIP_DEBUG_TIMERNAMES
+      if (handler != NULL) {
+        LWIP_DEBUGF(TIMERS_DEBUG, ("sct calling h=%s t=%"U32_F" arg=%p\n",
+                                   tmptimeout->handler_name, sys_now() - tmptimeout->time, arg));
+      }
+#endif /* LWIP_DEBUG_TIMERNAMES */
+      memp_free(MEMP_SYS_TIMEOUT, tmptimeout);
+      if (handler != NULL) {
+        handler(arg);
+      }
+      LWIP_TCPIP_THREAD_ALIVE();
+    }
+    if (tw_time == now) {
+      /* stay on this millisecond, timeouts added for it later are still due */
+      return;
+    }
+    tw_time++;
+  }
+#else /* LWIP_TIMERS_WHEEL */
   do {
     struct sys_timeo *tmptimeout;
     sys_timeout_handler handler;
@@ -393,6 +686,7 @@ sys_check_timeouts(void)
 
     /* Repeat until all expired timers have been called */
   } while (1);
+#endif /* LWIP_TIMERS_WHEEL */
 }
 
 /** Rebase the timeout times to the current time.
@@ -406,6 +700,46 @@ sys_restart_timeouts(void)
   u32_t now;
   u32_t base;
   struct sys_timeo *t;
+#if LWIP_TIMERS_WHEEL
+  struct sys_timeo *all = NULL;
+  u8_t lvl;
+  u32_t idx;
+
+  /* collect all timeouts, the hash links stay valid */
+  for (lvl = 0; lvl < TW_LEVELS; lvl++) {
+    for (idx = 0; idx < TW_LVL_SLOTS; idx++) {
+      while (tw_slots[lvl][idx] != NULL) {
+        t = tw_slots[lvl][idx];
+        tw_slots[lvl][idx] = t->next;
+        if ((all == NULL) || TIME_LESS_THAN(t->time, all->time)) {
+          /* keep the earliest timeout first */
+          t->next = all;
+          all = t;
+        } else {
+          t->next = all->next;
+          all->next = t;
+        }
+      }
+    }
+    for (idx = 0; idx < TW_BM_WORDS; idx++) {
+      tw_bitmap[lvl][idx] = 0;
+    }
+  }
+
+  now = sys_now();
+  tw_time = now;
+  if (all == NULL) {
+    return;
+  }
+
+  base = all->time;
+  while (all != NULL) {
+    t = all;
+    all = t->next;
+    t->time = (t->time - base) + now;
+    tw_link(t);
+  }
+#else /* LWIP_TIMERS_WHEEL */
 
   if (next_timeout == NULL) {
     return;
@@ -417,6 +751,7 @@ sys_restart_timeouts(void)
   for (t = next_timeout; t != NULL; t = t->next) {
     t->time = (t->time - base) + now;
   }
+#endif /* LWIP_TIMERS_WHEEL */
 }
 
 /** Return the time left before the next timeout is due. If no timeouts are
@@ -426,17 +761,25 @@ u32_t
 sys_timeouts_sleeptime(void)
 {
   u32_t now;
+  u32_t next_time;
 
   LWIP_ASSERT_CORE_LOCKED();
 
+#if LWIP_TIMERS_WHEEL
+  if (!tw_next_event(&next_time)) {
+    return SYS_TIMEOUTS_SLEEPTIME_INFINITE;
+  }
+#else /* LWIP_TIMERS_WHEEL */
   if (next_timeout == NULL) {
     return SYS_TIMEOUTS_SLEEPTIME_INFINITE;
   }
+  next_time = next_timeout->time;
+#endif /* LWIP_TIMERS_WHEEL */
   now = sys_now();
-  if (TIME_LESS_THAN(next_timeout->time, now)) {
+  if (TIME_LESS_THAN(next_time, now)) {
     return 0;
   } else {
-    u32_t ret = (u32_t)(next_timeout->time - now);
+    u32_t ret = (u32_t)(next_time - now);
     LWIP_ASSERT("invalid sleeptime", ret <= LWIP_MAX_TIMEOUT);
     return ret;
   }
@@ -55,6 +55,10 @@ extern "C" {
 #define LWIPERF_TOS_DEFAULT  0
 #endif
 
+#ifndef LWIPERF_ECHO_PORT_DEFAULT
+#define LWIPERF_ECHO_PORT_DEFAULT  7
+#endif
+
 /** lwIPerf test results */
 enum lwiperf_report_type
 {
@@ -138,6 +142,58 @@ void* lwiperf_start_udp_server(const ip_addr_t* local_addr, u16_t local_port,
                                lwiperf_report_fn report_fn, void* report_arg);
 void lwiperf_poll_udp_client(void);
 
+/** Datagram accounting of a UDP session. For a receiving session the values
+    are counted locally, for a sending client they are taken from the server
+    report (datagrams is 0 if no report arrived). */
+struct lwiperf_udp_stats
+{
+  /** Datagrams sent, sending clients only */
+  u32_t sent;
+  /** Datagrams received */
+  u32_t datagrams;
+  /** Datagrams missing from the sequence */
+  u32_t lost;
+  /** Datagrams received out of order */
+  u32_t out_of_order;
+  /** Interarrival jitter (RFC 1889), in microseconds */
+  u32_t jitter_us;
+};
+
+/** Prototype of a function that is called with the datagram accounting of a
+    UDP session right before its report function.
+    @param arg Report_arg from when the test was started.
+    @param stats Datagram accounting of the session
+*/
+typedef void (*lwiperf_udp_stats_fn)(void *arg, const struct lwiperf_udp_stats *stats);
+
+void lwiperf_set_udp_stats_fn(void *lwiperf_session, lwiperf_udp_stats_fn stats_fn);
+
+/** Round trip times of a request/response session */
+struct lwiperf_rtt_stats
+{
+  /** Completed request/response exchanges */
+  u32_t count;
+  u32_t min_us;
+  u32_t avg_us;
+  u32_t max_us;
+  /** Mean difference between consecutive round trip times */
+  u32_t jitter_us;
+};
+
+/** Prototype of a report function that is called when a request/response
+    session is finished.
+    @param arg Report_arg from when the test was started.
+    @param report_type LWIPERF_TCP_DONE_CLIENT_TX or the reason for the abort
+    @param stats Round trip times measured until then
+*/
+typedef void (*lwiperf_rtt_report_fn)(void *arg, enum lwiperf_report_type report_type,
+  const struct lwiperf_rtt_stats *stats);
+
+void* lwiperf_start_tcp_rtt_client(const ip_addr_t* remote_addr, u16_t remote_port,
+                                   u32_t count, u16_t payload_len,
+                                   lwiperf_rtt_report_fn report_fn, void* report_arg);
+void* lwiperf_start_tcp_echo_server(const ip_addr_t* local_addr, u16_t local_port);
+
 void  lwiperf_abort(void* lwiperf_session);
 
 
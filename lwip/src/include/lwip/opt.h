@@ -121,6 +121,17 @@
 #if !defined LWIP_TIMERS_CUSTOM || defined __DOXYGEN__
 #define LWIP_TIMERS_CUSTOM              0
 #endif
+
+/**
+ * LWIP_TIMERS_WHEEL==1: Keep the sys_timeout() timeouts in a hierarchical
+ * timer wheel instead of a list sorted by expiry time. Adding and removing a
+ * timeout is then O(1), independent of the number of active timeouts, at the
+ * cost of a fixed table of slot pointers (about 1.6 kB).
+ * Only used with LWIP_TIMERS && !LWIP_TIMERS_CUSTOM.
+ */
+#if !defined LWIP_TIMERS_WHEEL || defined __DOXYGEN__
+#define LWIP_TIMERS_WHEEL               0
+#endif
 /**
  * @}
  */
@@ -1330,6 +1341,17 @@
 #define LWIP_TCP_SACK_OUT               0
 #endif
 
+/**
+ * LWIP_TCP_SACK_IN==1: TCP will process selective acknowledgements (SACKs)
+ * received from the remote host. Segments reported as received are kept out
+ * of fast recovery, which retransmits only the holes between them and stays
+ * in recovery on partial ACKs instead of waiting for the RTO.
+ * Needs LWIP_TCP_SACK_OUT, which negotiates SACK with the remote host.
+ */
+#if !defined LWIP_TCP_SACK_IN || defined __DOXYGEN__
+#define LWIP_TCP_SACK_IN                0
+#endif
+
 /**
  * LWIP_TCP_MAX_SACK_NUM: The maximum number of SACK values to include in TCP segments.
  * Must be at least 1, but is only used if LWIP_TCP_SACK_OUT is enabled.
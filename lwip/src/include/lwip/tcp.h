@@ -316,6 +316,13 @@ struct tcp_pcb {
   /* first byte following last rto byte */
   u32_t rto_end;
 
+#if LWIP_TCP_SACK_IN
+  /* first byte following the highest byte SACKed by the remote host */
+  u32_t sack_high;
+  /* snd_nxt when fast recovery started, ACKs below it are partial */
+  u32_t sack_recover;
+#endif /* LWIP_TCP_SACK_IN */
+
   /* sender variables */
   u32_t snd_nxt;   /* next new seqno to be sent */
   u32_t snd_wl1, snd_wl2; /* Sequence and acknowledgement numbers of last
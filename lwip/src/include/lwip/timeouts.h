@@ -98,6 +98,16 @@ struct sys_timeo {
 #if LWIP_DEBUG_TIMERNAMES
   const char* handler_name;
 #endif /* LWIP_DEBUG_TIMERNAMES */
+#if LWIP_TIMERS_WHEEL
+  /** link to the 'next' pointer pointing to this timeout in its wheel slot */
+  struct sys_timeo **pprev;
+  /** chain of timeouts with the same handler/arg hash */
+  struct sys_timeo *hnext;
+  struct sys_timeo **hpprev;
+  /** wheel level and slot the timeout is linked into */
+  u8_t level;
+  u8_t slot;
+#endif /* LWIP_TIMERS_WHEEL */
 };
 
 void sys_timeouts_init(void);
@@ -115,7 +125,9 @@ void sys_check_timeouts(void);
 u32_t sys_timeouts_sleeptime(void);
 
 #if LWIP_TESTMODE
+#if !LWIP_TIMERS_WHEEL
 struct sys_timeo** sys_timeouts_get_next_timeout(void);
+#endif /* !LWIP_TIMERS_WHEEL */
 void lwip_cyclic_timer(void *arg);
 #endif
 
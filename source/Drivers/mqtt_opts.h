@@ -92,6 +92,22 @@ extern "C" {
 #define MQTT_CONNECT_TIMOUT 100
 #endif
 
+/**
+ * Called when a publish message is queued for sending, with its packet id
+ * (0 for QoS 0) and payload length.
+ */
+#ifndef MQTT_HOOK_PUBLISH
+#define MQTT_HOOK_PUBLISH(pkt_id, len)
+#endif
+
+/**
+ * Called when the server answers a request, with the message type of the
+ * answer (PUBACK, PUBCOMP, SUBACK or UNSUBACK) and the packet id.
+ */
+#ifndef MQTT_HOOK_RESPONSE
+#define MQTT_HOOK_RESPONSE(msg_type, pkt_id)
+#endif
+
 /**
  * @}
  */
@@ -49,6 +49,7 @@
 #define configUSE_16_BIT_TICKS                  0
 #define configIDLE_SHOULD_YIELD                 1
 #define configUSE_TASK_NOTIFICATIONS            1
+#define configTASK_NOTIFICATION_ARRAY_ENTRIES   2 /* Index 1 is used by the lwIP mailboxes */
 #define configUSE_MUTEXES                       1
 #define configUSE_RECURSIVE_MUTEXES             1
 #define configUSE_COUNTING_SEMAPHORES           1
@@ -60,15 +61,22 @@
 #define configENABLE_BACKWARD_COMPATIBILITY     1
 #define configNUM_THREAD_LOCAL_STORAGE_POINTERS 5
 
-/* Used memory allocation (heap_x.c) */
-#define configFRTOS_MEMORY_SCHEME               3
+/* Used memory allocation: heap_tlsf.c, heap_3.c is excluded from the build in .cproject.
+ * configFRTOS_MEMORY_SCHEME follows from it in freertos_tasks_c_additions.h (0, none
+ * of heap_1..5, so the debugger does not interpret the heap). */
+#define configUSE_HEAP_TLSF                     1
 /* Tasks.c additions (e.g. Thread Aware Debug capability) */
 #define configINCLUDE_FREERTOS_TASK_C_ADDITIONS_H 1
 
 /* Memory allocation related definitions. */
 #define configSUPPORT_STATIC_ALLOCATION         0
 #define configSUPPORT_DYNAMIC_ALLOCATION        1
-//#define configTOTAL_HEAP_SIZE                   ((size_t)(35 * 1024))
+/* Replaces the newlib heap and the lwIP MEM_SIZE heap. 120 KB is the smallest size
+ * the trace replay of test/heap_tlsf_test.c runs without a failed allocation. Newlib
+ * keeps 16 KB (.cproject): nothing in the build calls malloc() directly (mflash and
+ * OSA use pvPortMalloc(), SDK_Malloc() has no callers, printf has no float support
+ * and mbedTLS is not built), which leaves newlib-nano internals only. */
+#define configTOTAL_HEAP_SIZE                   ((size_t)(120 * 1024))
 #define configAPPLICATION_ALLOCATED_HEAP        0
 
 /* Hook function related definitions. */
@@ -78,10 +86,51 @@
 #define configUSE_MALLOC_FAILED_HOOK            0
 #define configUSE_DAEMON_TASK_STARTUP_HOOK      0
 
-/* Run time and task stats gathering related definitions. */
-#define configGENERATE_RUN_TIME_STATS 0
+/* Run time and task stats gathering related definitions. The run time comes
+ * from the DWT cycle counter (cpu_stats.c), the context switches of each task
+ * are counted in its last thread local storage pointer. */
+#define configGENERATE_RUN_TIME_STATS 1
 #define configUSE_TRACE_FACILITY 1
 #define configUSE_STATS_FORMATTING_FUNCTIONS 1
+#define configRUN_TIME_COUNTER_TYPE uint64_t
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS() cpu_stats_init()
+#define portGET_RUN_TIME_COUNTER_VALUE() cpu_stats_counter()
+#define CPU_STATS_SWITCH_TLS_INDEX (configNUM_THREAD_LOCAL_STORAGE_POINTERS - 1)
+#define traceTASK_SWITCHED_IN()                                                                               \
+    do                                                                                                        \
+    {                                                                                                         \
+        pxCurrentTCB->pvThreadLocalStoragePointers[CPU_STATS_SWITCH_TLS_INDEX] =                              \
+            (void *)((uintptr_t)pxCurrentTCB->pvThreadLocalStoragePointers[CPU_STATS_SWITCH_TLS_INDEX] + 1U); \
+        event_trace_add(EVENT_TRACE_TASK_IN, pxCurrentTCB->uxTCBNumber, 0U);                                  \
+    } while (0)
+
+/* Events of the binary trace ring (event_trace.c). Semaphores and mutexes go
+ * through the queue hooks too, the queue type tells them apart. */
+#define traceQUEUE_SEND(pxQueue) \
+    event_trace_add(EVENT_TRACE_QUEUE_SEND, (pxQueue)->ucQueueType, (uint32_t)(uintptr_t)(pxQueue))
+#define traceQUEUE_SEND_FROM_ISR(pxQueue) traceQUEUE_SEND(pxQueue)
+#define traceQUEUE_RECEIVE(pxQueue) \
+    event_trace_add(EVENT_TRACE_QUEUE_RECEIVE, (pxQueue)->ucQueueType, (uint32_t)(uintptr_t)(pxQueue))
+#define traceQUEUE_RECEIVE_FROM_ISR(pxQueue) traceQUEUE_RECEIVE(pxQueue)
+/* Interrupts. Of the kernel handlers only SysTick calls traceISR_ENTER(), but
+ * portYIELD_FROM_ISR() calls traceISR_EXIT() in every handler that wakes a
+ * task, so the exits of other exceptions are not recorded. Handlers outside
+ * the kernel record themselves with traceISR_HANDLER_ENTER/EXIT (the Wi-Fi
+ * IMU handler in fsl_adapter_imu.c). */
+#define EVENT_TRACE_SYSTICK_EXCEPTION 15U
+#define traceISR_ENTER()              event_trace_add(EVENT_TRACE_ISR_ENTER, __get_IPSR(), 0U)
+#define traceISR_EXIT_ARG(arg)                                                               \
+    do                                                                                       \
+    {                                                                                        \
+        if (__get_IPSR() == EVENT_TRACE_SYSTICK_EXCEPTION)                                   \
+        {                                                                                    \
+            event_trace_add(EVENT_TRACE_ISR_EXIT, EVENT_TRACE_SYSTICK_EXCEPTION, (arg));     \
+        }                                                                                    \
+    } while (0)
+#define traceISR_EXIT()               traceISR_EXIT_ARG(0U)
+#define traceISR_EXIT_TO_SCHEDULER()  traceISR_EXIT_ARG(1U)
+#define traceISR_HANDLER_ENTER()      event_trace_add(EVENT_TRACE_ISR_ENTER, __get_IPSR(), 0U)
+#define traceISR_HANDLER_EXIT()       event_trace_add(EVENT_TRACE_ISR_EXIT, __get_IPSR(), 0U)
 
 /* Task aware debugging. */
 #define configRECORD_STACK_HIGH_ADDRESS         1
@@ -120,6 +169,11 @@
 
 #if defined(__ICCARM__)||defined(__CC_ARM)||defined(__GNUC__)
 #include "fsl_device_registers.h"
+
+#include "event_trace.h"
+
+void cpu_stats_init(void);
+uint64_t cpu_stats_counter(void);
 #endif
 
 
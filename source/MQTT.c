@@ -24,6 +24,8 @@
 #include "Drivers/LED.h"
 #include "Drivers/GPIO.h"
 #include "Drivers/BUTTON.h"
+#include "perf_runner.h"
+#include "cpu_stats.h"
 
 /*! @brief MQTT server host name or IP address. */
 #ifndef EXAMPLE_MQTT_SERVER_HOST
@@ -47,6 +49,12 @@
 /*! @brief Priority of the temporary initialization thread. */
 #define APP_THREAD_PRIO DEFAULT_THREAD_PRIO
 
+/*! @brief Period of the CPU statistics messages in milliseconds. */
+#define DIAG_CPU_INTERVAL_MS 10000
+
+/*! @brief Delay between the messages of two tasks in milliseconds. */
+#define DIAG_CPU_STEP_MS 100
+
 /*******************************************************************************
  * Prototypes
  ******************************************************************************/
@@ -86,6 +94,13 @@ static volatile bool connected = false;
 
 uint8_t received_topic;
 
+/*! @brief received_topic value of TOPIC_PERF_CMD. */
+#define PERF_CMD_TOPIC_ID 7
+
+/*! @brief Benchmark command being received, may arrive in several fragments. */
+static char perf_cmd[128];
+static uint32_t perf_cmd_len;
+
 uint8_t r,g,b;
 
 uint8_t temp = 20;
@@ -133,6 +148,36 @@ static void check_topic(const char *topic){
 #endif
 		i++;
 	}
+
+	if (strncmp(topic, TOPIC_PERF_CMD, strlen(TOPIC_PERF_CMD)) == 0){
+		received_topic = PERF_CMD_TOPIC_ID;
+		perf_cmd_len = 0;
+	}
+}
+
+/*!
+ * @brief Collects a benchmark command and starts it once complete.
+ */
+static void manage_perf_cmd(const u8_t *data, u16_t len, u8_t flags)
+{
+    if (perf_cmd_len + len < sizeof(perf_cmd))
+    {
+        memcpy(&perf_cmd[perf_cmd_len], data, len);
+    }
+    perf_cmd_len += len;
+
+    if (flags & MQTT_DATA_FLAG_LAST)
+    {
+        if (perf_cmd_len < sizeof(perf_cmd))
+        {
+            perf_cmd[perf_cmd_len] = '\0';
+            if (perf_runner_start(perf_cmd) != 0)
+            {
+                PRINTF("perf: cannot start \"%s\"\r\n", perf_cmd);
+            }
+        }
+        perf_cmd_len = 0;
+    }
 }
 
 #if defined(DEVICE1) && !defined(DEVICE2)
@@ -260,6 +305,10 @@ static void mqtt_incoming_data_cb(void *arg, const u8_t *data, u16_t len, u8_t f
         }
     }
 
+    if (received_topic == PERF_CMD_TOPIC_ID)
+    {
+        manage_perf_cmd(data, len, flags);
+    }
 #if defined(DEVICE1) && !defined(DEVICE2)
         if(received_topic == 4){
         	manage_smoke_topic(data);
@@ -289,13 +338,13 @@ static void mqtt_incoming_data_cb(void *arg, const u8_t *data, u16_t len, u8_t f
 static void mqtt_subscribe_topics(mqtt_client_t *client)
 {
 #if defined(DEVICE1) && !defined(DEVICE2)
-    static const char *topics[] = {"smoke_detect/#", "night_light/#"};
+    static const char *topics[] = {"smoke_detect/#", "night_light/#", TOPIC_PERF_CMD "/#"};
 #endif
 #if defined(DEVICE2) && !defined(DEVICE1)
-    static const char *topics[] = {"temp_measure/#", "relax_music/#"};
+    static const char *topics[] = {"temp_measure/#", "relax_music/#", TOPIC_PERF_CMD "/#"};
 #endif
 
-    int qos[]                   = {0, 0};
+    int qos[]                   = {0, 0, 0};
     err_t err;
     int i;
 
@@ -393,6 +442,59 @@ static void mqtt_message_published_cb(void *arg, err_t err)
     }
 }
 
+/*!
+ * @brief Publishes the result of a benchmark. Called on tcpip_thread.
+ */
+static void publish_perf_result(const char *json)
+{
+    static const char *topic = TOPIC_PERF_RESULT;
+
+    if (connected)
+    {
+        mqtt_publish(mqtt_client, topic, json, strlen(json), 1, 0, mqtt_message_published_cb, (void *)topic);
+    }
+}
+
+/*!
+ * @brief Publishes the CPU statistics of one task and schedules the next one.
+ * Called on tcpip_thread.
+ */
+static void publish_cpu_stats(void *arg)
+{
+    static const char *topic = TOPIC_DIAG_CPU;
+    static unsigned int slot = 0;
+    struct cpu_stats_task task;
+    char message[128];
+    int len;
+
+    LWIP_UNUSED_ARG(arg);
+
+    /* Skip the free slots, a few messages are spread over every period */
+    while ((slot < CPU_STATS_MAX_TASKS) && !cpu_stats_read(slot, &task))
+    {
+        slot++;
+    }
+
+    if (slot >= CPU_STATS_MAX_TASKS)
+    {
+        slot = 0;
+        sys_timeout(DIAG_CPU_INTERVAL_MS, publish_cpu_stats, NULL);
+        return;
+    }
+    slot++;
+
+    if (connected)
+    {
+        len = snprintf(message, sizeof(message),
+                       "{\"task\":\"%s\",\"load\":%u,\"load_long\":%u,\"switches\":%u,\"switches_long\":%u}",
+                       task.name, (unsigned int)task.load, (unsigned int)task.load_long,
+                       (unsigned int)task.switches, (unsigned int)task.switches_long);
+        mqtt_publish(mqtt_client, topic, message, (u16_t)len, 0, 0, NULL, NULL);
+    }
+
+    sys_timeout(DIAG_CPU_STEP_MS, publish_cpu_stats, NULL);
+}
+
 /*!
  * @brief Publishes a message. To be called on tcpip_thread.
  */
@@ -648,6 +750,8 @@ void mqtt_freertos_run_thread(struct netif *netif)
 {
     LOCK_TCPIP_CORE();
     mqtt_client = mqtt_client_new();
+    perf_runner_set_result_fn(publish_perf_result);
+    sys_timeout(DIAG_CPU_INTERVAL_MS, publish_cpu_stats, NULL);
     UNLOCK_TCPIP_CORE();
     if (mqtt_client == NULL)
     {
@@ -27,6 +27,13 @@
 #define TOPIC5 "relax_music"
 #endif
 
+/* Network benchmark commands (perf_runner.h query strings) and their results */
+#define TOPIC_PERF_CMD    "perf_cmd"
+#define TOPIC_PERF_RESULT "perf_result"
+
+/* Per-task CPU load in 0.01 % and context switches (cpu_stats.h), one message per task */
+#define TOPIC_DIAG_CPU "diag/cpu"
+
 /*!
  * @brief Create and run example thread
  *
@@ -0,0 +1,235 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "capture.h"
+#include "http_server.h"
+#include "metrics.h"
+
+#include "netif_capture.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if LWIP_NETIF_CAPTURE
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/* pcapng block types and options */
+#define PCAPNG_BLOCK_SHB    0x0A0D0D0AUL
+#define PCAPNG_BLOCK_IDB    0x00000001UL
+#define PCAPNG_BLOCK_EPB    0x00000006UL
+#define PCAPNG_BYTE_ORDER   0x1A2B3C4DUL
+#define PCAPNG_LINKTYPE_ETH 1U
+#define PCAPNG_OPT_END      0U
+#define PCAPNG_OPT_TSRESOL  9U /* if_tsresol */
+#define PCAPNG_OPT_FLAGS    2U /* epb_flags */
+#define PCAPNG_FLAGS_IN     1U
+#define PCAPNG_FLAGS_OUT    2U
+
+/* Packs an option header, code in the low half */
+#define PCAPNG_OPT(code, len) ((uint32_t)(code) | ((uint32_t)(len) << 16))
+
+/*******************************************************************************
+ * Prototypes
+ ******************************************************************************/
+
+static uint32_t capture_get_enabled(void);
+static void capture_set_enabled(uint32_t enabled);
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+static metrics_recorder_t capture_recorder = {capture_get_enabled, capture_set_enabled, 0U, 0U};
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+static uint32_t capture_get_enabled(void)
+{
+    struct netif_capture_filter filter;
+
+    netif_capture_get_filter(&filter);
+    return filter.enabled;
+}
+
+static void capture_set_enabled(uint32_t enabled)
+{
+    struct netif_capture_filter filter;
+
+    netif_capture_get_filter(&filter);
+    filter.enabled = (enabled != 0U) ? 1U : 0U;
+    netif_capture_set_filter(&filter);
+}
+
+/* Section header and the description of the one interface, timestamps in ms */
+static void capture_write_header(metrics_writer_t *writer, uint32_t snaplen)
+{
+    const uint32_t shb[7] = {PCAPNG_BLOCK_SHB, sizeof(shb), PCAPNG_BYTE_ORDER,
+                             1U /* version 1.0 */, 0xFFFFFFFFUL, 0xFFFFFFFFUL /* unknown section length */,
+                             sizeof(shb)};
+    const uint32_t idb[8] = {PCAPNG_BLOCK_IDB,
+                             sizeof(idb),
+                             PCAPNG_LINKTYPE_ETH,
+                             snaplen,
+                             PCAPNG_OPT(PCAPNG_OPT_TSRESOL, 1U),
+                             3U /* 10^-3 s */,
+                             PCAPNG_OPT(PCAPNG_OPT_END, 0U),
+                             sizeof(idb)};
+
+    metrics_write(writer, shb, sizeof(shb));
+    metrics_write(writer, idb, sizeof(idb));
+}
+
+/* One enhanced packet block, the direction goes into epb_flags */
+static void capture_write_record(metrics_writer_t *writer, const struct netif_capture_record *record)
+{
+    static const uint8_t pad[3] = {0};
+    uint32_t padded = (record->cap_len + 3U) & ~3U;
+    uint32_t len    = 7U * 4U + padded + 3U * 4U + 4U;
+    uint32_t head[7];
+    uint32_t tail[4];
+
+    head[0] = PCAPNG_BLOCK_EPB;
+    head[1] = len;
+    head[2] = 0U; /* interface */
+    head[3] = 0U; /* timestamp high */
+    head[4] = record->time_ms;
+    head[5] = record->cap_len;
+    head[6] = record->orig_len;
+
+    tail[0] = PCAPNG_OPT(PCAPNG_OPT_FLAGS, 4U);
+    tail[1] = (record->dir == (uint8_t)NETIF_CAPTURE_IN) ? PCAPNG_FLAGS_IN : PCAPNG_FLAGS_OUT;
+    tail[2] = PCAPNG_OPT(PCAPNG_OPT_END, 0U);
+    tail[3] = len;
+
+    metrics_write(writer, head, sizeof(head));
+    metrics_write(writer, record->data, record->cap_len);
+    metrics_write(writer, pad, padded - record->cap_len);
+    metrics_write(writer, tail, sizeof(tail));
+}
+
+/* Streams the ring as pcapng, oldest frame first */
+static void capture_dump(HTTPSRV_CGI_REQ_STRUCT *param)
+{
+    struct netif_capture_filter filter;
+    struct netif_capture_record record;
+    metrics_writer_t *writer;
+    uint32_t count;
+    uint32_t seq;
+
+    writer = metrics_writer_open(param, HTTPSRV_CONTENT_TYPE_OCTETSTREAM);
+    if (writer == NULL)
+    {
+        return;
+    }
+
+    metrics_recorder_pause(&capture_recorder);
+    netif_capture_get_filter(&filter);
+
+    capture_write_header(writer, filter.snaplen);
+
+    count = netif_capture_count();
+    seq   = (count > NETIF_CAPTURE_RECORDS) ? (count - NETIF_CAPTURE_RECORDS) : 0U;
+    for (; seq != count; seq++)
+    {
+        if (netif_capture_read(seq, &record))
+        {
+            capture_write_record(writer, &record);
+        }
+    }
+
+    metrics_recorder_resume(&capture_recorder);
+
+    metrics_writer_close(writer);
+}
+
+/* Reads one numeric filter parameter from the query string, returns false when it is missing */
+static bool capture_get_param(char *query, char *name, uint32_t *value)
+{
+    char str[8];
+
+    if (!cgi_get_varval(query, name, str, sizeof(str)))
+    {
+        return false;
+    }
+
+    *value = strtoul(str, NULL, 10);
+    return true;
+}
+
+int capture_cgi_handler(HTTPSRV_CGI_REQ_STRUCT *param)
+{
+    HTTPSRV_CGI_RES_STRUCT response = {0};
+    struct netif_capture_filter filter;
+    char buffer[96] = {0};
+    bool set_proto   = false;
+    bool set_port    = false;
+    bool set_snaplen = false;
+    uint32_t proto   = 0;
+    uint32_t port    = 0;
+    uint32_t snaplen = 0;
+    uint32_t value;
+
+    if (param->request_method != HTTPSRV_REQ_GET)
+    {
+        return 0;
+    }
+
+    if ((param->query_string == NULL) || (param->query_string[0] == '\0'))
+    {
+        capture_dump(param);
+        return 0;
+    }
+
+    set_proto   = capture_get_param(param->query_string, "proto", &proto);
+    set_port    = capture_get_param(param->query_string, "port", &port);
+    set_snaplen = capture_get_param(param->query_string, "snaplen", &snaplen);
+    if (set_proto || set_port || set_snaplen)
+    {
+        /* Not between the get and set of a download pausing the capture */
+        taskENTER_CRITICAL();
+        netif_capture_get_filter(&filter);
+        filter.proto   = set_proto ? (uint8_t)proto : filter.proto;
+        filter.port    = set_port ? (uint16_t)port : filter.port;
+        filter.snaplen = set_snaplen ? (uint16_t)snaplen : filter.snaplen;
+        netif_capture_set_filter(&filter);
+        taskEXIT_CRITICAL();
+    }
+    if (capture_get_param(param->query_string, "enable", &value))
+    {
+        metrics_recorder_set(&capture_recorder, (value != 0U) ? 1U : 0U);
+    }
+
+    netif_capture_get_filter(&filter);
+    snprintf(buffer, sizeof(buffer), "{\"enable\":%u,\"proto\":%u,\"port\":%u,\"snaplen\":%u,\"count\":%u}",
+             (unsigned int)metrics_recorder_get(&capture_recorder), filter.proto, filter.port, filter.snaplen,
+             (unsigned int)netif_capture_count());
+
+    response.ses_handle     = param->ses_handle;
+    response.status_code    = HTTPSRV_CODE_OK;
+    response.content_type   = HTTPSRV_CONTENT_TYPE_PLAIN;
+    response.data           = buffer;
+    response.data_length    = strlen(buffer);
+    response.content_length = response.data_length;
+    HTTPSRV_cgi_write(&response);
+
+    return (response.content_length);
+}
+
+#endif /* LWIP_NETIF_CAPTURE */
@@ -0,0 +1,30 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include "httpsrv.h"
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+/*!
+ * @brief capture.cgi handler
+ *
+ * Without a query string the packet capture ring is returned as a pcapng
+ * file, the capture is paused while it is sent. With any of the query
+ * parameters proto, port, snaplen and enable the capture filter is changed
+ * instead and the new filter is returned as JSON.
+ *
+ * @param param  CGI request
+ */
+int capture_cgi_handler(HTTPSRV_CGI_REQ_STRUCT *param);
+
+#endif /* CAPTURE_H */
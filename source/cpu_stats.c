@@ -0,0 +1,230 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "cpu_stats.h"
+
+#include "task.h"
+#include "timers.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/* Run time of one task over the last sample periods */
+struct cpu_stats_slot
+{
+    TaskHandle_t handle;
+    UBaseType_t number; /* tells a new task from a deleted one with the same handle */
+    char name[configMAX_TASK_NAME_LEN];
+    uint64_t runtime;                       /* run time counter at the last sample */
+    uint32_t switches;                      /* switch count at the last sample */
+    uint32_t run[CPU_STATS_HISTORY];        /* cycles run in each sample period */
+    uint32_t switched[CPU_STATS_HISTORY];   /* switches in each sample period */
+};
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+static struct cpu_stats_slot cpu_slots[CPU_STATS_MAX_TASKS];
+static TaskStatus_t cpu_status[CPU_STATS_MAX_TASKS];
+static uint32_t cpu_elapsed[CPU_STATS_HISTORY]; /* cycles of each sample period */
+static uint64_t cpu_last_sample;
+static uint32_t cpu_samples;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+void cpu_stats_init(void)
+{
+    DCB->DEMCR |= DCB_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+uint64_t cpu_stats_counter(void)
+{
+    static uint32_t last;
+    static uint32_t wraps;
+    uint32_t primask = __get_PRIMASK();
+    uint32_t now;
+    uint64_t value;
+
+    /* Called with and without interrupts masked */
+    __disable_irq();
+    now = DWT->CYCCNT;
+    if (now < last)
+    {
+        wraps++;
+    }
+    last  = now;
+    value = ((uint64_t)wraps << 32) | now;
+    __set_PRIMASK(primask);
+
+    return value;
+}
+
+/* Finds the slot of a task, or a free slot for it */
+static struct cpu_stats_slot *cpu_stats_slot(const TaskStatus_t *status)
+{
+    struct cpu_stats_slot *free_slot = NULL;
+    uint32_t i;
+
+    for (i = 0; i < CPU_STATS_MAX_TASKS; i++)
+    {
+        if ((cpu_slots[i].handle == status->xHandle) && (cpu_slots[i].number == status->xTaskNumber))
+        {
+            return &cpu_slots[i];
+        }
+        if ((cpu_slots[i].handle == NULL) && (free_slot == NULL))
+        {
+            free_slot = &cpu_slots[i];
+        }
+    }
+
+    if (free_slot != NULL)
+    {
+        /* Counted from now on */
+        (void)memset(free_slot, 0, sizeof(*free_slot));
+        free_slot->handle   = status->xHandle;
+        free_slot->number   = status->xTaskNumber;
+        free_slot->runtime  = status->ulRunTimeCounter;
+        free_slot->switches = (uint32_t)(uintptr_t)pvTaskGetThreadLocalStoragePointer(status->xHandle,
+                                                                                       CPU_STATS_SWITCH_TLS_INDEX);
+        (void)strncpy(free_slot->name, status->pcTaskName, sizeof(free_slot->name) - 1U);
+    }
+    return free_slot;
+}
+
+/* Timer callback, adds one sample period to the history of every task */
+static void cpu_stats_sample(TimerHandle_t timer)
+{
+    struct cpu_stats_slot *slot;
+    bool seen[CPU_STATS_MAX_TASKS];
+    UBaseType_t count;
+    UBaseType_t i;
+    uint64_t now;
+    uint32_t period;
+    uint32_t switches;
+
+    (void)timer;
+
+    /* Keeps tasks from being deleted while their counters are read */
+    vTaskSuspendAll();
+
+    count  = uxTaskGetSystemState(cpu_status, CPU_STATS_MAX_TASKS, NULL);
+    now    = cpu_stats_counter();
+    period = cpu_samples % CPU_STATS_HISTORY;
+
+    cpu_elapsed[period] = (uint32_t)(now - cpu_last_sample);
+    cpu_last_sample     = now;
+
+    (void)memset(seen, 0, sizeof(seen));
+    for (i = 0; i < count; i++)
+    {
+        slot = cpu_stats_slot(&cpu_status[i]);
+        if (slot == NULL)
+        {
+            continue;
+        }
+        seen[slot - cpu_slots] = true;
+
+        switches = (uint32_t)(uintptr_t)pvTaskGetThreadLocalStoragePointer(cpu_status[i].xHandle,
+                                                                           CPU_STATS_SWITCH_TLS_INDEX);
+        slot->run[period]      = (uint32_t)(cpu_status[i].ulRunTimeCounter - slot->runtime);
+        slot->switched[period] = switches - slot->switches;
+        slot->runtime          = cpu_status[i].ulRunTimeCounter;
+        slot->switches         = switches;
+    }
+
+    /* Slots of deleted tasks are freed */
+    for (i = 0; i < CPU_STATS_MAX_TASKS; i++)
+    {
+        if (!seen[i])
+        {
+            cpu_slots[i].handle = NULL;
+        }
+    }
+
+    cpu_samples++;
+
+    (void)xTaskResumeAll();
+}
+
+int cpu_stats_start(void)
+{
+    TimerHandle_t timer;
+
+    cpu_last_sample = cpu_stats_counter();
+
+    timer = xTimerCreate("cpu_stats", pdMS_TO_TICKS(CPU_STATS_SAMPLE_MS), pdTRUE, NULL, cpu_stats_sample);
+    if ((timer == NULL) || (xTimerStart(timer, 0) != pdPASS))
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+/* Share of run in elapsed, in 0.01 % */
+static uint16_t cpu_stats_load(uint64_t run, uint64_t elapsed)
+{
+    if (elapsed == 0U)
+    {
+        return 0;
+    }
+    return (uint16_t)((run * 10000U) / elapsed);
+}
+
+int cpu_stats_read(unsigned int slot, struct cpu_stats_task *task)
+{
+    const struct cpu_stats_slot *src;
+    uint64_t elapsed = 0;
+    uint64_t run     = 0;
+    uint32_t periods;
+    uint32_t last;
+    uint32_t i;
+    int ret = 0;
+
+    if (slot >= CPU_STATS_MAX_TASKS)
+    {
+        return 0;
+    }
+    src = &cpu_slots[slot];
+
+    vTaskSuspendAll();
+
+    if ((src->handle != NULL) && (cpu_samples > 0U))
+    {
+        periods = (cpu_samples < CPU_STATS_HISTORY) ? cpu_samples : CPU_STATS_HISTORY;
+        last    = (cpu_samples - 1U) % CPU_STATS_HISTORY;
+
+        (void)memcpy(task->name, src->name, sizeof(task->name));
+        task->load          = cpu_stats_load(src->run[last], cpu_elapsed[last]);
+        task->switches      = src->switched[last];
+        task->switches_long = 0;
+        for (i = 0; i < periods; i++)
+        {
+            run += src->run[i];
+            elapsed += cpu_elapsed[i];
+            task->switches_long += src->switched[i];
+        }
+        task->load_long = cpu_stats_load(run, elapsed);
+        ret             = 1;
+    }
+
+    (void)xTaskResumeAll();
+
+    return ret;
+}
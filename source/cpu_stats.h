@@ -0,0 +1,79 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef CPU_STATS_H
+#define CPU_STATS_H
+
+#include "FreeRTOS.h"
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/* Number of tasks tracked, further tasks are not reported */
+#ifndef CPU_STATS_MAX_TASKS
+#define CPU_STATS_MAX_TASKS 24
+#endif
+
+/* Length of one sample period in ms */
+#ifndef CPU_STATS_SAMPLE_MS
+#define CPU_STATS_SAMPLE_MS 1000
+#endif
+
+/* Number of sample periods in the long window */
+#ifndef CPU_STATS_HISTORY
+#define CPU_STATS_HISTORY 10
+#endif
+
+/* CPU use of one task */
+struct cpu_stats_task
+{
+    char name[configMAX_TASK_NAME_LEN];
+    uint16_t load;          /* share of the CPU in the last sample period, in 0.01 % */
+    uint16_t load_long;     /* share over the last CPU_STATS_HISTORY sample periods, in 0.01 % */
+    uint32_t switches;      /* times the task was switched in during the last sample period */
+    uint32_t switches_long; /* the same over the last CPU_STATS_HISTORY sample periods */
+};
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+/*!
+ * @brief Enables the DWT cycle counter, called by the scheduler at start
+ */
+void cpu_stats_init(void);
+
+/*!
+ * @brief Returns the run time counter, the DWT cycle counter extended to 64 bits
+ *
+ * Called by the scheduler on every context switch. The counter wraps every few
+ * seconds, so it must also be read more often than that, which the sampling
+ * timer does.
+ */
+uint64_t cpu_stats_counter(void);
+
+/*!
+ * @brief Starts sampling the run time of the tasks every CPU_STATS_SAMPLE_MS
+ *
+ * @return 0 on success, -1 if the timer could not be created
+ */
+int cpu_stats_start(void);
+
+/*!
+ * @brief Copies the CPU use of the task in a slot
+ *
+ * @param slot  0 to CPU_STATS_MAX_TASKS - 1
+ * @param task  CPU use of the task
+ * @return 1 if the slot holds a task, 0 if it is empty
+ */
+int cpu_stats_read(unsigned int slot, struct cpu_stats_task *task);
+
+#endif /* CPU_STATS_H */
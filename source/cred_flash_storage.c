@@ -11,6 +11,7 @@
 #include "fsl_debug_console.h"
 #include "mflash_file.h"
 #include "wpl.h"
+#include "dhcp-server.h"
 
 #define FILE_HEADER "wifi_credentials:"
 
@@ -39,7 +40,9 @@ static uint32_t save_file(char *filename, char *data, uint32_t data_len)
 uint32_t init_flash_storage(char *filename)
 {
     /* Flash structure */
-    mflash_file_t file_table[] = {{.path = filename, .max_size = 200}, {0}};
+    mflash_file_t file_table[] = {{.path = filename, .max_size = 200},
+                                  {.path = DHCP_LEASES_FILENAME, .max_size = DHCP_SERVER_LEASE_STORE_SIZE},
+                                  {0}};
 
     if (mflash_init(file_table, 1) != kStatus_Success)
     {
@@ -164,3 +167,26 @@ uint32_t reset_saved_wifi_credentials(char *filename)
     }
     return save_file(filename, "", 1);
 }
+
+int save_dhcp_leases(const void *data, uint32_t len)
+{
+    return (save_file(DHCP_LEASES_FILENAME, (char *)data, len) == 0) ? WM_SUCCESS : -WM_FAIL;
+}
+
+int load_dhcp_leases(void *data, uint32_t len)
+{
+    uint8_t *leases_buf;
+    uint32_t data_len = 0;
+
+    if (mflash_file_mmap(DHCP_LEASES_FILENAME, &leases_buf, &data_len) != kStatus_Success)
+    {
+        return -WM_FAIL;
+    }
+    if (data_len > len)
+    {
+        data_len = len;
+    }
+    memcpy(data, leases_buf, data_len);
+
+    return (int)data_len;
+}
@@ -19,4 +19,9 @@ uint32_t get_saved_wifi_credentials(char *filename, char *ssid, char *passphrase
 
 uint32_t reset_saved_wifi_credentials(char *filename);
 
+/* Lease store of the uAP DHCP server, see dhcp_server_set_lease_store() */
+int save_dhcp_leases(const void *data, uint32_t len);
+
+int load_dhcp_leases(void *data, uint32_t len);
+
 #endif
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "event_trace.h"
+#include "cpu_stats.h"
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+static struct event_trace_record trace_ring[EVENT_TRACE_RECORDS];
+static volatile uint32_t trace_count;
+static volatile uint32_t trace_mask = EVENT_TRACE_ALL;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+void event_trace_add(uint32_t type, uint32_t id, uint32_t arg)
+{
+    struct event_trace_record *record;
+    uint32_t primask;
+
+    if ((trace_mask & EVENT_TRACE_BIT(type)) == 0U)
+    {
+        return;
+    }
+
+    /* Also called by the kernel with interrupts masked up to the syscall priority */
+    primask = __get_PRIMASK();
+    __disable_irq();
+    record           = &trace_ring[trace_count & (EVENT_TRACE_RECORDS - 1U)];
+    record->time     = cpu_stats_counter();
+    record->type     = (uint8_t)type;
+    record->reserved = 0U;
+    record->id       = (uint16_t)id;
+    record->arg      = arg;
+    trace_count++;
+    __set_PRIMASK(primask);
+}
+
+void event_trace_set_mask(uint32_t mask)
+{
+    trace_mask = mask & EVENT_TRACE_ALL;
+}
+
+uint32_t event_trace_get_mask(void)
+{
+    return trace_mask;
+}
+
+uint32_t event_trace_count(void)
+{
+    return trace_count;
+}
+
+int event_trace_read(uint32_t seq, struct event_trace_record *record)
+{
+    uint32_t primask;
+    int ret = 0;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    /* Between the oldest record in the ring and the newest, across the counter wrap */
+    if ((trace_count - seq - 1U) < EVENT_TRACE_RECORDS)
+    {
+        *record = trace_ring[seq & (EVENT_TRACE_RECORDS - 1U)];
+        ret     = 1;
+    }
+    __set_PRIMASK(primask);
+
+    return ret;
+}
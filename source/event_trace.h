@@ -0,0 +1,113 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Binary event trace ring.
+ *
+ * The kernel trace hooks of FreeRTOSConfig.h, the Wi-Fi netif and the MQTT
+ * client call event_trace_add() for task switches, queue operations,
+ * interrupts, frames and MQTT publishes. Each event is written as one 16 byte
+ * record with a 64 bit DWT cycle count into a fixed RAM ring, the oldest
+ * records are overwritten. This header is included by FreeRTOSConfig.h, so it
+ * must not include FreeRTOS headers.
+ *
+ * trace.cgi returns the ring in this format, all little endian:
+ *   header   magic "EVTR", u16 version, u16 record size, u32 cycles per
+ *            second, u32 number of task names
+ *   names    u32 task number, char name[EVENT_TRACE_NAME_LEN]
+ *   records  struct event_trace_record until the end of the file
+ * tools/event_trace.py converts it to a Chrome trace JSON timeline.
+ */
+
+#ifndef EVENT_TRACE_H
+#define EVENT_TRACE_H
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/* Number of records in the ring, must be a power of two */
+#ifndef EVENT_TRACE_RECORDS
+#define EVENT_TRACE_RECORDS 512
+#endif
+
+/* Length of the task names in the dump */
+#define EVENT_TRACE_NAME_LEN 16
+
+#define EVENT_TRACE_MAGIC   0x52545645UL /* "EVTR" */
+#define EVENT_TRACE_VERSION 1U
+
+/* Event types, id and arg of each type are given after it */
+enum event_trace_type
+{
+    EVENT_TRACE_TASK_IN = 1,   /* task number, 0 */
+    EVENT_TRACE_QUEUE_SEND,    /* queue type, queue address */
+    EVENT_TRACE_QUEUE_RECEIVE, /* queue type, queue address */
+    EVENT_TRACE_ISR_ENTER,     /* exception number, 0 */
+    EVENT_TRACE_ISR_EXIT,      /* exception number, 1 if a context switch is pended */
+    EVENT_TRACE_NET_IN,        /* 0, frame length */
+    EVENT_TRACE_NET_OUT,       /* 0, frame length */
+    EVENT_TRACE_MQTT_PUBLISH,  /* packet id, payload length */
+    EVENT_TRACE_MQTT_ACK       /* packet id, MQTT message type */
+};
+
+/* Bit of a type in the mask of recorded events */
+#define EVENT_TRACE_BIT(type) (1UL << (uint32_t)(type))
+#define EVENT_TRACE_ALL       0x3FEUL
+
+struct event_trace_record
+{
+    uint64_t time; /* DWT cycles */
+    uint8_t type;  /* enum event_trace_type */
+    uint8_t reserved;
+    uint16_t id;
+    uint32_t arg;
+};
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+/*!
+ * @brief Records an event if its type is in the mask, callable from any task or interrupt
+ *
+ * @param type  enum event_trace_type
+ * @param id    first value of the event
+ * @param arg   second value of the event
+ */
+void event_trace_add(uint32_t type, uint32_t id, uint32_t arg);
+
+/*!
+ * @brief Sets the event types that are recorded, 0 pauses the trace
+ *
+ * @param mask  EVENT_TRACE_BIT() of each type
+ */
+void event_trace_set_mask(uint32_t mask);
+
+/*!
+ * @brief Returns the event types that are recorded
+ */
+uint32_t event_trace_get_mask(void);
+
+/*!
+ * @brief Returns the number of events recorded since start-up
+ */
+uint32_t event_trace_count(void);
+
+/*!
+ * @brief Copies a record out of the ring
+ *
+ * @param seq     sequence number of the event, counted from 0
+ * @param record  copy of the record
+ * @return 1 on success, 0 if the record was overwritten or not written yet
+ */
+int event_trace_read(uint32_t seq, struct event_trace_record *record);
+
+#endif /* EVENT_TRACE_H */
@@ -62,6 +62,9 @@ void sys_check_core_locking(void);
 void sys_mark_tcpip_thread(void);
 #define LWIP_MARK_TCPIP_THREAD() sys_mark_tcpip_thread()
 
+/* Per call site wait/hold histograms of the core lock, exported by metrics.cgi */
+#define SYS_CORE_LOCK_PROFILE 1
+
 /**
  * Loopback demo related options.
  */
@@ -148,6 +151,15 @@ void sys_mark_tcpip_thread(void);
 
 #define SYS_LIGHTWEIGHT_PROT 1
 
+/**
+ * SYS_MBOX_RING==1: Back the mailboxes (tcpip thread, netconn recv/accept)
+ * with rings of message pointers and task notification wakeups instead of
+ * FreeRTOS queues, see sys_arch.c. Uses task notification index 1, so
+ * configTASK_NOTIFICATION_ARRAY_ENTRIES must be at least 2. Off: on the host
+ * (test/mbox_bench) the ring is not faster than the queue yet.
+ */
+#define SYS_MBOX_RING 0
+
 /*
    ------------------------------------
    ---------- Memory options ----------
@@ -192,6 +204,18 @@ void sys_mark_tcpip_thread(void);
 #define MEM_SIZE (20 * 1024)
 #endif
 
+/**
+ * MEM_CUSTOM_ALLOCATOR==1: Serve mem_malloc() from the FreeRTOS TLSF heap
+ * (heap_tlsf.c) instead of a separate MEM_SIZE heap, so lwIP and the rest of
+ * the system share one pool of free memory. lwIP blocks are accounted to
+ * heapTAG_LWIP in the heap statistics.
+ */
+#include "heap_tlsf.h"
+#define MEM_CUSTOM_ALLOCATOR 1
+#define MEM_CUSTOM_MALLOC(size)         pvPortMallocTagged((size), heapTAG_LWIP)
+#define MEM_CUSTOM_CALLOC(count, size)  pvPortCallocTagged((count), (size), heapTAG_LWIP)
+#define MEM_CUSTOM_FREE                 vPortFree
+
 /*
    ------------------------------------------------
    ---------- Internal Memory Pool Sizes ----------
@@ -199,6 +223,9 @@ void sys_mark_tcpip_thread(void);
 */
 #define MEMP_USE_CUSTOM_POOLS 1
 
+/* Size class RX pbufs, see PBUF_RX_SMALL_BUFSIZE */
+#define PBUF_RX_SIZE_CLASSES 1
+
 /**
  * MEMP_NUM_PBUF: the number of memp struct pbufs (used for PBUF_ROM and PBUF_REF).
  * If the application sends a lot of data out of ROM (or other static memory),
@@ -234,7 +261,13 @@ void sys_mark_tcpip_thread(void);
  * MEMP_NUM_SYS_TIMEOUT: the number of simulateously active timeouts.
  * (requires NO_SYS==0)
  */
-#define MEMP_NUM_SYS_TIMEOUT 12
+#define MEMP_NUM_SYS_TIMEOUT 32
+
+/**
+ * LWIP_TIMERS_WHEEL==1: Keep timeouts in a timer wheel, sys_timeout() and
+ * sys_untimeout() do not walk the list of active timeouts.
+ */
+#define LWIP_TIMERS_WHEEL 1
 
 /**
  * MEMP_NUM_NETBUF: the number of struct netbufs.
@@ -253,6 +286,8 @@ void sys_mark_tcpip_thread(void);
 
 /**
  * PBUF_POOL_SIZE: the number of buffers in the pbuf pool.
+ * With PBUF_RX_SIZE_CLASSES small frames go to the class pools first, the
+ * full 40 buffers are kept for bulk transfers (test/rx_pbuf_bench).
  */
 #define PBUF_POOL_SIZE 40
 
@@ -269,6 +304,33 @@ void sys_mark_tcpip_thread(void);
  */
 #define PBUF_POOL_BUFSIZE 1580
 
+/**
+ * PBUF_RX_SIZE_CLASSES==1: Copy received Wi-Fi frames into the smallest RX
+ * buffer class that fits them: PBUF_RX_SMALL_BUFSIZE (ACKs, MQTT control
+ * packets, DNS), PBUF_RX_MEDIUM_BUFSIZE or a PBUF_POOL_BUFSIZE pool pbuf.
+ * The two small classes are custom pools declared in lwippools.h. An empty
+ * class spills over to the next larger one.
+ */
+#define PBUF_RX_SMALL_BUFSIZE    128
+#define PBUF_RX_SMALL_POOL_SIZE  32
+#define PBUF_RX_MEDIUM_BUFSIZE   512
+#define PBUF_RX_MEDIUM_POOL_SIZE 16
+
+/**
+ * PBUF_LINK_ENCAPSULATION_HLEN: headroom in front of the Ethernet header of
+ * every TX pbuf. The Wi-Fi driver builds its WMM queue entry there, a pbuf
+ * pointer, the list entry, the interface header and the TxPD (4 + 8 + 4 + 22
+ * bytes, OUTBUF_WMM_EXT_HEADROOM), and queues the frame without copying it.
+ * 38 also puts the IP header of PBUF_RAM pbufs on a word boundary.
+ */
+#define PBUF_LINK_ENCAPSULATION_HLEN 38
+
+/**
+ * LWIP_NETIF_TX_SINGLE_PBUF==1: Build TCP segments and IP fragments in one
+ * pbuf, so they get the zero-copy TX path above.
+ */
+#define LWIP_NETIF_TX_SINGLE_PBUF 1
+
 /**
  * MEMP_NUM_FRAG_PBUF: the number of IP fragments simultaneously sent
  * (fragments, not whole packets!).
@@ -363,6 +425,14 @@ void sys_mark_tcpip_thread(void);
 #define TCP_WND (10 * TCP_MSS)
 #endif
 
+/**
+ * LWIP_TCP_SACK_OUT, LWIP_TCP_SACK_IN: Negotiate selective acknowledgements
+ * and use them in both directions. On a lossy link a single lost segment then
+ * costs one retransmission instead of the rest of the window.
+ */
+#define LWIP_TCP_SACK_OUT 1
+#define LWIP_TCP_SACK_IN  1
+
 /**
  * Enable TCP_KEEPALIVE
  */
@@ -458,6 +528,41 @@ void sys_mark_tcpip_thread(void);
  */
 #define LWIP_NETIF_HOSTNAME 1
 
+/**
+ * LWIP_NETIF_IMPAIR==1: Route the Wi-Fi station netif through the link
+ * impairment shim of lwip/port/netif_impair.c, so throughput and latency can
+ * be measured under a given rate, delay, jitter, loss and reordering. The
+ * profile is set with impair.cgi and starts out as a pass-through.
+ */
+#define LWIP_NETIF_IMPAIR 0
+
+/**
+ * LWIP_NETIF_CAPTURE==1: Keep the headers of the last NETIF_CAPTURE_RECORDS
+ * frames of the Wi-Fi interfaces in the RAM ring of lwip/port/netif_capture.c.
+ * capture.cgi sets the filter and downloads the ring as a pcapng file. The
+ * capture is off until capture.cgi?enable=1.
+ */
+#define LWIP_NETIF_CAPTURE 1
+
+/**
+ * LWIP_EVENT_TRACE==1: Add the frames of the Wi-Fi interfaces and the MQTT
+ * publishes and acknowledgements to the event trace ring of
+ * source/event_trace.c, next to the kernel events. trace.cgi downloads it.
+ */
+#define LWIP_EVENT_TRACE 1
+
+#if LWIP_EVENT_TRACE
+#include "event_trace.h"
+#define MQTT_HOOK_PUBLISH(pkt_id, len)      event_trace_add(EVENT_TRACE_MQTT_PUBLISH, (pkt_id), (len))
+#define MQTT_HOOK_RESPONSE(msg_type, pkt_id) event_trace_add(EVENT_TRACE_MQTT_ACK, (pkt_id), (msg_type))
+#endif
+
+/**
+ * LWIPERF_TIME_US: Microsecond clock of the lwiperf request/response test,
+ * sys_now_us() interpolates the SysTick counter between ticks.
+ */
+#define LWIPERF_TIME_US() sys_now_us()
+
 /**
  * TCP_RESOURCE_FAIL_RETRY_LIMIT: limit for retrying sending of tcp segment
  * on resource failure error returned by driver.
@@ -466,6 +571,28 @@ void sys_mark_tcpip_thread(void);
 
 #define LWIP_COMPAT_MUTEX_ALLOWED 1
 
+/*
+   --------------------------------------
+   ---------- Checksum options ----------
+   --------------------------------------
+*/
+/**
+ * LWIP_CHECKSUM_ON_COPY==1: Calculate checksum when copying data from
+ * application buffers to pbufs (tcp_write/udp_send without zero copy).
+ */
+#define LWIP_CHECKSUM_ON_COPY 1
+
+/**
+ * Word wide checksum routines from lwip/port/chksum.c, replacing the 16-bit
+ * LWIP_CHKSUM_ALGORITHM 2 reference implementation.
+ */
+#include "lwip/arch.h"
+u16_t lwip_port_chksum(const void *dataptr, int len);
+#define LWIP_CHKSUM lwip_port_chksum
+
+u16_t lwip_port_chksum_copy(void *dst, const void *src, u16_t len);
+#define LWIP_CHKSUM_COPY(dst, src, len) lwip_port_chksum_copy(dst, src, len)
+
 #if (LWIP_DNS || LWIP_IGMP || LWIP_IPV6) && !defined(LWIP_RAND)
 /* When using IGMP or IPv6, LWIP_RAND() needs to be defined to a random-function returning an u32_t random value*/
 #include "lwip/arch.h"
@@ -20,6 +20,24 @@
 extern unsigned char __attribute__((section(".wlan_data"))) memp_memory_PBUF_POOL_base[];
 extern unsigned char __attribute__((section(".wlan_data"))) memp_memory_TCP_PCB_POOL_base[];
 
+#if PBUF_RX_SIZE_CLASSES
+extern unsigned char __attribute__((section(".wlan_data"))) memp_memory_RX_PBUF_SMALL_base[];
+extern unsigned char __attribute__((section(".wlan_data"))) memp_memory_RX_PBUF_MEDIUM_base[];
+
+/* A size class element holds the custom pbuf followed by the frame */
+#define PBUF_RX_CLASS_ELEM_SIZE(bufsize) \
+    (LWIP_MEM_ALIGN_SIZE(sizeof(struct pbuf_custom)) + LWIP_MEM_ALIGN_SIZE(bufsize))
+#endif /* PBUF_RX_SIZE_CLASSES */
+
 #endif /* MEMP_USE_CUSTOM_POOLS */
 
 #endif /* __LWIPPOOLS_H__ */
+
+/*
+ * The pools are listed outside of the include guard, memp_std.h includes this
+ * file once for every expansion of LWIP_MEMPOOL.
+ */
+#if defined(MEMP_USE_CUSTOM_POOLS) && PBUF_RX_SIZE_CLASSES
+LWIP_MEMPOOL(RX_PBUF_SMALL, PBUF_RX_SMALL_POOL_SIZE, PBUF_RX_CLASS_ELEM_SIZE(PBUF_RX_SMALL_BUFSIZE), "RX_PBUF_SMALL")
+LWIP_MEMPOOL(RX_PBUF_MEDIUM, PBUF_RX_MEDIUM_POOL_SIZE, PBUF_RX_CLASS_ELEM_SIZE(PBUF_RX_MEDIUM_BUFSIZE), "RX_PBUF_MEDIUM")
+#endif
@@ -0,0 +1,516 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "metrics.h"
+#include "cpu_stats.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "heap_tlsf.h"
+
+#include "lwip/mem.h"
+#include "lwip/sys.h"
+#include "lwip/tcpip.h"
+#include "wm_net.h"
+#include "wifi.h"
+#include "netif_impair.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+/* Sends the collected text as one chunk of the response */
+static void metrics_flush(metrics_writer_t *writer)
+{
+    if (writer->length > 0U)
+    {
+        writer->response.data        = writer->buffer;
+        writer->response.data_length = writer->length;
+        HTTPSRV_cgi_write(&writer->response);
+        writer->length = 0;
+    }
+}
+
+void metrics_printf(metrics_writer_t *writer, const char *format, ...)
+{
+    va_list ap;
+    int len;
+
+    va_start(ap, format);
+    len = vsnprintf(&writer->buffer[writer->length], sizeof(writer->buffer) - writer->length, format, ap);
+    va_end(ap);
+
+    if ((len > 0) && ((uint32_t)len >= sizeof(writer->buffer) - writer->length))
+    {
+        /* Did not fit behind the pending text, send that first */
+        metrics_flush(writer);
+
+        va_start(ap, format);
+        len = vsnprintf(writer->buffer, sizeof(writer->buffer), format, ap);
+        va_end(ap);
+
+        if ((uint32_t)len >= sizeof(writer->buffer))
+        {
+            len = sizeof(writer->buffer) - 1U;
+        }
+    }
+
+    if (len > 0)
+    {
+        writer->length += (uint32_t)len;
+    }
+}
+
+void metrics_write(metrics_writer_t *writer, const void *data, uint32_t length)
+{
+    const uint8_t *src = (const uint8_t *)data;
+    uint32_t n;
+
+    while (length > 0U)
+    {
+        if (writer->length == sizeof(writer->buffer))
+        {
+            metrics_flush(writer);
+        }
+
+        n = LWIP_MIN(length, sizeof(writer->buffer) - writer->length);
+        memcpy(&writer->buffer[writer->length], src, n);
+        writer->length += n;
+        src += n;
+        length -= n;
+    }
+}
+
+metrics_writer_t *metrics_writer_open(HTTPSRV_CGI_REQ_STRUCT *param, HTTPSRV_CONTENT_TYPE content_type)
+{
+    metrics_writer_t *writer;
+
+    /* Too large for the session task stack */
+    writer = (metrics_writer_t *)mem_calloc(1, sizeof(metrics_writer_t));
+    if (writer == NULL)
+    {
+        HTTPSRV_CGI_RES_STRUCT response = {0};
+
+        response.ses_handle  = param->ses_handle;
+        response.status_code = HTTPSRV_CODE_INTERNAL_ERROR;
+        HTTPSRV_cgi_write(&response);
+        return NULL;
+    }
+
+    writer->response.ses_handle     = param->ses_handle;
+    writer->response.status_code    = HTTPSRV_CODE_OK;
+    writer->response.content_type   = content_type;
+    /* Chunked, the length is not known up front */
+    writer->response.content_length = -1;
+
+    return writer;
+}
+
+void metrics_writer_close(metrics_writer_t *writer)
+{
+    metrics_flush(writer);
+
+    /* Terminating chunk */
+    writer->response.data_length = 0;
+    HTTPSRV_cgi_write(&writer->response);
+
+    mem_free(writer);
+}
+
+/* The state functions are plain loads and stores, a critical section covers them */
+void metrics_recorder_pause(metrics_recorder_t *recorder)
+{
+    taskENTER_CRITICAL();
+    if (recorder->pauses++ == 0U)
+    {
+        recorder->saved = recorder->get();
+        recorder->set(0U);
+    }
+    taskEXIT_CRITICAL();
+}
+
+void metrics_recorder_resume(metrics_recorder_t *recorder)
+{
+    taskENTER_CRITICAL();
+    if (--recorder->pauses == 0U)
+    {
+        recorder->set(recorder->saved);
+    }
+    taskEXIT_CRITICAL();
+}
+
+void metrics_recorder_set(metrics_recorder_t *recorder, uint32_t state)
+{
+    taskENTER_CRITICAL();
+    if (recorder->pauses != 0U)
+    {
+        recorder->saved = state;
+    }
+    else
+    {
+        recorder->set(state);
+    }
+    taskEXIT_CRITICAL();
+}
+
+uint32_t metrics_recorder_get(metrics_recorder_t *recorder)
+{
+    uint32_t state;
+
+    taskENTER_CRITICAL();
+    state = (recorder->pauses != 0U) ? recorder->saved : recorder->get();
+    taskEXIT_CRITICAL();
+
+    return state;
+}
+
+#if LWIP_TCPIP_CORE_LOCKING && SYS_CORE_LOCK_PROFILE
+/* Prints one core lock histogram, converted to cumulative buckets */
+static void metrics_core_lock_hist(metrics_writer_t *writer, const char *name, const char *site, const u32_t *hist)
+{
+    u32_t total = 0;
+    u32_t i;
+
+    for (i = 0; i < SYS_CORE_LOCK_PROFILE_BUCKETS - 1U; i++)
+    {
+        total += hist[i];
+        metrics_printf(writer, "lwip_core_lock_%s_us_bucket{site=\"%s\",le=\"%u\"} %u\n", name, site,
+                       (unsigned int)(1UL << i), (unsigned int)total);
+    }
+    total += hist[i];
+    metrics_printf(writer, "lwip_core_lock_%s_us_bucket{site=\"%s\",le=\"+Inf\"} %u\n", name, site,
+                   (unsigned int)total);
+}
+
+/* Core lock contention per LOCK_TCPIP_CORE() call site, resolve the addresses with addr2line */
+static void metrics_core_lock(metrics_writer_t *writer)
+{
+    struct sys_core_lock_site site;
+    struct sys_core_lock_max_hold max_hold;
+    char name[12];
+    u32_t i;
+
+    metrics_printf(writer, "# TYPE lwip_core_lock_wait_us histogram\n# TYPE lwip_core_lock_hold_us histogram\n");
+
+    for (i = 0; i <= SYS_CORE_LOCK_PROFILE_SITES; i++)
+    {
+        if (!sys_core_lock_profile_site(i, &site))
+        {
+            continue;
+        }
+
+        if (site.caller != NULL)
+        {
+            snprintf(name, sizeof(name), "%p", site.caller);
+        }
+        else
+        {
+            strcpy(name, "other");
+        }
+
+        metrics_printf(writer, "lwip_core_lock_acquired_total{site=\"%s\"} %u\n", name, (unsigned int)site.count);
+        metrics_printf(writer, "lwip_core_lock_contended_total{site=\"%s\"} %u\n", name,
+                       (unsigned int)site.contended);
+        metrics_printf(writer, "lwip_core_lock_max_hold_us{site=\"%s\"} %u\n", name, (unsigned int)site.max_hold_us);
+        metrics_core_lock_hist(writer, "wait", name, site.wait_hist);
+        metrics_core_lock_hist(writer, "hold", name, site.hold_hist);
+    }
+
+    sys_core_lock_profile_max_hold(&max_hold);
+    metrics_printf(writer, "lwip_core_lock_longest_hold_us{site=\"%p\",task=\"%s\"} %u\n", max_hold.caller,
+                   max_hold.task, (unsigned int)max_hold.hold_us);
+}
+#endif /* LWIP_TCPIP_CORE_LOCKING && SYS_CORE_LOCK_PROFILE */
+
+#if PBUF_RX_SIZE_CLASSES
+/* Wi-Fi RX buffer usage per size class */
+static void metrics_rx_pbuf_classes(metrics_writer_t *writer)
+{
+    struct net_rx_pbuf_class_stats stats;
+    unsigned int rx_class;
+
+    for (rx_class = 0; rx_class < (unsigned int)NET_RX_PBUF_CLASSES; rx_class++)
+    {
+        if (net_rx_pbuf_class_stats(rx_class, &stats) != WM_SUCCESS)
+        {
+            continue;
+        }
+
+        metrics_printf(writer,
+                       "net_rx_pbuf_avail{bufsize=\"%u\"} %u\n"
+                       "net_rx_pbuf_used{bufsize=\"%u\"} %u\n"
+                       "net_rx_pbuf_max_used{bufsize=\"%u\"} %u\n",
+                       stats.bufsize, stats.avail, stats.bufsize, stats.used, stats.bufsize, stats.max);
+        metrics_printf(writer,
+                       "net_rx_pbuf_alloc_total{bufsize=\"%u\"} %u\n"
+                       "net_rx_pbuf_spill_total{bufsize=\"%u\"} %u\n"
+                       "net_rx_pbuf_empty_total{bufsize=\"%u\"} %u\n",
+                       stats.bufsize, (unsigned int)stats.alloc, stats.bufsize, (unsigned int)stats.spill,
+                       stats.bufsize, (unsigned int)stats.empty);
+    }
+}
+#endif /* PBUF_RX_SIZE_CLASSES */
+
+/* Wi-Fi TX frames by whether low_level_output() had to copy them */
+static void metrics_tx_copy(metrics_writer_t *writer)
+{
+    struct net_tx_copy_stats stats;
+
+    net_tx_copy_stats(&stats);
+    metrics_printf(writer,
+                   "net_tx_frames_total{path=\"zero_copy\"} %u\n"
+                   "net_tx_frames_total{path=\"copy\"} %u\n",
+                   (unsigned int)stats.zero_copy, (unsigned int)stats.copied);
+}
+
+#if CONFIG_WMM
+/* Wi-Fi TX queue back-pressure */
+static void metrics_tx_flow(metrics_writer_t *writer)
+{
+    static const char *const ac_names[4] = {"bk", "be", "vi", "vo"};
+    struct net_tx_flow_stats stats;
+    u32_t ac;
+
+    net_tx_flow_stats(&stats);
+    for (ac = 0; ac < 4U; ac++)
+    {
+        metrics_printf(writer, "net_tx_queue_full_total{ac=\"%s\"} %u\n", ac_names[ac], (unsigned int)stats.full[ac]);
+    }
+    metrics_printf(writer,
+                   "net_tx_queue_resume_total %u\n"
+                   "net_tx_queue_stall_ms_max %u\n"
+                   "net_tx_queue_resume_latency_us_max %u\n",
+                   (unsigned int)stats.resumes, (unsigned int)stats.stall_ms_max,
+                   (unsigned int)stats.resume_latency_us_max);
+}
+#endif
+
+#if CONFIG_MEM_POOLS
+/* Wi-Fi driver memory pools, in use, most ever in use and allocations that found the pool empty */
+static void metrics_mem_pools(metrics_writer_t *writer)
+{
+    static const struct
+    {
+        const char *name;
+        MemoryPool_t *pool;
+    } pools[] = {
+        {"adapter", &pmAdapterMemoryPool}, {"private", &pmPrivateMemoryPool}, {"32", &buf_32_MemoryPool},
+        {"128", &buf_128_MemoryPool},      {"256", &buf_256_MemoryPool},      {"512", &buf_512_MemoryPool},
+        {"768", &buf_768_MemoryPool},      {"1024", &buf_1024_MemoryPool},    {"1280", &buf_1280_MemoryPool},
+        {"1536", &buf_1536_MemoryPool},    {"1792", &buf_1792_MemoryPool},    {"2048", &buf_2048_MemoryPool},
+        {"2560", &buf_2560_MemoryPool},    {"3072", &buf_3072_MemoryPool},    {"4096", &buf_4096_MemoryPool},
+    };
+    MemPoolStats_t stats;
+    u32_t i;
+
+    for (i = 0; i < (u32_t)(sizeof(pools) / sizeof(pools[0])); i++)
+    {
+        if (*pools[i].pool == NULL)
+        {
+            continue;
+        }
+
+        OSA_MemoryPoolGetStats(*pools[i].pool, &stats);
+        metrics_printf(writer,
+                       "wifi_mem_pool_blocks{pool=\"%s\"} %u\n"
+                       "wifi_mem_pool_block_bytes{pool=\"%s\"} %u\n"
+                       "wifi_mem_pool_used{pool=\"%s\"} %u\n",
+                       pools[i].name, (unsigned int)stats.ItemCount, pools[i].name, (unsigned int)stats.ItemSize,
+                       pools[i].name, (unsigned int)stats.InUse);
+        metrics_printf(writer,
+                       "wifi_mem_pool_max_used{pool=\"%s\"} %u\n"
+                       "wifi_mem_pool_empty_total{pool=\"%s\"} %u\n",
+                       pools[i].name, (unsigned int)stats.HighWater, pools[i].name, (unsigned int)stats.Failures);
+    }
+}
+#endif /* CONFIG_MEM_POOLS */
+
+#if CONFIG_WIFI_TRACE
+/* Largest number of command codes and event ids reported */
+#define METRICS_WIFI_TRACE_IDS 24U
+
+/* Firmware command round trips and connection manager queue times of the last traced records */
+static void metrics_wifi_trace(metrics_writer_t *writer)
+{
+    static const char *const quantiles[4] = {"0.5", "0.9", "0.99", "1"};
+    wifi_trace_summary_t *summary;
+    uint32_t values[4];
+    const char *name;
+    unsigned int entries;
+    unsigned int i;
+    u32_t q;
+
+    /* Too large for the session task stack, like the writer */
+    summary = (wifi_trace_summary_t *)mem_malloc(METRICS_WIFI_TRACE_IDS * sizeof(wifi_trace_summary_t));
+    if (summary == NULL)
+    {
+        return;
+    }
+
+    entries = wifi_trace_get_summary(summary, METRICS_WIFI_TRACE_IDS);
+    for (i = 0; i < entries; i++)
+    {
+        name      = (summary[i].type == (uint8_t)WIFI_TRACE_CMD) ? "wifi_cmd_latency_us" : "wifi_event_queue_us";
+        values[0] = summary[i].p50_us;
+        values[1] = summary[i].p90_us;
+        values[2] = summary[i].p99_us;
+        values[3] = summary[i].max_us;
+        for (q = 0; q < 4U; q++)
+        {
+            metrics_printf(writer, "%s{id=\"0x%04x\",quantile=\"%s\"} %u\n", name, summary[i].id, quantiles[q],
+                           (unsigned int)values[q]);
+        }
+        metrics_printf(writer, "%s_count{id=\"0x%04x\"} %u\n", name, summary[i].id, (unsigned int)summary[i].count);
+    }
+
+    mem_free(summary);
+}
+#endif
+
+#if LWIP_NETIF_IMPAIR
+/* Link impairment shim counters */
+static void metrics_netif_impair(metrics_writer_t *writer)
+{
+    static const char *const dir_names[NETIF_IMPAIR_DIRS] = {"rx", "tx"};
+    struct netif_impair_stats stats[NETIF_IMPAIR_DIRS];
+    u32_t dir;
+
+    LOCK_TCPIP_CORE();
+    netif_impair_get_stats(NETIF_IMPAIR_RX, &stats[NETIF_IMPAIR_RX]);
+    netif_impair_get_stats(NETIF_IMPAIR_TX, &stats[NETIF_IMPAIR_TX]);
+    UNLOCK_TCPIP_CORE();
+
+    for (dir = 0; dir < (u32_t)NETIF_IMPAIR_DIRS; dir++)
+    {
+        metrics_printf(writer,
+                       "netif_impair_packets_total{dir=\"%s\"} %u\n"
+                       "netif_impair_bytes_total{dir=\"%s\"} %u\n"
+                       "netif_impair_lost_total{dir=\"%s\"} %u\n",
+                       dir_names[dir], (unsigned int)stats[dir].packets, dir_names[dir],
+                       (unsigned int)stats[dir].bytes, dir_names[dir], (unsigned int)stats[dir].lost);
+        metrics_printf(writer,
+                       "netif_impair_overflow_total{dir=\"%s\"} %u\n"
+                       "netif_impair_reordered_total{dir=\"%s\"} %u\n"
+                       "netif_impair_max_queued{dir=\"%s\"} %u\n",
+                       dir_names[dir], (unsigned int)stats[dir].overflow, dir_names[dir],
+                       (unsigned int)stats[dir].reordered, dir_names[dir], (unsigned int)stats[dir].max_queued);
+    }
+}
+#endif /* LWIP_NETIF_IMPAIR */
+
+/* CPU share and context switches of each task, over the last sample period
+ * and the last CPU_STATS_HISTORY periods */
+static void metrics_cpu(metrics_writer_t *writer)
+{
+    struct cpu_stats_task task;
+    unsigned int slot;
+
+    for (slot = 0; slot < CPU_STATS_MAX_TASKS; slot++)
+    {
+        if (!cpu_stats_read(slot, &task))
+        {
+            continue;
+        }
+        metrics_printf(writer,
+                       "task_cpu_percent{task=\"%s\",window=\"short\"} %u.%02u\n"
+                       "task_cpu_percent{task=\"%s\",window=\"long\"} %u.%02u\n",
+                       task.name, (unsigned int)task.load / 100U, (unsigned int)task.load % 100U, task.name,
+                       (unsigned int)task.load_long / 100U, (unsigned int)task.load_long % 100U);
+        metrics_printf(writer,
+                       "task_switches{task=\"%s\",window=\"short\"} %u\n"
+                       "task_switches{task=\"%s\",window=\"long\"} %u\n",
+                       task.name, (unsigned int)task.switches, task.name, (unsigned int)task.switches_long);
+    }
+}
+
+/* FreeRTOS heap usage, fragmentation and usage per allocation tag */
+static void metrics_heap(metrics_writer_t *writer)
+{
+    static const char *const tag_names[heapNUM_TAGS] = {"other", "lwip", "http", "wifi"};
+    HeapStats_t heap;
+    HeapTagStats_t tag;
+    uint8_t i;
+
+    vPortGetHeapStats(&heap);
+
+    metrics_printf(writer,
+                   "heap_size_bytes %u\n"
+                   "heap_free_bytes %u\n"
+                   "heap_min_ever_free_bytes %u\n"
+                   "heap_largest_free_block_bytes %u\n"
+                   "heap_free_blocks %u\n",
+                   (unsigned int)configTOTAL_HEAP_SIZE, (unsigned int)heap.xAvailableHeapSpaceInBytes,
+                   (unsigned int)heap.xMinimumEverFreeBytesRemaining, (unsigned int)heap.xSizeOfLargestFreeBlockInBytes,
+                   (unsigned int)heap.xNumberOfFreeBlocks);
+    metrics_printf(writer, "heap_fragmentation_percent %u\n", (unsigned int)ulPortGetHeapFragmentation());
+
+    for (i = 0; i < heapNUM_TAGS; i++)
+    {
+        vPortGetHeapTagStats(i, &tag);
+        metrics_printf(writer,
+                       "heap_tag_bytes{tag=\"%s\"} %u\n"
+                       "heap_tag_peak_bytes{tag=\"%s\"} %u\n"
+                       "heap_tag_blocks{tag=\"%s\"} %u\n"
+                       "heap_tag_failed_total{tag=\"%s\"} %u\n",
+                       tag_names[i], (unsigned int)tag.xBytesInUse, tag_names[i], (unsigned int)tag.xPeakBytesInUse,
+                       tag_names[i], (unsigned int)tag.xBlocksInUse, tag_names[i],
+                       (unsigned int)tag.xNumberOfFailedAllocations);
+    }
+}
+
+int metrics_cgi_handler(HTTPSRV_CGI_REQ_STRUCT *param)
+{
+    metrics_writer_t *writer;
+
+    if (param->request_method != HTTPSRV_REQ_GET)
+    {
+        return 0;
+    }
+
+    writer = metrics_writer_open(param, HTTPSRV_CONTENT_TYPE_PLAIN);
+    if (writer == NULL)
+    {
+        return 0;
+    }
+
+#if LWIP_TCPIP_CORE_LOCKING && SYS_CORE_LOCK_PROFILE
+    metrics_core_lock(writer);
+#endif
+
+#if PBUF_RX_SIZE_CLASSES
+    metrics_rx_pbuf_classes(writer);
+#endif
+    metrics_tx_copy(writer);
+#if CONFIG_WMM
+    metrics_tx_flow(writer);
+#endif
+#if CONFIG_MEM_POOLS
+    metrics_mem_pools(writer);
+#endif
+#if CONFIG_WIFI_TRACE
+    metrics_wifi_trace(writer);
+#endif
+
+#if LWIP_NETIF_IMPAIR
+    metrics_netif_impair(writer);
+#endif
+
+    metrics_cpu(writer);
+    metrics_heap(writer);
+
+    metrics_writer_close(writer);
+
+    return 0;
+}
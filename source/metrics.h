@@ -0,0 +1,117 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include "httpsrv.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/* Size of the buffer the metrics text is collected in before it is sent as a chunk */
+#ifndef METRICS_CHUNK_SIZE
+#define METRICS_CHUNK_SIZE 256
+#endif
+
+/* Output state of one chunked CGI response */
+typedef struct metrics_writer
+{
+    HTTPSRV_CGI_RES_STRUCT response;
+    uint32_t length;
+    char buffer[METRICS_CHUNK_SIZE];
+} metrics_writer_t;
+
+/* A recording ring that downloads pause, so the traffic of the download does
+ * not overwrite the ring while it is read. Paused while pauses is non-zero,
+ * the last download to end restores saved. */
+typedef struct metrics_recorder
+{
+    uint32_t (*get)(void);       /* current state, 0 records nothing */
+    void (*set)(uint32_t state); /* applies a state */
+    uint32_t pauses;
+    uint32_t saved;
+} metrics_recorder_t;
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+/*!
+ * @brief Starts a chunked CGI response, answers with an error if out of memory
+ *
+ * @param param         CGI request
+ * @param content_type  content type of the response
+ * @return writer to pass to the other functions, NULL on failure
+ */
+metrics_writer_t *metrics_writer_open(HTTPSRV_CGI_REQ_STRUCT *param, HTTPSRV_CONTENT_TYPE content_type);
+
+/*!
+ * @brief Sends the pending data and the terminating chunk, frees the writer
+ *
+ * @param writer  response being written
+ */
+void metrics_writer_close(metrics_writer_t *writer);
+
+/*!
+ * @brief Appends binary data to a response
+ *
+ * @param writer  response being written
+ * @param data    data to append
+ * @param length  number of bytes, may exceed METRICS_CHUNK_SIZE
+ */
+void metrics_write(metrics_writer_t *writer, const void *data, uint32_t length);
+
+/*!
+ * @brief Appends formatted text to a metrics response
+ *
+ * @param writer  response being written
+ * @param format  printf style format, the output of one call must fit METRICS_CHUNK_SIZE
+ */
+void metrics_printf(metrics_writer_t *writer, const char *format, ...);
+
+/*!
+ * @brief Stops a recorder for the duration of a download, nests
+ *
+ * @param recorder  recorder to pause
+ */
+void metrics_recorder_pause(metrics_recorder_t *recorder);
+
+/*!
+ * @brief Ends a metrics_recorder_pause(), the last one restores the state
+ *
+ * @param recorder  recorder to resume
+ */
+void metrics_recorder_resume(metrics_recorder_t *recorder);
+
+/*!
+ * @brief Sets the state of a recorder, deferred to the resume while it is paused
+ *
+ * @param recorder  recorder to set
+ * @param state     new state
+ */
+void metrics_recorder_set(metrics_recorder_t *recorder, uint32_t state);
+
+/*!
+ * @brief Returns the state of a recorder, the one it resumes with while it is paused
+ *
+ * @param recorder  recorder to query
+ * @return state set by the user
+ */
+uint32_t metrics_recorder_get(metrics_recorder_t *recorder);
+
+/*!
+ * @brief metrics.cgi handler, returns the runtime statistics of the board in
+ *        Prometheus text format
+ *
+ * @param param  CGI request
+ */
+int metrics_cgi_handler(HTTPSRV_CGI_REQ_STRUCT *param);
+
+#endif /* METRICS_H */
@@ -0,0 +1,340 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "perf_runner.h"
+#include "http_server.h"
+
+#include "lwip/apps/lwiperf.h"
+#include "lwip/ip_addr.h"
+#include "lwip/tcpip.h"
+#include "lwip/timeouts.h"
+#include "wm_net.h"
+#include "fsl_debug_console.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/* Interval of lwiperf_poll_udp_client() while a UDP test runs */
+#define PERF_UDP_POLL_MS 1U
+
+#define PERF_DEFAULT_TIME_S   10U
+#define PERF_DEFAULT_RTT_LEN  64U
+#define PERF_DEFAULT_RTT_CNT  100U
+#define PERF_DEFAULT_UDP_LEN  1470U
+#define PERF_DEFAULT_UDP_RATE (1024 * 1024) /* lwiperf default, bit/s */
+
+typedef enum _perf_test
+{
+    kPerfTest_None = 0,
+    kPerfTest_TcpTx,
+    kPerfTest_TcpRx,
+    kPerfTest_Udp,
+    kPerfTest_Rtt,
+    kPerfTest_Echo,
+} perf_test_t;
+
+/*******************************************************************************
+ * Prototypes
+ ******************************************************************************/
+
+static void perf_udp_poll(void *arg);
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+static const char *const s_perfTestNames[] = {"none", "tcp_tx", "tcp_rx", "udp", "rtt", "echo"};
+
+/* Test in progress, all state is owned by the tcpip thread */
+static perf_test_t s_perfTest;
+static void *s_perfSession;
+static void *s_perfEcho;
+static struct lwiperf_udp_stats s_perfUdpStats;
+static bool s_perfUdpStatsValid;
+static struct net_tx_copy_stats s_perfTxStart;
+static perf_result_fn_t s_perfResultFn;
+
+/* JSON result of the last test */
+static char s_perfResult[PERF_RESULT_SIZE] = "{\"test\":\"none\"}";
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+static const char *perf_report_state(enum lwiperf_report_type report_type)
+{
+    switch (report_type)
+    {
+        case LWIPERF_TCP_DONE_SERVER_RX:
+        case LWIPERF_TCP_DONE_SERVER_TX:
+        case LWIPERF_TCP_DONE_CLIENT_TX:
+        case LWIPERF_TCP_DONE_CLIENT_RX:
+        case LWIPERF_UDP_DONE_SERVER_RX:
+        case LWIPERF_UDP_DONE_SERVER_TX:
+        case LWIPERF_UDP_DONE_CLIENT_TX:
+        case LWIPERF_UDP_DONE_CLIENT_RX:
+            return "done";
+        default:
+            return "aborted";
+    }
+}
+
+/* Ends the running test and hands its result on */
+static void perf_done(void)
+{
+    sys_untimeout(perf_udp_poll, NULL);
+    s_perfTest    = kPerfTest_None;
+    s_perfSession = NULL;
+
+    PRINTF("perf: %s\r\n", s_perfResult);
+    if (s_perfResultFn != NULL)
+    {
+        s_perfResultFn(s_perfResult);
+    }
+}
+
+static void perf_udp_poll(void *arg)
+{
+    LWIP_UNUSED_ARG(arg);
+
+    lwiperf_poll_udp_client();
+    /* The poll may have finished the test */
+    if (s_perfTest == kPerfTest_Udp)
+    {
+        sys_timeout(PERF_UDP_POLL_MS, perf_udp_poll, NULL);
+    }
+}
+
+static void perf_udp_stats(void *arg, const struct lwiperf_udp_stats *stats)
+{
+    LWIP_UNUSED_ARG(arg);
+
+    s_perfUdpStats      = *stats;
+    s_perfUdpStatsValid = true;
+}
+
+/* Report of the TCP and UDP throughput tests */
+static void perf_report(void *arg,
+                        enum lwiperf_report_type report_type,
+                        const ip_addr_t *local_addr,
+                        u16_t local_port,
+                        const ip_addr_t *remote_addr,
+                        u16_t remote_port,
+                        u64_t bytes_transferred,
+                        u32_t ms_duration,
+                        u32_t bandwidth_kbitpsec)
+{
+    struct net_tx_copy_stats tx;
+    int len;
+
+    LWIP_UNUSED_ARG(arg);
+    LWIP_UNUSED_ARG(local_addr);
+    LWIP_UNUSED_ARG(local_port);
+    LWIP_UNUSED_ARG(remote_addr);
+    LWIP_UNUSED_ARG(remote_port);
+
+    len = snprintf(s_perfResult, sizeof(s_perfResult),
+                   "{\"test\":\"%s\",\"state\":\"%s\",\"bytes\":%lu,\"ms\":%lu,\"kbps\":%lu",
+                   s_perfTestNames[s_perfTest], perf_report_state(report_type), (unsigned long)bytes_transferred,
+                   (unsigned long)ms_duration, (unsigned long)bandwidth_kbitpsec);
+    if ((s_perfTest == kPerfTest_Udp) && s_perfUdpStatsValid)
+    {
+        len += snprintf(&s_perfResult[len], sizeof(s_perfResult) - len,
+                        ",\"sent\":%lu,\"datagrams\":%lu,\"lost\":%lu,\"out_of_order\":%lu,\"jitter_us\":%lu",
+                        (unsigned long)s_perfUdpStats.sent, (unsigned long)s_perfUdpStats.datagrams,
+                        (unsigned long)s_perfUdpStats.lost, (unsigned long)s_perfUdpStats.out_of_order,
+                        (unsigned long)s_perfUdpStats.jitter_us);
+    }
+    if ((s_perfTest == kPerfTest_TcpTx) || (s_perfTest == kPerfTest_Udp))
+    {
+        /* Frames this board sent during the test, by TX path */
+        net_tx_copy_stats(&tx);
+        len += snprintf(&s_perfResult[len], sizeof(s_perfResult) - len, ",\"tx_zero_copy\":%lu,\"tx_copy\":%lu",
+                        (unsigned long)(tx.zero_copy - s_perfTxStart.zero_copy),
+                        (unsigned long)(tx.copied - s_perfTxStart.copied));
+    }
+    snprintf(&s_perfResult[len], sizeof(s_perfResult) - len, "}");
+
+    perf_done();
+}
+
+/* Report of the request/response test */
+static void perf_rtt_report(void *arg, enum lwiperf_report_type report_type, const struct lwiperf_rtt_stats *stats)
+{
+    LWIP_UNUSED_ARG(arg);
+
+    snprintf(s_perfResult, sizeof(s_perfResult),
+             "{\"test\":\"%s\",\"state\":\"%s\",\"count\":%lu,\"min_us\":%lu,\"avg_us\":%lu,\"max_us\":%lu,"
+             "\"jitter_us\":%lu}",
+             s_perfTestNames[s_perfTest], perf_report_state(report_type), (unsigned long)stats->count,
+             (unsigned long)stats->min_us, (unsigned long)stats->avg_us, (unsigned long)stats->max_us,
+             (unsigned long)stats->jitter_us);
+
+    perf_done();
+}
+
+/* Reads one numeric parameter from the query string, keeps the default when it is missing */
+static void perf_get_param(char *query, char *name, uint32_t *value)
+{
+    char str[12];
+
+    if (cgi_get_varval(query, name, str, sizeof(str)))
+    {
+        *value = strtoul(str, NULL, 10);
+    }
+}
+
+void perf_runner_set_result_fn(perf_result_fn_t result_fn)
+{
+    s_perfResultFn = result_fn;
+}
+
+int perf_runner_start(char *query)
+{
+    perf_test_t test = kPerfTest_None;
+    ip_addr_t host;
+    char str[40];
+    uint32_t port;
+    uint32_t time  = PERF_DEFAULT_TIME_S;
+    uint32_t len   = 0U;
+    uint32_t pps   = 0U;
+    uint32_t count = PERF_DEFAULT_RTT_CNT;
+    s32_t rate     = PERF_DEFAULT_UDP_RATE;
+    uint32_t i;
+
+    LWIP_ASSERT_CORE_LOCKED();
+
+    if (cgi_get_varval(query, "test", str, sizeof(str)))
+    {
+        for (i = kPerfTest_TcpTx; i < ARRAY_SIZE(s_perfTestNames); i++)
+        {
+            if (strcmp(str, s_perfTestNames[i]) == 0)
+            {
+                test = (perf_test_t)i;
+            }
+        }
+    }
+
+    port = (test == kPerfTest_Rtt || test == kPerfTest_Echo) ? LWIPERF_ECHO_PORT_DEFAULT : LWIPERF_TCP_PORT_DEFAULT;
+    perf_get_param(query, "port", &port);
+
+    if (test == kPerfTest_Echo)
+    {
+        /* Runs alongside the other tests until reboot */
+        if (s_perfEcho == NULL)
+        {
+            s_perfEcho = lwiperf_start_tcp_echo_server(IP_ADDR_ANY, (u16_t)port);
+        }
+        return (s_perfEcho != NULL) ? 0 : -1;
+    }
+
+    if ((test == kPerfTest_None) || (s_perfTest != kPerfTest_None) || !cgi_get_varval(query, "host", str, sizeof(str)) ||
+        !ipaddr_aton(str, &host))
+    {
+        return -1;
+    }
+
+    perf_get_param(query, "time", &time);
+    perf_get_param(query, "len", &len);
+    perf_get_param(query, "pps", &pps);
+    perf_get_param(query, "count", &count);
+
+    s_perfTest          = test;
+    s_perfUdpStatsValid = false;
+    net_tx_copy_stats(&s_perfTxStart);
+    snprintf(s_perfResult, sizeof(s_perfResult), "{\"test\":\"%s\",\"state\":\"running\"}", s_perfTestNames[test]);
+
+    switch (test)
+    {
+        case kPerfTest_TcpTx:
+        case kPerfTest_TcpRx:
+            /* A negative amount is the duration in units of 10 ms */
+            s_perfSession = lwiperf_start_tcp_client(&host, (u16_t)port,
+                                                     (test == kPerfTest_TcpTx) ? LWIPERF_CLIENT : LWIPERF_REVERSE,
+                                                     -(int)(time * 100U), len, LWIPERF_TOS_DEFAULT, perf_report, NULL);
+            break;
+
+        case kPerfTest_Udp:
+            /* Packets per second are turned into the bit rate lwiperf paces with */
+            if (pps != 0U)
+            {
+                if (len == 0U)
+                {
+                    len = PERF_DEFAULT_UDP_LEN;
+                }
+                rate = (s32_t)LWIP_MIN((u64_t)pps * len * 8U, (u64_t)INT32_MAX);
+            }
+            s_perfSession = lwiperf_start_udp_client(NULL, 0, &host, (u16_t)port, LWIPERF_CLIENT, -(int)(time * 100U),
+                                                     len, rate, LWIPERF_TOS_DEFAULT, perf_report, NULL);
+            if (s_perfSession != NULL)
+            {
+                lwiperf_set_udp_stats_fn(s_perfSession, perf_udp_stats);
+                sys_timeout(PERF_UDP_POLL_MS, perf_udp_poll, NULL);
+            }
+            break;
+
+        case kPerfTest_Rtt:
+            s_perfSession = lwiperf_start_tcp_rtt_client(&host, (u16_t)port, count,
+                                                         (u16_t)((len != 0U) ? len : PERF_DEFAULT_RTT_LEN),
+                                                         perf_rtt_report, NULL);
+            break;
+
+        default:
+            break;
+    }
+
+    if (s_perfSession == NULL)
+    {
+        s_perfTest = kPerfTest_None;
+        snprintf(s_perfResult, sizeof(s_perfResult), "{\"test\":\"%s\",\"state\":\"failed\"}", s_perfTestNames[test]);
+        return -1;
+    }
+
+    return 0;
+}
+
+int perf_cgi_handler(HTTPSRV_CGI_REQ_STRUCT *param)
+{
+    HTTPSRV_CGI_RES_STRUCT response = {0};
+    char buffer[PERF_RESULT_SIZE];
+
+    if (param->request_method != HTTPSRV_REQ_GET)
+    {
+        return 0;
+    }
+
+    response.status_code = HTTPSRV_CODE_OK;
+
+    LOCK_TCPIP_CORE();
+    if ((param->query_string != NULL) && (param->query_string[0] != '\0'))
+    {
+        if (perf_runner_start(param->query_string) != 0)
+        {
+            response.status_code = HTTPSRV_CODE_BAD_REQ;
+        }
+    }
+    memcpy(buffer, s_perfResult, sizeof(buffer));
+    UNLOCK_TCPIP_CORE();
+
+    response.ses_handle     = param->ses_handle;
+    response.content_type   = HTTPSRV_CONTENT_TYPE_PLAIN;
+    response.data           = buffer;
+    response.data_length    = strlen(buffer);
+    response.content_length = response.data_length;
+    HTTPSRV_cgi_write(&response);
+
+    return (response.content_length);
+}
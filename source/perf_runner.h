@@ -0,0 +1,61 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef PERF_RUNNER_H
+#define PERF_RUNNER_H
+
+#include "httpsrv.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/* Size of the JSON text of one result */
+#define PERF_RESULT_SIZE 320
+
+/* Called in the tcpip thread with the JSON result of every finished test */
+typedef void (*perf_result_fn_t)(const char *json);
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+/*!
+ * @brief Sets the function that receives the test results
+ *
+ * @param result_fn  function to call, NULL for none
+ */
+void perf_runner_set_result_fn(perf_result_fn_t result_fn);
+
+/*!
+ * @brief Starts a network benchmark, one at a time, core lock must be held
+ *
+ * The test is described by a query string with the parameters
+ * test=tcp_tx|tcp_rx|udp|rtt|echo, host=<IPv4 address of the peer>, port,
+ * time=<seconds>, len=<payload bytes>, pps=<UDP packets per second> and
+ * count=<round trips>. tcp_tx, tcp_rx and udp need an iperf2 server on the
+ * peer, rtt needs an echo server and echo starts one on this board.
+ * The tcp_tx and udp results also count the frames the Wi-Fi driver sent
+ * with and without copying them (tx_zero_copy, tx_copy).
+ *
+ * @param query  test description, modified while parsing
+ * @return 0 if the test started, -1 if a test is running or the query is invalid
+ */
+int perf_runner_start(char *query);
+
+/*!
+ * @brief perf.cgi handler
+ *
+ * With a query string a test is started as described for perf_runner_start(),
+ * without one the result of the last test is returned as JSON.
+ *
+ * @param param  CGI request
+ */
+int perf_cgi_handler(HTTPSRV_CGI_REQ_STRUCT *param);
+
+#endif /* PERF_RUNNER_H */
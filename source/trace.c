@@ -0,0 +1,140 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "trace.h"
+#include "http_server.h"
+#include "metrics.h"
+
+#include "event_trace.h"
+#include "cpu_stats.h"
+#include "task.h"
+#include "lwip/mem.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+static metrics_recorder_t trace_recorder = {event_trace_get_mask, event_trace_set_mask, 0U, 0U};
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+/* File header and the names of the tasks, so task numbers can be resolved */
+static void trace_write_header(metrics_writer_t *writer)
+{
+    TaskStatus_t *tasks;
+    uint32_t head[4];
+    uint32_t number;
+    char name[EVENT_TRACE_NAME_LEN];
+    UBaseType_t count = 0;
+    UBaseType_t i;
+
+    /* Too large for the session task stack, and one per download */
+    tasks = (TaskStatus_t *)mem_malloc(CPU_STATS_MAX_TASKS * sizeof(TaskStatus_t));
+    if (tasks != NULL)
+    {
+        count = uxTaskGetSystemState(tasks, CPU_STATS_MAX_TASKS, NULL);
+    }
+
+    head[0] = EVENT_TRACE_MAGIC;
+    head[1] = EVENT_TRACE_VERSION | ((uint32_t)sizeof(struct event_trace_record) << 16);
+    head[2] = SystemCoreClock;
+    head[3] = count;
+    metrics_write(writer, head, sizeof(head));
+
+    for (i = 0; i < count; i++)
+    {
+        number = tasks[i].xTaskNumber;
+        (void)memset(name, 0, sizeof(name));
+        (void)strncpy(name, tasks[i].pcTaskName, sizeof(name) - 1U);
+        metrics_write(writer, &number, sizeof(number));
+        metrics_write(writer, name, sizeof(name));
+    }
+
+    if (tasks != NULL)
+    {
+        mem_free(tasks);
+    }
+}
+
+/* Streams the ring, oldest event first */
+static void trace_dump(HTTPSRV_CGI_REQ_STRUCT *param)
+{
+    struct event_trace_record record;
+    metrics_writer_t *writer;
+    uint32_t count;
+    uint32_t seq;
+
+    writer = metrics_writer_open(param, HTTPSRV_CONTENT_TYPE_OCTETSTREAM);
+    if (writer == NULL)
+    {
+        return;
+    }
+
+    metrics_recorder_pause(&trace_recorder);
+
+    trace_write_header(writer);
+
+    count = event_trace_count();
+    seq   = count - EVENT_TRACE_RECORDS;
+    for (; seq != count; seq++)
+    {
+        if (event_trace_read(seq, &record))
+        {
+            metrics_write(writer, &record, sizeof(record));
+        }
+    }
+
+    metrics_recorder_resume(&trace_recorder);
+
+    metrics_writer_close(writer);
+}
+
+int trace_cgi_handler(HTTPSRV_CGI_REQ_STRUCT *param)
+{
+    HTTPSRV_CGI_RES_STRUCT response = {0};
+    char buffer[48] = {0};
+    char str[12];
+
+    if (param->request_method != HTTPSRV_REQ_GET)
+    {
+        return 0;
+    }
+
+    if ((param->query_string == NULL) || (param->query_string[0] == '\0'))
+    {
+        trace_dump(param);
+        return 0;
+    }
+
+    if (cgi_get_varval(param->query_string, "mask", str, sizeof(str)))
+    {
+        metrics_recorder_set(&trace_recorder, strtoul(str, NULL, 0) & EVENT_TRACE_ALL);
+    }
+
+    snprintf(buffer, sizeof(buffer), "{\"mask\":%u,\"count\":%u}", (unsigned int)metrics_recorder_get(&trace_recorder),
+             (unsigned int)event_trace_count());
+
+    response.ses_handle     = param->ses_handle;
+    response.status_code    = HTTPSRV_CODE_OK;
+    response.content_type   = HTTPSRV_CONTENT_TYPE_PLAIN;
+    response.data           = buffer;
+    response.data_length    = strlen(buffer);
+    response.content_length = response.data_length;
+    HTTPSRV_cgi_write(&response);
+
+    return (response.content_length);
+}
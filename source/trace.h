@@ -0,0 +1,30 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "httpsrv.h"
+
+/*******************************************************************************
+ * API
+ ******************************************************************************/
+
+/*!
+ * @brief trace.cgi handler
+ *
+ * Without a query string the event trace ring is returned in the binary
+ * format described in event_trace.h, the trace is paused while it is sent.
+ * With the query parameter mask the recorded event types are changed instead
+ * and the new mask is returned as JSON.
+ *
+ * @param param  CGI request
+ */
+int trace_cgi_handler(HTTPSRV_CGI_REQ_STRUCT *param);
+
+#endif /* TRACE_H */
@@ -22,8 +22,10 @@
 #include "fsl_debug_console.h"
 #include "webconfig.h"
 #include "cred_flash_storage.h"
+#include "dhcp-server.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "FreeRTOS.h"
 
@@ -31,6 +33,12 @@
 
 #include "Drivers/BUTTON.h"
 #include "MQTT.h"
+#include "metrics.h"
+#include "netif_impair.h"
+#include "capture.h"
+#include "trace.h"
+#include "perf_runner.h"
+#include "cpu_stats.h"
 
 
 /*******************************************************************************
@@ -40,6 +48,9 @@ static int CGI_HandleGet(HTTPSRV_CGI_REQ_STRUCT *param);
 static int CGI_HandlePost(HTTPSRV_CGI_REQ_STRUCT *param);
 static int CGI_HandleReset(HTTPSRV_CGI_REQ_STRUCT *param);
 static int CGI_HandleStatus(HTTPSRV_CGI_REQ_STRUCT *param);
+#if LWIP_NETIF_IMPAIR
+static int CGI_HandleImpair(HTTPSRV_CGI_REQ_STRUCT *param);
+#endif
 
 static uint32_t SetBoardToClient();
 static uint32_t SetBoardToAP();
@@ -74,6 +85,15 @@ const HTTPSRV_CGI_LINK_STRUCT cgi_lnk_tbl[] = {
     {"get", CGI_HandleGet},
     {"post", CGI_HandlePost},
     {"status", CGI_HandleStatus},
+    {"metrics", metrics_cgi_handler},
+#if LWIP_NETIF_IMPAIR
+    {"impair", CGI_HandleImpair},
+#endif
+#if LWIP_NETIF_CAPTURE
+    {"capture", capture_cgi_handler},
+#endif
+    {"perf", perf_cgi_handler},
+    {"trace", trace_cgi_handler},
     {0, 0} // DO NOT REMOVE - last item - end of table
 };
 
@@ -356,6 +376,100 @@ static int CGI_HandleStatus(HTTPSRV_CGI_REQ_STRUCT *param)
     return (response.content_length);
 }
 
+#if LWIP_NETIF_IMPAIR
+/* Reads one numeric impairment parameter from the query string, keeps the old value when it is missing */
+static void ImpairGetParam(char *query, char *name, uint32_t *value)
+{
+    char str[12];
+
+    if (cgi_get_varval(query, name, str, sizeof(str)))
+    {
+        *value = strtoul(str, NULL, 10);
+    }
+}
+
+/* The impair.cgi?dir=rx|tx&rate=&delay=&jitter=&loss=&reorder= request sets the link impairment of one
+ * direction of the station interface, rate in kbit/s, times in ms, probabilities in permille.
+ * Without parameters it only returns the current profiles. */
+static int CGI_HandleImpair(HTTPSRV_CGI_REQ_STRUCT *param)
+{
+    HTTPSRV_CGI_RES_STRUCT response = {0};
+    struct netif_impair_profile profile[NETIF_IMPAIR_DIRS];
+    enum netif_impair_dir dir       = NETIF_IMPAIR_DIRS;
+    char buffer[256]                = {0};
+    char dir_str[4];
+    uint32_t value;
+    err_t err = ERR_OK;
+
+    response.ses_handle  = param->ses_handle;
+    response.status_code = HTTPSRV_CODE_OK;
+
+    if ((param->query_string != NULL) && cgi_get_varval(param->query_string, "dir", dir_str, sizeof(dir_str)))
+    {
+        if (strcmp(dir_str, "rx") == 0)
+        {
+            dir = NETIF_IMPAIR_RX;
+        }
+        else if (strcmp(dir_str, "tx") == 0)
+        {
+            dir = NETIF_IMPAIR_TX;
+        }
+        else
+        {
+            response.status_code = HTTPSRV_CODE_BAD_REQ;
+        }
+    }
+
+    LOCK_TCPIP_CORE();
+    netif_impair_get_profile(NETIF_IMPAIR_RX, &profile[NETIF_IMPAIR_RX]);
+    netif_impair_get_profile(NETIF_IMPAIR_TX, &profile[NETIF_IMPAIR_TX]);
+    if (dir != NETIF_IMPAIR_DIRS)
+    {
+        value = profile[dir].rate_kbps;
+        ImpairGetParam(param->query_string, "rate", &value);
+        profile[dir].rate_kbps = value;
+        value                  = profile[dir].delay_ms;
+        ImpairGetParam(param->query_string, "delay", &value);
+        profile[dir].delay_ms = (uint16_t)value;
+        value                 = profile[dir].jitter_ms;
+        ImpairGetParam(param->query_string, "jitter", &value);
+        profile[dir].jitter_ms = (uint16_t)value;
+        value                  = profile[dir].loss_permille;
+        ImpairGetParam(param->query_string, "loss", &value);
+        profile[dir].loss_permille = (uint16_t)value;
+        value                      = profile[dir].reorder_permille;
+        ImpairGetParam(param->query_string, "reorder", &value);
+        profile[dir].reorder_permille = (uint16_t)value;
+
+        err = netif_impair_set_profile(dir, &profile[dir]);
+        netif_impair_get_profile(dir, &profile[dir]);
+    }
+    UNLOCK_TCPIP_CORE();
+
+    if (err != ERR_OK)
+    {
+        response.status_code = HTTPSRV_CODE_BAD_REQ;
+    }
+
+    snprintf(buffer, sizeof(buffer),
+             "{\"rx\":{\"rate\":%u,\"delay\":%u,\"jitter\":%u,\"loss\":%u,\"reorder\":%u},"
+             "\"tx\":{\"rate\":%u,\"delay\":%u,\"jitter\":%u,\"loss\":%u,\"reorder\":%u}}",
+             (unsigned int)profile[NETIF_IMPAIR_RX].rate_kbps, profile[NETIF_IMPAIR_RX].delay_ms,
+             profile[NETIF_IMPAIR_RX].jitter_ms, profile[NETIF_IMPAIR_RX].loss_permille,
+             profile[NETIF_IMPAIR_RX].reorder_permille, (unsigned int)profile[NETIF_IMPAIR_TX].rate_kbps,
+             profile[NETIF_IMPAIR_TX].delay_ms, profile[NETIF_IMPAIR_TX].jitter_ms,
+             profile[NETIF_IMPAIR_TX].loss_permille, profile[NETIF_IMPAIR_TX].reorder_permille);
+
+    response.content_type   = HTTPSRV_CONTENT_TYPE_PLAIN;
+    response.data           = buffer;
+    response.data_length    = strlen(buffer);
+    response.content_length = response.data_length;
+    HTTPSRV_cgi_write(&response);
+
+    return (response.content_length);
+}
+#endif /* LWIP_NETIF_IMPAIR */
+
 /* Link lost callback */
 static void LinkStatusChangeCallback(bool linkState)
 {
@@ -392,6 +506,8 @@ static void main_task(void *arg)
     WC_DEBUG("[i] Trying to load data from mflash.\r\n");
 
     init_flash_storage(CONNECTION_INFO_FILENAME);
+    /* The leases the uAP handed out survive a restart */
+    dhcp_server_set_lease_store(save_dhcp_leases, load_dhcp_leases);
 
     char ssid[WPL_WIFI_SSID_LENGTH] = "";
     char password[WPL_WIFI_PASSWORD_LENGTH] = "";
@@ -446,6 +562,11 @@ static void main_task(void *arg)
 
     WC_DEBUG("[i] Successfully initialized Wi-Fi module\r\n");
 
+    if (cpu_stats_start() != 0)
+    {
+        PRINTF("[!] CPU statistics timer creation failed\r\n");
+    }
+
     /* Start WebServer */
     if (xTaskCreate(http_srv_task, "http_srv_task", HTTPD_STACKSIZE, NULL, HTTPD_PRIORITY, NULL) != pdPASS)
     {
@@ -486,12 +607,16 @@ static void main_task(void *arg)
 /* Initialize and start local AP */
 static uint32_t SetBoardToAP()
 {
+    static char *ap_domain_names[] = {WIFI_AP_DOMAIN_NAME, NULL};
     uint32_t result;
 
     /* Set the global ssid and password to the default AP ssid and password */
     strcpy(g_BoardState.ssid, WIFI_SSID);
     strcpy(g_BoardState.password, WIFI_PASSWORD);
 
+    /* The configuration page can be opened by name, the DNS server stops with the AP */
+    dhcp_enable_dns_server(ap_domain_names);
+
     /* Start the access point */
     PRINTF("Starting Access Point: SSID: %s, Chnl: %d\r\n", g_BoardState.ssid, WIFI_AP_CHANNEL);
     result = WPL_Start_AP(g_BoardState.ssid, g_BoardState.password, WIFI_AP_CHANNEL);
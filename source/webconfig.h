@@ -42,6 +42,11 @@
 #define WIFI_AP_CHANNEL 1
 #endif
 
+/* Name the DNS server of the AP resolves to the board */
+#ifndef WIFI_AP_DOMAIN_NAME
+#define WIFI_AP_DOMAIN_NAME "webconfig.nxp"
+#endif
+
 #define MAX_RETRY_TICKS 50
 
 #ifndef HTTPD_STACKSIZE
@@ -52,6 +57,7 @@
 #endif
 
 #define CONNECTION_INFO_FILENAME ("connection_info.dat")
+#define DHCP_LEASES_FILENAME     ("dhcp_leases.dat")
 
 #define WEBCONFIG_DEBUG
 
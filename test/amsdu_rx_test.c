@@ -0,0 +1,434 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Test of the RX A-MSDU split: handle_data_packet() of
+ * wifi/port/net/wifi_netif.c, the dispatch of
+ * wifi/wifidriver/mlan_11n_rxreorder.c and the de-aggregation of
+ * wifi/wifidriver/mlan_11n_aggr.c, with handle_amsdu_data_packet() wrapping
+ * the subframes.
+ *
+ * A-MSDUs are received in IMU rx buffers (wifi_host.h) and go through the
+ * mlan RX path without a block ack stream, as wrapper_wlan_handle_rx_packet()
+ * of mlan_glue.c hands them in. The subframes reach a netif input that keeps
+ * them until the case frees them. The cases are:
+ *  - in place: an A-MSDU held in its rx buffer, split into views
+ *    (MLAN_BUF_FLAG_AMSDU_REF) that keep the rx buffer until the last of
+ *    them is freed, with subframes of every padding;
+ *  - truncated: the same with a last subframe shorter than its header and
+ *    one whose length runs past the A-MSDU, neither is handed up;
+ *  - copied parent: a small A-MSDU copied into one pbuf, split into views
+ *    of that pbuf;
+ *  - chained: the RX_REF_PBUF pool taken empty, the A-MSDU copied into a
+ *    pbuf chain, then into amsdu_inbuf and every subframe copied;
+ *  - views exhausted: more subframes than CONFIG_AMSDU_RX_REF_PBUFS views,
+ *    the others are copied.
+ * Every subframe is checked byte by byte. After a case, the rx buffer has to
+ * be released once, and the RX_REF_PBUF, AMSDU_REF_PBUF and pbuf pools have
+ * to be empty.
+ *
+ * Usage: amsdu_rx_test
+ */
+
+#include "wifi_host.h"
+
+/* The netif under test, for its statics */
+#include "wifi_netif.c"
+
+#include "mlan_11n_aggr.h"
+#include "mlan_11n_rxreorder.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+#define SUBFRAMES_MAX 24U
+#define AMSDU_MAX     3839U
+#define SUB_HLEN      14U /* DA, SA and length of a subframe */
+
+struct amsdu_case
+{
+    const char *name;
+    /* Payload length of each subframe after the LLC/SNAP header, 0 ends the list */
+    uint16_t lens[SUBFRAMES_MAX];
+    /* Bytes of a subframe shorter than its header after the last one, 0 for none */
+    uint8_t truncated;
+    /* A last subframe whose length runs past the end of the A-MSDU */
+    bool overrun;
+    /* The RX_REF_PBUF pool is taken empty first */
+    bool no_rx_ref;
+    /* Subframes expected as views of the A-MSDU */
+    unsigned int views;
+};
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+static const struct amsdu_case cases[] = {
+    {"in place", {301, 598, 1000, 1, 2}, 0, false, false, 5},
+    {"truncated", {600, 203}, 10, false, false, 2},
+    {"truncated header", {600, 203}, 13, false, false, 2},
+    {"overrun", {600, 203}, 0, true, false, 2},
+    {"copied parent", {60, 61, 62, 63}, 0, false, false, 4},
+    {"chained", {1000, 999, 998}, 0, false, true, 0},
+    {"views exhausted", {100, 101, 102, 103, 104, 105, 106, 107, 108, 109, 110, 111,
+                         112, 113, 114, 115, 116, 117, 118, 119}, 0, false, false, CONFIG_AMSDU_RX_REF_PBUFS},
+};
+
+static const uint8_t peer_mac[MLAN_MAC_ADDR_LENGTH] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x02};
+static const uint8_t snap_ip[LLC_SNAP_LEN]          = {0xaa, 0xaa, 0x03, 0x00, 0x00, 0x00, 0x08, 0x00};
+
+static struct netif rx_netif;
+static uint8_t amsdu[AMSDU_MAX + 64U];
+
+/* Subframes handed up by wlan_11n_deaggregate_pkt() and received by the netif */
+static unsigned int handed_up;
+static struct pbuf *received[SUBFRAMES_MAX];
+static unsigned int received_count;
+static unsigned int failures;
+
+static void *taken[CONFIG_IMU_RX_ZERO_COPY_BUFS];
+static unsigned int taken_count;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+/* Driver hooks of the mlan RX path, as in mlan_glue.c */
+
+void wrapper_deliver_amsdu_subframe(pmlan_buffer amsdu_pmbuf, t_u8 *data, t_u16 pkt_len)
+{
+    RxPD *prx_pd    = (RxPD *)(void *)amsdu_pmbuf->pbuf;
+    void *amsdu_buf = ((amsdu_pmbuf->flags & MLAN_BUF_FLAG_AMSDU_REF) != 0U) ? amsdu_pmbuf->lwip_pbuf : NULL;
+
+    handed_up++;
+    handle_amsdu_data_packet(prx_pd->bss_type, data, pkt_len, amsdu_buf);
+}
+
+/* Frames that are not A-MSDUs, as wrapper_moal_recv_packet() */
+mlan_status wlan_process_rx_packet(pmlan_adapter pmadapter, pmlan_buffer pmbuf)
+{
+    RxPD *prx_pd = (RxPD *)(void *)pmbuf->pbuf;
+
+    handle_deliver_packet_above(prx_pd, prx_pd->bss_type, pmbuf->lwip_pbuf);
+    OSA_MemoryFree(pmbuf->pbuf);
+    OSA_MemoryFree(pmbuf);
+    return MLAN_STATUS_SUCCESS;
+}
+
+t_u8 wifi_sta_ampdu_rx_enable_per_tid_is_allowed(t_u8 tid)
+{
+    return MTRUE;
+}
+
+t_u8 wifi_uap_ampdu_rx_enable_per_tid_is_allowed(t_u8 tid)
+{
+    return MTRUE;
+}
+
+TxBAStreamTbl *wlan_11n_get_txbastream_tbl(mlan_private *pmpriv, t_u8 *ra)
+{
+    return MNULL;
+}
+
+void wlan_11n_update_txbastream_tbl_ampdu_stat(mlan_private *pmpriv, t_u8 *ra, t_u8 status, t_u8 tid)
+{
+}
+
+mlan_status wlan_prepare_cmd(IN mlan_private *pmpriv,
+                             IN t_u16 cmd_no,
+                             IN t_u16 cmd_action,
+                             IN t_u32 cmd_oid,
+                             IN t_void *pioctl_buf,
+                             IN t_void *pdata_buf)
+{
+    return MLAN_STATUS_SUCCESS;
+}
+
+/* No block ack stream is set up, its timer and locks are not used */
+void *OSA_TimerGetContext(osa_timer_handle_t timerHandle)
+{
+    return NULL;
+}
+
+osa_status_t OSA_SemaphoreWait(osa_semaphore_handle_t semaphoreHandle, uint32_t millisec)
+{
+    return KOSA_StatusSuccess;
+}
+
+osa_status_t OSA_SemaphorePost(osa_semaphore_handle_t semaphoreHandle)
+{
+    return KOSA_StatusSuccess;
+}
+
+osa_status_t OSA_MutexLock(osa_mutex_handle_t mutexHandle, uint32_t millisec)
+{
+    return KOSA_StatusSuccess;
+}
+
+osa_status_t OSA_MutexUnlock(osa_mutex_handle_t mutexHandle)
+{
+    return KOSA_StatusSuccess;
+}
+
+/* wrapper_wlan_handle_rx_packet() with no block ack stream: an mlan buffer with a copy of the RxPD */
+static int amsdu_rx_packet(t_u16 datalen, RxPD *rxpd, void *p, void *payload)
+{
+    pmlan_buffer pmbuf = OSA_MemoryAllocate(sizeof(mlan_buffer));
+
+    if (pmbuf == MNULL)
+    {
+        return -WM_FAIL;
+    }
+    pmbuf->pbuf = (t_u8 *)OSA_MemoryAllocate(sizeof(RxPD));
+    if (pmbuf->pbuf == MNULL)
+    {
+        OSA_MemoryFree(pmbuf);
+        return -WM_FAIL;
+    }
+    (void)memcpy(pmbuf->pbuf, rxpd, sizeof(RxPD));
+    pmbuf->pdesc       = payload;
+    pmbuf->lwip_pbuf   = p;
+    pmbuf->data_offset = 0;
+    pmbuf->data_len    = datalen;
+    pmbuf->buf_type    = MLAN_BUF_TYPE_DATA;
+
+    if (mlan_11n_rxreorder_pkt(mlan_adap->priv[rxpd->bss_type], 0, rxpd->priority, (t_u8 *)peer_mac,
+                               (t_u8)rxpd->rx_pkt_type, pmbuf) != MLAN_STATUS_SUCCESS)
+    {
+        OSA_MemoryFree(pmbuf->pbuf);
+        OSA_MemoryFree(pmbuf);
+        return -WM_FAIL;
+    }
+    return WM_SUCCESS;
+}
+
+static err_t keep_input(struct pbuf *p, struct netif *netif)
+{
+    if (received_count == SUBFRAMES_MAX)
+    {
+        return ERR_MEM;
+    }
+    received[received_count++] = p;
+    return ERR_OK;
+}
+
+static uint8_t payload_byte(unsigned int sub, unsigned int i)
+{
+    return (uint8_t)(sub * 31U + i);
+}
+
+/* Builds the A-MSDU of a case, returns its length */
+static uint16_t amsdu_build(const struct amsdu_case *c, unsigned int *subframes)
+{
+    uint16_t off = 0;
+    unsigned int sub;
+    unsigned int i;
+
+    for (sub = 0; (sub < SUBFRAMES_MAX) && (c->lens[sub] != 0U); sub++)
+    {
+        uint16_t len = (uint16_t)(LLC_SNAP_LEN + c->lens[sub]);
+
+        /* Every subframe but the last is padded to 4 bytes */
+        while ((off & 3U) != 0U)
+        {
+            amsdu[off++] = 0xee;
+        }
+        (void)memcpy(&amsdu[off], rx_netif.hwaddr, MLAN_MAC_ADDR_LENGTH);
+        (void)memcpy(&amsdu[off + 6U], peer_mac, MLAN_MAC_ADDR_LENGTH);
+        amsdu[off + 12U] = (uint8_t)(len >> 8);
+        amsdu[off + 13U] = (uint8_t)len;
+        (void)memcpy(&amsdu[off + SUB_HLEN], snap_ip, LLC_SNAP_LEN);
+        for (i = 0; i < c->lens[sub]; i++)
+        {
+            amsdu[off + SUB_HLEN + LLC_SNAP_LEN + i] = payload_byte(sub, i);
+        }
+        off = (uint16_t)(off + SUB_HLEN + len);
+    }
+    *subframes = sub;
+
+    if ((c->truncated != 0U) || c->overrun)
+    {
+        while ((off & 3U) != 0U)
+        {
+            amsdu[off++] = 0xee;
+        }
+    }
+    if (c->truncated != 0U)
+    {
+        /* The length field would lie past the A-MSDU, in the bytes after it */
+        (void)memset(&amsdu[off], 0x11, c->truncated);
+        off = (uint16_t)(off + c->truncated);
+    }
+    if (c->overrun)
+    {
+        (void)memcpy(&amsdu[off], rx_netif.hwaddr, MLAN_MAC_ADDR_LENGTH);
+        (void)memcpy(&amsdu[off + 6U], peer_mac, MLAN_MAC_ADDR_LENGTH);
+        amsdu[off + 12U] = 0x02;
+        amsdu[off + 13U] = 0x00;
+        (void)memcpy(&amsdu[off + SUB_HLEN], snap_ip, LLC_SNAP_LEN);
+        off = (uint16_t)(off + SUB_HLEN + LLC_SNAP_LEN + 100U);
+    }
+    return off;
+}
+
+static void rx_ref_take(void)
+{
+    if (!rx_ref_pbuf_pool_ready)
+    {
+        LWIP_MEMPOOL_INIT(RX_REF_PBUF);
+        rx_ref_pbuf_pool_ready = true;
+    }
+    while ((taken_count < CONFIG_IMU_RX_ZERO_COPY_BUFS) &&
+           ((taken[taken_count] = LWIP_MEMPOOL_ALLOC(RX_REF_PBUF)) != NULL))
+    {
+        taken_count++;
+    }
+}
+
+static void rx_ref_give_back(void)
+{
+    while (taken_count > 0U)
+    {
+        LWIP_MEMPOOL_FREE(RX_REF_PBUF, taken[--taken_count]);
+    }
+}
+
+static bool pools_empty(void)
+{
+    return (memp_RX_REF_PBUF.stats->used == 0U) && (memp_AMSDU_REF_PBUF.stats->used == 0U) &&
+           (memp_pools[MEMP_PBUF_POOL]->stats->used == 0U) && (memp_pools[MEMP_RX_PBUF_SMALL]->stats->used == 0U) &&
+           (memp_pools[MEMP_RX_PBUF_MEDIUM]->stats->used == 0U);
+}
+
+/* A subframe as handed up: the Ethernet header with the type of the LLC/SNAP header, then the payload */
+static bool subframe_ok(struct pbuf *p, unsigned int sub, uint16_t len)
+{
+    uint8_t hdr[SIZEOF_ETH_HDR];
+    uint16_t i;
+
+    if ((p->tot_len != SIZEOF_ETH_HDR + len) || (pbuf_copy_partial(p, hdr, SIZEOF_ETH_HDR, 0) != SIZEOF_ETH_HDR) ||
+        (memcmp(&hdr[0], rx_netif.hwaddr, ETH_HWADDR_LEN) != 0) || (memcmp(&hdr[6], peer_mac, ETH_HWADDR_LEN) != 0) ||
+        (hdr[12] != 0x08) || (hdr[13] != 0x00))
+    {
+        return false;
+    }
+    for (i = 0; i < len; i++)
+    {
+        if (pbuf_get_at(p, (u16_t)(SIZEOF_ETH_HDR + i)) != payload_byte(sub, i))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static int case_run(const struct amsdu_case *c)
+{
+    unsigned int subframes;
+    unsigned int views;
+    unsigned int i;
+    uint16_t len = amsdu_build(c, &subframes);
+    u16_t drops  = lwip_stats.link.drop;
+
+    wifi_host_reset();
+    handed_up      = 0;
+    received_count = 0;
+    failures       = 0;
+    if (c->no_rx_ref)
+    {
+        rx_ref_take();
+    }
+
+    if (!wifi_host_rx_frame(MLAN_BSS_TYPE_STA, PKT_TYPE_AMSDU, amsdu, len))
+    {
+        printf("FAIL %s: no free rx buffer\n", c->name);
+        return 0;
+    }
+    rx_ref_give_back();
+
+    if ((handed_up != subframes) || (received_count != subframes) || (lwip_stats.link.drop != drops))
+    {
+        printf("FAIL %s: %u subframes, %u handed up, %u received, %u dropped\n", c->name, subframes, handed_up,
+               received_count, (unsigned int)(lwip_stats.link.drop - drops));
+        return 0;
+    }
+    for (i = 0; i < received_count; i++)
+    {
+        if (!subframe_ok(received[i], i, c->lens[i]))
+        {
+            printf("FAIL %s: subframe %u changed\n", c->name, i);
+            return 0;
+        }
+    }
+    views = memp_AMSDU_REF_PBUF.stats->used;
+    if (views != c->views)
+    {
+        printf("FAIL %s: %u of %u subframes are views, %u expected\n", c->name, views, subframes, c->views);
+        return 0;
+    }
+
+    /* The views keep the A-MSDU, and with it the rx buffer if it was received in place */
+    for (i = 0; i < received_count; i++)
+    {
+        if ((memp_AMSDU_REF_PBUF.stats->used != 0U) && (wifi_host.rx_holds == 1U) && (wifi_host_rx_held() != 1U))
+        {
+            printf("FAIL %s: rx buffer released with %u subframes left\n", c->name, received_count - i);
+            return 0;
+        }
+        (void)pbuf_free(received[i]);
+    }
+    if ((wifi_host.rx_errors != 0U) || (wifi_host_rx_held() != 0U) || (wifi_host.rx_releases != wifi_host.rx_holds))
+    {
+        printf("FAIL %s: %u rx buffers held, %u released, %u still held, %u out of turn\n", c->name,
+               (unsigned int)wifi_host.rx_holds, (unsigned int)wifi_host.rx_releases, wifi_host_rx_held(),
+               (unsigned int)wifi_host.rx_errors);
+        return 0;
+    }
+    if (!pools_empty())
+    {
+        printf("FAIL %s: pbufs left allocated\n", c->name);
+        return 0;
+    }
+
+    printf("%-17s %4u bytes %2u subframes, %2u views, rx buffer %s\n", c->name, (unsigned int)len, subframes, views,
+           (wifi_host.rx_holds != 0U) ? "held" : "copied");
+    return 1;
+}
+
+static err_t rx_netif_init(struct netif *netif)
+{
+    return ERR_OK;
+}
+
+int main(int argc, char **argv)
+{
+    size_t i;
+
+    wifi_host_init();
+    wifi_host.rx_packet_fn = amsdu_rx_packet;
+
+    (void)netif_add(&rx_netif, IP4_ADDR_ANY4, IP4_ADDR_ANY4, IP4_ADDR_ANY4, NULL, rx_netif_init, keep_input);
+    (void)wlan_get_mac_address(rx_netif.hwaddr);
+    rx_netif.hwaddr_len          = ETH_HWADDR_LEN;
+    netif_arr[MLAN_BSS_TYPE_STA] = &rx_netif;
+
+    for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        if (!case_run(&cases[i]))
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
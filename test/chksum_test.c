@@ -0,0 +1,228 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Cross-check and benchmark of the port checksum (lwip/port/chksum.c).
+ *
+ * Random buffers of every start alignment and length up to 2000 bytes are
+ * summed by the portable and the DSP variant of lwip_port_chksum() and
+ * lwip_port_chksum_copy() and compared with lwIP's lwip_standard_chksum()
+ * and with a byte-wise reference. The benchmark then reports bytes per
+ * cycle of the portable variant against lwip_standard_chksum(), also for
+ * an odd start address (port+1), and of the summing copy against memcpy()
+ * followed by lwip_standard_chksum().
+ *
+ * Usage: chksum_test [iterations]
+ */
+
+#include "lwip/opt.h"
+#include "lwip/def.h"
+#include "lwip/inet_chksum.h"
+
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+#define MAX_LEN   2000
+#define MAX_ALIGN 8
+
+/*******************************************************************************
+ * Prototypes
+ ******************************************************************************/
+
+u16_t lwip_standard_chksum(const void *dataptr, int len);
+u16_t lwip_port_chksum(const void *dataptr, int len);
+u16_t lwip_port_chksum_copy(void *dst, const void *src, u16_t len);
+/* The DSP variant, chksum.c built with __ARM_FEATURE_DSP and the emulated intrinsics */
+u16_t lwip_port_chksum_dsp(const void *dataptr, int len);
+u16_t lwip_port_chksum_copy_dsp(void *dst, const void *src, u16_t len);
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+__thread uint32_t cmsis_host_ge;
+
+static u8_t src_buf[MAX_LEN + MAX_ALIGN] __attribute__((aligned(8)));
+static u8_t dst_buf[MAX_LEN + MAX_ALIGN] __attribute__((aligned(8)));
+static unsigned long failures;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+/* Byte-wise one's complement sum of big endian halfwords, not inverted */
+static u16_t reference_chksum(const u8_t *data, int len)
+{
+    u32_t sum = 0;
+    int i;
+
+    for (i = 0; i + 1 < len; i += 2)
+    {
+        sum += ((u32_t)data[i] << 8) | data[i + 1];
+    }
+    if (len & 1)
+    {
+        sum += (u32_t)data[len - 1] << 8;
+    }
+    while (sum >> 16)
+    {
+        sum = (sum & 0xFFFFU) + (sum >> 16);
+    }
+    return lwip_htons((u16_t)sum);
+}
+
+static void check(const char *what, int src_align, int dst_align, int len, u16_t expected, u16_t got)
+{
+    if (expected != got)
+    {
+        failures++;
+        if (failures <= 10U)
+        {
+            printf("FAIL %s: src align %d, dst align %d, len %d: expected 0x%04x, got 0x%04x\n", what, src_align,
+                   dst_align, len, expected, got);
+        }
+    }
+}
+
+static void check_copy(const char *what, u16_t (*copy_fn)(void *, const void *, u16_t), int src_align, u16_t expected,
+                       int len)
+{
+    int dst_align = rand() % MAX_ALIGN;
+    u16_t sum;
+
+    /* Half of the copies share the word alignment and take the summing copy loop */
+    if (rand() & 1)
+    {
+        dst_align = src_align;
+    }
+
+    memset(dst_buf, 0xA5, sizeof(dst_buf));
+    sum = copy_fn(&dst_buf[dst_align], &src_buf[src_align], (u16_t)len);
+    check(what, src_align, dst_align, len, expected, sum);
+    if (memcmp(&dst_buf[dst_align], &src_buf[src_align], (size_t)len) != 0)
+    {
+        failures++;
+        printf("FAIL %s: src align %d, dst align %d, len %d: data not copied\n", what, src_align, dst_align, len);
+    }
+}
+
+static void cross_check(unsigned long iterations)
+{
+    unsigned long it;
+    int align;
+    int len;
+    int i;
+    u16_t expected;
+
+    for (it = 0; it < iterations; it++)
+    {
+        align = rand() % MAX_ALIGN;
+        /* Mostly short lengths, where the head and tail handling is */
+        len = (int)((it & 1U) ? ((unsigned int)rand() % 64U) : ((unsigned int)rand() % (MAX_LEN + 1U)));
+        for (i = 0; i < len; i++)
+        {
+            src_buf[align + i] = (u8_t)rand();
+        }
+        /* All ones data makes the most carries */
+        if ((it % 16U) == 0U)
+        {
+            memset(&src_buf[align], 0xFF, (unsigned int)len);
+        }
+
+        expected = reference_chksum(&src_buf[align], len);
+        check("lwip_standard_chksum", align, 0, len, expected, lwip_standard_chksum(&src_buf[align], len));
+        check("lwip_port_chksum", align, 0, len, expected, lwip_port_chksum(&src_buf[align], len));
+        check("lwip_port_chksum dsp", align, 0, len, expected, lwip_port_chksum_dsp(&src_buf[align], len));
+        check_copy("lwip_port_chksum_copy", lwip_port_chksum_copy, align, expected, len);
+        check_copy("lwip_port_chksum_copy dsp", lwip_port_chksum_copy_dsp, align, expected, len);
+    }
+}
+
+static double bench_sum(u16_t (*sum_fn)(const void *, int), int len, int align)
+{
+    volatile u16_t sink = 0;
+    uint64_t start;
+    uint64_t cycles;
+    unsigned long rounds = 20000000UL / (unsigned long)len;
+    unsigned long i;
+
+    start = bench_cycles();
+    for (i = 0; i < rounds; i++)
+    {
+        sink = (u16_t)(sink + sum_fn(&src_buf[align], len));
+    }
+    cycles = bench_cycles() - start;
+    (void)sink;
+
+    return (double)len * (double)rounds / (double)cycles;
+}
+
+/* Sum and copy in one pass against memcpy() followed by a sum */
+static double bench_copy(int use_port, int len)
+{
+    volatile u16_t sink = 0;
+    uint64_t start;
+    uint64_t cycles;
+    unsigned long rounds = 20000000UL / (unsigned long)len;
+    unsigned long i;
+
+    start = bench_cycles();
+    for (i = 0; i < rounds; i++)
+    {
+        if (use_port)
+        {
+            sink = (u16_t)(sink + lwip_port_chksum_copy(dst_buf, src_buf, (u16_t)len));
+        }
+        else
+        {
+            MEMCPY(dst_buf, src_buf, (size_t)len);
+            sink = (u16_t)(sink + lwip_standard_chksum(dst_buf, len));
+        }
+    }
+    cycles = bench_cycles() - start;
+    (void)sink;
+
+    return (double)len * (double)rounds / (double)cycles;
+}
+
+static void benchmark(void)
+{
+    static const int lengths[] = {40, 64, 256, 576, 1460};
+    size_t i;
+
+    printf("bytes per %s          len  standard      port  port+1  copy+sum  port copy\n", BENCH_UNIT);
+    for (i = 0; i < LWIP_ARRAYSIZE(lengths); i++)
+    {
+        printf("                        %4d  %8.2f  %8.2f  %6.2f  %8.2f  %9.2f\n", lengths[i],
+               bench_sum(lwip_standard_chksum, lengths[i], 0), bench_sum(lwip_port_chksum, lengths[i], 0),
+               bench_sum(lwip_port_chksum, lengths[i], 1), bench_copy(0, lengths[i]), bench_copy(1, lengths[i]));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    unsigned long iterations = (argc > 1) ? strtoul(argv[1], NULL, 0) : 200000UL;
+
+    srand(1);
+    cross_check(iterations);
+    if (failures != 0U)
+    {
+        printf("chksum_test: %lu of %lu checks failed\n", failures, iterations * 5U);
+        return 1;
+    }
+    printf("chksum_test: %lu buffers, all sums match\n", iterations);
+
+    benchmark();
+    return 0;
+}
@@ -0,0 +1,498 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * DISCOVER storm against the uAP DHCP server (wifi/dhcpd/dhcp-server.c).
+ *
+ * dhcp-server.c is included, so its messages are handed straight to
+ * process_dhcp_message() and the sockets, network interface and OS time are
+ * stubs. The millisecond time starts 25 s before it wraps at 2^32:
+ *  - storm: half the lease table worth of clients send their DISCOVER up to
+ *    3 times, interleaved, then REQUEST the offered address;
+ *  - offers: as many clients again DISCOVER and never REQUEST, filling the
+ *    table;
+ *  - wrap: 61 s later, past the millisecond wrap, a third group binds, which
+ *    needs the held offers to have expired and to be reclaimed;
+ *  - restart: the server is started again and has to restore the bound
+ *    leases from the lease store.
+ * Every bound client has to get a distinct address of the subnet, keep it and
+ * find it in the lease table. The processing time of each message is
+ * reported as the response latency of the server.
+ *
+ * Usage: dhcpd_storm_test [seed]
+ */
+
+/* Before the CMSIS headers, whose __I and __O macros break the x86 intrinsics */
+#include "bench.h"
+
+#include "../wifi/dhcpd/dhcp-server.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+#define GROUP_CLIENTS  (MAC_IP_CACHE_SIZE / 2)
+#define MAX_CLIENTS    (3 * GROUP_CLIENTS)
+#define MAX_MESSAGES   (4 * MAX_CLIENTS)
+#define SERVER_IP      0xC0A80A01U /* 192.168.10.1 */
+#define SUBNET_MASK    0xFFFFFF00U
+#define MESSAGE_MSEC   10U
+#define CLOCK_START    (0U - 25000U)
+#define LEASE_STORE_SIZE 4096U
+
+struct client
+{
+    uint8_t mac[6];
+    uint32_t offered; /* network order */
+    uint32_t bound;   /* network order */
+};
+
+struct latency
+{
+    uint32_t ns[MAX_MESSAGES];
+    unsigned int count;
+};
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+int errno;
+
+static uint32_t host_msec = CLOCK_START;
+static int host_next_fd   = 3;
+static struct client clients[MAX_CLIENTS];
+static uint8_t last_type;
+static uint32_t last_yiaddr;
+static unsigned int responses;
+static unsigned int arps;
+static uint8_t lease_store[LEASE_STORE_SIZE];
+static uint32_t lease_store_len;
+static struct latency discover_latency;
+static struct latency request_latency;
+static unsigned long failures;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+#define CHECK(cond, ...)                     \
+    do                                       \
+    {                                        \
+        if (!(cond))                         \
+        {                                    \
+            printf("FAIL " __VA_ARGS__);     \
+            printf("\n");                    \
+            failures++;                      \
+        }                                    \
+    } while (0)
+
+/* OS, network and socket stubs */
+
+uint32_t OSA_TimeGetMsec(void)
+{
+    return host_msec;
+}
+
+void OSA_TimeDelay(uint32_t millisec)
+{
+    host_msec += millisec;
+}
+
+void *OSA_MemoryAllocate(uint32_t memLength)
+{
+    return calloc(1, memLength);
+}
+
+void OSA_MemoryFree(void *p)
+{
+    free(p);
+}
+
+osa_status_t OSA_MutexCreate(osa_mutex_handle_t mutexHandle)
+{
+    return KOSA_StatusSuccess;
+}
+
+osa_status_t OSA_MutexDestroy(osa_mutex_handle_t mutexHandle)
+{
+    return KOSA_StatusSuccess;
+}
+
+osa_status_t OSA_MutexLock(osa_mutex_handle_t mutexHandle, uint32_t millisec)
+{
+    return KOSA_StatusSuccess;
+}
+
+osa_status_t OSA_MutexUnlock(osa_mutex_handle_t mutexHandle)
+{
+    return KOSA_StatusSuccess;
+}
+
+int DbgConsole_Printf(const char *fmt_s, ...)
+{
+    return 0;
+}
+
+u32_t lwip_htonl(u32_t x)
+{
+    return __builtin_bswap32(x);
+}
+
+u16_t lwip_htons(u16_t x)
+{
+    return __builtin_bswap16(x);
+}
+
+int ip4addr_aton(const char *cp, ip4_addr_t *addr)
+{
+    return 0;
+}
+
+char *ip4addr_ntoa(const ip4_addr_t *addr)
+{
+    return "";
+}
+
+int net_get_if_ip_addr(uint32_t *ip, void *intrfc_handle)
+{
+    *ip = htonl(SERVER_IP);
+    return WM_SUCCESS;
+}
+
+int net_get_if_ip_mask(uint32_t *nm, void *intrfc_handle)
+{
+    *nm = htonl(SUBNET_MASK);
+    return WM_SUCCESS;
+}
+
+int net_get_if_name(char *if_name, void *intrfc_handle)
+{
+    (void)strcpy(if_name, "ua");
+    return WM_SUCCESS;
+}
+
+int wlan_get_mac_address_uap(uint8_t *dest)
+{
+    (void)memset(dest, 0x02, MLAN_MAC_ADDR_LENGTH);
+    return WM_SUCCESS;
+}
+
+int dns_server_init(void *intrfc_handle)
+{
+    return WM_SUCCESS;
+}
+
+void dns_process_packet(fd_set *rfds)
+{
+}
+
+uint32_t dns_get_nameserver(void)
+{
+    return htonl(SERVER_IP);
+}
+
+int dns_get_maxsock(fd_set *rfds)
+{
+    return 0;
+}
+
+void dns_free_allocations(void)
+{
+}
+
+int socket(int domain, int type, int protocol)
+{
+    return host_next_fd++;
+}
+
+int bind(int s, const struct sockaddr *name, socklen_t namelen)
+{
+    return 0;
+}
+
+int setsockopt(int s, int level, int optname, const void *optval, socklen_t optlen)
+{
+    return 0;
+}
+
+int ioctl(int s, long cmd, void *argp)
+{
+    return 0;
+}
+
+int close(int s)
+{
+    return 0;
+}
+
+int select(int maxfdp1, fd_set *readset, fd_set *writeset, fd_set *exceptset, struct timeval *timeout)
+{
+    return -1;
+}
+
+ssize_t recvfrom(int s, void *mem, size_t len, int flags, struct sockaddr *from, socklen_t *fromlen)
+{
+    return -1;
+}
+
+ssize_t sendto(int s, const void *dataptr, size_t size, int flags, const struct sockaddr *to, socklen_t tolen)
+{
+    const struct bootp_header *hdr = (const struct bootp_header *)dataptr;
+    const struct bootp_option *opt = (const struct bootp_option *)(const void *)(hdr + 1);
+
+    if (s != dhcps.sock)
+    {
+        arps++;
+        return (ssize_t)size;
+    }
+    if (size < sizeof(*hdr) + sizeof(*opt) + 1U)
+    {
+        return -1;
+    }
+    responses++;
+    last_type   = (opt->type == BOOTP_OPTION_DHCP_MESSAGE) ? (uint8_t)opt->value[0] : 0U;
+    last_yiaddr = hdr->yiaddr;
+    return (ssize_t)size;
+}
+
+static int store_save(const void *data, uint32_t len)
+{
+    if (len > sizeof(lease_store))
+    {
+        return -WM_FAIL;
+    }
+    (void)memcpy(lease_store, data, len);
+    lease_store_len = len;
+    return WM_SUCCESS;
+}
+
+static int store_load(void *data, uint32_t len)
+{
+    len = (len < lease_store_len) ? len : lease_store_len;
+    (void)memcpy(data, lease_store, len);
+    return (int)len;
+}
+
+/* Test */
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+static void latency_report(const char *name, struct latency *latency)
+{
+    if (latency->count == 0U)
+    {
+        return;
+    }
+    qsort(latency->ns, latency->count, sizeof(latency->ns[0]), cmp_u32);
+    printf("%-8s %6u %9u %9u %9u\n", name, latency->count, latency->ns[latency->count / 2U],
+           latency->ns[(latency->count * 99U) / 100U], latency->ns[latency->count - 1U]);
+}
+
+/* Sends one client message to the server, returns the response type or DHCP_NO_RESPONSE */
+static uint8_t client_send(struct client *client, enum dhcp_message_type type)
+{
+    struct bootp_header *hdr = (struct bootp_header *)(void *)dhcps.msg;
+    struct latency *latency  = (type == DHCP_MESSAGE_DISCOVER) ? &discover_latency : &request_latency;
+    char *offset             = dhcps.msg + sizeof(*hdr);
+    struct bootp_option *opt;
+    unsigned int before = responses;
+    uint64_t start;
+
+    (void)memset(dhcps.msg, 0, sizeof(dhcps.msg));
+    hdr->op     = BOOTP_OP_REQUEST;
+    hdr->htype  = 1;
+    hdr->hlen   = 6;
+    hdr->xid    = (uint32_t)(client - clients);
+    hdr->cookie = htonl(0x63825363U);
+    (void)memcpy(hdr->chaddr, client->mac, sizeof(client->mac));
+
+    opt           = (struct bootp_option *)(void *)offset;
+    opt->type     = BOOTP_OPTION_DHCP_MESSAGE;
+    opt->length   = 1;
+    opt->value[0] = (char)type;
+    offset += sizeof(*opt) + opt->length;
+    if (type == DHCP_MESSAGE_REQUEST)
+    {
+        opt         = (struct bootp_option *)(void *)offset;
+        opt->type   = BOOTP_OPTION_REQUESTED_IP;
+        opt->length = 4;
+        (void)memcpy(opt->value, &client->offered, 4);
+        offset += sizeof(*opt) + opt->length;
+    }
+    *offset++ = (char)BOOTP_END_OPTION;
+
+    start = bench_ns();
+    (void)process_dhcp_message(dhcps.msg, (int)(offset - dhcps.msg));
+    if (latency->count < MAX_MESSAGES)
+    {
+        latency->ns[latency->count++] = (uint32_t)(bench_ns() - start);
+    }
+    host_msec += MESSAGE_MSEC;
+
+    if (responses == before)
+    {
+        return (uint8_t)DHCP_NO_RESPONSE;
+    }
+    if (last_type == (uint8_t)DHCP_MESSAGE_OFFER)
+    {
+        client->offered = last_yiaddr;
+    }
+    return last_type;
+}
+
+static void clients_init(unsigned int seed)
+{
+    unsigned int i;
+
+    for (i = 0; i < MAX_CLIENTS; i++)
+    {
+        clients[i].mac[0] = 0x02;
+        clients[i].mac[1] = (uint8_t)seed;
+        clients[i].mac[2] = (uint8_t)(seed >> 8);
+        clients[i].mac[3] = (uint8_t)(rand_r(&seed) & 0xFF);
+        clients[i].mac[4] = (uint8_t)(i >> 8);
+        clients[i].mac[5] = (uint8_t)i;
+    }
+}
+
+/* DISCOVERs of a group, each sent 1 to 3 times and interleaved, then REQUESTs if bind */
+static void group_run(const char *phase, unsigned int first, bool bind, unsigned int *seed)
+{
+    unsigned int left[GROUP_CLIENTS];
+    unsigned int pending = 0;
+    unsigned int i;
+    uint8_t type;
+
+    for (i = 0; i < GROUP_CLIENTS; i++)
+    {
+        left[i] = 1U + (unsigned int)rand_r(seed) % 3U;
+        pending += left[i];
+    }
+    while (pending > 0U)
+    {
+        i = (unsigned int)rand_r(seed) % GROUP_CLIENTS;
+        if (left[i] == 0U)
+        {
+            continue;
+        }
+        left[i]--;
+        pending--;
+        type = client_send(&clients[first + i], DHCP_MESSAGE_DISCOVER);
+        CHECK(type == (uint8_t)DHCP_MESSAGE_OFFER, "%s: client %u DISCOVER answered with %u", phase, first + i,
+              (unsigned int)type);
+    }
+
+    if (!bind)
+    {
+        return;
+    }
+    for (i = first; i < first + GROUP_CLIENTS; i++)
+    {
+        type = client_send(&clients[i], DHCP_MESSAGE_REQUEST);
+        CHECK(type == (uint8_t)DHCP_MESSAGE_ACK, "%s: client %u REQUEST answered with %u", phase, i,
+              (unsigned int)type);
+        clients[i].bound = (type == (uint8_t)DHCP_MESSAGE_ACK) ? last_yiaddr : 0U;
+    }
+}
+
+/* Bound clients of [0, end) have distinct addresses of the subnet, found in the lease table */
+static void check_bound(const char *phase, unsigned int end)
+{
+    uint32_t host;
+    uint32_t ip;
+    unsigned int i;
+    unsigned int j;
+
+    for (i = 0; i < end; i++)
+    {
+        if (clients[i].bound == 0U)
+        {
+            continue;
+        }
+        host = ntohl(clients[i].bound) & ~SUBNET_MASK;
+        CHECK(((ntohl(clients[i].bound) & SUBNET_MASK) == (SERVER_IP & SUBNET_MASK)) && (host != 0U) &&
+                  (host != (SERVER_IP & ~SUBNET_MASK)) && (host != ~SUBNET_MASK),
+              "%s: client %u bound to host %u", phase, i, (unsigned int)host);
+        CHECK((dhcp_get_ip_from_mac(clients[i].mac, &ip) == WM_SUCCESS) && (ip == clients[i].bound),
+              "%s: lease of client %u lost", phase, i);
+        for (j = i + 1U; j < end; j++)
+        {
+            CHECK(clients[j].bound != clients[i].bound, "%s: clients %u and %u share an address", phase, i, j);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int seed = (argc > 1) ? (unsigned int)strtoul(argv[1], NULL, 0) : 1U;
+    unsigned int i;
+    uint32_t sec_before;
+
+    clients_init(seed);
+    dhcp_server_set_lease_store(store_save, store_load);
+    if (dhcp_server_init(NULL) != WM_SUCCESS)
+    {
+        printf("FAIL server not started\n");
+        return 1;
+    }
+
+    group_run("storm", 0, true, &seed);
+    check_bound("storm", GROUP_CLIENTS);
+    CHECK(arps == GROUP_CLIENTS, "storm: %u gratuitous ARPs for %u ACKs", arps, GROUP_CLIENTS);
+
+    group_run("offers", GROUP_CLIENTS, false, &seed);
+    CHECK(dhcps.count_clients == MAC_IP_CACHE_SIZE, "offers: %d of %d leases held", dhcps.count_clients,
+          MAC_IP_CACHE_SIZE);
+
+    sec_before = ac_now();
+    host_msec += (DHCP_OFFER_TIMEOUT + 1U) * 1000U;
+    CHECK(host_msec < CLOCK_START, "wrap: the millisecond time did not wrap");
+    CHECK(ac_now() - sec_before == DHCP_OFFER_TIMEOUT + 1U, "wrap: %u s passed, not %u",
+          (unsigned int)(ac_now() - sec_before), DHCP_OFFER_TIMEOUT + 1U);
+    group_run("wrap", 2U * GROUP_CLIENTS, true, &seed);
+    check_bound("wrap", MAX_CLIENTS);
+
+    if (dhcp_server_init(NULL) != WM_SUCCESS)
+    {
+        printf("FAIL server not restarted\n");
+        return 1;
+    }
+    CHECK(dhcps.count_clients == 2 * GROUP_CLIENTS, "restart: %d of %d leases restored", dhcps.count_clients,
+          2 * GROUP_CLIENTS);
+    check_bound("restart", MAX_CLIENTS);
+    for (i = 0; i < GROUP_CLIENTS; i++)
+    {
+        uint8_t type = client_send(&clients[i], DHCP_MESSAGE_REQUEST);
+
+        CHECK((type == (uint8_t)DHCP_MESSAGE_ACK) && (last_yiaddr == clients[i].bound),
+              "restart: client %u not given its address back", i);
+    }
+
+    printf("%d lease table entries, %d clients bound, %d offers held and reclaimed across the millisecond wrap\n",
+           MAC_IP_CACHE_SIZE, 2 * GROUP_CLIENTS, GROUP_CLIENTS);
+    printf("%-8s %6s %9s %9s %9s\n", "message", "count", "p50 ns", "p99 ns", "max ns");
+    latency_report("DISCOVER", &discover_latency);
+    latency_report("REQUEST", &request_latency);
+
+    if (failures != 0U)
+    {
+        printf("%lu checks failed\n", failures);
+        return 1;
+    }
+    printf("dhcpd_storm_test passed\n");
+    return 0;
+}
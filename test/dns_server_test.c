@@ -0,0 +1,370 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Queries against the uAP DNS server (wifi/dhcpd/dns-server.c).
+ *
+ * dns-server.c is included, so its queries are handed straight to
+ * process_dns_message() and the socket is a stub that keeps the response.
+ * The queries are:
+ *  - a query as dig sends it, with an EDNS OPT record after the question;
+ *  - the name in other case, an AAAA query and an unknown name;
+ *  - two questions, the second name compressed to a pointer into the first;
+ *  - malformed names: a pointer forward, a pointer loop and a name running
+ *    past the message;
+ *  - "*", which answers every name, also a compressed one and one longer
+ *    than a domain name can be;
+ *  - the server stopped and enabled again without names, which has to
+ *    refuse the names it had before;
+ *  - more domain names than are kept.
+ * Every response is checked field by field: rcode, aa, the question echoed,
+ * one A record of the server address per A question, pointing at the
+ * question.
+ *
+ * Usage: dns_server_test
+ */
+
+/* Before the CMSIS headers, whose __I and __O macros break the x86 intrinsics */
+#include "bench.h"
+
+#include "../wifi/dhcpd/dns-server.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+#define SERVER_IP     0xC0A80101U /* 192.168.1.1 */
+#define DNS_HDR_LEN   12U
+#define DNS_RR_LEN    16U
+#define NO_RESPONSE   (-1)
+#define RCODE_REFUSED 5
+#define EXTRA_NAMES   300
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+struct dhcp_server_data dhcps;
+
+static uint8_t response[SERVER_BUFFER_SIZE];
+static int response_len;
+static unsigned long failures;
+
+static char *domain_names[] = {"webconfig.nxp", "www.example.com", "mail.example.com", NULL};
+static char *wildcard_names[] = {"*", NULL};
+
+/* dig @192.168.1.1 webconfig.nxp: RD and AD set, an OPT record with a cookie */
+static const uint8_t dig_query[] = {
+    0x5a, 0x3c, 0x01, 0x20, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x09, 'w',  'e',  'b',
+    'c',  'o',  'n',  'f',  'i',  'g',  0x03, 'n',  'x',  'p',  0x00, 0x00, 0x01, 0x00, 0x01, 0x00,
+    0x00, 0x29, 0x04, 0xd0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0c, 0x00, 0x0a, 0x00, 0x08, 0x8f, 0x41,
+    0x6e, 0x27, 0x19, 0x0b, 0xd2, 0x53};
+
+/* www.example.com A, then mail and a pointer to example.com of the first question, A */
+static const uint8_t compressed_query[] = {
+    0x11, 0x22, 0x01, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 'w', 'w', 'w', 0x07, 'e', 'x',
+    'a',  'm',  'p',  'l',  'e',  0x03, 'c',  'o',  'm',  0x00, 0x00, 0x01, 0x00, 0x01, 0x04, 'm', 'a', 'i', 'l',
+    0xc0, 0x10, 0x00, 0x01, 0x00, 0x01};
+
+/* a pointer to the question itself */
+static const uint8_t loop_query[] = {0x11, 0x23, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                                     0x03, 'w',  'w',  'w',  0xc0, 0x0c, 0x00, 0x01, 0x00, 0x01};
+
+/* a pointer past itself */
+static const uint8_t forward_query[] = {0x11, 0x24, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                                        0xc0, 0x12, 0x00, 0x01, 0x00, 0x01, 0x03, 'w',  'w',  'w',  0x00};
+
+/* a label running past the message */
+static const uint8_t short_query[] = {0x11, 0x25, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00,
+                                      0x00, 0x00, 0x09, 'w',  'e',  'b',  'c',  'o',  'n',  'f'};
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+#define CHECK(cond, ...)                     \
+    do                                       \
+    {                                        \
+        if (!(cond))                         \
+        {                                    \
+            printf("FAIL " __VA_ARGS__);     \
+            printf("\n");                    \
+            failures++;                      \
+        }                                    \
+    } while (0)
+
+/* OS, network and socket stubs */
+
+void *OSA_MemoryAllocate(uint32_t memLength)
+{
+    return calloc(1, memLength);
+}
+
+void OSA_MemoryFree(void *p)
+{
+    free(p);
+}
+
+int DbgConsole_Printf(const char *fmt_s, ...)
+{
+    return 0;
+}
+
+u32_t lwip_htonl(u32_t x)
+{
+    return __builtin_bswap32(x);
+}
+
+u16_t lwip_htons(u16_t x)
+{
+    return __builtin_bswap16(x);
+}
+
+int dhcp_create_and_bind_udp_socket(struct sockaddr_in *address, void *intrfc_handle)
+{
+    return 4;
+}
+
+int close(int s)
+{
+    return 0;
+}
+
+ssize_t recvfrom(int s, void *mem, size_t len, int flags, struct sockaddr *from, socklen_t *fromlen)
+{
+    return -1;
+}
+
+int dhcp_send_response(int sock, struct sockaddr *addr, char *msg, int len)
+{
+    (void)memcpy(response, msg, (size_t)len);
+    response_len = len;
+    return WM_SUCCESS;
+}
+
+/* Test */
+
+static uint16_t get16(const uint8_t *p)
+{
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+    return ((uint32_t)get16(p) << 16) | get16(p + 2);
+}
+
+/* Hands a copy of the query to the server as the socket would */
+static int query(const uint8_t *msg, size_t len)
+{
+    struct sockaddr_in from = {0};
+
+    (void)memcpy(dhcps.msg, msg, len);
+    response_len = NO_RESPONSE;
+    (void)process_dns_message(dhcps.msg, (int)len, &from);
+    return response_len;
+}
+
+/*
+ * Checks the response to a query whose questions take qlen bytes after the
+ * header, with one A record expected for each of the answers question
+ * offsets.
+ */
+static void check_response(const char *name, const uint8_t *msg, size_t qlen, int rcode, const uint16_t *answers, int na)
+{
+    size_t len = DNS_HDR_LEN + qlen + ((size_t)na * DNS_RR_LEN);
+    const uint8_t *rr;
+    int i;
+
+    if (response_len == NO_RESPONSE)
+    {
+        CHECK(0, "%s: no response", name);
+        return;
+    }
+    CHECK((size_t)response_len == len, "%s: response of %d bytes, %u expected", name, response_len, (unsigned int)len);
+    if ((size_t)response_len != len)
+    {
+        return;
+    }
+    CHECK(get16(response) == get16(msg), "%s: transaction id changed", name);
+    CHECK((response[2] & 0x80U) != 0U, "%s: not a response", name);
+    CHECK((response[3] & 0x0fU) == rcode, "%s: rcode %d, %d expected", name, response[3] & 0x0f, rcode);
+    CHECK(((response[2] & 0x04U) != 0U) == (rcode == 0), "%s: authoritative answer bit", name);
+    CHECK(get16(response + 4) == get16(msg + 4), "%s: question count changed", name);
+    CHECK(get16(response + 6) == (uint16_t)na, "%s: %u answers, %d expected", name, get16(response + 6), na);
+    CHECK((get16(response + 8) == 0U) && (get16(response + 10) == 0U), "%s: authority or additional records", name);
+    CHECK(memcmp(response + DNS_HDR_LEN, msg + DNS_HDR_LEN, qlen) == 0, "%s: questions changed", name);
+
+    rr = response + DNS_HDR_LEN + qlen;
+    for (i = 0; i < na; i++, rr += DNS_RR_LEN)
+    {
+        CHECK(get16(rr) == (0xC000U | answers[i]), "%s: answer %d points to 0x%04x", name, i, get16(rr));
+        CHECK((get16(rr + 2) == DNS_TYPE_A) && (get16(rr + 4) == DNS_CLASS_IN), "%s: answer %d not IN A", name, i);
+        CHECK(get32(rr + 6) == DNS_TTL, "%s: answer %d TTL %u", name, i, get32(rr + 6));
+        CHECK((get16(rr + 10) == 4U) && (get32(rr + 12) == SERVER_IP), "%s: answer %d address", name, i);
+    }
+}
+
+/* Builds a query of one question for name, returns its length */
+static size_t build_query(uint8_t *msg, const char *name, uint16_t type)
+{
+    size_t len = DNS_HDR_LEN;
+
+    (void)memset(msg, 0, DNS_HDR_LEN);
+    msg[0] = 0x42;
+    msg[2] = 0x01; /* RD */
+    msg[5] = 1;
+    format_qname((char *)name, (char *)&msg[len]);
+    len += strlen(name) + 1U;
+    msg[len++] = 0; /* root label */
+    msg[len++] = (uint8_t)(type >> 8);
+    msg[len++] = (uint8_t)type;
+    msg[len++] = 0;
+    msg[len++] = DNS_CLASS_IN;
+    return len;
+}
+
+static void server_start(char **names)
+{
+    dhcp_enable_dns_server(names);
+    (void)dns_server_init(NULL);
+}
+
+static void test_names(void)
+{
+    static const uint16_t first[]  = {DNS_HDR_LEN};
+    static const uint16_t second[] = {DNS_HDR_LEN, 33};
+    uint8_t msg[SERVER_BUFFER_SIZE];
+    size_t len;
+
+    server_start(domain_names);
+
+    (void)query(dig_query, sizeof(dig_query));
+    /* the OPT record is dropped from the response */
+    check_response("dig", dig_query, 19, 0, first, 1);
+
+    len = build_query(msg, "WebConfig.NXP", DNS_TYPE_A);
+    (void)query(msg, len);
+    check_response("case", msg, len - DNS_HDR_LEN, 0, first, 1);
+
+    len = build_query(msg, "webconfig.nxp", 28U /* AAAA */);
+    (void)query(msg, len);
+    check_response("AAAA", msg, len - DNS_HDR_LEN, 0, NULL, 0);
+
+    len = build_query(msg, "example.com", DNS_TYPE_A);
+    (void)query(msg, len);
+    check_response("unknown", msg, len - DNS_HDR_LEN, RCODE_REFUSED, NULL, 0);
+
+    (void)query(compressed_query, sizeof(compressed_query));
+    check_response("compressed", compressed_query, sizeof(compressed_query) - DNS_HDR_LEN, 0, second, 2);
+
+    CHECK(query(loop_query, sizeof(loop_query)) == NO_RESPONSE, "pointer loop answered");
+    CHECK(query(forward_query, sizeof(forward_query)) == NO_RESPONSE, "forward pointer answered");
+    CHECK(query(short_query, sizeof(short_query)) == NO_RESPONSE, "truncated name answered");
+
+    dns_free_allocations();
+}
+
+static void test_wildcard(void)
+{
+    static const uint16_t first[]  = {DNS_HDR_LEN};
+    static const uint16_t second[] = {DNS_HDR_LEN, 33};
+    uint8_t msg[SERVER_BUFFER_SIZE];
+    size_t len;
+
+    server_start(wildcard_names);
+
+    len = build_query(msg, "connectivitycheck.gstatic.com", DNS_TYPE_A);
+    (void)query(msg, len);
+    check_response("wildcard", msg, len - DNS_HDR_LEN, 0, first, 1);
+
+    len = build_query(msg, "a-name-longer-than-any-domain-name-the-server-keeps.example.com", DNS_TYPE_A);
+    (void)query(msg, len);
+    check_response("wildcard long", msg, len - DNS_HDR_LEN, 0, first, 1);
+
+    (void)query(compressed_query, sizeof(compressed_query));
+    check_response("wildcard compressed", compressed_query, sizeof(compressed_query) - DNS_HDR_LEN, 0, second, 2);
+
+    CHECK(query(loop_query, sizeof(loop_query)) == NO_RESPONSE, "wildcard: pointer loop answered");
+
+    dns_free_allocations();
+}
+
+/* A server enabled again without names must not use the names of the one before */
+static void test_restart(void)
+{
+    uint8_t msg[SERVER_BUFFER_SIZE];
+    size_t len;
+
+    server_start(domain_names);
+    dns_free_allocations();
+    server_start(NULL);
+    len = build_query(msg, "webconfig.nxp", DNS_TYPE_A);
+    (void)query(msg, len);
+    check_response("restart", msg, len - DNS_HDR_LEN, RCODE_REFUSED, NULL, 0);
+    dns_free_allocations();
+
+    server_start(wildcard_names);
+    dns_free_allocations();
+    server_start(NULL);
+    (void)query(msg, len);
+    check_response("restart wildcard", msg, len - DNS_HDR_LEN, RCODE_REFUSED, NULL, 0);
+    dns_free_allocations();
+}
+
+static void test_many_names(void)
+{
+    static const uint16_t first[] = {DNS_HDR_LEN};
+    static char names[EXTRA_NAMES][16];
+    static char *list[EXTRA_NAMES + 1];
+    uint8_t msg[SERVER_BUFFER_SIZE];
+    size_t len;
+    int i;
+
+    for (i = 0; i < EXTRA_NAMES; i++)
+    {
+        (void)snprintf(names[i], sizeof(names[i]), "n%d.test", i);
+        list[i] = names[i];
+    }
+    list[EXTRA_NAMES] = NULL;
+    server_start(list);
+
+    CHECK(dnss.count_qnames == (int)DNS_MAX_QNAMES, "%d of %d domain names kept, %d expected", dnss.count_qnames,
+          EXTRA_NAMES, (int)DNS_MAX_QNAMES);
+
+    len = build_query(msg, names[DNS_MAX_QNAMES - 1U], DNS_TYPE_A);
+    (void)query(msg, len);
+    check_response("last name kept", msg, len - DNS_HDR_LEN, 0, first, 1);
+
+    len = build_query(msg, names[DNS_MAX_QNAMES], DNS_TYPE_A);
+    (void)query(msg, len);
+    check_response("first name dropped", msg, len - DNS_HDR_LEN, RCODE_REFUSED, NULL, 0);
+
+    dns_free_allocations();
+}
+
+int main(int argc, char **argv)
+{
+    dhcps.my_ip  = htonl(SERVER_IP);
+    dnss.dnssock = -1;
+
+    test_names();
+    test_wildcard();
+    test_restart();
+    test_many_names();
+
+    if (failures != 0U)
+    {
+        printf("%lu checks failed\n", failures);
+        return 1;
+    }
+    printf("dns server: %d domain names kept at most, all queries answered as expected\n", (int)DNS_MAX_QNAMES);
+    return 0;
+}
@@ -0,0 +1,507 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Trace replay stress test of the TLSF heap
+ * (freertos/freertos-kernel/portable/MemMang/heap_tlsf.c).
+ *
+ * An allocation trace is replayed against the 120 KB heap of
+ * source/FreeRTOSConfig.h. The built-in trace models the application: task
+ * stacks and kernel objects allocated at boot, then lwIP PBUF_RAM buffers
+ * with short lifetimes, HTTP sessions, Wi-Fi scan results and occasional
+ * kernel objects, each with its allocation tag. A trace file is replayed
+ * instead when one is given, one operation per line:
+ *
+ *   m <id> <size> <tag>    allocate size bytes with tag (0..3) as block id
+ *   f <id>                 free block id
+ *
+ * Every allocated block is filled with a pattern that is checked when it is
+ * freed, and every 1000 operations the physical block list is walked and
+ * checked against the free lists, the free byte and block counters and the
+ * per-tag usage. When the trace is done every block is freed and the heap
+ * must have coalesced back into a single free block.
+ *
+ * The test reports failed allocations and peak usage per tag, the
+ * fragmentation (ulPortGetHeapFragmentation()) sampled every 1000
+ * operations, and the cost of pvPortMallocTagged() and vPortFree().
+ *
+ * Usage: heap_tlsf_test [trace file]
+ */
+
+#include "heap_tlsf.c"
+
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+#define MAX_BLOCKS    65536U
+#define TRACE_OPS     2000000U
+#define CHECK_PERIOD  1000U
+/* Expiry wheel of the built-in trace, longer than any lifetime */
+#define EXPIRY_SLOTS  32768U
+#define NO_BLOCK      0xFFFFFFFFU
+
+struct block
+{
+    uint8_t *ptr;
+    size_t size;
+    uint8_t tag;
+    uint8_t pattern;
+    /* Next block expiring in the same wheel slot */
+    uint32_t next;
+};
+
+/* An allocation source of the built-in trace */
+struct source
+{
+    const char *name;
+    uint8_t tag;
+    /* Share of the operations in percent */
+    unsigned int percent;
+    uint16_t min_size;
+    uint16_t max_size;
+    uint16_t min_life;
+    uint16_t max_life;
+    unsigned int max_live;
+    unsigned int live;
+};
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+static struct source sources[] = {
+    {"kernel", heapTAG_OTHER, 2, 64, 512, 2000, 20000, 24, 0},
+    {"pbuf", heapTAG_LWIP, 80, 64, 1600, 1, 64, 24, 0},
+    {"http", heapTAG_HTTP, 12, 512, 4096, 200, 3000, 4, 0},
+    {"wifi", heapTAG_WIFI, 6, 1024, 8192, 100, 1000, 2, 0},
+};
+
+/* Task stacks and queues created at boot, never freed */
+static const uint16_t boot_blocks[] = {4096, 4096, 4000, 4000, 3072, 2048, 2048, 2048, 1536, 1024, 640, 512, 256, 256};
+
+static const char *const tag_names[heapNUM_TAGS] = {"other", "lwip", "http", "wifi"};
+
+static struct block blocks[MAX_BLOCKS];
+static uint32_t free_ids[MAX_BLOCKS];
+static uint32_t free_id_count;
+static uint32_t expiry[EXPIRY_SLOTS];
+static unsigned int source_of[MAX_BLOCKS];
+
+static uint32_t *malloc_cycles;
+static uint32_t *free_cycles;
+static unsigned long malloc_count;
+static unsigned long free_count;
+
+static unsigned long ops;
+static unsigned long frag_samples;
+static unsigned long frag_sum;
+static uint32_t frag_max;
+static size_t largest_min = portMAX_DELAY;
+
+static uint32_t seed = 1;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+static uint32_t rand_next(void)
+{
+    seed = seed * 1103515245U + 12345U;
+    return seed >> 8;
+}
+
+static uint32_t rand_range(uint32_t min, uint32_t max)
+{
+    return min + rand_next() % (max - min + 1U);
+}
+
+/* Walks the physical blocks and checks them against the heap bookkeeping */
+static int heap_check(void)
+{
+    TLSFBlock_t *pxBlock = (TLSFBlock_t *)ucHeap;
+    TLSFBlock_t *pxPrev  = NULL;
+    size_t free_bytes    = 0;
+    size_t free_blocks   = 0;
+    size_t used[heapNUM_TAGS] = {0};
+    uint32_t fl;
+    uint32_t sl;
+    unsigned int tag;
+
+    if (xHeapInitialised == pdFALSE)
+    {
+        return 0;
+    }
+
+    for (;;)
+    {
+        if (pxBlock->pxPrevPhysBlock != pxPrev)
+        {
+            printf("FAIL block %p: previous block link broken\n", (void *)pxBlock);
+            return 1;
+        }
+
+        /* The zero sized, allocated sentinel ends the heap */
+        if ((prvBlockSize(pxBlock) == 0U) && (prvBlockIsFree(pxBlock) == pdFALSE))
+        {
+            break;
+        }
+
+        if (prvBlockIsFree(pxBlock) != pdFALSE)
+        {
+            TLSFBlock_t *pxList;
+
+            if ((pxPrev != NULL) && (prvBlockIsFree(pxPrev) != pdFALSE))
+            {
+                printf("FAIL block %p: adjacent free blocks not merged\n", (void *)pxBlock);
+                return 1;
+            }
+
+            prvMappingInsert(prvBlockSize(pxBlock), &fl, &sl);
+            for (pxList = pxFreeLists[fl][sl]; (pxList != NULL) && (pxList != pxBlock); pxList = pxList->pxNextFreeBlock)
+            {
+            }
+            if (pxList == NULL)
+            {
+                printf("FAIL block %p: free block not in its free list\n", (void *)pxBlock);
+                return 1;
+            }
+
+            free_bytes += heapBLOCK_HEADER_SIZE + prvBlockSize(pxBlock);
+            free_blocks++;
+        }
+        else
+        {
+            used[prvBlockTag(pxBlock)] += heapBLOCK_HEADER_SIZE + prvBlockSize(pxBlock);
+        }
+
+        pxPrev  = pxBlock;
+        pxBlock = prvNextPhysBlock(pxBlock);
+    }
+
+    if ((free_bytes != xFreeBytesRemaining) || (free_blocks != xNumberOfFreeBlocks))
+    {
+        printf("FAIL free bytes %zu/%zu, free blocks %zu/%zu\n", free_bytes, xFreeBytesRemaining, free_blocks,
+               xNumberOfFreeBlocks);
+        return 1;
+    }
+
+    for (tag = 0; tag < heapNUM_TAGS; tag++)
+    {
+        if (used[tag] != xTagStats[tag].xBytesInUse)
+        {
+            printf("FAIL tag %s: %zu bytes in use, counted %zu\n", tag_names[tag], used[tag],
+                   xTagStats[tag].xBytesInUse);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static void sample_fragmentation(void)
+{
+    HeapStats_t stats;
+    uint32_t frag = ulPortGetHeapFragmentation();
+
+    vPortGetHeapStats(&stats);
+    frag_sum += frag;
+    frag_samples++;
+    if (frag > frag_max)
+    {
+        frag_max = frag;
+    }
+    if (stats.xSizeOfLargestFreeBlockInBytes < largest_min)
+    {
+        largest_min = stats.xSizeOfLargestFreeBlockInBytes;
+    }
+}
+
+/* Ends an operation, returns non-zero when the periodic check fails */
+static int op_done(void)
+{
+    ops++;
+    if ((ops % CHECK_PERIOD) == 0U)
+    {
+        sample_fragmentation();
+        return heap_check();
+    }
+    return 0;
+}
+
+static int block_alloc(uint32_t id, size_t size, uint8_t tag)
+{
+    struct block *block = &blocks[id];
+    uint64_t start;
+    uint64_t cycles;
+
+    start      = bench_cycles();
+    block->ptr = pvPortMallocTagged(size, tag);
+    cycles     = bench_cycles() - start;
+    malloc_cycles[malloc_count % TRACE_OPS] = (uint32_t)cycles;
+    malloc_count++;
+
+    if (block->ptr == NULL)
+    {
+        return 0;
+    }
+
+    block->size    = size;
+    block->tag     = tag;
+    block->pattern = (uint8_t)rand_next();
+    memset(block->ptr, block->pattern, size);
+    return 1;
+}
+
+static int block_free(uint32_t id)
+{
+    struct block *block = &blocks[id];
+    uint64_t start;
+    uint64_t cycles;
+    size_t i;
+
+    for (i = 0; i < block->size; i++)
+    {
+        if (block->ptr[i] != block->pattern)
+        {
+            printf("FAIL block %u: overwritten at byte %zu\n", (unsigned int)id, i);
+            return 1;
+        }
+    }
+
+    start = bench_cycles();
+    vPortFree(block->ptr);
+    cycles = bench_cycles() - start;
+    free_cycles[free_count % TRACE_OPS] = (uint32_t)cycles;
+    free_count++;
+
+    block->ptr = NULL;
+    return 0;
+}
+
+/* The built-in trace of the application */
+static int replay_model(void)
+{
+    uint32_t step;
+    uint32_t id;
+    size_t i;
+
+    for (id = 0; id < MAX_BLOCKS; id++)
+    {
+        free_ids[id] = MAX_BLOCKS - 1U - id;
+    }
+    free_id_count = MAX_BLOCKS;
+    for (i = 0; i < EXPIRY_SLOTS; i++)
+    {
+        expiry[i] = NO_BLOCK;
+    }
+
+    for (i = 0; i < sizeof(boot_blocks) / sizeof(boot_blocks[0]); i++)
+    {
+        id = free_ids[--free_id_count];
+        if (!block_alloc(id, boot_blocks[i], heapTAG_OTHER))
+        {
+            printf("FAIL boot allocation of %u bytes\n", boot_blocks[i]);
+            return 1;
+        }
+    }
+
+    for (step = 0; ops < TRACE_OPS; step++)
+    {
+        struct source *source = sources;
+        uint32_t slot         = step % EXPIRY_SLOTS;
+        uint32_t pick         = rand_next() % 100U;
+
+        /* Free the blocks whose lifetime ends in this step */
+        while (expiry[slot] != NO_BLOCK)
+        {
+            id           = expiry[slot];
+            expiry[slot] = blocks[id].next;
+            sources[source_of[id]].live--;
+            if ((block_free(id) != 0) || (op_done() != 0))
+            {
+                return 1;
+            }
+            free_ids[free_id_count++] = id;
+        }
+
+        while (pick >= source->percent)
+        {
+            pick -= source->percent;
+            source++;
+        }
+        if (source->live == source->max_live)
+        {
+            continue;
+        }
+
+        id = free_ids[--free_id_count];
+        if (!block_alloc(id, rand_range(source->min_size, source->max_size), source->tag))
+        {
+            free_id_count++;
+        }
+        else
+        {
+            slot           = (step + rand_range(source->min_life, source->max_life)) % EXPIRY_SLOTS;
+            blocks[id].next = expiry[slot];
+            expiry[slot]   = id;
+            source_of[id]  = (unsigned int)(source - sources);
+            source->live++;
+        }
+        if (op_done() != 0)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static int replay_file(const char *path)
+{
+    FILE *file = fopen(path, "r");
+    char op;
+    unsigned int id;
+    unsigned int size;
+    unsigned int tag;
+    unsigned long line = 0;
+    int result         = 0;
+
+    if (file == NULL)
+    {
+        perror(path);
+        return 1;
+    }
+
+    while ((result == 0) && (fscanf(file, " %c %u", &op, &id) == 2))
+    {
+        line++;
+        if (id >= MAX_BLOCKS)
+        {
+            printf("%s:%lu: block id out of range\n", path, line);
+            result = 1;
+        }
+        else if (op == 'm')
+        {
+            if ((fscanf(file, "%u %u", &size, &tag) != 2) || (tag >= heapNUM_TAGS) || (blocks[id].ptr != NULL))
+            {
+                printf("%s:%lu: bad allocation\n", path, line);
+                result = 1;
+            }
+            else
+            {
+                (void)block_alloc(id, size, (uint8_t)tag);
+                result = op_done();
+            }
+        }
+        else if (op == 'f')
+        {
+            /* Frees of failed allocations are skipped */
+            if (blocks[id].ptr != NULL)
+            {
+                result = block_free(id);
+                result = (result != 0) ? result : op_done();
+            }
+        }
+        else
+        {
+            printf("%s:%lu: unknown operation '%c'\n", path, line, op);
+            result = 1;
+        }
+    }
+
+    fclose(file);
+    return result;
+}
+
+static int compare_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+static void print_cycles(const char *name, uint32_t *cycles, unsigned long count)
+{
+    if (count > TRACE_OPS)
+    {
+        count = TRACE_OPS;
+    }
+    if (count == 0U)
+    {
+        return;
+    }
+
+    qsort(cycles, count, sizeof(cycles[0]), compare_u32);
+    printf("%-18s %8u %8u %8u\n", name, cycles[count / 2U], cycles[count * 99U / 100U], cycles[count - 1U]);
+}
+
+int main(int argc, char **argv)
+{
+    HeapStats_t stats;
+    unsigned int tag;
+    uint32_t id;
+    int result;
+
+    malloc_cycles = malloc(TRACE_OPS * sizeof(malloc_cycles[0]));
+    free_cycles   = malloc(TRACE_OPS * sizeof(free_cycles[0]));
+
+    result = (argc > 1) ? replay_file(argv[1]) : replay_model();
+    if (result != 0)
+    {
+        return result;
+    }
+    vPortGetHeapStats(&stats);
+
+    printf("%lu operations in a %u byte heap, minimum ever free %zu bytes\n", ops,
+           (unsigned int)configTOTAL_HEAP_SIZE, stats.xMinimumEverFreeBytesRemaining);
+    printf("fragmentation mean %lu%%, max %u%%, smallest largest free block %zu bytes\n",
+           frag_samples ? frag_sum / frag_samples : 0UL, (unsigned int)frag_max, largest_min);
+    printf("tag    peak bytes  failed\n");
+    for (tag = 0; tag < heapNUM_TAGS; tag++)
+    {
+        printf("%-5s  %10zu  %6zu\n", tag_names[tag], xTagStats[tag].xPeakBytesInUse,
+               xTagStats[tag].xNumberOfFailedAllocations);
+    }
+    printf("%-18s %8s %8s %8s\n", BENCH_UNIT "s", "p50", "p99", "max");
+    print_cycles("pvPortMallocTagged", malloc_cycles, malloc_count);
+    print_cycles("vPortFree", free_cycles, free_count);
+
+    for (id = 0; id < MAX_BLOCKS; id++)
+    {
+        if ((blocks[id].ptr != NULL) && (block_free(id) != 0))
+        {
+            return 1;
+        }
+    }
+    if (heap_check() != 0)
+    {
+        return 1;
+    }
+    if ((xNumberOfFreeBlocks != 1U) || (ulPortGetHeapFragmentation() != 0U))
+    {
+        printf("FAIL %zu free blocks left after freeing everything\n", xNumberOfFreeBlocks);
+        return 1;
+    }
+    /* configTOTAL_HEAP_SIZE is sized for the built-in trace */
+    for (tag = 0; (argc <= 1) && (tag < heapNUM_TAGS); tag++)
+    {
+        if (xTagStats[tag].xNumberOfFailedAllocations != 0U)
+        {
+            printf("FAIL %zu %s allocations failed\n", xTagStats[tag].xNumberOfFailedAllocations, tag_names[tag]);
+            return 1;
+        }
+    }
+
+    return 0;
+}
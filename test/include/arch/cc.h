@@ -0,0 +1,38 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * lwIP architecture header of the host test builds, in place of
+ * lwip/port/arch/cc.h.
+ */
+
+#ifndef __CC_H__
+#define __CC_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define LWIP_TIMEVAL_PRIVATE 0
+#include <sys/time.h>
+
+#define LWIP_PLATFORM_DIAG(x) \
+    do                        \
+    {                         \
+        printf x;             \
+    } while (0)
+
+#define LWIP_PLATFORM_ASSERT(x)                                                 \
+    do                                                                          \
+    {                                                                           \
+        printf("Assertion \"%s\" failed at line %d in %s\n", x, __LINE__, __FILE__); \
+        fflush(NULL);                                                           \
+        abort();                                                                \
+    } while (0)
+
+#define LWIP_RAND() ((u32_t)random())
+
+#endif /* __CC_H__ */
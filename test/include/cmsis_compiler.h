@@ -0,0 +1,125 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Host stand-in for the CMSIS compiler header. The DSP intrinsics are
+ * emulated in C with the same results as the Cortex-M33 instructions, so the
+ * __ARM_FEATURE_DSP code paths can be checked on the host. The exclusive
+ * load and store are emulated for host threads, so lock-free code built for
+ * __ARM_ARCH_7EM__ can be run concurrently.
+ */
+
+#ifndef CMSIS_COMPILER_H
+#define CMSIS_COMPILER_H
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+
+#ifndef __STATIC_INLINE
+#define __STATIC_INLINE static inline
+#endif
+
+/* APSR.GE flags set by the last __UADD16 of this thread, one bit per byte */
+extern __thread uint32_t cmsis_host_ge;
+
+/* Two unsigned 16-bit additions, GE[1:0] and GE[3:2] are set by the carries */
+__STATIC_INLINE uint32_t __UADD16(uint32_t op1, uint32_t op2)
+{
+    uint32_t lo = (op1 & 0xFFFFU) + (op2 & 0xFFFFU);
+    uint32_t hi = (op1 >> 16) + (op2 >> 16);
+
+    cmsis_host_ge = ((lo > 0xFFFFU) ? 0x3U : 0U) | ((hi > 0xFFFFU) ? 0xCU : 0U);
+    return (lo & 0xFFFFU) | (hi << 16);
+}
+
+/* Selects each byte from op1 if its GE flag is set, from op2 otherwise */
+__STATIC_INLINE uint32_t __SEL(uint32_t op1, uint32_t op2)
+{
+    uint32_t result = 0;
+    uint32_t i;
+
+    for (i = 0; i < 4U; i++)
+    {
+        uint32_t mask = 0xFFUL << (8U * i);
+        result |= ((cmsis_host_ge >> i) & 1U) ? (op1 & mask) : (op2 & mask);
+    }
+    return result;
+}
+
+/*
+ * Exclusive monitor. A store-exclusive succeeds only if no other
+ * store-exclusive succeeded since the load-exclusive of the same thread,
+ * which is at least as strict as a core where any exception taken between
+ * the two clears the monitor.
+ */
+extern pthread_mutex_t cmsis_host_excl_lock;
+extern uint32_t cmsis_host_excl_stores;   /* successful store-exclusives */
+extern uint32_t cmsis_host_excl_failures; /* failed store-exclusives */
+/* Threads yield between the exclusive load and store every 2^n loads, to mix them. 0 never */
+extern unsigned int cmsis_host_excl_yield_shift;
+extern __thread uint32_t cmsis_host_excl_seen;
+extern __thread int cmsis_host_excl_open;
+extern __thread uint32_t cmsis_host_excl_loads;
+/* Run once before the next store-exclusive of this thread, like an interrupt, and clears the monitor */
+extern __thread void (*cmsis_host_excl_irq)(void);
+
+__STATIC_INLINE uint32_t __LDREXW(volatile uint32_t *addr)
+{
+    uint32_t value;
+
+    pthread_mutex_lock(&cmsis_host_excl_lock);
+    value                = *addr;
+    cmsis_host_excl_seen = cmsis_host_excl_stores;
+    cmsis_host_excl_open = 1;
+    pthread_mutex_unlock(&cmsis_host_excl_lock);
+
+    cmsis_host_excl_loads++;
+    if ((cmsis_host_excl_yield_shift != 0U) &&
+        ((cmsis_host_excl_loads & ((1UL << cmsis_host_excl_yield_shift) - 1U)) == 0U))
+    {
+        sched_yield();
+    }
+    return value;
+}
+
+/* Returns 0 if the value was stored, 1 if the monitor was lost */
+__STATIC_INLINE uint32_t __STREXW(uint32_t value, volatile uint32_t *addr)
+{
+    void (*irq)(void) = cmsis_host_excl_irq;
+    uint32_t result   = 1;
+
+    if (irq != NULL)
+    {
+        cmsis_host_excl_irq = NULL;
+        irq();
+        cmsis_host_excl_open = 0;
+    }
+
+    pthread_mutex_lock(&cmsis_host_excl_lock);
+    if (cmsis_host_excl_open && (cmsis_host_excl_seen == cmsis_host_excl_stores))
+    {
+        *addr = value;
+        cmsis_host_excl_stores++;
+        result = 0;
+    }
+    else
+    {
+        cmsis_host_excl_failures++;
+    }
+    cmsis_host_excl_open = 0;
+    pthread_mutex_unlock(&cmsis_host_excl_lock);
+
+    return result;
+}
+
+__STATIC_INLINE void __CLREX(void)
+{
+    cmsis_host_excl_open = 0;
+}
+
+#endif /* CMSIS_COMPILER_H */
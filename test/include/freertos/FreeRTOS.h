@@ -0,0 +1,59 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Host stand-in for the FreeRTOS configuration and types used by the heap
+ * (heap_tlsf.c). The host tests run the heap in a single thread.
+ */
+
+#ifndef FREERTOS_H
+#define FREERTOS_H
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define configSUPPORT_DYNAMIC_ALLOCATION 1
+#define configUSE_HEAP_TLSF              1
+#define configAPPLICATION_ALLOCATED_HEAP 0
+#define configUSE_MALLOC_FAILED_HOOK     0
+#define configASSERT(x)                  assert(x)
+
+/* source/FreeRTOSConfig.h */
+#ifndef configTOTAL_HEAP_SIZE
+#define configTOTAL_HEAP_SIZE ((size_t)(120 * 1024))
+#endif
+
+#define PRIVILEGED_DATA
+#define PRIVILEGED_FUNCTION
+
+#define traceMALLOC(pvAddress, uiSize)
+#define traceFREE(pvAddress, uiSize)
+
+#define pdFALSE       ((BaseType_t)0)
+#define pdTRUE        ((BaseType_t)1)
+#define portMAX_DELAY ((size_t)-1)
+
+typedef long BaseType_t;
+
+/* portable.h */
+typedef struct xHeapStats
+{
+    size_t xAvailableHeapSpaceInBytes;
+    size_t xSizeOfLargestFreeBlockInBytes;
+    size_t xSizeOfSmallestFreeBlockInBytes;
+    size_t xNumberOfFreeBlocks;
+    size_t xMinimumEverFreeBytesRemaining;
+    size_t xNumberOfSuccessfulAllocations;
+    size_t xNumberOfSuccessfulFrees;
+} HeapStats_t;
+
+void *pvPortMalloc(size_t xWantedSize);
+void vPortFree(void *pv);
+void vPortGetHeapStats(HeapStats_t *pxHeapStats);
+
+#endif /* FREERTOS_H */
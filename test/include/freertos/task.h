@@ -0,0 +1,24 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Host stand-in for the scheduler calls of the heap, the tests are single threaded */
+
+#ifndef INC_TASK_H
+#define INC_TASK_H
+
+#include "FreeRTOS.h"
+
+static inline void vTaskSuspendAll(void)
+{
+}
+
+static inline BaseType_t xTaskResumeAll(void)
+{
+    return pdFALSE;
+}
+
+#endif /* INC_TASK_H */
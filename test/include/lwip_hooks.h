@@ -0,0 +1,46 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * lwIP hooks of the host test builds (LWIP_HOOK_FILENAME).
+ */
+
+#ifndef LWIP_HOOKS_H
+#define LWIP_HOOKS_H
+
+#include "lwip/netif.h"
+
+/*
+ * The nodes of the link simulator (netsim.h) share one subnet, so the
+ * subnet match of ip4_route() would send everything on the netif added
+ * last. A packet to the address of one node leaves on the other one
+ * instead, which also routes pcbs not bound to a netif, like lwiperf's.
+ */
+static inline struct netif *lwip_hook_ip4_route_src(const ip4_addr_t *src, const ip4_addr_t *dest)
+{
+    struct netif *netif;
+    struct netif *other = NULL;
+    int local           = 0;
+
+    LWIP_UNUSED_ARG(src);
+
+    NETIF_FOREACH(netif)
+    {
+        if (ip4_addr_eq(netif_ip4_addr(netif), dest))
+        {
+            local = 1;
+        }
+        else if (netif_is_up(netif))
+        {
+            other = netif;
+        }
+    }
+
+    return local ? other : NULL;
+}
+
+#endif /* LWIP_HOOKS_H */
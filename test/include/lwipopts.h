@@ -0,0 +1,83 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * lwIP options of the host test builds. The stack runs without an OS
+ * (NO_SYS), the TCP settings follow source/lwipopts.h so results carry over
+ * to the board. Options a test varies are only set if it has not set them.
+ */
+
+#ifndef LWIPOPTS_H
+#define LWIPOPTS_H
+
+#define NO_SYS               1
+#define SYS_LIGHTWEIGHT_PROT 0
+#define LWIP_SOCKET          0
+#define LWIP_NETCONN         0
+
+#define MEM_ALIGNMENT 4
+#define MEM_SIZE      (256 * 1024)
+
+#define LWIP_IPV4 1
+#define LWIP_IPV6 0
+#define LWIP_ARP  0
+#define LWIP_RAW  0
+#define LWIP_UDP  1
+#define LWIP_TCP  1
+#define LWIP_DHCP 0
+#define LWIP_DNS  0
+#define LWIP_IGMP 0
+#define LWIP_ACD  0
+#define SO_REUSE  1
+
+/* Same TCP configuration as the board with CONFIG_NETWORK_HIGH_PERF */
+#define TCP_MSS     1460
+#define TCP_WND     (15 * TCP_MSS)
+#define TCP_SND_BUF (12 * TCP_MSS)
+#define TCP_SND_QUEUELEN ((4 * (TCP_SND_BUF) + (TCP_MSS - 1)) / (TCP_MSS))
+#define MEMP_NUM_TCP_SEG 64
+#define MEMP_NUM_TCP_PCB 8
+#define MEMP_NUM_PBUF    32
+#define PBUF_POOL_SIZE   64
+#define PBUF_POOL_BUFSIZE 1580
+/* Custom pbufs of the RX paths, the board gets them with IPv6 fragmentation */
+#define LWIP_SUPPORT_CUSTOM_PBUF 1
+
+/* TX frames in one pbuf with room for the Wi-Fi driver headers, as on the board */
+#ifndef LWIP_NETIF_TX_SINGLE_PBUF
+#define LWIP_NETIF_TX_SINGLE_PBUF 1
+#endif
+#ifndef PBUF_LINK_ENCAPSULATION_HLEN
+#define PBUF_LINK_ENCAPSULATION_HLEN 38
+#endif
+
+#ifndef LWIP_TCP_SACK_OUT
+#define LWIP_TCP_SACK_OUT 1
+#endif
+#ifndef LWIP_TCP_SACK_IN
+#define LWIP_TCP_SACK_IN 1
+#endif
+
+/* Random initial sequence numbers over the whole sequence space, the
+   built-in ones stay far below the wraparound */
+#define LWIP_HOOK_TCP_ISN(local_ip, local_port, remote_ip, remote_port) \
+    ((u32_t)LWIP_RAND() ^ ((u32_t)LWIP_RAND() << 16))
+
+#define LWIP_HOOK_FILENAME "lwip_hooks.h"
+/* Routing between the nodes of the link simulator, see lwip_hooks.h */
+#define LWIP_HOOK_IP4_ROUTE_SRC(src, dest) lwip_hook_ip4_route_src(src, dest)
+
+#ifndef LWIP_TIMERS_WHEEL
+#define LWIP_TIMERS_WHEEL 1
+#endif
+#define MEMP_NUM_SYS_TIMEOUT 1100
+
+#define LWIP_STATS         1
+#define MIB2_STATS         1
+#define LWIP_STATS_DISPLAY 0
+
+#endif /* LWIPOPTS_H */
@@ -0,0 +1,25 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Host stand-in for the Wi-Fi OSA header, with only what the FreeRTOS memory
+ * pools (wifi/port/osa/mem_pool.c) use.
+ */
+
+#ifndef OSA_H
+#define OSA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cmsis_compiler.h"
+
+#define CONFIG_MEM_POOLS 1
+
+typedef void *MemoryPool_t;
+
+#endif /* OSA_H */
@@ -0,0 +1,398 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Post/fetch benchmark of the ring mailbox (SYS_MBOX_RING, sys_mbox_ring.h).
+ *
+ * The ring of lwip/port/sys_arch/dynamic/sys_mbox_ring.h is driven the way
+ * sys_arch.c drives it, with host stand-ins for the kernel: a spinlock for
+ * the interrupt mask, a semaphore for the task notification of the consumer
+ * and one for the "space" semaphore of blocked producers. The same traffic
+ * goes through a locked queue that copies every message and signals a
+ * condition variable, standing in for the FreeRTOS queue.
+ *
+ * Every message carries its producer and sequence number, the consumer
+ * checks that nothing is lost, duplicated or reordered per producer. The
+ * benchmark reports the time per message, consumer wakeups per message and
+ * producer blocks on a full mailbox, and the post-to-fetch latency of single
+ * messages.
+ *
+ * Usage: mbox_bench [messages per producer]
+ */
+
+#include "lwip/arch.h"
+
+#define SYS_MBOX_RING_BARRIER() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#include "sys_mbox_ring.h"
+
+#include "bench.h"
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/* TCPIP_MBOX_SIZE of source/lwipopts.h */
+#define MBOX_SIZE     32
+/* SYS_MBOX_FETCH_BATCH of sys_arch.h */
+#define FETCH_BATCH   8
+#define MAX_PRODUCERS 4
+#define LATENCY_MSGS  20000
+
+struct mbox_ops
+{
+    const char *name;
+    void (*init)(void);
+    void (*post)(void *msg);
+    void *(*fetch)(void);
+};
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+/* Ring mailbox */
+static struct sys_mbox_cells *ring;
+static pthread_spinlock_t ring_mask;
+static volatile int ring_waiter;
+static sem_t ring_notify;
+static sem_t ring_space;
+static volatile u32_t ring_full_waiters;
+static u32_t ring_space_given;
+static void *ring_batch[FETCH_BATCH];
+static u32_t ring_batch_next;
+static u32_t ring_batch_len;
+
+/* Locked queue */
+static void *queue_items[MBOX_SIZE];
+static u32_t queue_head;
+static u32_t queue_count;
+static int queue_rx_waiting;
+static int queue_tx_waiting;
+static pthread_mutex_t queue_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queue_not_empty = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t queue_not_full = PTHREAD_COND_INITIALIZER;
+
+static unsigned long wakeups;
+static unsigned long full_blocks;
+static uint64_t latency_ns[LATENCY_MSGS];
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+static void ring_init(void)
+{
+    u32_t cells = sys_mbox_ring_cells(MBOX_SIZE);
+
+    free(ring);
+    ring = malloc(sizeof(*ring) + cells * sizeof(void *));
+    sys_mbox_ring_init(ring, cells);
+    pthread_spin_init(&ring_mask, PTHREAD_PROCESS_PRIVATE);
+    sem_init(&ring_notify, 0, 0);
+    sem_init(&ring_space, 0, 0);
+    ring_waiter       = 0;
+    ring_full_waiters = 0;
+    ring_space_given  = 0;
+    ring_batch_next   = 0;
+    ring_batch_len    = 0;
+}
+
+/* sys_mbox_post() */
+static void ring_post(void *msg)
+{
+    int pushed;
+
+    for (;;)
+    {
+        pthread_spin_lock(&ring_mask);
+        pushed = sys_mbox_ring_push(ring, msg);
+        if (!pushed)
+        {
+            ring_full_waiters++;
+        }
+        pthread_spin_unlock(&ring_mask);
+        if (pushed)
+        {
+            break;
+        }
+
+        __atomic_fetch_add(&full_blocks, 1, __ATOMIC_RELAXED);
+        sem_wait(&ring_space);
+        pthread_spin_lock(&ring_mask);
+        ring_full_waiters--;
+        ring_space_given--;
+        pthread_spin_unlock(&ring_mask);
+    }
+
+    /* sys_mbox_wake() */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (ring_waiter)
+    {
+        sem_post(&ring_notify);
+    }
+}
+
+/* sys_mbox_release_space() */
+static void ring_release_space(void)
+{
+    u32_t gives = 0;
+
+    pthread_spin_lock(&ring_mask);
+    if ((ring_full_waiters > ring_space_given) && sys_mbox_ring_drained(ring))
+    {
+        gives            = ring_full_waiters - ring_space_given;
+        ring_space_given = ring_full_waiters;
+    }
+    pthread_spin_unlock(&ring_mask);
+
+    while (gives-- > 0U)
+    {
+        sem_post(&ring_space);
+    }
+}
+
+/* sys_mbox_pop() */
+static int ring_pop(void **msg)
+{
+    if (ring_batch_next == ring_batch_len)
+    {
+        ring_batch_next = 0;
+        ring_batch_len  = sys_mbox_ring_pop_batch(ring, ring_batch, FETCH_BATCH);
+        if (ring_batch_len == 0U)
+        {
+            return 0;
+        }
+        ring_release_space();
+    }
+    *msg = ring_batch[ring_batch_next++];
+    return 1;
+}
+
+/* sys_arch_mbox_fetch() without timeout */
+static void *ring_fetch(void)
+{
+    void *msg;
+
+    if (ring_pop(&msg))
+    {
+        return msg;
+    }
+
+    ring_waiter = 1;
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    while (!ring_pop(&msg))
+    {
+        /* ulTaskNotifyTakeIndexed() with pdTRUE clears the count */
+        sem_wait(&ring_notify);
+        while (sem_trywait(&ring_notify) == 0)
+        {
+        }
+        wakeups++;
+    }
+    ring_waiter = 0;
+    return msg;
+}
+
+static void queue_init(void)
+{
+    queue_head       = 0;
+    queue_count      = 0;
+    queue_rx_waiting = 0;
+    queue_tx_waiting = 0;
+}
+
+static void queue_post(void *msg)
+{
+    pthread_mutex_lock(&queue_lock);
+    while (queue_count == MBOX_SIZE)
+    {
+        full_blocks++;
+        queue_tx_waiting++;
+        pthread_cond_wait(&queue_not_full, &queue_lock);
+        queue_tx_waiting--;
+    }
+    memcpy(&queue_items[(queue_head + queue_count) % MBOX_SIZE], &msg, sizeof(msg));
+    queue_count++;
+    if (queue_rx_waiting)
+    {
+        pthread_cond_signal(&queue_not_empty);
+    }
+    pthread_mutex_unlock(&queue_lock);
+}
+
+static void *queue_fetch(void)
+{
+    void *msg;
+
+    pthread_mutex_lock(&queue_lock);
+    while (queue_count == 0U)
+    {
+        queue_rx_waiting = 1;
+        pthread_cond_wait(&queue_not_empty, &queue_lock);
+        queue_rx_waiting = 0;
+        wakeups++;
+    }
+    memcpy(&msg, &queue_items[queue_head], sizeof(msg));
+    queue_head = (queue_head + 1U) % MBOX_SIZE;
+    queue_count--;
+    if (queue_tx_waiting)
+    {
+        pthread_cond_signal(&queue_not_full);
+    }
+    pthread_mutex_unlock(&queue_lock);
+    return msg;
+}
+
+static const struct mbox_ops mailboxes[] = {
+    {"ring", ring_init, ring_post, ring_fetch},
+    {"queue", queue_init, queue_post, queue_fetch},
+};
+
+struct producer
+{
+    const struct mbox_ops *ops;
+    uintptr_t id;
+    unsigned long count;
+    pthread_t thread;
+};
+
+/* Messages are id << 24 | sequence number, never NULL */
+static void *producer_main(void *arg)
+{
+    struct producer *producer = arg;
+    unsigned long i;
+
+    for (i = 1; i <= producer->count; i++)
+    {
+        producer->ops->post((void *)((producer->id << 24) | i));
+    }
+    return NULL;
+}
+
+static int throughput(const struct mbox_ops *ops, int producers, unsigned long count)
+{
+    struct producer threads[MAX_PRODUCERS];
+    unsigned long next[MAX_PRODUCERS];
+    unsigned long total = count * (unsigned long)producers;
+    unsigned long i;
+    uint64_t start;
+    uint64_t elapsed;
+    int p;
+
+    ops->init();
+    wakeups     = 0;
+    full_blocks = 0;
+
+    start = bench_ns();
+    for (p = 0; p < producers; p++)
+    {
+        threads[p].ops   = ops;
+        threads[p].id    = (uintptr_t)p;
+        threads[p].count = count;
+        next[p]          = 1;
+        pthread_create(&threads[p].thread, NULL, producer_main, &threads[p]);
+    }
+
+    for (i = 0; i < total; i++)
+    {
+        uintptr_t msg = (uintptr_t)ops->fetch();
+        uintptr_t id  = msg >> 24;
+
+        if ((id >= (uintptr_t)producers) || ((msg & 0xFFFFFFU) != next[id]))
+        {
+            printf("FAIL %s: message %lx out of order\n", ops->name, (unsigned long)msg);
+            return 1;
+        }
+        next[id]++;
+    }
+    elapsed = bench_ns() - start;
+
+    for (p = 0; p < producers; p++)
+    {
+        pthread_join(threads[p].thread, NULL);
+    }
+
+    printf("%-5s  %9d  %10.1f  %15.3f  %12.3f\n", ops->name, producers, (double)elapsed / (double)total,
+           (double)wakeups / (double)total, (double)full_blocks / (double)total);
+    return 0;
+}
+
+static void *latency_producer(void *arg)
+{
+    const struct mbox_ops *ops = arg;
+    int i;
+
+    for (i = 0; i < LATENCY_MSGS; i++)
+    {
+        /* One message at a time, the consumer is asleep when it arrives */
+        usleep(20);
+        ops->post((void *)(uintptr_t)bench_ns());
+    }
+    return NULL;
+}
+
+static int compare_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+static void latency(const struct mbox_ops *ops)
+{
+    pthread_t thread;
+    int i;
+
+    ops->init();
+    wakeups = 0;
+    pthread_create(&thread, NULL, latency_producer, (void *)ops);
+    for (i = 0; i < LATENCY_MSGS; i++)
+    {
+        uint64_t sent = (uint64_t)(uintptr_t)ops->fetch();
+        latency_ns[i] = bench_ns() - sent;
+    }
+    pthread_join(thread, NULL);
+
+    qsort(latency_ns, LATENCY_MSGS, sizeof(latency_ns[0]), compare_u64);
+    printf("%-5s  %8.1f  %8.1f  %8.1f  %15.3f\n", ops->name, latency_ns[LATENCY_MSGS / 2] / 1000.0,
+           latency_ns[LATENCY_MSGS * 99 / 100] / 1000.0, latency_ns[LATENCY_MSGS - 1] / 1000.0,
+           (double)wakeups / LATENCY_MSGS);
+}
+
+int main(int argc, char **argv)
+{
+    unsigned long count = (argc > 1) ? strtoul(argv[1], NULL, 0) : 200000UL;
+    size_t m;
+    int producers;
+
+    printf("mbox   producers  ns/message  wakeups/message  full/message\n");
+    for (producers = 1; producers <= MAX_PRODUCERS; producers *= 2)
+    {
+        for (m = 0; m < sizeof(mailboxes) / sizeof(mailboxes[0]); m++)
+        {
+            if (throughput(&mailboxes[m], producers, count) != 0)
+            {
+                return 1;
+            }
+        }
+    }
+
+    printf("mbox   p50 (us)  p99 (us)  max (us)  wakeups/message\n");
+    for (m = 0; m < sizeof(mailboxes) / sizeof(mailboxes[0]); m++)
+    {
+        latency(&mailboxes[m]);
+    }
+    return 0;
+}
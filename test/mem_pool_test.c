@@ -0,0 +1,358 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Concurrency test of the lock-free Wi-Fi memory pools (wifi/port/osa/mem_pool.c).
+ *
+ * mem_pool.c is built for __ARM_ARCH_7EM__, so its free list is the
+ * LDREX/STREX stack, with the exclusive monitor emulated in
+ * include/cmsis_compiler.h. First an interrupt is injected between the pop's
+ * exclusive load and store that pops two blocks and pushes the first back
+ * (the ABA case), and the pop has to retry instead of handing out the second
+ * block again. Then threads allocate and free random blocks of a small pool
+ * that runs empty, each block tagged with its owner to catch a block handed
+ * out twice, and the free list and the InUse, HighWater and Failures
+ * counters are checked once they are done.
+ *
+ * The pool keeps 32-bit pointers, so its memory is mapped below 4 GB.
+ *
+ * Usage: mem_pool_test [operations per thread]
+ */
+
+#include "mem_pool.h"
+
+#include "bench.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+#define POOL_ITEMS     64U
+#define POOL_DATA_SIZE 40
+#define POOL_ALIGNMENT 8
+#define THREADS        4U
+#define THREAD_HOLD    24U
+#define DEFAULT_OPS    200000UL
+
+struct block
+{
+    uint32_t owner; /* thread number + 1 while allocated, 0 while free */
+    uint32_t seq;
+    uint8_t fill[POOL_DATA_SIZE - 8];
+};
+
+struct worker
+{
+    pthread_t thread;
+    uint32_t id;
+    unsigned long ops;
+    unsigned long allocs;
+    unsigned long empty;
+    unsigned long errors;
+    unsigned int max_held;
+};
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+pthread_mutex_t cmsis_host_excl_lock = PTHREAD_MUTEX_INITIALIZER;
+uint32_t cmsis_host_excl_stores;
+uint32_t cmsis_host_excl_failures;
+unsigned int cmsis_host_excl_yield_shift;
+__thread uint32_t cmsis_host_excl_seen;
+__thread int cmsis_host_excl_open;
+__thread uint32_t cmsis_host_excl_loads;
+__thread void (*cmsis_host_excl_irq)(void);
+
+static MemPool_t pool_struct;
+static MemoryPool_t pool;
+static uint8_t *pool_mem;
+static size_t pool_mem_size;
+static void *irq_blocks[2];
+static unsigned long failures;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+#define CHECK(cond, ...)                     \
+    do                                       \
+    {                                        \
+        if (!(cond))                         \
+        {                                    \
+            printf("FAIL " __VA_ARGS__);     \
+            printf("\n");                    \
+            failures++;                      \
+        }                                    \
+    } while (0)
+
+static void pool_create(unsigned int items)
+{
+    size_t item_size = (POOL_DATA_SIZE / POOL_ALIGNMENT + 1) * POOL_ALIGNMENT;
+    int flags        = MAP_PRIVATE | MAP_ANONYMOUS;
+
+#ifdef MAP_32BIT
+    flags |= MAP_32BIT;
+#endif
+    if (pool_mem != NULL)
+    {
+        munmap(pool_mem, pool_mem_size);
+    }
+    pool_mem_size = item_size * items;
+    pool_mem      = mmap(NULL, pool_mem_size, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if ((pool_mem == MAP_FAILED) || ((uintptr_t)pool_mem + pool_mem_size > 0xFFFFFFFFUL))
+    {
+        printf("no memory below 4 GB for the pool\n");
+        exit(1);
+    }
+
+    pool = OSA_MemoryPoolCreate(&pool_struct, POOL_DATA_SIZE, pool_mem, (int)pool_mem_size, POOL_ALIGNMENT);
+    if ((pool == NULL) || (pool_struct.ItemCount != items) || ((size_t)pool_struct.ItemSize != item_size))
+    {
+        printf("pool of %u items not created\n", items);
+        exit(1);
+    }
+}
+
+static int pool_owns(void *ptr)
+{
+    uintptr_t offset = (uintptr_t)ptr - (uintptr_t)pool_mem;
+
+    return ((uintptr_t)ptr >= (uintptr_t)pool_mem) && (offset < pool_mem_size) &&
+           ((offset % (uintptr_t)pool_struct.ItemSize) == (uintptr_t)POOL_ALIGNMENT);
+}
+
+/* Blocks on the free list, or -1 if it is not a list of distinct pool blocks */
+static int pool_free_count(void)
+{
+    SlNode_t *node;
+    unsigned int count = 0;
+    uint8_t seen[POOL_ITEMS];
+
+    memset(seen, 0, sizeof(seen));
+    for (node = pool_struct.Head; node != NULL; node = node->Next)
+    {
+        size_t index = ((uint8_t *)node - pool_mem) / (size_t)pool_struct.ItemSize;
+
+        if (!pool_owns((uint8_t *)node + POOL_ALIGNMENT) || (index >= POOL_ITEMS) || seen[index])
+        {
+            return -1;
+        }
+        seen[index] = 1;
+        count++;
+    }
+    return (int)count;
+}
+
+/* Interrupt between the exclusive load and store of a pop */
+static void irq_pop_pop_push(void)
+{
+    irq_blocks[0] = OSA_MemoryPoolAllocate(pool);
+    irq_blocks[1] = OSA_MemoryPoolAllocate(pool);
+    OSA_MemoryPoolFree(pool, irq_blocks[0]);
+}
+
+static void test_aba(void)
+{
+    MemPoolStats_t stats;
+    void *first;
+    void *next;
+    uint32_t store_failures;
+
+    pool_create(3);
+
+    store_failures      = cmsis_host_excl_failures;
+    cmsis_host_excl_irq = irq_pop_pop_push;
+    first               = OSA_MemoryPoolAllocate(pool);
+    next                = OSA_MemoryPoolAllocate(pool);
+
+    CHECK(cmsis_host_excl_failures > store_failures, "aba: the interrupted pop was not retried");
+    CHECK(first == irq_blocks[0], "aba: the pop returned %p, not the block pushed back %p", first, irq_blocks[0]);
+    CHECK((next != irq_blocks[1]) && (next != NULL), "aba: block %p handed out twice", irq_blocks[1]);
+    CHECK(OSA_MemoryPoolAllocate(pool) == NULL, "aba: pool of 3 gave a 4th block");
+
+    OSA_MemoryPoolFree(pool, first);
+    OSA_MemoryPoolFree(pool, next);
+    OSA_MemoryPoolFree(pool, irq_blocks[1]);
+    OSA_MemoryPoolGetStats(pool, &stats);
+    CHECK(pool_free_count() == 3, "aba: free list broken");
+    CHECK(stats.InUse == 0U, "aba: %u blocks in use after freeing all", (unsigned int)stats.InUse);
+    CHECK(stats.HighWater == 3U, "aba: high water %u, not 3", (unsigned int)stats.HighWater);
+    CHECK(stats.Failures == 1U, "aba: %u failures, not 1", (unsigned int)stats.Failures);
+
+    printf("aba: interrupted pop retried, %u store-exclusives failed\n",
+           (unsigned int)(cmsis_host_excl_failures - store_failures));
+}
+
+static void block_fill(struct block *block, uint32_t owner, uint32_t seq)
+{
+    block->seq = seq;
+    memset(block->fill, (int)(owner * 31U + seq), sizeof(block->fill));
+}
+
+static int block_check(const struct block *block, uint32_t owner)
+{
+    size_t i;
+    uint8_t value = (uint8_t)(owner * 31U + block->seq);
+
+    for (i = 0; i < sizeof(block->fill); i++)
+    {
+        if (block->fill[i] != value)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void *worker_run(void *arg)
+{
+    struct worker *w = arg;
+    struct block *held[THREAD_HOLD];
+    unsigned int count = 0;
+    unsigned int seed  = w->id * 7919U + 1U;
+    uint32_t owner     = w->id + 1U;
+    unsigned long op;
+
+    for (op = 0; op < w->ops; op++)
+    {
+        unsigned int r = (unsigned int)rand_r(&seed);
+
+        if ((count < THREAD_HOLD) && ((count == 0U) || ((r & 1U) != 0U)))
+        {
+            struct block *block = OSA_MemoryPoolAllocate(pool);
+            uint32_t expected   = 0;
+
+            if (block == NULL)
+            {
+                w->empty++;
+                continue;
+            }
+            w->allocs++;
+            if (!pool_owns(block) ||
+                !__atomic_compare_exchange_n(&block->owner, &expected, owner, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+            {
+                w->errors++;
+                continue;
+            }
+            block_fill(block, owner, (uint32_t)op);
+            held[count++] = block;
+            if (count > w->max_held)
+            {
+                w->max_held = count;
+            }
+        }
+        else
+        {
+            unsigned int index  = (r >> 1) % count;
+            struct block *block = held[index];
+
+            held[index] = held[--count];
+            if ((__atomic_load_n(&block->owner, __ATOMIC_SEQ_CST) != owner) || !block_check(block, owner))
+            {
+                w->errors++;
+            }
+            __atomic_store_n(&block->owner, 0U, __ATOMIC_SEQ_CST);
+            OSA_MemoryPoolFree(pool, block);
+        }
+    }
+
+    while (count > 0U)
+    {
+        struct block *block = held[--count];
+
+        __atomic_store_n(&block->owner, 0U, __ATOMIC_SEQ_CST);
+        OSA_MemoryPoolFree(pool, block);
+    }
+    return NULL;
+}
+
+static void test_stress(unsigned long ops)
+{
+    struct worker workers[THREADS];
+    MemPoolStats_t stats;
+    unsigned long allocs = 0;
+    unsigned long empty  = 0;
+    unsigned long errors = 0;
+    unsigned int max_held = 0;
+    uint32_t stores;
+    uint32_t store_failures;
+    uint64_t start;
+    uint64_t ns;
+    uint32_t i;
+
+    pool_create(POOL_ITEMS);
+
+    stores                      = cmsis_host_excl_stores;
+    store_failures              = cmsis_host_excl_failures;
+    cmsis_host_excl_yield_shift = 2;
+    start                       = bench_ns();
+    for (i = 0; i < THREADS; i++)
+    {
+        memset(&workers[i], 0, sizeof(workers[i]));
+        workers[i].id  = i;
+        workers[i].ops = ops;
+        if (pthread_create(&workers[i].thread, NULL, worker_run, &workers[i]) != 0)
+        {
+            printf("thread not started\n");
+            exit(1);
+        }
+    }
+    for (i = 0; i < THREADS; i++)
+    {
+        pthread_join(workers[i].thread, NULL);
+        allocs += workers[i].allocs;
+        empty += workers[i].empty;
+        errors += workers[i].errors;
+        if (workers[i].max_held > max_held)
+        {
+            max_held = workers[i].max_held;
+        }
+    }
+    ns                          = bench_ns() - start;
+    cmsis_host_excl_yield_shift = 0;
+
+    OSA_MemoryPoolGetStats(pool, &stats);
+    CHECK(errors == 0U, "stress: %lu blocks handed out twice, outside the pool or overwritten", errors);
+    CHECK(pool_free_count() == (int)POOL_ITEMS, "stress: free list has %d of %u blocks", pool_free_count(),
+          POOL_ITEMS);
+    CHECK(stats.InUse == 0U, "stress: %u blocks in use after freeing all", (unsigned int)stats.InUse);
+    CHECK((stats.HighWater >= max_held) && (stats.HighWater <= POOL_ITEMS), "stress: high water %u",
+          (unsigned int)stats.HighWater);
+    CHECK(stats.Failures == empty, "stress: %u failures counted, %lu seen", (unsigned int)stats.Failures, empty);
+    CHECK(empty > 0U, "stress: the pool never ran empty");
+    CHECK(cmsis_host_excl_failures > store_failures, "stress: no store-exclusive ever failed");
+
+    printf("stress: %u threads x %lu operations on %u blocks, %lu allocations, %lu found the pool empty\n", THREADS,
+           ops, POOL_ITEMS, allocs, empty);
+    printf("        high water %u, store-exclusives %u ok %u failed, %.0f ns per operation\n",
+           (unsigned int)stats.HighWater, (unsigned int)(cmsis_host_excl_stores - stores),
+           (unsigned int)(cmsis_host_excl_failures - store_failures), (double)ns / (double)(ops * THREADS));
+}
+
+int main(int argc, char **argv)
+{
+    unsigned long ops = (argc > 1) ? strtoul(argv[1], NULL, 0) : DEFAULT_OPS;
+
+    test_aba();
+    test_stress(ops);
+
+    if (failures != 0U)
+    {
+        printf("%lu checks failed\n", failures);
+        return 1;
+    }
+    printf("mem_pool_test passed\n");
+    return 0;
+}
@@ -0,0 +1,552 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * MQTT client of the application (source/Drivers/mqtt.c) over the two-node
+ * simulator (netsim.h).
+ *
+ * The client runs on node A with the options of the board (256 byte output
+ * ring, 4 requests in flight). Node B runs a minimal broker on the raw TCP
+ * API: it accepts the connection, grants subscriptions, acknowledges QoS 1
+ * publishes and sends every publish to a subscribed topic back at QoS 0.
+ * The client subscribes to its own topic and publishes QoS 1 messages as
+ * fast as the requests in flight allow, like the sensor publishes of
+ * source/MQTT.c. Then it stays idle for several keep alive periods.
+ *
+ * Every message has to come back once, in order and unchanged, no request
+ * may time out and the idle connection has to survive on PINGREQs. The
+ * simulation reports the messages per second, the publish to PUBACK and
+ * publish to echo latency and the host time the client and broker spend
+ * per message.
+ *
+ * Usage: mqtt_sim [messages]
+ */
+
+#include "bench.h"
+#include "netsim.h"
+
+#include "mqtt.h"
+#include "lwip/priv/tcp_priv.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+#define BROKER_PORT      1883
+#define TOPIC            "sim/echo"
+#define PAYLOAD_LEN      96U
+#define KEEP_ALIVE_S     20U
+#define IDLE_PERIODS     4U
+#define MAX_MESSAGES     5000U
+#define BROKER_BUF_SIZE  1024U
+/* A run that takes longer failed */
+#define RUN_LIMIT_US     (600ULL * 1000000ULL)
+
+struct sim_profile
+{
+    const char *name;
+    struct netsim_profile link;
+};
+
+struct broker
+{
+    struct tcp_pcb *listener;
+    struct tcp_pcb *pcb;
+    uint8_t buf[BROKER_BUF_SIZE];
+    uint32_t len;
+    int subscribed;
+    int closed;
+    uint32_t pingreqs;
+    uint32_t publishes;
+    int failed;
+};
+
+struct client
+{
+    mqtt_client_t *mqtt;
+    int connected;
+    uint32_t messages;
+    uint32_t sent;
+    uint32_t acked;
+    uint32_t echoed;
+    uint32_t timeouts;
+    uint32_t max_in_flight;
+    uint8_t in[PAYLOAD_LEN];
+    uint32_t in_len;
+    uint64_t *sent_us;
+    uint32_t *ack_us;
+    uint32_t *echo_us;
+    int failed;
+};
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+/* 20 Mbit/s, 3 ms one way plus up to 2 ms jitter, 64 KB queue */
+#define WIFI_LINK(loss) \
+    {.rate_kbps = 20000, .delay_us = 3000, .jitter_us = 2000, .loss_ppm = (loss), .queue_bytes = 65536}
+
+static const struct sim_profile profiles[] = {
+    {"clean", WIFI_LINK(0)},
+    {"loss 1%", WIFI_LINK(10000)},
+    {"loss 5%", WIFI_LINK(50000)},
+};
+
+static struct broker broker;
+static struct client client;
+static uint64_t host_cycles;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+/* Broker on node B */
+
+static void broker_send(const uint8_t *data, uint16_t len)
+{
+    if (tcp_write(broker.pcb, data, len, TCP_WRITE_FLAG_COPY) != ERR_OK)
+    {
+        printf("FAIL broker: no room to send %u bytes\n", (unsigned int)len);
+        broker.failed = 1;
+    }
+}
+
+/* Handles one packet of the client, returns 0 if it is malformed */
+static int broker_packet(const uint8_t *packet, uint32_t header_len, uint32_t len)
+{
+    const uint8_t *body = packet + header_len;
+    uint32_t body_len   = len - header_len;
+    uint32_t topic_len;
+    uint8_t reply[4];
+
+    switch (packet[0] >> 4)
+    {
+        case 1: /* CONNECT */
+            reply[0] = 0x20;
+            reply[1] = 2;
+            reply[2] = 0;
+            reply[3] = 0;
+            broker_send(reply, 4);
+            break;
+
+        case 8: /* SUBSCRIBE, one topic */
+            if ((body_len < 5U) || (body_len != 5U + ((uint32_t)body[2] << 8 | body[3])))
+            {
+                return 0;
+            }
+            broker.subscribed = (body_len - 5U == strlen(TOPIC)) && (memcmp(&body[4], TOPIC, body_len - 5U) == 0);
+            reply[0]          = 0x90;
+            reply[1]          = 3;
+            (void)memcpy(&reply[2], body, 2);
+            broker_send(reply, 4);
+            reply[0] = (uint8_t)(body[body_len - 1U] & 1U);
+            broker_send(reply, 1);
+            break;
+
+        case 3: /* PUBLISH */
+            if (body_len < 2U)
+            {
+                return 0;
+            }
+            topic_len = (uint32_t)body[0] << 8 | body[1];
+            if (((packet[0] >> 1) & 3U) != 1U)
+            {
+                printf("FAIL broker: publish with QoS %u\n", (unsigned int)((packet[0] >> 1) & 3U));
+                return 0;
+            }
+            if (body_len < 4U + topic_len)
+            {
+                return 0;
+            }
+            broker.publishes++;
+            reply[0] = 0x40;
+            reply[1] = 2;
+            (void)memcpy(&reply[2], &body[2 + topic_len], 2);
+            broker_send(reply, 4);
+            if (broker.subscribed && (topic_len == strlen(TOPIC)) && (memcmp(&body[2], TOPIC, topic_len) == 0))
+            {
+                /* back at QoS 0: the packet identifier is left out */
+                uint32_t out_len = body_len - 2U;
+
+                reply[0] = 0x30;
+                if (out_len < 128U)
+                {
+                    reply[1] = (uint8_t)out_len;
+                    broker_send(reply, 2);
+                }
+                else
+                {
+                    reply[1] = (uint8_t)(out_len | 0x80U);
+                    reply[2] = (uint8_t)(out_len >> 7);
+                    broker_send(reply, 3);
+                }
+                broker_send(&body[0], (uint16_t)(2U + topic_len));
+                broker_send(&body[4 + topic_len], (uint16_t)(body_len - 4U - topic_len));
+            }
+            break;
+
+        case 12: /* PINGREQ */
+            broker.pingreqs++;
+            reply[0] = 0xD0;
+            reply[1] = 0;
+            broker_send(reply, 2);
+            break;
+
+        case 14: /* DISCONNECT */
+            broker.closed = 1;
+            break;
+
+        default:
+            printf("FAIL broker: packet type %u\n", (unsigned int)(packet[0] >> 4));
+            return 0;
+    }
+    return 1;
+}
+
+static err_t broker_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err)
+{
+    uint64_t start = bench_cycles();
+    uint32_t used  = 0;
+
+    if (p == NULL)
+    {
+        (void)tcp_close(pcb);
+        broker.pcb    = NULL;
+        broker.closed = 1;
+        return ERR_OK;
+    }
+    if (broker.len + p->tot_len > sizeof(broker.buf))
+    {
+        printf("FAIL broker: %u bytes of incomplete packets\n", (unsigned int)(broker.len + p->tot_len));
+        broker.failed = 1;
+        pbuf_free(p);
+        return ERR_OK;
+    }
+    (void)pbuf_copy_partial(p, &broker.buf[broker.len], p->tot_len, 0);
+    broker.len += p->tot_len;
+    tcp_recved(pcb, p->tot_len);
+    pbuf_free(p);
+
+    /* fixed header: type, remaining length in up to 4 bytes of 7 bits */
+    while (broker.len - used >= 2U)
+    {
+        uint32_t remaining = 0;
+        uint32_t header    = 1;
+
+        do
+        {
+            remaining |= (uint32_t)(broker.buf[used + header] & 0x7FU) << (7U * (header - 1U));
+        } while (((broker.buf[used + header++] & 0x80U) != 0U) && (header < 5U) && (used + header < broker.len));
+        if (used + header + remaining > broker.len)
+        {
+            break;
+        }
+        if (!broker_packet(&broker.buf[used], header, header + remaining))
+        {
+            printf("FAIL broker: malformed packet type %u\n", (unsigned int)(broker.buf[used] >> 4));
+            broker.failed = 1;
+        }
+        used += header + remaining;
+    }
+    (void)memmove(broker.buf, &broker.buf[used], broker.len - used);
+    broker.len -= used;
+    (void)tcp_output(pcb);
+    host_cycles += bench_cycles() - start;
+    return ERR_OK;
+}
+
+static err_t broker_accept(void *arg, struct tcp_pcb *pcb, err_t err)
+{
+    if ((err != ERR_OK) || (broker.pcb != NULL))
+    {
+        return ERR_VAL;
+    }
+    broker.pcb = pcb;
+    tcp_nagle_disable(pcb);
+    tcp_recv(pcb, broker_recv);
+    return ERR_OK;
+}
+
+static void broker_start(void)
+{
+    struct netif *netif = &netsim_netif[NETSIM_B];
+
+    (void)memset(&broker, 0, sizeof(broker));
+    broker.listener = tcp_new();
+    tcp_bind_netif(broker.listener, netif);
+    (void)tcp_bind(broker.listener, netif_ip_addr4(netif), BROKER_PORT);
+    broker.listener = tcp_listen(broker.listener);
+    tcp_accept(broker.listener, broker_accept);
+}
+
+static void broker_stop(void)
+{
+    if (broker.pcb != NULL)
+    {
+        tcp_abort(broker.pcb);
+    }
+    (void)tcp_close(broker.listener);
+}
+
+/* Client on node A */
+
+static void client_publish(void);
+
+static void client_published(void *arg, err_t err)
+{
+    uint32_t seq = (uint32_t)(uintptr_t)arg;
+
+    if (err != ERR_OK)
+    {
+        client.timeouts++;
+        return;
+    }
+    client.ack_us[client.acked++] = (uint32_t)(netsim_time_us() - client.sent_us[seq]);
+    client_publish();
+}
+
+/* Publishes until the requests in flight or the output ring are full */
+static void client_publish(void)
+{
+    uint64_t start = bench_cycles();
+    uint8_t payload[PAYLOAD_LEN];
+    uint32_t i;
+
+    while (client.sent < client.messages)
+    {
+        for (i = 0; i < PAYLOAD_LEN; i++)
+        {
+            payload[i] = (uint8_t)(client.sent * 7U + i);
+        }
+        (void)memcpy(payload, &client.sent, sizeof(client.sent));
+        client.sent_us[client.sent] = netsim_time_us();
+        if (mqtt_publish(client.mqtt, TOPIC, payload, PAYLOAD_LEN, 1, 0, client_published,
+                         (void *)(uintptr_t)client.sent) != ERR_OK)
+        {
+            break;
+        }
+        client.sent++;
+        if (client.sent - client.acked > client.max_in_flight)
+        {
+            client.max_in_flight = client.sent - client.acked;
+        }
+    }
+    host_cycles += bench_cycles() - start;
+}
+
+static void client_incoming_publish(void *arg, const char *topic, u32_t tot_len)
+{
+    if ((strcmp(topic, TOPIC) != 0) || (tot_len != PAYLOAD_LEN))
+    {
+        printf("FAIL client: %u bytes on %s\n", (unsigned int)tot_len, topic);
+        client.failed = 1;
+    }
+    client.in_len = 0;
+}
+
+static void client_incoming_data(void *arg, const u8_t *data, u16_t len, u8_t flags)
+{
+    uint32_t seq;
+    uint32_t i;
+
+    if (client.in_len + len > sizeof(client.in))
+    {
+        client.failed = 1;
+        return;
+    }
+    (void)memcpy(&client.in[client.in_len], data, len);
+    client.in_len += len;
+    if ((flags & MQTT_DATA_FLAG_LAST) == 0U)
+    {
+        return;
+    }
+
+    (void)memcpy(&seq, client.in, sizeof(seq));
+    if ((seq != client.echoed) || (client.in_len != PAYLOAD_LEN))
+    {
+        printf("FAIL client: message %u came back as message %u\n", (unsigned int)client.echoed,
+               (unsigned int)seq);
+        client.failed = 1;
+        return;
+    }
+    for (i = sizeof(seq); i < PAYLOAD_LEN; i++)
+    {
+        if (client.in[i] != (uint8_t)(seq * 7U + i))
+        {
+            printf("FAIL client: message %u changed at byte %u\n", (unsigned int)seq, (unsigned int)i);
+            client.failed = 1;
+            return;
+        }
+    }
+    client.echo_us[client.echoed++] = (uint32_t)(netsim_time_us() - client.sent_us[seq]);
+}
+
+static void client_subscribed(void *arg, err_t err)
+{
+    if (err != ERR_OK)
+    {
+        printf("FAIL client: subscribe %d\n", (int)err);
+        client.failed = 1;
+        return;
+    }
+    client_publish();
+}
+
+static void client_connection(mqtt_client_t *mqtt, void *arg, mqtt_connection_status_t status)
+{
+    client.connected = (status == MQTT_CONNECT_ACCEPTED);
+    if (!client.connected)
+    {
+        printf("FAIL client: connection status %d\n", (int)status);
+        client.failed = 1;
+        return;
+    }
+    mqtt_set_inpub_callback(mqtt, client_incoming_publish, client_incoming_data, NULL);
+    if (mqtt_subscribe(mqtt, TOPIC, 1, client_subscribed, NULL) != ERR_OK)
+    {
+        printf("FAIL client: subscribe not sent\n");
+        client.failed = 1;
+    }
+}
+
+static int client_echoed(void *arg)
+{
+    return client.failed || broker.failed || (client.timeouts != 0U) ||
+           ((client.echoed == client.messages) && (client.acked == client.messages));
+}
+
+static int client_failed(void *arg)
+{
+    return client.failed || broker.failed || !client.connected;
+}
+
+static int compare_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+static double quantile_ms(uint32_t *samples, uint32_t count, double quantile)
+{
+    return samples[(uint32_t)(quantile * (count - 1U))] / 1000.0;
+}
+
+/* Runs one profile, returns 0 if it failed */
+static int mqtt_run(const struct sim_profile *profile, uint32_t messages)
+{
+    struct mqtt_connect_client_info_t info = {0};
+    uint64_t start_us;
+    uint64_t time_us;
+    uint32_t pingreqs;
+
+    netsim_reset(1);
+    netsim_set_profile(NETSIM_A, &profile->link);
+    netsim_set_profile(NETSIM_B, &profile->link);
+    broker_start();
+
+    (void)memset(client.sent_us, 0, messages * sizeof(client.sent_us[0]));
+    client.mqtt          = mqtt_client_new();
+    client.connected     = 0;
+    client.messages      = messages;
+    client.sent          = 0;
+    client.acked         = 0;
+    client.echoed        = 0;
+    client.timeouts      = 0;
+    client.max_in_flight = 0;
+    client.failed        = 0;
+    host_cycles          = 0;
+    info.client_id       = "mqtt_sim";
+    info.keep_alive      = KEEP_ALIVE_S;
+    if ((client.mqtt == NULL) || (mqtt_client_connect(client.mqtt, netif_ip_addr4(&netsim_netif[NETSIM_B]),
+                                                      BROKER_PORT, client_connection, NULL, &info) != ERR_OK))
+    {
+        printf("FAIL %s: client not started\n", profile->name);
+        return 0;
+    }
+
+    start_us = netsim_time_us();
+    if (!netsim_run(start_us + RUN_LIMIT_US, client_echoed, NULL) || client.failed || broker.failed ||
+        (client.timeouts != 0U))
+    {
+        printf("FAIL %s: %u of %u messages acknowledged, %u came back, %u requests timed out\n", profile->name,
+               (unsigned int)client.acked, (unsigned int)messages, (unsigned int)client.echoed,
+               (unsigned int)client.timeouts);
+        return 0;
+    }
+    time_us = netsim_time_us() - start_us;
+
+    /* idle, the client has to keep the connection with PINGREQs */
+    pingreqs = broker.pingreqs;
+    if (netsim_run(netsim_time_us() + IDLE_PERIODS * KEEP_ALIVE_S * 1000000ULL, client_failed, NULL) ||
+        (broker.pingreqs - pingreqs < IDLE_PERIODS - 1U) || !mqtt_client_is_connected(client.mqtt))
+    {
+        printf("FAIL %s: connection lost while idle, %u PINGREQs\n", profile->name,
+               (unsigned int)(broker.pingreqs - pingreqs));
+        return 0;
+    }
+    pingreqs = broker.pingreqs - pingreqs;
+
+    mqtt_disconnect(client.mqtt);
+    (void)netsim_run(netsim_time_us() + 1000000U, NULL, NULL);
+    if (!broker.closed)
+    {
+        printf("FAIL %s: connection not closed\n", profile->name);
+        return 0;
+    }
+    mqtt_client_free(client.mqtt);
+    broker_stop();
+    /* Lets the connection leave TIME_WAIT, the next run starts from the same seed and port */
+    (void)netsim_run(netsim_time_us() + 2ULL * TCP_MSL * 1000U + 1000000U, NULL, NULL);
+
+    qsort(client.ack_us, messages, sizeof(client.ack_us[0]), compare_u32);
+    qsort(client.echo_us, messages, sizeof(client.echo_us[0]), compare_u32);
+    printf("%-8s %7.0f %6u  %6.1f %6.1f %6.1f  %6.1f %6.1f %6.1f  %7.0f %5u\n", profile->name,
+           messages * 1e6 / (double)time_us, (unsigned int)client.max_in_flight, quantile_ms(client.ack_us, messages, 0.5),
+           quantile_ms(client.ack_us, messages, 0.99), quantile_ms(client.ack_us, messages, 1.0),
+           quantile_ms(client.echo_us, messages, 0.5), quantile_ms(client.echo_us, messages, 0.99),
+           quantile_ms(client.echo_us, messages, 1.0), (double)host_cycles / messages, (unsigned int)pingreqs);
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    int messages = (argc > 1) ? atoi(argv[1]) : 2000;
+    size_t i;
+
+    if ((messages < 1) || (messages > (int)MAX_MESSAGES))
+    {
+        printf("messages: 1 to %u\n", MAX_MESSAGES);
+        return 1;
+    }
+
+    client.sent_us = calloc((size_t)messages, sizeof(client.sent_us[0]));
+    client.ack_us  = calloc((size_t)messages, sizeof(client.ack_us[0]));
+    client.echo_us = calloc((size_t)messages, sizeof(client.echo_us[0]));
+    netsim_init();
+
+    printf("%d QoS 1 publishes of %u bytes from A to the broker on B and back, at most %d in flight and %d bytes "
+           "queued, keep alive %u s\n",
+           messages, PAYLOAD_LEN, MQTT_REQ_MAX_IN_FLIGHT, MQTT_OUTPUT_RINGBUF_SIZE, KEEP_ALIVE_S);
+    printf("profile    msg/s flight  PUBACK p50   p99    max    echo p50  p99    max  %s/msg  pings\n", BENCH_UNIT);
+
+    for (i = 0; i < sizeof(profiles) / sizeof(profiles[0]); i++)
+    {
+        if (!mqtt_run(&profiles[i], (uint32_t)messages))
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,709 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Two-node network simulator, see netsim.h.
+ *
+ * Every frame is copied out of the sending stack into its own buffer, so
+ * the sender may free its pbufs right away as with a real driver, and
+ * copied into a PBUF_POOL pbuf of the receiver when it is delivered, or
+ * wrapped in place (struct netsim_rx_mode). The frames in flight of a link
+ * are kept sorted by their delivery time.
+ */
+
+#include "netsim.h"
+
+#include "bench.h"
+
+#include "lwip/init.h"
+#include "lwip/ip4.h"
+#include "lwip/pbuf.h"
+#include "lwip/priv/tcp_priv.h"
+#include "lwip/prot/ethernet.h"
+#include "lwip/prot/ip.h"
+#include "lwip/prot/ip4.h"
+#include "lwip/prot/tcp.h"
+#include "lwip/timeouts.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/* Headroom in front of the IP header of a frame sent in place */
+#define NETSIM_TX_HEADROOM (SIZEOF_ETH_HDR + NETSIM_TX_DRIVER_HLEN)
+
+/* Data segments a link tracks for RTT samples at the same time */
+#define NETSIM_RTT_PENDING 256U
+
+struct netsim_frame
+{
+    struct netsim_frame *next;
+    /* The link starts sending the frame, it waits in the driver TX queue until then */
+    uint64_t start_us;
+    uint64_t due_us;
+    uint16_t len;
+    uint8_t data[];
+};
+
+/* Data segment waiting for its ACK */
+struct netsim_pending
+{
+    uint32_t seq_end;
+    uint64_t sent_us;
+    /* Sent again, no RTT sample is taken (Karn) */
+    int retransmitted;
+};
+
+struct netsim_samples
+{
+    uint32_t *values;
+    uint32_t count;
+    uint32_t size;
+};
+
+struct netsim_link
+{
+    struct netsim_profile profile;
+    struct netsim_link_stats stats;
+    uint32_t rand;
+    /* Frames in flight, earliest delivery first */
+    struct netsim_frame *frames;
+    /* The link finishes serializing the previous frame */
+    uint64_t free_us;
+    /* Latest delivery time of a frame that was not held back, keeps the order under jitter */
+    uint64_t last_due_us;
+    /* Data segments sent through the link */
+    struct netsim_pending pending[NETSIM_RTT_PENDING];
+    uint32_t pending_head;
+    uint32_t pending_count;
+    uint32_t seq_high;
+    int seq_valid;
+    struct netsim_samples rtt;
+    /* How late the frames were handed to the receiving stack */
+    struct netsim_samples late;
+    /* The driver TX queue refused a frame, the space callback is due */
+    int tx_waiting;
+    void (*space_fn)(void);
+};
+
+/* Frame held by the receiving stack in place */
+struct netsim_rx_ref
+{
+    struct pbuf_custom pc;
+    struct netsim_frame *frame;
+    struct netsim_rx *rx;
+    struct netsim_rx_ref *next_free;
+};
+
+struct netsim_rx
+{
+    struct netsim_rx_mode mode;
+    struct netsim_rx_ref refs[NETSIM_RX_REF_MAX];
+    struct netsim_rx_ref *free_refs;
+    uint32_t held;
+};
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+struct netif netsim_netif[NETSIM_NODES];
+
+static struct netsim_link links[NETSIM_NODES];
+static struct netsim_rx rx_nodes[NETSIM_NODES];
+static uint64_t now_us;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+u32_t sys_now(void)
+{
+    return (u32_t)(now_us / 1000U);
+}
+
+uint64_t netsim_time_us(void)
+{
+    return now_us;
+}
+
+/* xorshift32, one generator per link */
+static uint32_t netsim_rand(struct netsim_link *link)
+{
+    uint32_t x = link->rand;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    link->rand = x;
+    return x;
+}
+
+static int netsim_chance(struct netsim_link *link, uint32_t ppm)
+{
+    return (ppm != 0U) && ((netsim_rand(link) % 1000000U) < ppm);
+}
+
+static void netsim_sample(struct netsim_samples *samples, uint32_t value)
+{
+    if (samples->count == samples->size)
+    {
+        samples->size   = (samples->size != 0U) ? (2U * samples->size) : 1024U;
+        samples->values = realloc(samples->values, samples->size * sizeof(samples->values[0]));
+    }
+    samples->values[samples->count++] = value;
+}
+
+/* Returns the TCP header of an IPv4 frame, or NULL */
+static const struct tcp_hdr *netsim_tcp(const struct netsim_frame *frame, uint32_t *payload)
+{
+    const struct ip_hdr *iphdr = (const struct ip_hdr *)frame->data;
+    const struct tcp_hdr *tcphdr;
+    uint32_t iphlen;
+    uint32_t tcphlen;
+
+    if ((frame->len < IP_HLEN) || (IPH_V(iphdr) != 4U) || (IPH_PROTO(iphdr) != IP_PROTO_TCP))
+    {
+        return NULL;
+    }
+
+    iphlen = IPH_HL_BYTES(iphdr);
+    if (frame->len < iphlen + TCP_HLEN)
+    {
+        return NULL;
+    }
+
+    tcphdr  = (const struct tcp_hdr *)(frame->data + iphlen);
+    tcphlen = TCPH_HDRLEN_BYTES(tcphdr);
+    if (lwip_ntohs(IPH_LEN(iphdr)) < iphlen + tcphlen)
+    {
+        return NULL;
+    }
+    *payload = lwip_ntohs(IPH_LEN(iphdr)) - iphlen - tcphlen;
+
+    return tcphdr;
+}
+
+/* Tracks a segment sent into the link */
+static void netsim_track_data(struct netsim_link *link, const struct netsim_frame *frame)
+{
+    const struct tcp_hdr *tcphdr;
+    uint32_t payload;
+    uint32_t seq_end;
+    uint32_t i;
+
+    tcphdr = netsim_tcp(frame, &payload);
+    if (tcphdr == NULL)
+    {
+        return;
+    }
+
+    if ((TCPH_FLAGS(tcphdr) & (TCP_SYN | TCP_FIN)) != 0U)
+    {
+        payload++;
+    }
+    if (payload == 0U)
+    {
+        return;
+    }
+
+    link->stats.data_segments++;
+    seq_end = lwip_ntohl(tcphdr->seqno) + payload;
+
+    if (link->seq_valid && TCP_SEQ_LEQ(seq_end, link->seq_high))
+    {
+        link->stats.retransmitted++;
+        for (i = 0; i < link->pending_count; i++)
+        {
+            struct netsim_pending *pending = &link->pending[(link->pending_head + i) % NETSIM_RTT_PENDING];
+
+            if (TCP_SEQ_GEQ(pending->seq_end, seq_end))
+            {
+                pending->retransmitted = 1;
+                break;
+            }
+        }
+        return;
+    }
+
+    link->seq_high  = seq_end;
+    link->seq_valid = 1;
+
+    if (link->pending_count == NETSIM_RTT_PENDING)
+    {
+        /* Drop the oldest, its sample is lost */
+        link->pending_head = (link->pending_head + 1U) % NETSIM_RTT_PENDING;
+        link->pending_count--;
+    }
+    link->pending[(link->pending_head + link->pending_count) % NETSIM_RTT_PENDING] =
+        (struct netsim_pending){seq_end, now_us, 0};
+    link->pending_count++;
+}
+
+/* Takes the RTT samples of the data an ACK delivered back to the sender covers */
+static void netsim_track_ack(struct netsim_link *link, const struct netsim_frame *frame)
+{
+    const struct tcp_hdr *tcphdr;
+    uint32_t payload;
+    uint32_t ackno;
+
+    tcphdr = netsim_tcp(frame, &payload);
+    if ((tcphdr == NULL) || ((TCPH_FLAGS(tcphdr) & TCP_ACK) == 0U))
+    {
+        return;
+    }
+
+    ackno = lwip_ntohl(tcphdr->ackno);
+    while (link->pending_count > 0U)
+    {
+        struct netsim_pending *pending = &link->pending[link->pending_head];
+
+        if (TCP_SEQ_GT(pending->seq_end, ackno))
+        {
+            break;
+        }
+
+        if (!pending->retransmitted)
+        {
+            netsim_sample(&link->rtt, (uint32_t)(now_us - pending->sent_us));
+        }
+        link->pending_head = (link->pending_head + 1U) % NETSIM_RTT_PENDING;
+        link->pending_count--;
+    }
+}
+
+/* Moves a start of sending out of the pause of the peer it falls into */
+static uint64_t netsim_after_pause(const struct netsim_profile *profile, uint64_t start_us)
+{
+    uint64_t phase_us;
+
+    if (profile->pause_period_us == 0U)
+    {
+        return start_us;
+    }
+
+    phase_us = start_us % profile->pause_period_us;
+    return (phase_us < profile->pause_us) ? (start_us + profile->pause_us - phase_us) : start_us;
+}
+
+/* Frames waiting to be sent and their bytes */
+static uint32_t netsim_queued(const struct netsim_link *link, uint32_t *bytes)
+{
+    const struct netsim_frame *frame;
+    uint32_t queued = 0;
+
+    *bytes = 0;
+    for (frame = link->frames; frame != NULL; frame = frame->next)
+    {
+        if (frame->start_us > now_us)
+        {
+            queued++;
+            *bytes += frame->len;
+        }
+    }
+    return queued;
+}
+
+/* When the next frame leaves the driver TX queue */
+static uint64_t netsim_next_start(const struct netsim_link *link)
+{
+    const struct netsim_frame *frame;
+    uint64_t next_us = UINT64_MAX;
+
+    for (frame = link->frames; frame != NULL; frame = frame->next)
+    {
+        if ((frame->start_us > now_us) && (frame->start_us < next_us))
+        {
+            next_us = frame->start_us;
+        }
+    }
+    return next_us;
+}
+
+static void netsim_enqueue(struct netsim_link *link, struct netsim_frame *frame)
+{
+    const struct netsim_profile *profile = &link->profile;
+    struct netsim_frame **pos;
+    uint64_t start_us = now_us;
+    uint64_t due_us;
+
+    link->stats.frames++;
+    link->stats.bytes += frame->len;
+    netsim_track_data(link, frame);
+
+    if (netsim_chance(link, profile->loss_ppm))
+    {
+        link->stats.lost++;
+        free(frame);
+        return;
+    }
+
+    if ((profile->rate_kbps != 0U) && (link->free_us > now_us))
+    {
+        uint32_t queued_bytes;
+
+        (void)netsim_queued(link, &queued_bytes);
+        if ((profile->queue_bytes != 0U) && (queued_bytes + frame->len > profile->queue_bytes))
+        {
+            link->stats.overflow++;
+            free(frame);
+            return;
+        }
+        start_us = link->free_us;
+    }
+
+    start_us        = netsim_after_pause(profile, start_us);
+    frame->start_us = start_us;
+    due_us          = start_us;
+    if (profile->rate_kbps != 0U)
+    {
+        due_us += (uint64_t)frame->len * 8000U / profile->rate_kbps;
+        link->free_us = due_us;
+    }
+
+    due_us += profile->delay_us;
+    if (profile->jitter_us != 0U)
+    {
+        due_us += netsim_rand(link) % (profile->jitter_us + 1U);
+    }
+
+    if (netsim_chance(link, profile->reorder_ppm))
+    {
+        link->stats.reordered++;
+        due_us += profile->reorder_us;
+    }
+    else
+    {
+        if (due_us < link->last_due_us)
+        {
+            due_us = link->last_due_us;
+        }
+        link->last_due_us = due_us;
+    }
+
+    frame->due_us = due_us;
+    for (pos = &link->frames; (*pos != NULL) && ((*pos)->due_us <= due_us); pos = &(*pos)->next)
+    {
+    }
+    frame->next = *pos;
+    *pos        = frame;
+}
+
+/* Whether the Wi-Fi driver could build its headers in front of the frame */
+static int netsim_tx_in_place(struct pbuf *p)
+{
+    int in_place;
+
+    if ((p->next != NULL) || (pbuf_add_header(p, NETSIM_TX_HEADROOM) != 0U))
+    {
+        return 0;
+    }
+    in_place = ((uintptr_t)p->payload & 3U) == 0U;
+    (void)pbuf_remove_header(p, NETSIM_TX_HEADROOM);
+
+    return in_place;
+}
+
+static err_t netsim_output(struct netif *netif, struct pbuf *p, const ip4_addr_t *ipaddr)
+{
+    struct netsim_link *link = (struct netsim_link *)netif->state;
+    struct netsim_frame *frame;
+
+    LWIP_UNUSED_ARG(ipaddr);
+
+    if (netsim_tx_full((enum netsim_node)(link - links)))
+    {
+        link->stats.tx_full++;
+        link->tx_waiting = 1;
+        return ERR_MEM;
+    }
+
+    if (netsim_tx_in_place(p))
+    {
+        link->stats.tx_in_place++;
+    }
+    else
+    {
+        link->stats.tx_copied++;
+        link->stats.tx_copied_bytes += p->tot_len;
+    }
+
+    frame = malloc(sizeof(*frame) + p->tot_len);
+    if (frame == NULL)
+    {
+        return ERR_MEM;
+    }
+    frame->len = p->tot_len;
+    (void)pbuf_copy_partial(p, frame->data, p->tot_len, 0);
+
+    netsim_enqueue(link, frame);
+    return ERR_OK;
+}
+
+static err_t netsim_netif_init(struct netif *netif)
+{
+    netif->name[0] = 's';
+    netif->name[1] = 'm';
+    netif->output  = netsim_output;
+    netif->mtu     = 1500;
+    netif->flags   = NETIF_FLAG_BROADCAST;
+    return ERR_OK;
+}
+
+void netsim_init(void)
+{
+    static const struct netsim_rx_mode copy_all = {0, 0};
+
+    ip4_addr_t addr;
+    ip4_addr_t mask;
+    ip4_addr_t gw;
+    int node;
+
+    lwip_init();
+
+    IP4_ADDR(&mask, 255, 255, 255, 0);
+    ip4_addr_set_zero(&gw);
+    for (node = 0; node < (int)NETSIM_NODES; node++)
+    {
+        IP4_ADDR(&addr, 10, 0, 0, node + 1);
+        netif_add(&netsim_netif[node], &addr, &mask, &gw, &links[node], netsim_netif_init, ip4_input);
+        netif_set_up(&netsim_netif[node]);
+        netif_set_link_up(&netsim_netif[node]);
+        netsim_set_rx_mode((enum netsim_node)node, &copy_all);
+    }
+
+    netsim_reset(1);
+}
+
+void netsim_reset(uint32_t seed)
+{
+    int node;
+
+    for (node = 0; node < (int)NETSIM_NODES; node++)
+    {
+        struct netsim_link *link = &links[node];
+
+        while (link->frames != NULL)
+        {
+            struct netsim_frame *frame = link->frames;
+
+            link->frames = frame->next;
+            free(frame);
+        }
+
+        memset(&link->stats, 0, sizeof(link->stats));
+        link->rand          = (seed * 2654435761U) ^ (0x9E3779B9U * (uint32_t)(node + 1));
+        link->free_us       = now_us;
+        link->last_due_us   = now_us;
+        link->pending_head  = 0;
+        link->pending_count = 0;
+        link->seq_valid     = 0;
+        link->rtt.count     = 0;
+        link->late.count    = 0;
+        link->tx_waiting    = 0;
+    }
+
+    /* Initial sequence numbers and local ports */
+    srandom(seed);
+}
+
+void netsim_set_profile(enum netsim_node from, const struct netsim_profile *profile)
+{
+    links[from].profile = *profile;
+}
+
+void netsim_set_tx_space_fn(enum netsim_node from, void (*space_fn)(void))
+{
+    links[from].space_fn = space_fn;
+}
+
+int netsim_tx_full(enum netsim_node from)
+{
+    const struct netsim_link *link = &links[from];
+    uint32_t bytes;
+
+    return (link->profile.txq_frames != 0U) && (netsim_queued(link, &bytes) >= link->profile.txq_frames);
+}
+
+void netsim_stall(uint32_t us)
+{
+    now_us += us;
+}
+
+const struct netsim_link_stats *netsim_link_stats(enum netsim_node from)
+{
+    return &links[from].stats;
+}
+
+uint32_t netsim_rtt_samples(enum netsim_node from, const uint32_t **samples)
+{
+    *samples = links[from].rtt.values;
+    return links[from].rtt.count;
+}
+
+uint32_t netsim_late_samples(enum netsim_node from, const uint32_t **samples)
+{
+    *samples = links[from].late.values;
+    return links[from].late.count;
+}
+
+void netsim_set_rx_mode(enum netsim_node to, const struct netsim_rx_mode *mode)
+{
+    struct netsim_rx *rx = &rx_nodes[to];
+    uint32_t i;
+
+    LWIP_ASSERT("wrapped frames still held", rx->held == 0U);
+    LWIP_ASSERT("too many wrapped frames", mode->ref_bufs <= NETSIM_RX_REF_MAX);
+
+    rx->mode      = *mode;
+    rx->free_refs = NULL;
+    for (i = 0; i < mode->ref_bufs; i++)
+    {
+        rx->refs[i].rx        = rx;
+        rx->refs[i].next_free = rx->free_refs;
+        rx->free_refs         = &rx->refs[i];
+    }
+}
+
+static void netsim_rx_ref_free(struct pbuf *p)
+{
+    struct netsim_rx_ref *ref = (struct netsim_rx_ref *)p;
+    struct netsim_rx *rx      = ref->rx;
+
+    free(ref->frame);
+    ref->frame     = NULL;
+    ref->next_free = rx->free_refs;
+    rx->free_refs  = ref;
+    rx->held--;
+}
+
+/* Hands the frame on to the other node, takes its ownership */
+static void netsim_deliver(int from, struct netsim_frame *frame)
+{
+    struct netsim_link *link = &links[from];
+    struct netsim_rx *rx     = &rx_nodes[1 - from];
+    struct netif *netif      = &netsim_netif[1 - from];
+    uint64_t start;
+    struct pbuf *p;
+
+    /* The ACKs of the other direction arrive at the sender of its data */
+    netsim_track_ack(&links[1 - from], frame);
+    netsim_sample(&link->late, (uint32_t)(now_us - frame->due_us));
+
+    start = bench_cycles();
+
+    if ((rx->free_refs != NULL) && (frame->len >= rx->mode.ref_min_len))
+    {
+        struct netsim_rx_ref *ref = rx->free_refs;
+
+        rx->free_refs                = ref->next_free;
+        ref->frame                   = frame;
+        ref->pc.custom_free_function = netsim_rx_ref_free;
+        rx->held++;
+        p = pbuf_alloced_custom(PBUF_RAW, frame->len, PBUF_REF, &ref->pc, frame->data, frame->len);
+        link->stats.rx_ref++;
+    }
+    else
+    {
+        p = pbuf_alloc(PBUF_RAW, frame->len, PBUF_POOL);
+        if (p == NULL)
+        {
+            link->stats.no_pbuf++;
+            free(frame);
+            return;
+        }
+        (void)pbuf_take(p, frame->data, frame->len);
+        link->stats.rx_copied++;
+        link->stats.rx_copied_bytes += frame->len;
+        free(frame);
+    }
+    link->stats.delivered++;
+
+    if (netif->input(p, netif) != ERR_OK)
+    {
+        pbuf_free(p);
+    }
+    link->stats.rx_cycles += bench_cycles() - start;
+}
+
+int netsim_run(uint64_t until_us, int (*done)(void *arg), void *arg)
+{
+    for (;;)
+    {
+        uint64_t next_us = until_us;
+        u32_t sleep_ms;
+        int node;
+
+        sys_check_timeouts();
+        if ((done != NULL) && done(arg))
+        {
+            return 1;
+        }
+
+        sleep_ms = sys_timeouts_sleeptime();
+        if (sleep_ms != SYS_TIMEOUTS_SLEEPTIME_INFINITE)
+        {
+            /* Timers run on the ms clock */
+            uint64_t timer_us = ((uint64_t)sys_now() + sleep_ms) * 1000U;
+
+            if (timer_us < next_us)
+            {
+                next_us = timer_us;
+            }
+        }
+        for (node = 0; node < (int)NETSIM_NODES; node++)
+        {
+            if ((links[node].frames != NULL) && (links[node].frames->due_us < next_us))
+            {
+                next_us = links[node].frames->due_us;
+            }
+            if (links[node].tx_waiting && (netsim_next_start(&links[node]) < next_us))
+            {
+                next_us = netsim_next_start(&links[node]);
+            }
+        }
+
+        if (next_us >= until_us)
+        {
+            now_us = until_us;
+            return 0;
+        }
+        if (next_us > now_us)
+        {
+            now_us = next_us;
+        }
+
+        for (node = 0; node < (int)NETSIM_NODES; node++)
+        {
+            while ((links[node].frames != NULL) && (links[node].frames->due_us <= now_us))
+            {
+                struct netsim_frame *frame = links[node].frames;
+
+                links[node].frames = frame->next;
+                netsim_deliver(node, frame);
+            }
+        }
+
+        for (node = 0; node < (int)NETSIM_NODES; node++)
+        {
+            struct netsim_link *link = &links[node];
+
+            if (link->tx_waiting && !netsim_tx_full((enum netsim_node)node))
+            {
+                link->tx_waiting = 0;
+                link->stats.tx_space++;
+                if (link->space_fn != NULL)
+                {
+                    link->space_fn();
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,153 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Two-node network simulator of the host tests.
+ *
+ * Node A (10.0.0.1) and node B (10.0.0.2) are two netifs of the host lwIP
+ * core (NO_SYS), joined by one simulated link per direction. Connections
+ * between the nodes are bound to their netif with tcp_bind_netif(), so
+ * each end sends on its own netif and lwIP demultiplexes both ends of a
+ * connection by their addresses. The nodes share the lwIP pools.
+ *
+ * A link serializes frames at its rate, delays them by a fixed latency
+ * plus uniform jitter, drops them at random or when the bottleneck queue is
+ * full, and holds some back so that later frames overtake them. Jitter
+ * alone keeps the frame order, like the Wi-Fi MAC does.
+ *
+ * Time is virtual: sys_now() follows the simulation clock, which jumps to
+ * the next frame delivery or lwIP timer. Runs are reproducible for a seed.
+ *
+ * The link also watches the TCP segments it carries. It counts data
+ * segments sent again (retransmissions) and measures the RTT from sending a
+ * data segment to delivering the first ACK that covers it, skipping
+ * retransmitted segments. One connection per direction is assumed.
+ *
+ * On the sending side the simulator checks every frame the way the Wi-Fi
+ * driver decides whether it can queue a frame in place: one pbuf with room
+ * for the Ethernet header and the driver headers (NETSIM_TX_DRIVER_HLEN) in
+ * front, starting on a word boundary. Other frames are counted as copied.
+ *
+ * A link can also model the TX queue of the driver: frames wait there until
+ * the link starts sending them, and while the peer pauses the link (power
+ * save) nothing is sent. A full queue refuses frames with ERR_MEM instead of
+ * dropping them and calls the space callback of the node once a frame
+ * leaves it. netsim_stall() stands for the sender blocking its thread: the
+ * clock moves on while the stack processes nothing, so frames reach the
+ * stack late. The simulator records how late every frame is handed to the
+ * receiving stack.
+ */
+
+#ifndef NETSIM_H
+#define NETSIM_H
+
+#include "lwip/netif.h"
+
+#include <stdint.h>
+
+enum netsim_node
+{
+    NETSIM_A = 0,
+    NETSIM_B,
+    NETSIM_NODES
+};
+
+/* Impairment of the link leaving one node, all zero is an ideal link */
+struct netsim_profile
+{
+    uint32_t rate_kbps;       /* Link rate, 0 for unlimited */
+    uint32_t delay_us;        /* Fixed one way delay */
+    uint32_t jitter_us;       /* Uniform random extra delay, 0 to jitter_us */
+    uint32_t loss_ppm;        /* Probability of losing a frame, per million */
+    uint32_t reorder_ppm;     /* Probability of holding a frame back, per million */
+    uint32_t reorder_us;      /* How long a held back frame is delayed additionally */
+    uint32_t queue_bytes;     /* Bottleneck queue, frames beyond it are dropped, 0 for unlimited */
+    uint32_t txq_frames;      /* Driver TX queue, refuses frames beyond it with ERR_MEM, 0 for none */
+    uint32_t pause_period_us; /* The peer pauses the link once per period, 0 for never */
+    uint32_t pause_us;        /* Length of a pause */
+};
+
+/* Driver headers in front of the Ethernet header of a frame sent in place, OUTBUF_WMM_EXT_HEADROOM */
+#define NETSIM_TX_DRIVER_HLEN 38
+
+struct netsim_link_stats
+{
+    uint32_t frames;        /* Frames sent into the link */
+    uint32_t bytes;         /* Bytes sent into the link */
+    uint32_t delivered;     /* Frames delivered to the other node */
+    uint32_t lost;          /* Frames dropped by loss_ppm */
+    uint32_t overflow;      /* Frames dropped by the full bottleneck queue */
+    uint32_t reordered;     /* Frames held back */
+    uint32_t no_pbuf;       /* Frames dropped because the receiver had no pbuf */
+    uint32_t data_segments; /* TCP segments carrying data, SYN or FIN */
+    uint32_t retransmitted; /* Data segments sent again */
+    uint32_t tx_in_place;   /* Frames the driver could send without copying */
+    uint32_t tx_copied;     /* Frames the driver would copy */
+    uint32_t tx_copied_bytes;
+    uint32_t tx_full;       /* Frames refused by the full driver TX queue */
+    uint32_t tx_space;      /* Space callbacks after the queue was full */
+    uint32_t rx_copied;     /* Frames copied into a PBUF_POOL pbuf by the receiver */
+    uint32_t rx_copied_bytes;
+    uint32_t rx_ref;        /* Frames handed to the receiver in place */
+    uint64_t rx_cycles;     /* Receiver time spent on the frames, allocation to return of input (bench.h) */
+};
+
+/*
+ * How a node receives frames. By default every frame is copied into a
+ * PBUF_POOL pbuf. Frames of at least ref_min_len bytes can instead be handed
+ * to the stack in place, in a PBUF_REF custom pbuf whose free callback
+ * releases the frame, as the RX zero-copy path of the Wi-Fi driver does
+ * (CONFIG_IMU_RX_ZERO_COPY_MIN, CONFIG_IMU_RX_ZERO_COPY_BUFS). The stack
+ * holds at most ref_bufs such frames at a time, further frames are copied.
+ */
+#define NETSIM_RX_REF_MAX 64U
+
+struct netsim_rx_mode
+{
+    uint32_t ref_min_len;
+    uint32_t ref_bufs; /* 0 copies every frame, at most NETSIM_RX_REF_MAX */
+};
+
+extern struct netif netsim_netif[NETSIM_NODES];
+
+/* Brings up both nodes with ideal links, must be called once before the first run */
+void netsim_init(void);
+
+/* Drops the frames in flight, clears the counters and RTT samples and seeds the links */
+void netsim_reset(uint32_t seed);
+
+void netsim_set_profile(enum netsim_node from, const struct netsim_profile *profile);
+
+void netsim_set_rx_mode(enum netsim_node to, const struct netsim_rx_mode *mode);
+
+/* Simulation time in us */
+uint64_t netsim_time_us(void);
+
+/*
+ * Runs the simulation until done(arg) returns non-zero or the time reaches
+ * until_us. Returns non-zero if done.
+ */
+int netsim_run(uint64_t until_us, int (*done)(void *arg), void *arg);
+
+/* Called by netsim_run() when the full TX queue of a node has room again */
+void netsim_set_tx_space_fn(enum netsim_node from, void (*space_fn)(void));
+
+/* Non-zero if the driver TX queue of a node refuses frames */
+int netsim_tx_full(enum netsim_node from);
+
+/* Moves the clock on by us without processing frames or timers */
+void netsim_stall(uint32_t us);
+
+const struct netsim_link_stats *netsim_link_stats(enum netsim_node from);
+
+/* RTT samples in us of the data sent by a node, in the order taken */
+uint32_t netsim_rtt_samples(enum netsim_node from, const uint32_t **samples);
+
+/* How late in us the frames sent by a node were handed to the receiving stack, in delivery order */
+uint32_t netsim_late_samples(enum netsim_node from, const uint32_t **samples);
+
+#endif /* NETSIM_H */
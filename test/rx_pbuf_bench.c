@@ -0,0 +1,370 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Replay benchmark of the Wi-Fi RX pbuf size classes (PBUF_RX_SIZE_CLASSES).
+ *
+ * Received frame lengths are replayed through handle_data_packet() of
+ * wifi/port/net/wifi_netif.c, built with the lwIP options of the application
+ * and without CONFIG_IMU_RX_ZERO_COPY, so that rx_pbuf_alloc() copies every
+ * frame into a pbuf. The stack holds the frames in a queue behind the netif
+ * input function until the benchmark frees them. Two buffer layouts are
+ * compared: the size classes of source/lwipopts.h in front of the PBUF_POOL,
+ * and the PBUF_POOL alone, for which the class pools are taken empty before
+ * the run so that rx_pbuf_alloc() spills every frame over to the pool.
+ *
+ * For every trace the benchmark reports
+ * - burst: frames received back to back before the first one is dropped,
+ *   with nothing freed in between (mean over 1000 starting points),
+ * - drops: the share of frames dropped when frames arrive in bursts of 1 to
+ *   48 and the stack frees the 24 oldest frames between two bursts, about
+ *   the mean burst, so only the peaks overflow.
+ *
+ * The synthetic traces are seeded mixes of Ethernet frame lengths. A file
+ * with one frame length per line, for example from
+ * "tshark -r capture.pcap -T fields -e frame.len", is replayed as a fourth
+ * trace. The check fails if the size classes hold fewer frames of the
+ * control trace than the single pool, the traffic they are sized for, or
+ * drop more frames of the bulk trace, if a frame comes up changed or if a
+ * pbuf is left allocated after a run.
+ *
+ * Usage: rx_pbuf_bench [frame length file]
+ */
+
+#include "wifi_host.h"
+
+/* The netif under test, for its statics */
+#include "wifi_netif.c"
+
+#include "lwip/memp.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+#define MAX_IN_FLIGHT 256
+#define TRACE_FRAMES  100000
+#define BURST_RUNS    1000
+#define BURST_MAX     48
+#define FREE_PER_GAP  24
+#define FRAME_MAX     1514
+
+struct rx_layout
+{
+    const char *name;
+    /* Only the PBUF_POOL, the class pools are taken empty */
+    int pool_only;
+};
+
+struct trace
+{
+    const char *name;
+    uint16_t *len;
+    unsigned int frames;
+};
+
+/* Share in percent and length range of a frame kind in a synthetic trace */
+struct frame_kind
+{
+    unsigned int percent;
+    uint16_t min;
+    uint16_t max;
+};
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+static const struct rx_layout layouts[] = {
+    {"pool", 1},
+    {"classes", 0},
+};
+
+/* TCP ACKs, MQTT PUBACK/PINGRESP, DNS and DHCP replies, occasional publishes */
+static const struct frame_kind control_mix[] = {{50, 54, 66}, {25, 58, 70}, {15, 80, 342}, {10, 1514, 1514}, {0}};
+/* MQTT publishes of a few hundred bytes between ACKs and full segments */
+static const struct frame_kind mixed_mix[] = {{40, 54, 66}, {30, 200, 600}, {30, 1514, 1514}, {0}};
+/* TCP download */
+static const struct frame_kind bulk_mix[] = {{90, 1514, 1514}, {10, 54, 66}, {0}};
+
+static uint32_t seed = 1;
+
+static struct netif rx_netif;
+static uint8_t frame[FRAME_MAX];
+
+/* Frames held by the stack, oldest first */
+static struct pbuf *held[MAX_IN_FLIGHT];
+static unsigned int held_head;
+static unsigned int held_count;
+static unsigned int corrupted;
+
+/* Class pool elements taken for the pool only layout */
+static void *taken[PBUF_RX_SMALL_POOL_SIZE + PBUF_RX_MEDIUM_POOL_SIZE];
+static unsigned int taken_count;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+static uint32_t rand_next(void)
+{
+    seed = seed * 1103515245U + 12345U;
+    return seed >> 8;
+}
+
+/* The stack keeps every frame it is handed */
+static err_t hold_input(struct pbuf *p, struct netif *inp)
+{
+    if (held_count == MAX_IN_FLIGHT)
+    {
+        (void)pbuf_free(p);
+        return ERR_OK;
+    }
+    if ((p->tot_len < SIZEOF_ETH_HDR + 1U) || (pbuf_get_at(p, SIZEOF_ETH_HDR) != (u8_t)p->tot_len))
+    {
+        corrupted++;
+    }
+    held[(held_head + held_count) % MAX_IN_FLIGHT] = p;
+    held_count++;
+    return ERR_OK;
+}
+
+static void rx_free_oldest(unsigned int frames)
+{
+    while ((frames-- > 0U) && (held_count > 0U))
+    {
+        (void)pbuf_free(held[held_head]);
+        held_head = (held_head + 1U) % MAX_IN_FLIGHT;
+        held_count--;
+    }
+}
+
+static void rx_reset(const struct rx_layout *layout)
+{
+    rx_free_oldest(held_count);
+    while (taken_count > 0U)
+    {
+        taken_count--;
+        memp_free((taken_count < PBUF_RX_SMALL_POOL_SIZE) ? MEMP_RX_PBUF_SMALL : MEMP_RX_PBUF_MEDIUM,
+                  taken[taken_count]);
+    }
+
+    if (layout->pool_only)
+    {
+        while ((taken_count < PBUF_RX_SMALL_POOL_SIZE) &&
+               ((taken[taken_count] = memp_malloc(MEMP_RX_PBUF_SMALL)) != NULL))
+        {
+            taken_count++;
+        }
+        while ((taken_count < PBUF_RX_SMALL_POOL_SIZE + PBUF_RX_MEDIUM_POOL_SIZE) &&
+               ((taken[taken_count] = memp_malloc(MEMP_RX_PBUF_MEDIUM)) != NULL))
+        {
+            taken_count++;
+        }
+    }
+}
+
+/* A frame through handle_data_packet(), returns non-zero if the stack got it */
+static int rx_receive(uint16_t len)
+{
+    unsigned int before = held_count;
+
+    /* An IPv4 frame to the STA, its first payload byte tells the length */
+    (void)memcpy(&frame[0], rx_netif.hwaddr, ETH_HWADDR_LEN);
+    frame[12]             = 0x08;
+    frame[13]             = 0x00;
+    frame[SIZEOF_ETH_HDR] = (uint8_t)len;
+    (void)wifi_host_rx_frame(MLAN_BSS_TYPE_STA, 0, frame, len);
+
+    return held_count > before;
+}
+
+static void trace_generate(struct trace *trace, const char *name, const struct frame_kind *mix)
+{
+    unsigned int i;
+
+    trace->name   = name;
+    trace->frames = TRACE_FRAMES;
+    trace->len    = malloc(TRACE_FRAMES * sizeof(trace->len[0]));
+    for (i = 0; i < TRACE_FRAMES; i++)
+    {
+        const struct frame_kind *kind = mix;
+        unsigned int pick             = rand_next() % 100U;
+
+        while (pick >= kind->percent)
+        {
+            pick -= kind->percent;
+            kind++;
+        }
+        trace->len[i] = (uint16_t)(kind->min + rand_next() % (kind->max - kind->min + 1U));
+    }
+}
+
+static int trace_load(struct trace *trace, const char *path)
+{
+    FILE *file = fopen(path, "r");
+    unsigned int size = 1024;
+    unsigned int len;
+
+    if (file == NULL)
+    {
+        perror(path);
+        return 1;
+    }
+
+    trace->name   = "file";
+    trace->frames = 0;
+    trace->len    = malloc(size * sizeof(trace->len[0]));
+    while (fscanf(file, "%u", &len) == 1)
+    {
+        if ((len < SIZEOF_ETH_HDR + 1U) || (len > FRAME_MAX))
+        {
+            continue;
+        }
+        if (trace->frames == size)
+        {
+            size *= 2U;
+            trace->len = realloc(trace->len, size * sizeof(trace->len[0]));
+        }
+        trace->len[trace->frames++] = (uint16_t)len;
+    }
+    fclose(file);
+
+    if (trace->frames == 0U)
+    {
+        printf("%s: no frame lengths from %u to %u\n", path, SIZEOF_ETH_HDR + 1U, FRAME_MAX);
+        return 1;
+    }
+    return 0;
+}
+
+static double burst_capacity(const struct rx_layout *layout, const struct trace *trace)
+{
+    unsigned long total = 0;
+    unsigned int run;
+
+    for (run = 0; run < BURST_RUNS; run++)
+    {
+        unsigned int pos = rand_next() % trace->frames;
+
+        rx_reset(layout);
+        while ((held_count < MAX_IN_FLIGHT) && rx_receive(trace->len[pos]))
+        {
+            pos = (pos + 1U) % trace->frames;
+        }
+        total += held_count;
+    }
+    return (double)total / BURST_RUNS;
+}
+
+static double drop_percent(const struct rx_layout *layout, const struct trace *trace)
+{
+    unsigned int frames  = (trace->frames < TRACE_FRAMES) ? TRACE_FRAMES : trace->frames;
+    unsigned int dropped = 0;
+    unsigned int pos     = 0;
+
+    seed = 7;
+    rx_reset(layout);
+    while (pos < frames)
+    {
+        unsigned int burst = 1U + rand_next() % BURST_MAX;
+
+        while ((burst-- > 0U) && (pos < frames))
+        {
+            if (!rx_receive(trace->len[pos % trace->frames]))
+            {
+                dropped++;
+            }
+            pos++;
+        }
+        rx_free_oldest(FREE_PER_GAP);
+    }
+    return 100.0 * dropped / frames;
+}
+
+/* Every pbuf and class buffer is back in its pool */
+static int pools_empty(void)
+{
+    static const memp_t pools[] = {MEMP_PBUF_POOL, MEMP_RX_PBUF_SMALL, MEMP_RX_PBUF_MEDIUM};
+    size_t i;
+
+    rx_reset(&layouts[1]);
+    for (i = 0; i < sizeof(pools) / sizeof(pools[0]); i++)
+    {
+        if (memp_pools[pools[i]]->stats->used != 0U)
+        {
+            printf("FAIL %s: %u buffers left allocated\n", memp_pools[pools[i]]->desc,
+                   (unsigned int)memp_pools[pools[i]]->stats->used);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    struct trace traces[4];
+    unsigned int count = 0;
+    unsigned int t;
+    size_t l;
+
+    wifi_host_init();
+    netif_arr[MLAN_BSS_TYPE_STA] = &rx_netif;
+    rx_netif.input               = hold_input;
+    (void)wlan_get_mac_address(rx_netif.hwaddr);
+
+    trace_generate(&traces[count++], "control", control_mix);
+    trace_generate(&traces[count++], "mixed", mixed_mix);
+    trace_generate(&traces[count++], "bulk", bulk_mix);
+    if ((argc > 1) && (trace_load(&traces[count++], argv[1]) != 0))
+    {
+        return 1;
+    }
+
+    printf("pool     %3u buffers of %u bytes\n", PBUF_POOL_SIZE, PBUF_POOL_BUFSIZE);
+    printf("classes  %3u buffers, %u x %u and %u x %u bytes in front of the pool\n",
+           PBUF_POOL_SIZE + PBUF_RX_SMALL_POOL_SIZE + PBUF_RX_MEDIUM_POOL_SIZE, PBUF_RX_SMALL_POOL_SIZE,
+           PBUF_RX_SMALL_BUFSIZE, PBUF_RX_MEDIUM_POOL_SIZE, PBUF_RX_MEDIUM_BUFSIZE);
+
+    printf("trace    layout    burst  drops (%%)\n");
+    for (t = 0; t < count; t++)
+    {
+        for (l = 0; l < sizeof(layouts) / sizeof(layouts[0]); l++)
+        {
+            seed = 3;
+            printf("%-8s %-8s %6.1f  %9.2f\n", traces[t].name, layouts[l].name, burst_capacity(&layouts[l], &traces[t]),
+                   drop_percent(&layouts[l], &traces[t]));
+        }
+    }
+
+    if (corrupted != 0U)
+    {
+        printf("FAIL %u frames changed on the way up\n", corrupted);
+        return 1;
+    }
+    if (!pools_empty())
+    {
+        return 1;
+    }
+
+    seed = 3;
+    if (burst_capacity(&layouts[1], &traces[0]) < burst_capacity(&layouts[0], &traces[0]))
+    {
+        printf("FAIL %s: size classes hold fewer frames than the pool\n", traces[0].name);
+        return 1;
+    }
+    if (drop_percent(&layouts[1], &traces[2]) > drop_percent(&layouts[0], &traces[2]))
+    {
+        printf("FAIL %s: size classes drop more frames than the pool\n", traces[2].name);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,427 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * RX zero-copy benchmark of wifi/port/net/wifi_netif.c (CONFIG_IMU_RX_ZERO_COPY).
+ *
+ * UDP datagrams to the STA are handed to handle_data_packet() in IMU rx
+ * buffers (wifi_host.h) and go up through the lwIP core, built with the
+ * options of the application, to a UDP receive callback that checks every
+ * byte. Frames of CONFIG_IMU_RX_ZERO_COPY_MIN bytes and more are wrapped in
+ * place by rx_ref_pbuf_alloc(), which holds their rx buffer until the pbuf
+ * is freed, the others are copied. The modes are:
+ *  - copy: the RX_REF_PBUF pool is taken empty before the run, so every
+ *    frame takes the fallback copy;
+ *  - in place: the application frees every datagram at once;
+ *  - held: the application keeps the last 16 datagrams, more than the
+ *    CONFIG_IMU_RX_ZERO_COPY_BUFS rx buffers that may be held, so the
+ *    frames beyond them are copied until a held one is freed.
+ * The traffic is either full size datagrams (bulk) or one in three of 100
+ * to 400 bytes, below the zero-copy minimum (mixed).
+ *
+ * The benchmark reports the host time per frame spent in
+ * handle_data_packet(), from the pbuf allocation to the return of the
+ * receive callback, the share of frames received in place and the bytes
+ * still copied per MB, best of the runs. The numbers are host CPU numbers,
+ * they show the relative cost of the copy and not the cost on the board,
+ * where the copy also competes for the SRAM bandwidth. The check fails if a
+ * datagram is lost or changed, an rx buffer is held or released out of
+ * turn or left held, or a pbuf is left allocated after a run.
+ *
+ * Usage: rx_zero_copy_bench [MB]
+ */
+
+#include "wifi_host.h"
+
+/* The netif under test, for its statics */
+#include "wifi_netif.c"
+
+#include "lwip/udp.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+#define TIMED_RUNS  15
+#define UDP_PORT    5001
+#define PAYLOAD_MAX 1472U
+#define HELD_MAX    16U
+#define FRAME_HLEN  (SIZEOF_ETH_HDR + IP_HLEN + UDP_HLEN)
+
+enum rx_mode
+{
+    MODE_COPY,
+    MODE_IN_PLACE,
+    MODE_HELD,
+    MODES
+};
+
+struct rx_traffic
+{
+    const char *name;
+    /* One in small_every datagrams is small, 0 for none */
+    unsigned int small_every;
+};
+
+struct rx_result
+{
+    uint64_t cycles;
+    uint32_t frames;
+    uint32_t in_place;
+    uint64_t copied_bytes;
+};
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+static const char *const mode_names[MODES] = {"copy", "in place", "held"};
+
+static const struct rx_traffic traffics[] = {
+    {"bulk", 0},
+    {"mixed", 3},
+};
+
+static struct netif rx_netif;
+static struct udp_pcb *rx_pcb;
+static uint8_t frame[FRAME_HLEN + PAYLOAD_MAX];
+
+static enum rx_mode mode;
+static uint32_t expected_seq;
+static uint32_t received;
+static uint32_t failures;
+static struct pbuf *held[HELD_MAX];
+static unsigned int held_head;
+static unsigned int held_count;
+
+/* RX_REF_PBUF elements taken for the copy mode */
+static void *taken[CONFIG_IMU_RX_ZERO_COPY_BUFS];
+static unsigned int taken_count;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+static uint8_t payload_byte(uint32_t seq, uint32_t i)
+{
+    return (uint8_t)(seq * 7U + i);
+}
+
+/* Runs in handle_data_packet(), the datagram is still in frame */
+static void rx_datagram(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr, u16_t port)
+{
+    const uint8_t *sent = &frame[FRAME_HLEN];
+    uint32_t seq;
+    uint16_t off = 0;
+    struct pbuf *q;
+
+    (void)memcpy(&seq, sent, 4);
+    if ((seq != expected_seq) || (p->tot_len != (uint16_t)(((frame[16] << 8) | frame[17]) - IP_HLEN - UDP_HLEN)))
+    {
+        failures++;
+    }
+    else
+    {
+        for (q = p; q != NULL; q = q->next)
+        {
+            if (memcmp(q->payload, &sent[off], q->len) != 0)
+            {
+                failures++;
+                break;
+            }
+            off = (uint16_t)(off + q->len);
+        }
+    }
+    expected_seq++;
+    received++;
+
+    if (mode != MODE_HELD)
+    {
+        (void)pbuf_free(p);
+        return;
+    }
+    if (held_count == HELD_MAX)
+    {
+        (void)pbuf_free(held[held_head]);
+        held_head = (held_head + 1U) % HELD_MAX;
+        held_count--;
+    }
+    held[(held_head + held_count) % HELD_MAX] = p;
+    held_count++;
+}
+
+static u16_t chksum_add(uint32_t sum, const uint8_t *data, uint32_t len)
+{
+    uint32_t i;
+
+    for (i = 0; i + 1U < len; i += 2U)
+    {
+        sum += (uint32_t)(data[i] << 8) | data[i + 1U];
+    }
+    if ((len & 1U) != 0U)
+    {
+        sum += (uint32_t)data[len - 1U] << 8;
+    }
+    while ((sum >> 16) != 0U)
+    {
+        sum = (sum & 0xffffU) + (sum >> 16);
+    }
+    return (u16_t)sum;
+}
+
+/* An Ethernet frame with a UDP datagram from 10.0.0.1 to the STA */
+static uint16_t frame_build(uint32_t seq, uint16_t payload_len)
+{
+    uint8_t *ip     = &frame[SIZEOF_ETH_HDR];
+    uint8_t *udp    = ip + IP_HLEN;
+    uint8_t *data   = udp + UDP_HLEN;
+    uint16_t ip_len = (uint16_t)(IP_HLEN + UDP_HLEN + payload_len);
+    uint16_t sum;
+    uint32_t i;
+
+    (void)memcpy(&frame[0], rx_netif.hwaddr, ETH_HWADDR_LEN);
+    (void)memset(&frame[6], 0x12, ETH_HWADDR_LEN);
+    frame[12] = 0x08;
+    frame[13] = 0x00;
+
+    (void)memset(ip, 0, IP_HLEN);
+    ip[0] = 0x45;
+    ip[2] = (uint8_t)(ip_len >> 8);
+    ip[3] = (uint8_t)ip_len;
+    ip[8] = 64;
+    ip[9] = IP_PROTO_UDP;
+    ip[12] = 10, ip[15] = 1;
+    ip[16] = 10, ip[19] = 2;
+    sum    = (u16_t)~chksum_add(0, ip, IP_HLEN);
+    ip[10] = (uint8_t)(sum >> 8);
+    ip[11] = (uint8_t)sum;
+
+    (void)memcpy(data, &seq, 4);
+    for (i = 4; i < payload_len; i++)
+    {
+        data[i] = payload_byte(seq, i);
+    }
+    udp[0] = (uint8_t)(UDP_PORT >> 8);
+    udp[1] = (uint8_t)UDP_PORT;
+    udp[2] = (uint8_t)(UDP_PORT >> 8);
+    udp[3] = (uint8_t)UDP_PORT;
+    udp[4] = (uint8_t)((UDP_HLEN + payload_len) >> 8);
+    udp[5] = (uint8_t)(UDP_HLEN + payload_len);
+    udp[6] = 0;
+    udp[7] = 0;
+    /* Pseudo header: addresses, protocol and UDP length */
+    sum = chksum_add((uint32_t)IP_PROTO_UDP + UDP_HLEN + payload_len, &ip[12], 8);
+    sum = (u16_t)~chksum_add(sum, udp, UDP_HLEN + payload_len);
+    if (sum == 0U)
+    {
+        sum = 0xffffU;
+    }
+    udp[6] = (uint8_t)(sum >> 8);
+    udp[7] = (uint8_t)sum;
+
+    return (uint16_t)(SIZEOF_ETH_HDR + ip_len);
+}
+
+static void rx_release_all(void)
+{
+    while (held_count > 0U)
+    {
+        (void)pbuf_free(held[held_head]);
+        held_head = (held_head + 1U) % HELD_MAX;
+        held_count--;
+    }
+    while (taken_count > 0U)
+    {
+        LWIP_MEMPOOL_FREE(RX_REF_PBUF, taken[--taken_count]);
+    }
+}
+
+/* Receives bytes of datagrams, returns non-zero if all of them arrived unchanged */
+static int rx_run(const struct rx_traffic *traffic, enum rx_mode run_mode, uint32_t bytes, struct rx_result *result)
+{
+    uint32_t sent = 0;
+    uint32_t seq  = 0;
+    uint32_t seed = 1;
+    uint32_t in_place;
+    uint64_t copied = 0;
+
+    wifi_host_reset();
+    mode         = run_mode;
+    expected_seq = 0;
+    received     = 0;
+    failures     = 0;
+
+    if (mode == MODE_COPY)
+    {
+        /* rx_ref_pbuf_alloc() initializes the pool with its first frame */
+        if (!rx_ref_pbuf_pool_ready)
+        {
+            LWIP_MEMPOOL_INIT(RX_REF_PBUF);
+            rx_ref_pbuf_pool_ready = true;
+        }
+        while ((taken_count < CONFIG_IMU_RX_ZERO_COPY_BUFS) &&
+               ((taken[taken_count] = LWIP_MEMPOOL_ALLOC(RX_REF_PBUF)) != NULL))
+        {
+            taken_count++;
+        }
+    }
+
+    while (sent < bytes)
+    {
+        uint16_t payload_len = PAYLOAD_MAX;
+        uint32_t holds       = wifi_host.rx_holds;
+        uint16_t len;
+
+        if ((traffic->small_every != 0U) && ((seq % traffic->small_every) == 0U))
+        {
+            seed         = seed * 1103515245U + 12345U;
+            payload_len = (uint16_t)(100U + (seed >> 8) % 301U);
+        }
+        len = frame_build(seq, payload_len);
+        if (!wifi_host_rx_frame(MLAN_BSS_TYPE_STA, 0, frame, len))
+        {
+            printf("FAIL %s %s: no free rx buffer\n", traffic->name, mode_names[mode]);
+            return 0;
+        }
+        if (wifi_host.rx_holds == holds)
+        {
+            copied += len;
+        }
+        sent += payload_len;
+        seq++;
+    }
+    in_place = wifi_host.rx_holds;
+    rx_release_all();
+
+    if ((received != seq) || (failures != 0U))
+    {
+        printf("FAIL %s %s: %u of %u datagrams received, %u changed\n", traffic->name, mode_names[mode],
+               (unsigned int)received, (unsigned int)seq, (unsigned int)failures);
+        return 0;
+    }
+    if ((wifi_host.rx_errors != 0U) || (wifi_host_rx_held() != 0U) || (wifi_host.rx_releases != in_place))
+    {
+        printf("FAIL %s %s: %u rx buffers held, %u released, %u still held, %u out of turn\n", traffic->name,
+               mode_names[mode], (unsigned int)in_place, (unsigned int)wifi_host.rx_releases, wifi_host_rx_held(),
+               (unsigned int)wifi_host.rx_errors);
+        return 0;
+    }
+    if ((memp_RX_REF_PBUF.stats->used != 0U) || (memp_pools[MEMP_PBUF_POOL]->stats->used != 0U) ||
+        (memp_pools[MEMP_RX_PBUF_SMALL]->stats->used != 0U) || (memp_pools[MEMP_RX_PBUF_MEDIUM]->stats->used != 0U))
+    {
+        printf("FAIL %s %s: pbufs left allocated\n", traffic->name, mode_names[mode]);
+        return 0;
+    }
+
+    if (wifi_host.rx_cycles < result->cycles)
+    {
+        result->cycles       = wifi_host.rx_cycles;
+        result->frames       = seq;
+        result->in_place     = in_place;
+        result->copied_bytes = copied;
+    }
+    return 1;
+}
+
+/* The announcements of the netif are not looked at */
+static err_t rx_netif_linkoutput(struct netif *netif, struct pbuf *p)
+{
+    return ERR_OK;
+}
+
+static err_t rx_netif_init(struct netif *netif)
+{
+    netif->output     = etharp_output;
+    netif->linkoutput = rx_netif_linkoutput;
+    return ERR_OK;
+}
+
+static void rx_netif_setup(void)
+{
+    ip4_addr_t addr;
+    ip4_addr_t mask;
+    ip4_addr_t gw;
+
+    IP4_ADDR(&addr, 10, 0, 0, 2);
+    IP4_ADDR(&mask, 255, 255, 255, 0);
+    IP4_ADDR(&gw, 10, 0, 0, 1);
+    (void)netif_add(&rx_netif, &addr, &mask, &gw, NULL, rx_netif_init, tcpip_input);
+    (void)wlan_get_mac_address(rx_netif.hwaddr);
+    rx_netif.hwaddr_len = ETH_HWADDR_LEN;
+    rx_netif.mtu        = 1500;
+    rx_netif.flags      = NETIF_FLAG_BROADCAST | NETIF_FLAG_ETHARP;
+    netif_set_up(&rx_netif);
+    netif_set_link_up(&rx_netif);
+    netif_arr[MLAN_BSS_TYPE_STA] = &rx_netif;
+
+    rx_pcb = udp_new();
+    (void)udp_bind(rx_pcb, IP_ADDR_ANY, UDP_PORT);
+    udp_recv(rx_pcb, rx_datagram, NULL);
+}
+
+int main(int argc, char **argv)
+{
+    struct rx_result results[MODES];
+    int mb = (argc > 1) ? atoi(argv[1]) : 8;
+    size_t i;
+    int m;
+    int run;
+
+    if ((mb < 1) || (mb > 1024))
+    {
+        printf("MB: 1 to 1024\n");
+        return 1;
+    }
+
+    wifi_host_init();
+    rx_netif_setup();
+
+    printf("%d MB of UDP to the STA, zero-copy from %u bytes with %u rx buffers held at most, best of %d runs\n", mb,
+           (unsigned int)CONFIG_IMU_RX_ZERO_COPY_MIN, (unsigned int)CONFIG_IMU_RX_ZERO_COPY_BUFS, TIMED_RUNS);
+    printf("traffic  mode       " BENCH_UNIT "s/frame  in place %%  copied KB/MB\n");
+
+    for (i = 0; i < sizeof(traffics) / sizeof(traffics[0]); i++)
+    {
+        for (m = 0; m < MODES; m++)
+        {
+            results[m].cycles = UINT64_MAX;
+        }
+
+        for (run = 0; run < TIMED_RUNS; run++)
+        {
+            for (m = 0; m < MODES; m++)
+            {
+                if (!rx_run(&traffics[i], (enum rx_mode)m, (uint32_t)mb * 1024U * 1024U, &results[m]))
+                {
+                    return 1;
+                }
+            }
+        }
+
+        for (m = 0; m < MODES; m++)
+        {
+            const struct rx_result *result = &results[m];
+
+            if ((m == MODE_COPY) ? (result->in_place != 0U) : (result->in_place == 0U))
+            {
+                printf("FAIL %s %s: %u frames received in place\n", traffics[i].name, mode_names[m],
+                       (unsigned int)result->in_place);
+                return 1;
+            }
+
+            printf("%-8s %-9s %11.0f %10.1f %13.1f\n", traffics[i].name, mode_names[m],
+                   (double)result->cycles / result->frames, 100.0 * result->in_place / result->frames,
+                   (double)result->copied_bytes / 1024.0 / mb);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,486 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Benchmark of the 802.11n RX reorder window (wifi/wifidriver/mlan_11n_rxreorder.c).
+ *
+ * A block ack stream of a 64 packet window is set up with
+ * wlan_cmd_11n_addba_rspgen() and fed through mlan_11n_rxreorder_pkt()
+ * with synthetic sequence number patterns, wrapping at 4096:
+ *  - in order;
+ *  - reordered, 1 in 20 packets arriving up to 16 positions late;
+ *  - lost, 1 in 100 packets never arriving, so the window is moved by the
+ *    first packet past its end;
+ *  - BAR, 4 packets lost every 128 and skipped with a block ack request;
+ *  - timer, bursts of 16 whose last packet is lost, flushed by the reorder
+ *    timer between bursts.
+ * Every packet handed up is checked to come in sequence order and once, and
+ * every packet sent to be handed up or dropped, after the stream is torn
+ * down with a DELBA. The driver, OS and stack hooks are stubs that count
+ * lock acquisitions and timer starts.
+ *
+ * The table reports host time per packet, best of the runs, RX lock
+ * acquisitions and reorder timer starts per 1000 packets.
+ *
+ * Usage: rxreorder_bench [packets per run]
+ */
+
+/* Before the CMSIS headers, whose __I and __O macros break the x86 intrinsics */
+#include "bench.h"
+
+#include <mlan_api.h>
+#include "lwip/pbuf.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+#define WIN_SIZE        64U
+#define SEQ_MOD         4096U
+#define TEST_TID        0
+#define DEFAULT_PACKETS 200000U
+#define RUNS            5U
+/* rx_pkt_type of an 802.3 data frame */
+#define PKT_TYPE_DATA 0U
+
+enum pattern
+{
+    PATTERN_IN_ORDER,
+    PATTERN_REORDER,
+    PATTERN_LOSS,
+    PATTERN_BAR,
+    PATTERN_TIMER,
+    PATTERNS
+};
+
+/* One frame of a pattern, a packet with its stream index or a BAR starting at it */
+struct frame
+{
+    uint32_t index;
+    uint8_t bar;
+};
+
+struct host_timer
+{
+    t_void (*callback)(osa_timer_arg_t arg);
+    t_void *context;
+    bool armed;
+};
+
+struct run_stats
+{
+    uint64_t cycles;
+    unsigned long packets;
+    unsigned long delivered;
+    unsigned long dropped;
+    unsigned long locks;
+    unsigned long timer_starts;
+    unsigned long timer_flushes;
+    unsigned long errors;
+};
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+mlan_adapter *mlan_adap;
+
+static const char *const pattern_names[PATTERNS] = {"in order", "reorder", "loss", "BAR", "timer"};
+static t_u8 peer_mac[MLAN_MAC_ADDR_LENGTH] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+
+static mlan_adapter *adapter;
+static mlan_private *priv;
+static struct host_timer reorder_timer;
+static struct frame *frames;
+static mlan_buffer *buffers;
+static RxPD *rx_pds;
+static uint8_t *handed;
+static long last_delivered;
+static struct run_stats stats;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+/* Driver, OS and stack hooks of the reorder code */
+
+mlan_status wlan_process_rx_packet(pmlan_adapter pmadapter, pmlan_buffer pmbuf)
+{
+    long index = (long)(pmbuf - buffers);
+
+    if (handed[index] || (index <= last_delivered))
+    {
+        stats.errors++;
+    }
+    handed[index]  = 1;
+    last_delivered = index;
+    stats.delivered++;
+    return MLAN_STATUS_SUCCESS;
+}
+
+mlan_status wlan_11n_deaggregate_pkt(mlan_private *pmpriv, pmlan_buffer pmbuf)
+{
+    return MLAN_STATUS_FAILURE;
+}
+
+t_u8 wifi_sta_ampdu_rx_enable_per_tid_is_allowed(t_u8 tid)
+{
+    return MTRUE;
+}
+
+t_u8 wifi_uap_ampdu_rx_enable_per_tid_is_allowed(t_u8 tid)
+{
+    return MTRUE;
+}
+
+TxBAStreamTbl *wlan_11n_get_txbastream_tbl(mlan_private *pmpriv, t_u8 *ra)
+{
+    return MNULL;
+}
+
+void wlan_11n_update_txbastream_tbl_ampdu_stat(mlan_private *pmpriv, t_u8 *ra, t_u8 status, t_u8 tid)
+{
+}
+
+mlan_status wlan_prepare_cmd(IN mlan_private *pmpriv,
+                             IN t_u16 cmd_no,
+                             IN t_u16 cmd_action,
+                             IN t_u32 cmd_oid,
+                             IN t_void *pioctl_buf,
+                             IN t_void *pdata_buf)
+{
+    return MLAN_STATUS_SUCCESS;
+}
+
+void *OSA_TimerGetContext(osa_timer_handle_t timerHandle)
+{
+    return ((struct host_timer *)*(void **)timerHandle)->context;
+}
+
+osa_status_t OSA_SemaphoreWait(osa_semaphore_handle_t semaphoreHandle, uint32_t millisec)
+{
+    return KOSA_StatusSuccess;
+}
+
+osa_status_t OSA_SemaphorePost(osa_semaphore_handle_t semaphoreHandle)
+{
+    return KOSA_StatusSuccess;
+}
+
+osa_status_t OSA_MutexLock(osa_mutex_handle_t mutexHandle, uint32_t millisec)
+{
+    return KOSA_StatusSuccess;
+}
+
+osa_status_t OSA_MutexUnlock(osa_mutex_handle_t mutexHandle)
+{
+    return KOSA_StatusSuccess;
+}
+
+void OSA_MemoryFree(void *p)
+{
+    free(p);
+}
+
+u16_t pbuf_copy_partial(const struct pbuf *p, void *dataptr, u16_t len, u16_t offset)
+{
+    return 0;
+}
+
+u8_t pbuf_free(struct pbuf *p)
+{
+    return 0;
+}
+
+static mlan_status host_malloc(t_void *pmoal_handle, t_u32 size, t_u32 flag, t_u8 **ppbuf)
+{
+    *ppbuf = calloc(1, size);
+    return (*ppbuf != NULL) ? MLAN_STATUS_SUCCESS : MLAN_STATUS_FAILURE;
+}
+
+static mlan_status host_mfree(t_void *pmoal_handle, t_u8 *pbuf)
+{
+    free(pbuf);
+    return MLAN_STATUS_SUCCESS;
+}
+
+static mlan_status host_init_timer(t_void *pmoal_handle, t_void *ptimer, t_void (*callback)(osa_timer_arg_t arg),
+                                   t_void *pcontext)
+{
+    reorder_timer.callback = callback;
+    reorder_timer.context  = pcontext;
+    reorder_timer.armed    = false;
+    return MLAN_STATUS_SUCCESS;
+}
+
+static mlan_status host_free_timer(t_void *pmoal_handle, t_void *ptimer)
+{
+    reorder_timer.callback = NULL;
+    return MLAN_STATUS_SUCCESS;
+}
+
+static mlan_status host_start_timer(t_void *pmoal_handle, t_void *ptimer, bool periodic, t_u32 msec)
+{
+    reorder_timer.armed = true;
+    stats.timer_starts++;
+    return MLAN_STATUS_SUCCESS;
+}
+
+static mlan_status host_stop_timer(t_void *pmoal_handle, t_void *ptimer)
+{
+    reorder_timer.armed = false;
+    return MLAN_STATUS_SUCCESS;
+}
+
+static mlan_status host_spin_lock(t_void *pmoal_handle, t_void *plock)
+{
+    stats.locks++;
+    return MLAN_STATUS_SUCCESS;
+}
+
+static mlan_status host_spin_unlock(t_void *pmoal_handle, t_void *plock)
+{
+    return MLAN_STATUS_SUCCESS;
+}
+
+/* Expiry of the reorder timer, as if no packet came for win_size * MIN_FLUSH_TIMER_MS */
+static void timer_fire(void)
+{
+    osa_timer_arg_t handle = (osa_timer_arg_t)(void *)&reorder_timer;
+
+    if (reorder_timer.armed && (reorder_timer.callback != NULL))
+    {
+        reorder_timer.armed = false;
+        stats.timer_flushes++;
+        reorder_timer.callback(handle);
+    }
+}
+
+static void driver_init(unsigned int packets)
+{
+    static int rx_pkt_lock;
+
+    adapter = calloc(1, sizeof(*adapter));
+    priv    = calloc(1, sizeof(*priv));
+    frames  = calloc(packets + packets / 16U, sizeof(*frames));
+    buffers = calloc(packets, sizeof(*buffers));
+    rx_pds  = calloc(packets, sizeof(*rx_pds));
+    handed  = calloc(packets, 1);
+    if ((adapter == NULL) || (priv == NULL) || (frames == NULL) || (buffers == NULL) || (rx_pds == NULL) ||
+        (handed == NULL))
+    {
+        printf("out of memory\n");
+        exit(1);
+    }
+
+    adapter->callbacks.moal_malloc      = host_malloc;
+    adapter->callbacks.moal_mfree       = host_mfree;
+    adapter->callbacks.moal_init_timer  = host_init_timer;
+    adapter->callbacks.moal_free_timer  = host_free_timer;
+    adapter->callbacks.moal_start_timer = host_start_timer;
+    adapter->callbacks.moal_stop_timer  = host_stop_timer;
+    adapter->callbacks.moal_spin_lock   = host_spin_lock;
+    adapter->callbacks.moal_spin_unlock = host_spin_unlock;
+    adapter->priv_num                   = 1;
+    adapter->priv[0]                    = priv;
+    mlan_adap                           = adapter;
+
+    priv->adapter              = adapter;
+    priv->bss_mode             = MLAN_BSS_MODE_INFRA;
+    priv->bss_role             = MLAN_BSS_ROLE_STA;
+    priv->rx_pkt_lock          = &rx_pkt_lock;
+    priv->add_ba_param.rx_win_size = WIN_SIZE;
+    util_init_list((pmlan_linked_list)(void *)&priv->rx_reorder_tbl_ptr);
+    (void)memset(priv->rx_seq, 0xff, sizeof(priv->rx_seq));
+}
+
+/* The frames of a pattern, returns their number */
+static unsigned int pattern_frames(enum pattern pattern, unsigned int packets)
+{
+    unsigned int seed = 1U + (unsigned int)pattern;
+    unsigned int count = 0;
+    unsigned int i;
+    unsigned int j;
+
+    for (i = 0; i < packets; i++)
+    {
+        switch (pattern)
+        {
+            case PATTERN_LOSS:
+                if ((rand_r(&seed) % 100) == 0)
+                {
+                    continue;
+                }
+                break;
+            case PATTERN_BAR:
+                if ((i % 128U) == 124U)
+                {
+                    /* 124..127 lost, the BAR moves the window to 128 */
+                    frames[count].index = i + 4U;
+                    frames[count].bar   = 1;
+                    count++;
+                    i += 3U;
+                    continue;
+                }
+                break;
+            case PATTERN_TIMER:
+                if ((i % 16U) == 15U)
+                {
+                    continue;
+                }
+                break;
+            default:
+                break;
+        }
+        frames[count].index = i;
+        frames[count].bar   = 0;
+        count++;
+    }
+
+    if (pattern == PATTERN_REORDER)
+    {
+        /* Move 1 in 20 packets up to 16 positions later */
+        for (i = 0; i + 16U < count; i++)
+        {
+            if ((rand_r(&seed) % 20) == 0)
+            {
+                struct frame late  = frames[i];
+                unsigned int delay = 1U + (unsigned int)rand_r(&seed) % 16U;
+
+                for (j = i; j < i + delay; j++)
+                {
+                    frames[j] = frames[j + 1U];
+                }
+                frames[i + delay] = late;
+            }
+        }
+    }
+    return count;
+}
+
+static void stream_open(void)
+{
+    static HostCmd_DS_COMMAND cmd;
+    HostCmd_DS_11N_ADDBA_REQ req;
+
+    (void)memset(&req, 0, sizeof(req));
+    (void)memcpy(req.peer_mac_addr, peer_mac, sizeof(peer_mac));
+    req.block_ack_param_set = (t_u16)(((unsigned int)TEST_TID << BLOCKACKPARAM_TID_POS) |
+                                      (WIN_SIZE << BLOCKACKPARAM_WINSIZE_POS));
+    req.ssn                 = 0;
+    (void)wlan_cmd_11n_addba_rspgen(priv, &cmd, &req);
+}
+
+static void stream_close(void)
+{
+    mlan_11n_update_bastream_tbl(priv, TEST_TID, peer_mac, TYPE_DELBA_RECEIVE, MTRUE);
+}
+
+static void run(enum pattern pattern, unsigned int count, unsigned int packets, struct run_stats *result)
+{
+    uint64_t start;
+    unsigned int i;
+
+    (void)memset(&stats, 0, sizeof(stats));
+    (void)memset(handed, 0, packets);
+    for (i = 0; i < packets; i++)
+    {
+        rx_pds[i].rx_pkt_type = PKT_TYPE_DATA;
+        buffers[i].pbuf       = (t_u8 *)&rx_pds[i];
+        buffers[i].data_len   = sizeof(RxPD);
+    }
+    last_delivered = -1;
+
+    stream_open();
+    if (wlan_11n_get_rxreorder_tbl(priv, TEST_TID, peer_mac) == MNULL)
+    {
+        printf("FAIL %s: no reorder table\n", pattern_names[pattern]);
+        exit(1);
+    }
+
+    start = bench_cycles();
+    for (i = 0; i < count; i++)
+    {
+        const struct frame *frame = &frames[i];
+        t_u16 seq                 = (t_u16)(frame->index % SEQ_MOD);
+
+        if (frame->bar)
+        {
+            (void)mlan_11n_rxreorder_pkt(priv, seq, TEST_TID, peer_mac, PKT_TYPE_BAR, MNULL);
+            continue;
+        }
+        stats.packets++;
+        if (mlan_11n_rxreorder_pkt(priv, seq, TEST_TID, peer_mac, PKT_TYPE_DATA, &buffers[frame->index]) !=
+            MLAN_STATUS_SUCCESS)
+        {
+            stats.dropped++;
+        }
+        if ((pattern == PATTERN_TIMER) && ((frame->index % 16U) == 14U))
+        {
+            timer_fire();
+        }
+    }
+    stats.cycles = bench_cycles() - start;
+
+    stream_close();
+    *result = stats;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int packets = (argc > 1) ? (unsigned int)strtoul(argv[1], NULL, 0) : DEFAULT_PACKETS;
+    struct run_stats best;
+    struct run_stats result;
+    enum pattern pattern;
+    unsigned int count;
+    unsigned int r;
+    unsigned long failures = 0;
+
+    driver_init(packets);
+
+    printf("%-9s %9s %9s %8s %10s %10s %12s\n", "pattern", BENCH_UNIT "s/pkt", "delivered", "dropped", "locks/1k",
+           "timer/1k", "timer flush");
+    for (pattern = PATTERN_IN_ORDER; pattern < PATTERNS; pattern++)
+    {
+        count = pattern_frames(pattern, packets);
+        for (r = 0; r < RUNS; r++)
+        {
+            run(pattern, count, packets, &result);
+            if ((result.errors != 0U) || (result.dropped != 0U) || (result.delivered != result.packets))
+            {
+                printf("FAIL %s: %lu of %lu packets handed up, %lu dropped, %lu out of order or twice\n",
+                       pattern_names[pattern], result.delivered, result.packets, result.dropped, result.errors);
+                failures++;
+            }
+            if ((pattern == PATTERN_TIMER) && (result.timer_flushes == 0U))
+            {
+                printf("FAIL %s: the reorder timer never flushed\n", pattern_names[pattern]);
+                failures++;
+            }
+            if ((r == 0U) || (result.cycles < best.cycles))
+            {
+                best = result;
+            }
+        }
+
+        printf("%-9s %9.1f %9lu %8lu %10.0f %10.1f %12lu\n", pattern_names[pattern],
+               (double)best.cycles / (double)best.packets, best.delivered, best.dropped,
+               1000.0 * (double)best.locks / (double)best.packets,
+               1000.0 * (double)best.timer_starts / (double)best.packets, best.timer_flushes);
+    }
+
+    if (failures != 0U)
+    {
+        printf("%lu runs failed\n", failures);
+        return 1;
+    }
+    return 0;
+}
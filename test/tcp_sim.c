@@ -0,0 +1,169 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * TCP bulk transfer benchmark over the two-node simulator (netsim.h).
+ *
+ * Node A sends TRANSFER_BYTES to node B over a link resembling the Wi-Fi
+ * link of the board, clean and with loss and reordering in both
+ * directions. Every profile runs with several seeds. B checks every byte it
+ * receives. The benchmark reports the goodput, the share of data segments
+ * sent again and the distribution of the RTT seen by A.
+ *
+ * The benchmark is built twice, with SACK based recovery (tcp_sim) and over a
+ * core built with LWIP_TCP_SACK_IN=0 that repairs loss by plain fast
+ * retransmit (tcp_sim_nosack).
+ *
+ * Usage: tcp_sim [seeds]
+ */
+
+#include "transfer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+#define TRANSFER_BYTES   (2U * 1024U * 1024U)
+/* A run that takes longer failed */
+#define RUN_LIMIT_US     (600ULL * 1000000ULL)
+#define MAX_SEEDS        32
+
+struct sim_profile
+{
+    const char *name;
+    struct netsim_profile link;
+};
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+/* 20 Mbit/s, 3 ms one way plus up to 2 ms jitter, 64 KB queue */
+#define WIFI_LINK(loss, reorder) \
+    {.rate_kbps = 20000, .delay_us = 3000, .jitter_us = 2000, .loss_ppm = (loss), .reorder_ppm = (reorder), \
+     .reorder_us = 4000, .queue_bytes = 65536}
+
+static const struct sim_profile profiles[] = {
+    {"clean", WIFI_LINK(0, 0)},
+    {"loss 1%", WIFI_LINK(10000, 0)},
+    {"loss 2%", WIFI_LINK(20000, 0)},
+    {"loss 3%", WIFI_LINK(30000, 0)},
+    {"loss 5%", WIFI_LINK(50000, 0)},
+    {"reorder 2%", WIFI_LINK(0, 20000)},
+};
+
+static uint32_t *rtt_all;
+static uint32_t rtt_all_count;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+/* Runs one transfer, returns the time it took in us or 0 if it failed */
+static uint64_t transfer_run(const struct sim_profile *profile, uint32_t seed)
+{
+    struct transfer transfer;
+    const uint32_t *rtt;
+    uint32_t count;
+    uint64_t start_us;
+    uint64_t time_us = 0;
+
+    netsim_reset(seed);
+    netsim_set_profile(NETSIM_A, &profile->link);
+    netsim_set_profile(NETSIM_B, &profile->link);
+
+    start_us = netsim_time_us();
+    transfer_start(&transfer, NETSIM_A, TRANSFER_BYTES, 1);
+
+    if (netsim_run(start_us + RUN_LIMIT_US, transfer_done, &transfer) && !transfer.failed)
+    {
+        time_us = netsim_time_us() - start_us;
+    }
+    else if (!transfer.failed)
+    {
+        printf("FAIL %s seed %u: %u of %u bytes received\n", profile->name, (unsigned int)seed,
+               (unsigned int)transfer.received, TRANSFER_BYTES);
+    }
+
+    count = netsim_rtt_samples(NETSIM_A, &rtt);
+    rtt_all = realloc(rtt_all, (rtt_all_count + count) * sizeof(rtt_all[0]));
+    memcpy(&rtt_all[rtt_all_count], rtt, count * sizeof(rtt[0]));
+    rtt_all_count += count;
+
+    transfer_stop(&transfer);
+
+    return time_us;
+}
+
+static int compare_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+static double rtt_ms(double quantile)
+{
+    return rtt_all[(uint32_t)(quantile * (rtt_all_count - 1U))] / 1000.0;
+}
+
+int main(int argc, char **argv)
+{
+    int seeds = (argc > 1) ? atoi(argv[1]) : 5;
+    size_t i;
+    int seed;
+
+    if ((seeds < 1) || (seeds > MAX_SEEDS))
+    {
+        printf("seeds: 1 to %d\n", MAX_SEEDS);
+        return 1;
+    }
+
+    netsim_init();
+
+    printf("%u KB from A to B, TCP_MSS %d, TCP_WND %d MSS, SACK %s, %d seeds\n", TRANSFER_BYTES / 1024U, TCP_MSS,
+           TCP_WND / TCP_MSS, LWIP_TCP_SACK_IN ? "on" : "off", seeds);
+    printf("profile     Mbit/s   min    max   retx %%  RTT p50  p90    p99 (ms)\n");
+
+    for (i = 0; i < sizeof(profiles) / sizeof(profiles[0]); i++)
+    {
+        double sum = 0.0;
+        double min = 1e9;
+        double max = 0.0;
+        uint32_t segments = 0;
+        uint32_t retransmitted = 0;
+
+        rtt_all_count = 0;
+        for (seed = 1; seed <= seeds; seed++)
+        {
+            uint64_t time_us = transfer_run(&profiles[i], (uint32_t)seed);
+            double mbps;
+
+            if (time_us == 0U)
+            {
+                return 1;
+            }
+            mbps = (double)TRANSFER_BYTES * 8.0 / (double)time_us;
+            sum += mbps;
+            min = (mbps < min) ? mbps : min;
+            max = (mbps > max) ? mbps : max;
+            segments += netsim_link_stats(NETSIM_A)->data_segments;
+            retransmitted += netsim_link_stats(NETSIM_A)->retransmitted;
+        }
+
+        qsort(rtt_all, rtt_all_count, sizeof(rtt_all[0]), compare_u32);
+        printf("%-10s %7.2f %5.2f %6.2f  %6.2f  %7.1f %5.1f %6.1f\n", profiles[i].name, sum / seeds, min, max,
+               100.0 * retransmitted / segments, rtt_ms(0.5), rtt_ms(0.9), rtt_ms(0.99));
+    }
+
+    return 0;
+}
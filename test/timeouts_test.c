@@ -0,0 +1,297 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Model check and benchmark of the lwIP timeouts (lwip/src/core/timeouts.c).
+ *
+ * The test is linked twice, against the timer wheel (LWIP_TIMERS_WHEEL=1,
+ * timeouts_test) and against the sorted list (timeouts_list_test).
+ *
+ * The model check runs random sys_timeout(), sys_untimeout() and time steps
+ * against a plain array of the pending timers, also across the 32-bit
+ * wraparound of sys_now(). No timer may fire early, be missed, fire after
+ * it was cancelled, and sys_timeouts_sleeptime() may never be later than
+ * the next expiry.
+ *
+ * The benchmark keeps 10 to 1000 timers with delays of up to 60 s pending,
+ * every timer re-arms itself when it fires, and reports the cost of one
+ * insert, one cancel and one millisecond of sys_check_timeouts().
+ *
+ * Usage: timeouts_test [model steps]
+ */
+
+#include "lwip/def.h"
+#include "lwip/init.h"
+#include "lwip/timeouts.h"
+
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+#if LWIP_TIMERS_WHEEL
+#define TIMEOUTS_NAME "wheel"
+#else
+#define TIMEOUTS_NAME "list"
+#endif
+
+/* Timers of the model, the pool leaves room for the cyclic timers of lwIP */
+#define MODEL_TIMERS 1000
+
+struct model_timer
+{
+    int active;
+    u32_t expires;
+};
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+static u32_t now;
+static struct model_timer timers[MODEL_TIMERS];
+static unsigned long fired;
+static int failed;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+u32_t sys_now(void)
+{
+    return now;
+}
+
+static u32_t random_delay(void)
+{
+    switch (rand() % 4)
+    {
+        case 0:
+            return (u32_t)rand() % 70U;
+        case 1:
+            return (u32_t)rand() % 5000U;
+        case 2:
+            return (u32_t)rand() % 300000U;
+        default:
+            return (u32_t)rand() % (1U << 28);
+    }
+}
+
+static void model_handler(void *arg)
+{
+    struct model_timer *timer = &timers[(intptr_t)arg];
+
+    if (!timer->active)
+    {
+        printf("FAIL %s: timer %d fired while not pending\n", TIMEOUTS_NAME, (int)(intptr_t)arg);
+        failed = 1;
+        return;
+    }
+    if ((s32_t)(now - timer->expires) < 0)
+    {
+        printf("FAIL %s: timer %d fired %d ms early\n", TIMEOUTS_NAME, (int)(intptr_t)arg, (int)(timer->expires - now));
+        failed = 1;
+    }
+    timer->active = 0;
+    fired++;
+}
+
+/* Time until the first model timer expires, 0 if one is already due */
+static u32_t model_next(void)
+{
+    u32_t next = SYS_TIMEOUTS_SLEEPTIME_INFINITE;
+    int i;
+
+    for (i = 0; i < MODEL_TIMERS; i++)
+    {
+        if (timers[i].active)
+        {
+            u32_t left = ((s32_t)(timers[i].expires - now) < 0) ? 0U : (timers[i].expires - now);
+            if (left < next)
+            {
+                next = left;
+            }
+        }
+    }
+    return next;
+}
+
+static u32_t random_step(void)
+{
+    u32_t sleep;
+
+    switch (rand() % 4)
+    {
+        case 0:
+            return (u32_t)rand() % 3U;
+        case 1:
+            return (u32_t)rand() % 2000U;
+        case 2:
+            return (u32_t)rand() % 100000U;
+        default:
+            /* Sleep exactly as long as asked, as tcpip_thread does */
+            sleep = sys_timeouts_sleeptime();
+            return (sleep == SYS_TIMEOUTS_SLEEPTIME_INFINITE) ? 1U : sleep;
+    }
+}
+
+static void model_check(unsigned long steps, u32_t start)
+{
+    unsigned long step;
+    int i;
+    int op;
+    u32_t delay;
+
+    now = start;
+    sys_restart_timeouts();
+
+    for (step = 0; (step < steps) && !failed; step++)
+    {
+        op = rand() % 10;
+        i  = rand() % MODEL_TIMERS;
+        if (op < 4)
+        {
+            if (!timers[i].active)
+            {
+                delay              = random_delay();
+                timers[i].active   = 1;
+                timers[i].expires  = now + delay;
+                sys_timeout(delay, model_handler, (void *)(intptr_t)i);
+            }
+        }
+        else if (op < 5)
+        {
+            if (timers[i].active)
+            {
+                sys_untimeout(model_handler, (void *)(intptr_t)i);
+                timers[i].active = 0;
+            }
+        }
+        else
+        {
+            if (sys_timeouts_sleeptime() > model_next())
+            {
+                printf("FAIL %s: sleeptime %u is after the next expiry in %u ms\n", TIMEOUTS_NAME,
+                       (unsigned int)sys_timeouts_sleeptime(), (unsigned int)model_next());
+                failed = 1;
+            }
+            now += random_step();
+            sys_check_timeouts();
+            for (i = 0; i < MODEL_TIMERS; i++)
+            {
+                if (timers[i].active && ((s32_t)(now - timers[i].expires) >= 0))
+                {
+                    printf("FAIL %s: timer %d due at %u not fired at %u\n", TIMEOUTS_NAME, i,
+                           (unsigned int)timers[i].expires, (unsigned int)now);
+                    failed = 1;
+                    break;
+                }
+            }
+        }
+    }
+
+    /* Leave no model timers behind for the next run */
+    for (i = 0; i < MODEL_TIMERS; i++)
+    {
+        if (timers[i].active)
+        {
+            sys_untimeout(model_handler, (void *)(intptr_t)i);
+            timers[i].active = 0;
+        }
+    }
+}
+
+/* Re-arms itself like the protocol timers do */
+static void bench_handler(void *arg)
+{
+    sys_timeout(1U + (u32_t)rand() % 60000U, bench_handler, arg);
+    fired++;
+}
+
+static void bench_dummy(void *arg)
+{
+}
+
+static void benchmark(int count)
+{
+    uint64_t start;
+    uint64_t insert;
+    uint64_t cancel;
+    uint64_t tick;
+    int rounds = 2000;
+    int i;
+
+    for (i = 0; i < count; i++)
+    {
+        sys_timeout(1U + (u32_t)rand() % 60000U, bench_handler, (void *)(intptr_t)i);
+    }
+
+    /* Inserts and cancels with count timers pending */
+    insert = 0;
+    cancel = 0;
+    for (i = 0; i < rounds; i++)
+    {
+        u32_t delay = 1U + (u32_t)rand() % 60000U;
+
+        start = bench_cycles();
+        sys_timeout(delay, bench_dummy, NULL);
+        insert += bench_cycles() - start;
+
+        start = bench_cycles();
+        sys_untimeout(bench_dummy, NULL);
+        cancel += bench_cycles() - start;
+    }
+
+    /* 60 s of 1 ms ticks, every timer fires about once */
+    fired = 0;
+    start = bench_cycles();
+    for (i = 0; i < 60000; i++)
+    {
+        now++;
+        sys_check_timeouts();
+    }
+    tick = bench_cycles() - start;
+
+    printf("%-5s  %5d  %10.0f  %10.0f  %10.1f  %8lu\n", TIMEOUTS_NAME, count, (double)insert / rounds,
+           (double)cancel / rounds, (double)tick / 60000.0, fired);
+
+    for (i = 0; i < count; i++)
+    {
+        sys_untimeout(bench_handler, (void *)(intptr_t)i);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    static const int counts[] = {10, 100, 300, 1000};
+    unsigned long steps = (argc > 1) ? strtoul(argv[1], NULL, 0) : 100000UL;
+    size_t i;
+
+    srand(1);
+    lwip_init();
+
+    model_check(steps, 12345U);
+    /* Across the wraparound of the 32-bit time */
+    model_check(steps, 0xFFFFFFFFUL - 50000UL);
+    if (failed)
+    {
+        return 1;
+    }
+    printf("timeouts_test %s: %lu steps twice, %lu timers fired, none early or missed\n", TIMEOUTS_NAME, steps,
+           fired);
+
+    printf("%ss   count      insert      cancel  1 ms check     fired\n", BENCH_UNIT);
+    for (i = 0; i < LWIP_ARRAYSIZE(counts); i++)
+    {
+        benchmark(counts[i]);
+    }
+    return 0;
+}
@@ -0,0 +1,198 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * TCP bulk transfer between the nodes of the link simulator, see transfer.h.
+ */
+
+#include "transfer.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+#define PATTERN_SIZE 65536U
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+static uint8_t pattern[PATTERN_SIZE];
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+static void transfer_fill(struct transfer *transfer)
+{
+    struct tcp_pcb *pcb = transfer->client;
+
+    while (transfer->queued < transfer->bytes)
+    {
+        uint32_t offset = transfer->queued % PATTERN_SIZE;
+        uint32_t len    = transfer->bytes - transfer->queued;
+        u8_t flags      = TCP_WRITE_FLAG_COPY;
+
+        if (len > PATTERN_SIZE - offset)
+        {
+            len = PATTERN_SIZE - offset;
+        }
+        if (len > tcp_sndbuf(pcb))
+        {
+            len = tcp_sndbuf(pcb);
+        }
+        if (len == 0U)
+        {
+            break;
+        }
+        if (transfer->queued + len < transfer->bytes)
+        {
+            flags |= TCP_WRITE_FLAG_MORE;
+        }
+        if (tcp_write(pcb, &pattern[offset], (u16_t)len, flags) != ERR_OK)
+        {
+            break;
+        }
+        transfer->queued += len;
+    }
+
+    (void)tcp_output(pcb);
+}
+
+static err_t transfer_sent(void *arg, struct tcp_pcb *pcb, u16_t len)
+{
+    LWIP_UNUSED_ARG(pcb);
+    LWIP_UNUSED_ARG(len);
+
+    transfer_fill(arg);
+    return ERR_OK;
+}
+
+static err_t transfer_connected(void *arg, struct tcp_pcb *pcb, err_t err)
+{
+    LWIP_UNUSED_ARG(err);
+
+    tcp_sent(pcb, transfer_sent);
+    transfer_fill(arg);
+    return ERR_OK;
+}
+
+static err_t transfer_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err)
+{
+    struct transfer *transfer = arg;
+    struct pbuf *q;
+
+    LWIP_UNUSED_ARG(err);
+
+    if (p == NULL)
+    {
+        return ERR_OK;
+    }
+
+    for (q = p; q != NULL; q = q->next)
+    {
+        const uint8_t *data = q->payload;
+        u16_t i;
+
+        for (i = 0; transfer->verify && (i < q->len); i++)
+        {
+            if (data[i] != pattern[(transfer->received + i) % PATTERN_SIZE])
+            {
+                printf("FAIL byte %u received corrupted\n", (unsigned int)(transfer->received + i));
+                transfer->failed = 1;
+                transfer->verify = 0;
+            }
+        }
+        transfer->received += q->len;
+    }
+
+    tcp_recved(pcb, p->tot_len);
+    pbuf_free(p);
+    return ERR_OK;
+}
+
+static void transfer_error(void *arg, err_t err)
+{
+    struct transfer *transfer = arg;
+
+    printf("FAIL connection error %d\n", (int)err);
+    transfer->client = NULL;
+    transfer->failed = 1;
+}
+
+static err_t transfer_accept(void *arg, struct tcp_pcb *pcb, err_t err)
+{
+    struct transfer *transfer = arg;
+
+    LWIP_UNUSED_ARG(err);
+
+    transfer->server = pcb;
+    tcp_arg(pcb, transfer);
+    tcp_recv(pcb, transfer_recv);
+    return ERR_OK;
+}
+
+void transfer_start(struct transfer *transfer, enum netsim_node from, uint32_t bytes, int verify)
+{
+    struct netif *to = &netsim_netif[1 - from];
+    uint32_t i;
+
+    if (pattern[1] == 0U)
+    {
+        for (i = 0; i < PATTERN_SIZE; i++)
+        {
+            pattern[i] = (uint8_t)((i * 131U) ^ (i >> 8));
+        }
+    }
+
+    memset(transfer, 0, sizeof(*transfer));
+    transfer->bytes  = bytes;
+    transfer->verify = verify;
+
+    transfer->listener = tcp_new();
+    tcp_bind_netif(transfer->listener, to);
+    (void)tcp_bind(transfer->listener, netif_ip_addr4(to), TRANSFER_PORT);
+    transfer->listener = tcp_listen(transfer->listener);
+    tcp_arg(transfer->listener, transfer);
+    tcp_accept(transfer->listener, transfer_accept);
+
+    transfer->client = tcp_new();
+    tcp_arg(transfer->client, transfer);
+    tcp_err(transfer->client, transfer_error);
+    tcp_bind_netif(transfer->client, &netsim_netif[from]);
+    (void)tcp_connect(transfer->client, netif_ip_addr4(to), TRANSFER_PORT, transfer_connected);
+}
+
+int transfer_done(void *arg)
+{
+    const struct transfer *transfer = arg;
+
+    return transfer->failed || (transfer->received == transfer->bytes);
+}
+
+static void transfer_abort(struct tcp_pcb *pcb)
+{
+    if (pcb != NULL)
+    {
+        tcp_arg(pcb, NULL);
+        tcp_err(pcb, NULL);
+        tcp_abort(pcb);
+    }
+}
+
+void transfer_stop(struct transfer *transfer)
+{
+    transfer_abort(transfer->client);
+    transfer_abort(transfer->server);
+    (void)tcp_close(transfer->listener);
+    transfer->client   = NULL;
+    transfer->server   = NULL;
+    transfer->listener = NULL;
+}
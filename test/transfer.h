@@ -0,0 +1,47 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * TCP bulk transfer between the two nodes of the link simulator (netsim.h),
+ * shared by the host benchmarks. The sender keeps the send buffer full, the
+ * receiver consumes every segment at once and can check the data.
+ */
+
+#ifndef TRANSFER_H
+#define TRANSFER_H
+
+#include "netsim.h"
+
+#include "lwip/tcp.h"
+
+#include <stdint.h>
+
+#define TRANSFER_PORT 5001
+
+struct transfer
+{
+    struct tcp_pcb *listener;
+    struct tcp_pcb *client;
+    struct tcp_pcb *server;
+    uint32_t bytes;
+    uint32_t queued;
+    uint32_t received;
+    /* Check every received byte */
+    int verify;
+    int failed;
+};
+
+/* Starts sending bytes from node from to the other node */
+void transfer_start(struct transfer *transfer, enum netsim_node from, uint32_t bytes, int verify);
+
+/* netsim_run() condition: everything received or the transfer failed */
+int transfer_done(void *arg);
+
+/* Closes the connection and the listener */
+void transfer_stop(struct transfer *transfer);
+
+#endif /* TRANSFER_H */
@@ -0,0 +1,711 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Benchmark of the Wi-Fi TX flow control of low_level_output() in
+ * wifi/port/net/wifi_netif.c, over the WMM TX queue of wifi_host.h.
+ *
+ * With the queue full, low_level_output() returns ERR_MEM at once for a TCP
+ * segment, TCP keeps it unsent and handle_tx_queue_space() sends it again
+ * with tcp_txnow() when the driver frees a buffer. Other frames (UDP, DHCP,
+ * ARP) have no such resume, they still wait for a buffer, up to
+ * retry_attempts tries, sleeping 1 ms per try while the peer paused the link.
+ *
+ * The policy is checked frame by frame on a queue of 4 buffers first: TCP
+ * over IPv4 and IPv6 refused without a sleep, UDP and ARP sent once the
+ * driver frees a buffer, dropped after retry_attempts tries, sleeping only
+ * while paused, and the resume of TCP once a buffer is freed.
+ *
+ * Then the STA (A) sends a TCP bulk transfer to a peer (B) over a 20 Mbit/s
+ * link with a TX queue of TXQ_FRAMES frames, while the peer pauses the link
+ * periodically like a client in power save. A also sends a small UDP probe
+ * to B every PROBE_MS. The frames from B reach A through
+ * handle_data_packet(). The driver task runs for DRIVER_US whenever
+ * low_level_output() signals it. The benchmark reports the throughput, the
+ * TCP segments refused and resumed, the probes dropped, the time the tcpip
+ * thread slept per s and the longest time the queue stayed full. Every
+ * transfer checks its data, and fails if a TCP segment made the tcpip
+ * thread sleep.
+ *
+ * Usage: tx_backpressure_bench
+ */
+
+#include "wifi_host.h"
+
+/* The netif under test, for its statics */
+#include "wifi_netif.c"
+
+#include "lwip/priv/tcp_priv.h"
+#include "lwip/udp.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+#define TRANSFER_BYTES (1024U * 1024U)
+#define RUN_LIMIT_US   (60ULL * 1000000ULL)
+#define STEP_US        100U
+/* Frames the driver queues, below the TCP window so that the queue fills */
+#define TXQ_FRAMES     8U
+#define LINK_KBPS      20000U
+#define LINK_DELAY_US  3000U
+/* The driver task runs for this long when low_level_output() signals it */
+#define DRIVER_US      100U
+#define PROBE_MS       5U
+#define PROBE_PORT     7
+#define PROBE_LEN      64U
+#define TCP_PORT       5001
+#define LINK_FRAMES    256U
+#define FRAME_MAX      1514U
+
+struct sim_profile
+{
+    const char *name;
+    uint32_t pause_period_ms;
+    uint32_t pause_ms;
+};
+
+struct link_frame
+{
+    uint64_t due_us;
+    uint16_t len;
+    uint8_t data[FRAME_MAX];
+};
+
+/* Frames on the way in one direction */
+struct link_queue
+{
+    struct link_frame frames[LINK_FRAMES];
+    unsigned int head;
+    unsigned int count;
+    uint32_t drops;
+};
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+static const struct sim_profile profiles[] = {
+    {"no pause", 0, 0},
+    {"20/100 ms", 100, 20},
+    {"40/200 ms", 200, 40},
+};
+
+static const struct sim_profile *profile;
+
+static struct ethernetif sta_if = {.interface = MLAN_BSS_TYPE_STA};
+static struct netif sta_netif;
+static struct netif peer_netif;
+static const uint8_t peer_mac[ETH_HWADDR_LEN] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x02};
+
+static struct link_queue to_peer;
+static struct link_queue to_sta;
+static uint64_t link_next_us;
+static uint16_t link_last_len;
+
+static struct tcp_pcb *listener;
+static struct tcp_pcb *sender;
+static struct tcp_pcb *receiver;
+static uint8_t pattern[TCP_MSS * 4U + 256U];
+static uint32_t written;
+static uint32_t received;
+static bool connected;
+static bool failed;
+
+static struct udp_pcb *probe_tx;
+static struct udp_pcb *probe_rx;
+static bool probe_sending;
+static uint32_t probes_sent;
+static uint32_t probes_received;
+static uint32_t probes_refused;
+static uint32_t tcp_delays;
+
+/* Policy checks */
+static unsigned int unpause_after;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+static void link_queue_put(struct link_queue *queue, const uint8_t *data, uint16_t len)
+{
+    struct link_frame *frame;
+
+    if ((queue->count == LINK_FRAMES) || (len > FRAME_MAX))
+    {
+        queue->drops++;
+        return;
+    }
+    frame = &queue->frames[(queue->head + queue->count) % LINK_FRAMES];
+    (void)memcpy(frame->data, data, len);
+    frame->len    = len;
+    frame->due_us = wifi_host_time_us() + LINK_DELAY_US;
+    queue->count++;
+}
+
+static struct link_frame *link_queue_due(struct link_queue *queue)
+{
+    struct link_frame *frame = &queue->frames[queue->head];
+
+    if ((queue->count == 0U) || (frame->due_us > wifi_host_time_us()))
+    {
+        return NULL;
+    }
+    queue->head = (queue->head + 1U) % LINK_FRAMES;
+    queue->count--;
+    return frame;
+}
+
+/* A frame the driver took off the WMM queue */
+static void sta_frame_sent(const uint8_t *frame, uint16_t len)
+{
+    link_queue_put(&to_peer, frame, len);
+    link_last_len = len;
+}
+
+static err_t peer_linkoutput(struct netif *netif, struct pbuf *p)
+{
+    uint8_t frame[FRAME_MAX];
+    uint16_t len = p->tot_len;
+
+    if (len > FRAME_MAX)
+    {
+        return ERR_IF;
+    }
+    (void)pbuf_copy_partial(p, frame, len, 0);
+    link_queue_put(&to_sta, frame, len);
+    return ERR_OK;
+}
+
+/* Sends the frames of the WMM queue the link had time for, unless the peer paused it */
+static void link_run(void)
+{
+    uint64_t now_us = wifi_host_time_us();
+    uint32_t now_ms = (uint32_t)(now_us / 1000U);
+
+    wifi_host.tx_paused = (profile != NULL) && (profile->pause_ms != 0U) &&
+                          ((now_ms % profile->pause_period_ms) >= (profile->pause_period_ms - profile->pause_ms));
+    if (wifi_host.tx_paused)
+    {
+        link_next_us = now_us;
+        return;
+    }
+    while (link_next_us <= now_us)
+    {
+        if (wifi_host_tx_send(1) == 0U)
+        {
+            link_next_us = now_us;
+            break;
+        }
+        link_next_us += 50U + link_last_len * 8U * 1000U / LINK_KBPS;
+    }
+}
+
+/* The driver task took its turn */
+static void driver_run(void)
+{
+    wifi_host_advance_us(DRIVER_US);
+    link_run();
+}
+
+static void sleep_run(void)
+{
+    if (!probe_sending)
+    {
+        tcp_delays++;
+    }
+    link_run();
+}
+
+static void link_deliver(void)
+{
+    struct link_frame *frame;
+
+    while ((frame = link_queue_due(&to_peer)) != NULL)
+    {
+        struct pbuf *p = pbuf_alloc(PBUF_RAW, frame->len, PBUF_RAM);
+
+        if (p == NULL)
+        {
+            to_peer.drops++;
+            continue;
+        }
+        (void)pbuf_take(p, frame->data, frame->len);
+        if (peer_netif.input(p, &peer_netif) != ERR_OK)
+        {
+            (void)pbuf_free(p);
+        }
+    }
+    while ((frame = link_queue_due(&to_sta)) != NULL)
+    {
+        if (!wifi_host_rx_frame(MLAN_BSS_TYPE_STA, 0, frame->data, frame->len))
+        {
+            to_sta.drops++;
+        }
+    }
+}
+
+static void sender_fill(void)
+{
+    if ((sender == NULL) || !connected)
+    {
+        return;
+    }
+    while (written < TRANSFER_BYTES)
+    {
+        u16_t len = (u16_t)LWIP_MIN((uint32_t)tcp_sndbuf(sender), TRANSFER_BYTES - written);
+
+        len = (u16_t)LWIP_MIN(len, TCP_MSS * 4U);
+        if ((len == 0U) || (tcp_write(sender, &pattern[written % 256U], len, TCP_WRITE_FLAG_COPY) != ERR_OK))
+        {
+            break;
+        }
+        written += len;
+    }
+    (void)tcp_output(sender);
+}
+
+static err_t sender_sent(void *arg, struct tcp_pcb *pcb, u16_t len)
+{
+    sender_fill();
+    return ERR_OK;
+}
+
+static err_t sender_connected(void *arg, struct tcp_pcb *pcb, err_t err)
+{
+    connected = true;
+    sender_fill();
+    return ERR_OK;
+}
+
+static void sender_err(void *arg, err_t err)
+{
+    sender = NULL;
+    failed = true;
+    printf("FAIL %s: connection error %d\n", profile->name, (int)err);
+}
+
+static err_t receiver_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err)
+{
+    struct pbuf *q;
+    u16_t i;
+
+    if (p == NULL)
+    {
+        return ERR_OK;
+    }
+    for (q = p; q != NULL; q = q->next)
+    {
+        const uint8_t *data = q->payload;
+
+        for (i = 0; i < q->len; i++)
+        {
+            if (data[i] != (uint8_t)(received + i))
+            {
+                if (!failed)
+                {
+                    printf("FAIL %s: byte %u changed\n", profile->name, (unsigned int)(received + i));
+                }
+                failed = true;
+                break;
+            }
+        }
+        received += q->len;
+    }
+    tcp_recved(pcb, p->tot_len);
+    (void)pbuf_free(p);
+    return ERR_OK;
+}
+
+static err_t receiver_accept(void *arg, struct tcp_pcb *pcb, err_t err)
+{
+    if ((err != ERR_OK) || (pcb == NULL))
+    {
+        return ERR_VAL;
+    }
+    receiver = pcb;
+    tcp_recv(pcb, receiver_recv);
+    return ERR_OK;
+}
+
+static void probe_send(void)
+{
+    struct pbuf *p = pbuf_alloc(PBUF_TRANSPORT, PROBE_LEN, PBUF_RAM);
+
+    if (p == NULL)
+    {
+        probes_refused++;
+        return;
+    }
+    (void)memset(p->payload, 0, PROBE_LEN);
+    probe_sending = true;
+    if (udp_sendto(probe_tx, p, netif_ip_addr4(&peer_netif), PROBE_PORT) != ERR_OK)
+    {
+        probes_refused++;
+    }
+    probe_sending = false;
+    probes_sent++;
+    (void)pbuf_free(p);
+}
+
+static void probe_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr, u16_t port)
+{
+    probes_received++;
+    (void)pbuf_free(p);
+}
+
+/* Runs the link until nothing is on the way */
+static void links_settle(void)
+{
+    wifi_host.tx_paused = false;
+    while ((to_peer.count > 0U) || (to_sta.count > 0U) || (wifi_host_tx_queued() > 0U))
+    {
+        wifi_host_advance_us(STEP_US);
+        link_run();
+        link_deliver();
+        (void)wifi_host_tcpip_poll();
+    }
+}
+
+static void links_reset(void)
+{
+    (void)memset(&to_peer, 0, sizeof(to_peer));
+    (void)memset(&to_sta, 0, sizeof(to_sta));
+    link_next_us  = wifi_host_time_us();
+    link_last_len = 0;
+}
+
+/* Runs one transfer, returns the time it took in us or 0 if it failed */
+static uint64_t transfer_run(const struct sim_profile *run_profile)
+{
+    uint64_t start_us;
+    uint64_t next_probe_us;
+    uint64_t time_us = 0;
+
+    profile               = run_profile;
+    wifi_host.tx_bufs     = TXQ_FRAMES;
+    wifi_host.tx_event_fn = driver_run;
+    wifi_host.delay_fn    = sleep_run;
+    wifi_host.tx_frame_fn = sta_frame_sent;
+    wifi_host_reset();
+    links_reset();
+    (void)memset(&tx_flow_stats, 0, sizeof(tx_flow_stats));
+    written         = 0;
+    received        = 0;
+    connected       = false;
+    failed          = false;
+    probes_sent     = 0;
+    probes_received = 0;
+    probes_refused  = 0;
+    tcp_delays      = 0;
+
+    sender = tcp_new();
+    tcp_bind_netif(sender, &sta_netif);
+    (void)tcp_bind(sender, netif_ip_addr4(&sta_netif), 0);
+    tcp_sent(sender, sender_sent);
+    tcp_err(sender, sender_err);
+    (void)tcp_connect(sender, netif_ip_addr4(&peer_netif), TCP_PORT, sender_connected);
+
+    start_us      = wifi_host_time_us();
+    next_probe_us = start_us + PROBE_MS * 1000U;
+    while (!failed && (received < TRANSFER_BYTES) && (wifi_host_time_us() - start_us < RUN_LIMIT_US))
+    {
+        wifi_host_advance_us(STEP_US);
+        link_run();
+        link_deliver();
+        (void)wifi_host_tcpip_poll();
+        if (wifi_host_time_us() >= next_probe_us)
+        {
+            next_probe_us += PROBE_MS * 1000U;
+            probe_send();
+        }
+    }
+    if (!failed && (received < TRANSFER_BYTES))
+    {
+        printf("FAIL %s: %u of %u bytes received\n", profile->name, (unsigned int)received, TRANSFER_BYTES);
+        failed = true;
+    }
+    if (!failed)
+    {
+        time_us = wifi_host_time_us() - start_us;
+    }
+
+    /* No FIN handshake, the next run starts from empty queues */
+    if (sender != NULL)
+    {
+        tcp_err(sender, NULL);
+        tcp_abort(sender);
+        sender = NULL;
+    }
+    if (receiver != NULL)
+    {
+        tcp_abort(receiver);
+        receiver = NULL;
+    }
+    profile = NULL;
+    links_settle();
+
+    if ((time_us != 0U) && (tcp_delays != 0U))
+    {
+        printf("FAIL %s: TCP made the tcpip thread sleep %u times\n", run_profile->name, (unsigned int)tcp_delays);
+        time_us = 0;
+    }
+    if ((time_us != 0U) && ((wifi_host.rx_errors != 0U) || (wifi_host_rx_held() != 0U)))
+    {
+        printf("FAIL %s: %u rx buffers released out of turn, %u still held\n", run_profile->name,
+               (unsigned int)wifi_host.rx_errors, wifi_host_rx_held());
+        time_us = 0;
+    }
+    return time_us;
+}
+
+/* A frame of 64 bytes from the STA to the peer */
+static struct pbuf *policy_frame(uint16_t type, uint8_t proto)
+{
+    struct pbuf *p = pbuf_alloc(PBUF_RAW, 64, PBUF_RAM);
+    uint8_t *frame = p->payload;
+
+    (void)memset(frame, 0, 64);
+    (void)memcpy(&frame[0], peer_mac, ETH_HWADDR_LEN);
+    (void)memcpy(&frame[6], sta_netif.hwaddr, ETH_HWADDR_LEN);
+    frame[12] = (uint8_t)(type >> 8);
+    frame[13] = (uint8_t)type;
+    if (type == ETHTYPE_IP)
+    {
+        frame[SIZEOF_ETH_HDR]      = 0x45;
+        frame[SIZEOF_ETH_HDR + 9U] = proto;
+    }
+    else if (type == ETHTYPE_IPV6)
+    {
+        frame[SIZEOF_ETH_HDR]      = 0x60;
+        frame[SIZEOF_ETH_HDR + 6U] = proto;
+    }
+    return p;
+}
+
+static err_t policy_output(uint16_t type, uint8_t proto)
+{
+    struct pbuf *p = policy_frame(type, proto);
+    err_t err      = sta_netif.linkoutput(&sta_netif, p);
+
+    (void)pbuf_free(p);
+    return err;
+}
+
+/* Frees one buffer per driver run */
+static void policy_drain(void)
+{
+    (void)wifi_host_tx_send(1);
+}
+
+static void policy_unpause(void)
+{
+    if (wifi_host.delays == unpause_after)
+    {
+        wifi_host.tx_paused = false;
+    }
+}
+
+/* Fills a queue of 4 buffers and clears the counters */
+static void policy_fill(void)
+{
+    wifi_host.tx_paused   = false;
+    wifi_host.tx_event_fn = NULL;
+    wifi_host.delay_fn    = NULL;
+    wifi_host.tx_frame_fn = NULL;
+    wifi_host.tx_bufs     = 4;
+    wifi_host_reset();
+    while (wifi_host_tx_queued() < 4U)
+    {
+        (void)policy_output(ETHTYPE_IP, IP_PROTO_UDP);
+    }
+    wifi_host_clear_counters();
+}
+
+#define POLICY_CHECK(cond, what)        \
+    do                                  \
+    {                                   \
+        if (!(cond))                    \
+        {                               \
+            printf("FAIL %s\n", what);  \
+            return 0;                   \
+        }                               \
+    } while (0)
+
+static int policy_check(void)
+{
+    struct net_tx_flow_stats stats;
+
+    policy_fill();
+    POLICY_CHECK(policy_output(ETHTYPE_IP, IP_PROTO_TCP) == ERR_MEM, "TCP sent on a full queue");
+    POLICY_CHECK((wifi_host.delays == 0U) && (wifi_host.tx_events == 1U) && (wifi_host.tx_retried_drops == 1U),
+                 "TCP waited on a full queue");
+    POLICY_CHECK(policy_output(ETHTYPE_IPV6, IP_PROTO_TCP) == ERR_MEM, "TCP over IPv6 sent on a full queue");
+    POLICY_CHECK((wifi_host.delays == 0U) && (wifi_host.tx_events == 2U), "TCP over IPv6 waited on a full queue");
+
+    /* The driver frees a buffer, TCP is resumed in the tcpip thread */
+    net_tx_flow_stats(&stats);
+    POLICY_CHECK(wifi_host_tx_send(1) == 1U, "no frame sent");
+    POLICY_CHECK(wifi_host.tx_resumes == 1U, "no resume on a freed buffer");
+    POLICY_CHECK(wifi_host_tcpip_poll() == 1U, "net_tx_resume() not posted");
+    net_tx_flow_stats(&stats);
+    POLICY_CHECK(stats.resumes >= 1U, "net_tx_resume() did not run");
+
+    policy_fill();
+    POLICY_CHECK(policy_output(ETHTYPE_IP, IP_PROTO_UDP) == ERR_MEM, "UDP sent on a full queue");
+    POLICY_CHECK((wifi_host.tx_events == 1U + (uint32_t)retry_attempts) && (wifi_host.delays == 0U) &&
+                     (wifi_host.tx_retried_drops == 1U),
+                 "UDP not retried retry_attempts times without sleeping");
+
+    policy_fill();
+    wifi_host.tx_event_fn = policy_drain;
+    POLICY_CHECK(policy_output(ETHTYPE_ARP, 0) == ERR_OK, "ARP dropped while the driver frees buffers");
+    POLICY_CHECK(wifi_host.tx_frames == 1U, "ARP not queued");
+
+    policy_fill();
+    wifi_host.tx_event_fn = NULL;
+    wifi_host.tx_paused   = true;
+    POLICY_CHECK(policy_output(ETHTYPE_IP, IP_PROTO_UDP) == ERR_MEM, "UDP sent on a paused link");
+    POLICY_CHECK((wifi_host.delays == (uint32_t)retry_attempts) && (wifi_host.tx_pause_drops == 1U),
+                 "UDP did not sleep retry_attempts times on a paused link");
+
+    policy_fill();
+    wifi_host.tx_paused = true;
+    POLICY_CHECK(policy_output(ETHTYPE_IP, IP_PROTO_TCP) == ERR_MEM, "TCP sent on a paused link");
+    POLICY_CHECK((wifi_host.delays == 0U) && (wifi_host.tx_pause_drops == 1U), "TCP slept on a paused link");
+
+    policy_fill();
+    wifi_host.tx_paused   = true;
+    wifi_host.tx_event_fn = policy_drain;
+    wifi_host.delay_fn    = policy_unpause;
+    unpause_after         = 3;
+    POLICY_CHECK(policy_output(ETHTYPE_IP, IP_PROTO_UDP) == ERR_OK, "UDP dropped after the pause");
+    POLICY_CHECK(wifi_host.delays == 3U, "UDP did not sleep through the pause");
+
+    policy_fill();
+    return 1;
+}
+
+static err_t sta_netif_init(struct netif *netif)
+{
+    /* lwip_netif_init() without low_level_init() */
+    netif->state      = &sta_if;
+    netif->output     = etharp_output;
+    netif->linkoutput = low_level_output;
+    netif->output_ip6 = ethip6_output;
+    sta_if.ethaddr    = (struct eth_addr *)(void *)&netif->hwaddr[0];
+    (void)wlan_get_mac_address(netif->hwaddr);
+    netif->hwaddr_len = ETH_HWADDR_LEN;
+    netif->mtu        = 1500;
+    netif->flags      = NETIF_FLAG_BROADCAST | NETIF_FLAG_ETHARP;
+    register_interface(netif, MLAN_BSS_TYPE_STA);
+    return ERR_OK;
+}
+
+static err_t peer_netif_init(struct netif *netif)
+{
+    netif->output     = etharp_output;
+    netif->linkoutput = peer_linkoutput;
+    (void)memcpy(netif->hwaddr, peer_mac, ETH_HWADDR_LEN);
+    netif->hwaddr_len = ETH_HWADDR_LEN;
+    netif->mtu        = 1500;
+    netif->flags      = NETIF_FLAG_BROADCAST | NETIF_FLAG_ETHARP;
+    return ERR_OK;
+}
+
+static void netifs_setup(void)
+{
+    ip4_addr_t addr;
+    ip4_addr_t mask;
+    unsigned int i;
+
+    IP4_ADDR(&mask, 255, 255, 255, 0);
+    IP4_ADDR(&addr, 10, 0, 0, 2);
+    (void)netif_add(&sta_netif, &addr, &mask, IP4_ADDR_ANY4, NULL, sta_netif_init, tcpip_input);
+    IP4_ADDR(&addr, 10, 0, 0, 3);
+    (void)netif_add(&peer_netif, &addr, &mask, IP4_ADDR_ANY4, NULL, peer_netif_init, ethernet_input);
+    netif_set_up(&sta_netif);
+    netif_set_link_up(&sta_netif);
+    netif_set_up(&peer_netif);
+    netif_set_link_up(&peer_netif);
+
+    /* Both ends are in this stack, each one only talks through its netif */
+    listener = tcp_new();
+    tcp_bind_netif(listener, &peer_netif);
+    (void)tcp_bind(listener, netif_ip_addr4(&peer_netif), TCP_PORT);
+    listener = tcp_listen(listener);
+    tcp_accept(listener, receiver_accept);
+
+    probe_tx = udp_new();
+    udp_bind_netif(probe_tx, &sta_netif);
+    (void)udp_bind(probe_tx, netif_ip_addr4(&sta_netif), 0);
+    probe_rx = udp_new();
+    udp_bind_netif(probe_rx, &peer_netif);
+    (void)udp_bind(probe_rx, netif_ip_addr4(&peer_netif), PROBE_PORT);
+    udp_recv(probe_rx, probe_recv, NULL);
+
+    for (i = 0; i < sizeof(pattern); i++)
+    {
+        pattern[i] = (uint8_t)i;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    size_t i;
+
+    wifi_host_init();
+    netifs_setup();
+
+    if (!policy_check())
+    {
+        return 1;
+    }
+
+    /* Resolve the peer first, a SYN sent before the ARP reply would wait for its retransmission */
+    wifi_host.tx_bufs     = TXQ_FRAMES;
+    wifi_host.tx_frame_fn = sta_frame_sent;
+    links_reset();
+    (void)etharp_request(&sta_netif, netif_ip4_addr(&peer_netif));
+    links_settle();
+
+    printf("%u KB from the STA to the peer, TX queue %u frames, %u Mbit/s, probe every %u ms, %d tries\n",
+           TRANSFER_BYTES / 1024U, TXQ_FRAMES, LINK_KBPS / 1000U, PROBE_MS, retry_attempts);
+    printf("pause       Mbit/s  TCP refused  resumed  probes dropped  slept ms/s  queue full max ms\n");
+
+    for (i = 0; i < sizeof(profiles) / sizeof(profiles[0]); i++)
+    {
+        uint64_t time_us = transfer_run(&profiles[i]);
+
+        if (time_us == 0U)
+        {
+            return 1;
+        }
+        if ((profiles[i].pause_ms != 0U) && (tx_flow_stats.full[WMM_AC_BE] == 0U || tx_flow_stats.resumes == 0U))
+        {
+            printf("FAIL %s: the TX queue never filled\n", profiles[i].name);
+            return 1;
+        }
+        /* Probes wait out pauses shorter than retry_attempts sleeps */
+        if ((profiles[i].pause_ms < (uint32_t)retry_attempts) && (probes_refused != 0U))
+        {
+            printf("FAIL %s: %u probes dropped\n", profiles[i].name, (unsigned int)probes_refused);
+            return 1;
+        }
+
+        printf("%-10s %7.2f %12u %8u %9u of %-4u %10.1f %18u\n", profiles[i].name,
+               (double)TRANSFER_BYTES * 8.0 / (double)time_us, (unsigned int)tx_flow_stats.full[WMM_AC_BE],
+               (unsigned int)tx_flow_stats.resumes, (unsigned int)probes_refused, (unsigned int)probes_sent,
+               1e6 * wifi_host.delay_ms / (double)time_us, (unsigned int)tx_flow_stats.stall_ms_max);
+    }
+
+    return 0;
+}
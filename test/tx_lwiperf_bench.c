@@ -0,0 +1,232 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * TX benchmark over the two-node simulator (netsim.h).
+ *
+ * Node A sends to node B with the lwiperf TCP client, which queues its data
+ * from a constant buffer without copying (PBUF_ROM), to the lwiperf server
+ * on B, and with the bulk transfer of transfer.c, which lets tcp_write()
+ * copy the data like the MQTT and HTTP code does. For every frame A sends,
+ * the simulator checks whether the Wi-Fi driver could build its headers in
+ * the headroom and queue the frame in place, or has to copy it.
+ *
+ * The benchmark reports the throughput, the share of frames sent in place
+ * and the bytes the driver copies per MB sent. It is built with the TX
+ * options of the board (LWIP_NETIF_TX_SINGLE_PBUF, 38 bytes of
+ * PBUF_LINK_ENCAPSULATION_HLEN), where every frame has to go in place, and
+ * as tx_lwiperf_bench_chained with the previous options, where segments are
+ * chained and have no room for the driver headers.
+ *
+ * Usage: tx_lwiperf_bench [seconds]
+ */
+
+#include "transfer.h"
+
+#include "lwip/apps/lwiperf.h"
+#include "lwip/priv/tcp_priv.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+#define RUN_LIMIT_US (600ULL * 1000000ULL)
+
+struct sim_profile
+{
+    const char *name;
+    struct netsim_profile link;
+};
+
+struct iperf_result
+{
+    int done;
+    uint64_t bytes;
+    uint32_t kbps;
+};
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+/* 20 Mbit/s, 3 ms one way plus up to 2 ms jitter, 64 KB queue */
+#define WIFI_LINK(loss) \
+    {.rate_kbps = 20000, .delay_us = 3000, .jitter_us = 2000, .loss_ppm = (loss), .queue_bytes = 65536}
+
+static const struct sim_profile profiles[] = {
+    {"clean", WIFI_LINK(0)},
+    {"loss 1%", WIFI_LINK(10000)},
+};
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+static void iperf_report(void *arg,
+                         enum lwiperf_report_type report_type,
+                         const ip_addr_t *local_addr,
+                         u16_t local_port,
+                         const ip_addr_t *remote_addr,
+                         u16_t remote_port,
+                         u64_t bytes_transferred,
+                         u32_t ms_duration,
+                         u32_t bandwidth_kbitpsec)
+{
+    struct iperf_result *result = arg;
+
+    LWIP_UNUSED_ARG(local_addr);
+    LWIP_UNUSED_ARG(local_port);
+    LWIP_UNUSED_ARG(remote_addr);
+    LWIP_UNUSED_ARG(remote_port);
+    LWIP_UNUSED_ARG(ms_duration);
+
+    /* Closing the listener reports again */
+    if (result->done)
+    {
+        return;
+    }
+
+    if (report_type != LWIPERF_TCP_DONE_SERVER_RX)
+    {
+        printf("FAIL lwiperf server report %d\n", (int)report_type);
+        result->kbps = 0;
+    }
+    else
+    {
+        result->bytes = bytes_transferred;
+        result->kbps  = bandwidth_kbitpsec;
+    }
+    result->done = 1;
+}
+
+static int iperf_done(void *arg)
+{
+    return ((const struct iperf_result *)arg)->done;
+}
+
+/* Runs lwiperf from A to B for seconds, returns the throughput in kbit/s or 0 */
+static uint32_t iperf_run(int seconds, uint64_t *bytes)
+{
+    struct iperf_result result = {0};
+    void *server;
+    void *client;
+
+    *bytes = 0;
+
+    server = lwiperf_start_tcp_server(&netsim_netif[NETSIM_B].ip_addr, LWIPERF_TCP_PORT_DEFAULT, iperf_report,
+                                      &result);
+    client = lwiperf_start_tcp_client(&netsim_netif[NETSIM_B].ip_addr, LWIPERF_TCP_PORT_DEFAULT, LWIPERF_CLIENT,
+                                      -seconds * 100, 0, 0, NULL, NULL);
+    if ((server == NULL) || (client == NULL))
+    {
+        printf("FAIL lwiperf not started\n");
+        return 0;
+    }
+
+    if (!netsim_run(netsim_time_us() + RUN_LIMIT_US, iperf_done, &result))
+    {
+        printf("FAIL lwiperf did not finish\n");
+        result.kbps = 0;
+    }
+
+    lwiperf_abort(client);
+    lwiperf_abort(server);
+    /* Lets the connection leave TIME_WAIT, the next run starts from the same seed and port */
+    (void)netsim_run(netsim_time_us() + 2ULL * TCP_MSL * 1000U + 1000000U, NULL, NULL);
+    *bytes = result.bytes;
+    return result.kbps;
+}
+
+/* Sends the bytes lwiperf sent with a copying application, returns the throughput in kbit/s or 0 */
+static uint32_t transfer_run(uint32_t bytes)
+{
+    struct transfer transfer;
+    uint64_t start_us = netsim_time_us();
+    uint32_t kbps     = 0;
+
+    transfer_start(&transfer, NETSIM_A, bytes, 1);
+    if (netsim_run(start_us + RUN_LIMIT_US, transfer_done, &transfer) && !transfer.failed)
+    {
+        kbps = (uint32_t)((uint64_t)bytes * 8000U / (netsim_time_us() - start_us));
+    }
+    else if (!transfer.failed)
+    {
+        printf("FAIL transfer: %u of %u bytes received\n", (unsigned int)transfer.received, (unsigned int)bytes);
+    }
+    transfer_stop(&transfer);
+
+    return kbps;
+}
+
+static int tx_print(const char *profile, const char *sender, uint32_t kbps)
+{
+    const struct netsim_link_stats *stats = netsim_link_stats(NETSIM_A);
+    uint32_t frames                       = stats->tx_in_place + stats->tx_copied;
+
+    if (kbps == 0U)
+    {
+        return 0;
+    }
+
+    printf("%-8s %-8s %7.2f %7u %10.1f %13.1f\n", profile, sender, kbps / 1000.0, (unsigned int)frames,
+           100.0 * stats->tx_in_place / frames, stats->tx_copied_bytes / 1024.0 / (stats->bytes / 1048576.0));
+
+#if LWIP_NETIF_TX_SINGLE_PBUF && (PBUF_LINK_ENCAPSULATION_HLEN >= NETSIM_TX_DRIVER_HLEN)
+    if (stats->tx_copied != 0U)
+    {
+        printf("FAIL %s %s: %u frames without room for the driver headers\n", profile, sender,
+               (unsigned int)stats->tx_copied);
+        return 0;
+    }
+#endif
+
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    int seconds = (argc > 1) ? atoi(argv[1]) : 10;
+    size_t i;
+
+    if ((seconds < 1) || (seconds > 600))
+    {
+        printf("seconds: 1 to 600\n");
+        return 1;
+    }
+
+    netsim_init();
+
+    printf("A to B for %d s, LWIP_NETIF_TX_SINGLE_PBUF %d, PBUF_LINK_ENCAPSULATION_HLEN %d\n", seconds,
+           LWIP_NETIF_TX_SINGLE_PBUF, PBUF_LINK_ENCAPSULATION_HLEN);
+    printf("profile  sender    Mbit/s  frames  in place %%  copied KB/MB\n");
+
+    for (i = 0; i < sizeof(profiles) / sizeof(profiles[0]); i++)
+    {
+        uint64_t bytes;
+
+        netsim_reset(1);
+        netsim_set_profile(NETSIM_A, &profiles[i].link);
+        netsim_set_profile(NETSIM_B, &profiles[i].link);
+        if (!tx_print(profiles[i].name, "lwiperf", iperf_run(seconds, &bytes)))
+        {
+            return 1;
+        }
+
+        netsim_reset(1);
+        netsim_set_profile(NETSIM_A, &profiles[i].link);
+        netsim_set_profile(NETSIM_B, &profiles[i].link);
+        if (!tx_print(profiles[i].name, "copy", transfer_run((uint32_t)bytes)))
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,661 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Host stand-ins around wifi/port/net/wifi_netif.c, see wifi_host.h.
+ */
+
+#include "wifi_host.h"
+
+#include <netif_decl.h>
+
+#include "event_trace.h"
+#include "netif_capture.h"
+
+#include "lwip/init.h"
+#include "lwip/tcpip.h"
+#include "lwip/timeouts.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+#define TCPIP_CALLS 16U
+
+/* Ethernet frame behind the driver headers of an outbuf, see low_level_output() */
+#define TX_FRAME_OFFSET (sizeof(mlan_linked_list) + INTF_HEADER_LEN + sizeof(TxPD))
+
+enum rx_buf_state
+{
+    RX_BUF_FREE = 0,
+    RX_BUF_IN_HANDLER,
+    RX_BUF_HELD,
+};
+
+struct tcpip_call
+{
+    tcpip_callback_fn fn;
+    void *ctx;
+};
+
+/* Outbuf in the TX queue */
+struct tx_entry
+{
+    uint8_t *outbuf;
+    uint16_t len;
+    /* Built in the headroom of a pbuf (wifi_wmm_buf_put_mem()), the pbuf is freed once sent */
+    bool ext;
+};
+
+/* Defined by wifi_netif.c, registered with wifi_register_tx_resume_callback() on the board */
+void handle_tx_queue_space(t_u32 full_mask);
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+struct wifi_host wifi_host;
+
+mlan_adapter *mlan_adap;
+
+/* Set by wlan_init() on the board with wifi_set_packet_retry_count(MAX_RETRY_TICKS) */
+int retry_attempts = 50;
+
+t_u8 wifi_tx_status = WIFI_DATA_RUNNING;
+t_u8 wifi_tx_block_cnt;
+
+static mlan_adapter adapter;
+static mlan_private privs[2];
+static t_u8 sta_mac[MLAN_MAC_ADDR_LENGTH] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+static t_u8 uap_mac[MLAN_MAC_ADDR_LENGTH] = {0x02, 0x00, 0x00, 0x00, 0x01, 0x01};
+
+static uint64_t now_us;
+
+static struct tcpip_call tcpip_calls[TCPIP_CALLS];
+static unsigned int tcpip_call_count;
+
+SDK_ALIGN(static uint8_t rx_bufs[WIFI_HOST_RX_BUFS][WIFI_HOST_RX_BUF_SIZE], 32);
+static uint8_t rx_buf_state[WIFI_HOST_RX_BUFS];
+
+static outbuf_t tx_mem[WIFI_HOST_TX_BUFS];
+static bool tx_mem_used[WIFI_HOST_TX_BUFS];
+static struct tx_entry tx_queue[WIFI_HOST_TX_BUFS];
+static unsigned int tx_head;
+static unsigned int tx_count;
+/* Outbufs handed out and not yet sent */
+static unsigned int tx_slots;
+/* The next outbuf queued is in the headroom of a pbuf */
+static bool tx_next_ext;
+/* wifi_wmm_tx_full() found the queue full, the next free buffer resumes the senders */
+static bool tx_full_seen;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+/* OS and lwIP port */
+
+int DbgConsole_Printf(const char *fmt_s, ...)
+{
+    va_list ap;
+    int n;
+
+    va_start(ap, fmt_s);
+    n = vprintf(fmt_s, ap);
+    va_end(ap);
+    return n;
+}
+
+void *OSA_MemoryAllocate(uint32_t memLength)
+{
+    return calloc(1, memLength);
+}
+
+void OSA_MemoryFree(void *p)
+{
+    free(p);
+}
+
+void OSA_TimeDelay(uint32_t millisec)
+{
+    wifi_host.delays++;
+    wifi_host.delay_ms += millisec;
+    now_us += (uint64_t)millisec * 1000U;
+    if (wifi_host.delay_fn != NULL)
+    {
+        wifi_host.delay_fn();
+    }
+}
+
+void *pvPortMallocTagged(size_t xWantedSize, uint8_t ucTag)
+{
+    return malloc(xWantedSize);
+}
+
+void *pvPortCallocTagged(size_t xNum, size_t xSize, uint8_t ucTag)
+{
+    return calloc(xNum, xSize);
+}
+
+void vPortFree(void *pv)
+{
+    free(pv);
+}
+
+void vPortYield(void)
+{
+    wifi_host.yields++;
+}
+
+void sys_init(void)
+{
+}
+
+sys_prot_t sys_arch_protect(void)
+{
+    return 0;
+}
+
+void sys_arch_unprotect(sys_prot_t pval)
+{
+}
+
+void sys_check_core_locking(void)
+{
+}
+
+void sys_assert(const char *pcMessage)
+{
+    printf("FAIL assert: %s\n", pcMessage);
+    exit(1);
+}
+
+u32_t sys_now(void)
+{
+    return (u32_t)(now_us / 1000U);
+}
+
+uint32_t sys_now_us(void)
+{
+    return (uint32_t)now_us;
+}
+
+u32_t lwip_rand(void)
+{
+    return (u32_t)rand();
+}
+
+err_t tcpip_input(struct pbuf *p, struct netif *inp)
+{
+    return ethernet_input(p, inp);
+}
+
+err_t tcpip_try_callback(tcpip_callback_fn function, void *ctx)
+{
+    if (tcpip_call_count == TCPIP_CALLS)
+    {
+        return ERR_MEM;
+    }
+    tcpip_calls[tcpip_call_count].fn  = function;
+    tcpip_calls[tcpip_call_count].ctx = ctx;
+    tcpip_call_count++;
+    return ERR_OK;
+}
+
+void event_trace_add(uint32_t type, uint32_t id, uint32_t arg)
+{
+}
+
+void netif_capture(const struct pbuf *p, enum netif_capture_dir dir)
+{
+}
+
+/* Wi-Fi driver */
+
+static mlan_status host_malloc(t_void *pmoal_handle, t_u32 size, t_u32 flag, t_u8 **ppbuf)
+{
+    *ppbuf = calloc(1, size);
+    return (*ppbuf != NULL) ? MLAN_STATUS_SUCCESS : MLAN_STATUS_FAILURE;
+}
+
+static mlan_status host_mfree(t_void *pmoal_handle, t_u8 *pbuf)
+{
+    free(pbuf);
+    return MLAN_STATUS_SUCCESS;
+}
+
+static mlan_status host_init_timer(t_void *pmoal_handle, t_void *ptimer, t_void (*callback)(osa_timer_arg_t arg),
+                                   t_void *pcontext)
+{
+    return MLAN_STATUS_SUCCESS;
+}
+
+static mlan_status host_timer(t_void *pmoal_handle, t_void *ptimer)
+{
+    return MLAN_STATUS_SUCCESS;
+}
+
+static mlan_status host_start_timer(t_void *pmoal_handle, t_void *ptimer, bool periodic, t_u32 msec)
+{
+    return MLAN_STATUS_SUCCESS;
+}
+
+static mlan_status host_lock(t_void *pmoal_handle, t_void *plock)
+{
+    return MLAN_STATUS_SUCCESS;
+}
+
+int wlan_get_mac_address(uint8_t *dest)
+{
+    (void)memcpy(dest, sta_mac, MLAN_MAC_ADDR_LENGTH);
+    return WM_SUCCESS;
+}
+
+int wlan_get_mac_address_uap(uint8_t *dest)
+{
+    (void)memcpy(dest, uap_mac, MLAN_MAC_ADDR_LENGTH);
+    return WM_SUCCESS;
+}
+
+int wifi_add_mcast_filter(uint8_t *mac_addr)
+{
+    return WM_SUCCESS;
+}
+
+int wifi_remove_mcast_filter(uint8_t *mac_addr)
+{
+    return WM_SUCCESS;
+}
+
+void wifi_get_ipv4_multicast_mac(uint32_t ipaddr, uint8_t *mac_addr)
+{
+    (void)memset(mac_addr, 0, MLAN_MAC_ADDR_LENGTH);
+}
+
+void wifi_get_ipv6_multicast_mac(uint32_t ipaddr, uint8_t *mac_addr)
+{
+    (void)memset(mac_addr, 0, MLAN_MAC_ADDR_LENGTH);
+}
+
+int wifi_event_completion(enum wifi_event event, enum wifi_event_reason result, void *data)
+{
+    return -WM_FAIL;
+}
+
+mlan_status wlan_bypass_802dot11_mgmt_pkt(void *data)
+{
+    return MLAN_STATUS_FAILURE;
+}
+
+bool get_monitor_flag(void)
+{
+    return false;
+}
+
+void user_recv_monitor_data(const t_u8 *rcvdata)
+{
+}
+
+void wrapper_wlan_update_uap_rxrate_info(RxPD *rxpd)
+{
+}
+
+/* No block ack stream, the frame goes up at once, see wifi_host.rx_packet_fn */
+int wrapper_wlan_handle_rx_packet(t_u16 datalen, RxPD *rxpd, void *p, void *payload)
+{
+    if (wifi_host.rx_packet_fn != NULL)
+    {
+        return wifi_host.rx_packet_fn(datalen, rxpd, p, payload);
+    }
+    handle_deliver_packet_above(rxpd, rxpd->bss_type, p);
+    return WM_SUCCESS;
+}
+
+/* IMU rx buffers */
+
+static int rx_buf_index(const t_u8 *buf)
+{
+    unsigned int i;
+
+    for (i = 0; i < WIFI_HOST_RX_BUFS; i++)
+    {
+        if (buf == rx_bufs[i])
+        {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+void wifi_imu_rx_buf_hold(const t_u8 *buf)
+{
+    int i = rx_buf_index(buf);
+
+    if ((i < 0) || (rx_buf_state[i] != RX_BUF_IN_HANDLER))
+    {
+        wifi_host.rx_errors++;
+        return;
+    }
+    rx_buf_state[i] = RX_BUF_HELD;
+    wifi_host.rx_holds++;
+}
+
+void wifi_imu_rx_buf_release(const t_u8 *buf)
+{
+    int i = rx_buf_index(buf);
+
+    if ((i < 0) || (rx_buf_state[i] != RX_BUF_HELD))
+    {
+        wifi_host.rx_errors++;
+        return;
+    }
+    rx_buf_state[i] = RX_BUF_FREE;
+    wifi_host.rx_releases++;
+}
+
+int wifi_host_rx_frame(t_u8 interface, t_u16 pkt_type, const uint8_t *frame, uint16_t len)
+{
+    unsigned int i;
+    uint8_t *buf;
+    RxPD *rxpd;
+    uint16_t datalen = (uint16_t)(INTF_HEADER_LEN + sizeof(RxPD) + len);
+    uint64_t start;
+
+    for (i = 0; (i < WIFI_HOST_RX_BUFS) && (rx_buf_state[i] != RX_BUF_FREE); i++)
+    {
+    }
+    if ((i == WIFI_HOST_RX_BUFS) || (datalen + 32U > WIFI_HOST_RX_BUF_SIZE))
+    {
+        return 0;
+    }
+
+    buf  = rx_bufs[i];
+    rxpd = (RxPD *)(void *)(buf + INTF_HEADER_LEN);
+    (void)memset(buf, 0, INTF_HEADER_LEN + sizeof(RxPD));
+    rxpd->bss_type      = interface;
+    rxpd->rx_pkt_length = len;
+    rxpd->rx_pkt_offset = sizeof(RxPD);
+    rxpd->rx_pkt_type   = pkt_type;
+    (void)memcpy(buf + INTF_HEADER_LEN + sizeof(RxPD), frame, len);
+    /* Whatever follows the frame in the buffer reads as zeros */
+    (void)memset(buf + datalen, 0, 32);
+
+    rx_buf_state[i] = RX_BUF_IN_HANDLER;
+    wifi_host.rx_frames++;
+    start = bench_cycles();
+    handle_data_packet(interface, buf, datalen);
+    wifi_host.rx_cycles += bench_cycles() - start;
+    if (rx_buf_state[i] == RX_BUF_IN_HANDLER)
+    {
+        rx_buf_state[i] = RX_BUF_FREE;
+    }
+
+    return 1;
+}
+
+unsigned int wifi_host_rx_held(void)
+{
+    unsigned int held = 0;
+    unsigned int i;
+
+    for (i = 0; i < WIFI_HOST_RX_BUFS; i++)
+    {
+        held += (rx_buf_state[i] == RX_BUF_HELD) ? 1U : 0U;
+    }
+    return held;
+}
+
+/* WMM TX queue */
+
+t_u32 wifi_wmm_get_pkt_prio(void *buf, t_u8 *tid)
+{
+    *tid = 0;
+    return (t_u32)WMM_AC_BE;
+}
+
+int wifi_add_to_bypassq(const t_u8 interface, void *pkt, t_u32 len)
+{
+    return -WM_FAIL;
+}
+
+void wifi_wmm_da_to_ra(uint8_t *da, uint8_t *ra)
+{
+    (void)memcpy(ra, da, MLAN_MAC_ADDR_LENGTH);
+}
+
+uint8_t *wifi_wmm_get_outbuf_enh(
+    uint32_t *outbuf_len, mlan_wmm_ac_e queue, const uint8_t interface, uint8_t *ra, bool *is_tx_pause)
+{
+    unsigned int i;
+
+    *is_tx_pause = false;
+    if (tx_slots < wifi_host.tx_bufs)
+    {
+        for (i = 0; i < WIFI_HOST_TX_BUFS; i++)
+        {
+            if (!tx_mem_used[i])
+            {
+                tx_mem_used[i] = true;
+                tx_slots++;
+                *outbuf_len = sizeof(outbuf_t);
+                return (uint8_t *)&tx_mem[i];
+            }
+        }
+    }
+
+    /* The pause is only reported when no buffer is free, as by the driver */
+    *is_tx_pause = wifi_host.tx_paused;
+    return NULL;
+}
+
+void wifi_wmm_buf_put_mem(outbuf_t *buf)
+{
+    tx_mem_used[buf - tx_mem] = false;
+    tx_next_ext               = true;
+}
+
+bool wifi_wmm_tx_full(const uint8_t interface, mlan_wmm_ac_e queue)
+{
+    if (tx_slots < wifi_host.tx_bufs)
+    {
+        return false;
+    }
+    tx_full_seen = true;
+    wifi_host.tx_full++;
+    return true;
+}
+
+void wifi_wmm_drop_no_media(const uint8_t interface)
+{
+}
+
+void wifi_wmm_drop_retried_drop(const uint8_t interface)
+{
+    wifi_host.tx_retried_drops++;
+}
+
+void wifi_wmm_drop_pause_drop(const uint8_t interface)
+{
+    wifi_host.tx_pause_drops++;
+}
+
+int send_wifi_driver_tx_data_event(t_u8 interface)
+{
+    wifi_host.tx_events++;
+    if (wifi_host.tx_event_fn != NULL)
+    {
+        wifi_host.tx_event_fn();
+    }
+    return WM_SUCCESS;
+}
+
+int wifi_low_level_output(const uint8_t interface,
+                          const uint8_t *buffer,
+                          const uint16_t len,
+                          uint8_t pkt_prio,
+                          uint8_t tid)
+{
+    struct tx_entry *entry = &tx_queue[(tx_head + tx_count) % WIFI_HOST_TX_BUFS];
+
+    entry->outbuf = (uint8_t *)buffer;
+    entry->len    = len;
+    entry->ext    = tx_next_ext;
+    tx_next_ext   = false;
+    tx_count++;
+    wifi_host.tx_frames++;
+    return WM_SUCCESS;
+}
+
+unsigned int wifi_host_tx_queued(void)
+{
+    return tx_count;
+}
+
+unsigned int wifi_host_tx_send(unsigned int frames)
+{
+    unsigned int sent = 0;
+
+    while ((sent < frames) && (tx_count > 0U) && !wifi_host.tx_paused)
+    {
+        struct tx_entry *entry = &tx_queue[tx_head];
+
+        tx_head = (tx_head + 1U) % WIFI_HOST_TX_BUFS;
+        tx_count--;
+        if (wifi_host.tx_frame_fn != NULL)
+        {
+            wifi_host.tx_frame_fn(entry->outbuf + TX_FRAME_OFFSET, (uint16_t)(entry->len - TX_FRAME_OFFSET));
+        }
+        if (entry->ext)
+        {
+            (void)pbuf_free(*(struct pbuf **)(void *)(entry->outbuf - sizeof(struct pbuf *)));
+        }
+        else
+        {
+            tx_mem_used[(outbuf_t *)(void *)entry->outbuf - tx_mem] = false;
+        }
+        tx_slots--;
+        wifi_host.tx_sent++;
+        sent++;
+
+        /* wifi_wmm_buf_put() calls the resume callback once the queue has room again */
+        if (tx_full_seen)
+        {
+            tx_full_seen = false;
+            wifi_host.tx_resumes++;
+            handle_tx_queue_space(1U << WMM_AC_BE);
+        }
+    }
+    return sent;
+}
+
+/* Setup */
+
+void wifi_host_advance_us(uint32_t us)
+{
+    now_us += us;
+}
+
+uint64_t wifi_host_time_us(void)
+{
+    return now_us;
+}
+
+static unsigned int tcpip_calls_run(void)
+{
+    unsigned int run = 0;
+
+    while (tcpip_call_count > 0U)
+    {
+        struct tcpip_call call = tcpip_calls[0];
+
+        tcpip_call_count--;
+        (void)memmove(&tcpip_calls[0], &tcpip_calls[1], tcpip_call_count * sizeof(tcpip_calls[0]));
+        call.fn(call.ctx);
+        run++;
+    }
+    return run;
+}
+
+unsigned int wifi_host_tcpip_poll(void)
+{
+    unsigned int run = tcpip_calls_run();
+
+    sys_check_timeouts();
+    return run;
+}
+
+void wifi_host_reset(void)
+{
+    unsigned int tx_bufs = wifi_host.tx_bufs;
+
+    while (tx_count > 0U)
+    {
+        bool paused = wifi_host.tx_paused;
+        void (*tx_frame_fn)(const uint8_t *frame, uint16_t len) = wifi_host.tx_frame_fn;
+
+        /* Drop the queued frames */
+        wifi_host.tx_paused   = false;
+        wifi_host.tx_frame_fn = NULL;
+        (void)wifi_host_tx_send(tx_count);
+        wifi_host.tx_paused   = paused;
+        wifi_host.tx_frame_fn = tx_frame_fn;
+    }
+    /* Not dropped, a posted call may have left a pending flag set */
+    (void)tcpip_calls_run();
+    tx_full_seen = false;
+
+    wifi_host.tx_bufs = tx_bufs;
+    wifi_host_clear_counters();
+}
+
+void wifi_host_clear_counters(void)
+{
+    (void)memset(&wifi_host.rx_frames, 0, sizeof(wifi_host) - offsetof(struct wifi_host, rx_frames));
+    privs[0].rx_overrun_cnt = 0;
+    privs[0].tx_overrun_cnt = 0;
+    privs[1].rx_overrun_cnt = 0;
+    privs[1].tx_overrun_cnt = 0;
+}
+
+void wifi_host_init(void)
+{
+    static int rx_pkt_lock;
+    unsigned int i;
+
+    adapter.callbacks.moal_malloc      = host_malloc;
+    adapter.callbacks.moal_mfree       = host_mfree;
+    adapter.callbacks.moal_init_timer  = host_init_timer;
+    adapter.callbacks.moal_free_timer  = host_timer;
+    adapter.callbacks.moal_start_timer = host_start_timer;
+    adapter.callbacks.moal_stop_timer  = host_timer;
+    adapter.callbacks.moal_spin_lock   = host_lock;
+    adapter.callbacks.moal_spin_unlock = host_lock;
+    adapter.priv_num                   = 2;
+    mlan_adap                          = &adapter;
+
+    for (i = 0; i < 2U; i++)
+    {
+        adapter.priv[i]        = &privs[i];
+        privs[i].adapter       = &adapter;
+        privs[i].bss_type      = (i == 0U) ? MLAN_BSS_TYPE_STA : MLAN_BSS_TYPE_UAP;
+        privs[i].bss_role      = (i == 0U) ? MLAN_BSS_ROLE_STA : MLAN_BSS_ROLE_UAP;
+        privs[i].bss_mode      = MLAN_BSS_MODE_INFRA;
+        privs[i].rx_pkt_lock   = &rx_pkt_lock;
+        util_init_list((pmlan_linked_list)(void *)&privs[i].rx_reorder_tbl_ptr);
+        (void)memset(privs[i].rx_seq, 0xff, sizeof(privs[i].rx_seq));
+    }
+    (void)memcpy(privs[0].curr_addr, sta_mac, MLAN_MAC_ADDR_LENGTH);
+    (void)memcpy(privs[1].curr_addr, uap_mac, MLAN_MAC_ADDR_LENGTH);
+
+    wifi_host.tx_bufs = WIFI_HOST_TX_BUFS;
+    lwip_init();
+}
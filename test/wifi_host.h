@@ -0,0 +1,122 @@
+/*
+ * Copyright 2024 NXP
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Host stand-ins for the OS, the lwIP port and the Wi-Fi driver around
+ * wifi/port/net/wifi_netif.c, so that the tests can build the real netif
+ * code with the SDK headers and the lwIP options of the application.
+ *
+ * The stack runs in the thread of the test: tcpip_input() hands a frame to
+ * ethernet_input() at once, tcpip_try_callback() queues the call until
+ * wifi_host_tcpip_poll(). Time is virtual, sys_now() and sys_now_us()
+ * follow a clock that only wifi_host_advance_us() and OSA_TimeDelay() move.
+ *
+ * RX: the IMU rx buffers of the firmware are a pool of WIFI_HOST_RX_BUFS
+ * buffers. wifi_host_rx_frame() fills a free one with the interface header,
+ * an RxPD and the frame and calls handle_data_packet(). A buffer the netif
+ * holds with wifi_imu_rx_buf_hold() stays taken until
+ * wifi_imu_rx_buf_release(), any other goes back to the pool when
+ * handle_data_packet() returns, as with the IMU rx data handler.
+ *
+ * TX: the WMM TX queue is WIFI_HOST_TX_BUFS outbufs at most (wifi_host.tx_bufs).
+ * wifi_low_level_output() queues a frame in its outbuf, wifi_host_tx_send()
+ * takes frames off the queue as the firmware does when it sends them.
+ * Freeing a buffer after wifi_wmm_tx_full() found the queue full calls
+ * handle_tx_queue_space(), as wifi_wmm_buf_put() calls the registered
+ * resume callback. While the link is paused wifi_wmm_get_outbuf_enh()
+ * reports the pause and no frame is sent.
+ */
+
+#ifndef WIFI_HOST_H
+#define WIFI_HOST_H
+
+/* Before the CMSIS headers, whose __I and __O macros break the x86 intrinsics */
+#include "bench.h"
+
+/* Not netif_decl.h, which has no include guard and comes with wifi_netif.c */
+#include <mlan_api.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define WIFI_HOST_RX_BUFS     32U
+#define WIFI_HOST_RX_BUF_SIZE MLAN_RX_DATA_BUF_SIZE
+#define WIFI_HOST_TX_BUFS     64U
+
+struct wifi_host
+{
+    /* Settings, wifi_host_init() sets the defaults */
+    unsigned int tx_bufs;   /* WMM TX queue size in frames, at most WIFI_HOST_TX_BUFS */
+    bool tx_paused;         /* The peer paused the link (power save), nothing is sent */
+    /* Called by send_wifi_driver_tx_data_event(), stands for the driver task running */
+    void (*tx_event_fn)(void);
+    /* Called by OSA_TimeDelay() after the clock moved on */
+    void (*delay_fn)(void);
+    /* Called with every frame taken off the TX queue */
+    void (*tx_frame_fn)(const uint8_t *frame, uint16_t len);
+    /* Replaces the hand up of wrapper_wlan_handle_rx_packet(), for the mlan RX path */
+    int (*rx_packet_fn)(t_u16 datalen, RxPD *rxpd, void *p, void *payload);
+
+    /* Counters */
+    uint32_t rx_frames;
+    uint64_t rx_cycles;     /* Time spent in handle_data_packet() (bench.h) */
+    uint32_t rx_holds;
+    uint32_t rx_releases;
+    uint32_t rx_errors;     /* Releases of buffers not held, holds of buffers not in the handler */
+    uint32_t tx_frames;     /* Frames queued by wifi_low_level_output() */
+    uint32_t tx_sent;       /* Frames taken off the queue */
+    uint32_t tx_events;     /* send_wifi_driver_tx_data_event() calls */
+    uint32_t tx_full;       /* wifi_wmm_tx_full() calls that found the queue full */
+    uint32_t tx_resumes;    /* handle_tx_queue_space() calls */
+    uint32_t tx_retried_drops;
+    uint32_t tx_pause_drops;
+    uint32_t delays;        /* OSA_TimeDelay() calls */
+    uint32_t delay_ms;
+    uint32_t yields;
+};
+
+extern struct wifi_host wifi_host;
+
+/* The entry points of wifi_netif.c called by the driver */
+void handle_data_packet(const t_u8 interface, const t_u8 *rcvdata, const t_u16 datalen);
+void handle_amsdu_data_packet(t_u8 interface, t_u8 *rcvdata, t_u16 datalen, void *amsdu_buf);
+void handle_deliver_packet_above(t_void *rxpd, t_u8 interface, t_void *lwip_pbuf);
+
+/* Brings up lwIP and the adapter with a STA and a uAP interface, must be called once */
+void wifi_host_init(void);
+
+/* Drops the queued TX frames, runs the posted calls and clears the counters, keeps the settings */
+void wifi_host_reset(void);
+
+/* Clears the counters only */
+void wifi_host_clear_counters(void);
+
+/* Moves the clock on */
+void wifi_host_advance_us(uint32_t us);
+
+uint64_t wifi_host_time_us(void);
+
+/* Runs the calls posted with tcpip_try_callback() and the due lwIP timers, returns the calls run */
+unsigned int wifi_host_tcpip_poll(void);
+
+/*
+ * Receives a frame on an interface through handle_data_packet(). pkt_type is
+ * the rx_pkt_type of the RxPD, 0 for an 802.3 frame or PKT_TYPE_AMSDU.
+ * Returns 0 if no rx buffer was free, the frame is lost then.
+ */
+int wifi_host_rx_frame(t_u8 interface, t_u16 pkt_type, const uint8_t *frame, uint16_t len);
+
+/* Rx buffers held by the stack */
+unsigned int wifi_host_rx_held(void);
+
+/* Frames in the WMM TX queue */
+unsigned int wifi_host_tx_queued(void);
+
+/* Takes up to frames frames off the TX queue, unless the link is paused. Returns the frames sent. */
+unsigned int wifi_host_tx_send(unsigned int frames);
+
+#endif /* WIFI_HOST_H */
@@ -0,0 +1,117 @@
+#!/usr/bin/env python3
+#
+# Copyright 2024 NXP
+# All rights reserved.
+#
+# SPDX-License-Identifier: BSD-3-Clause
+#
+# Converts an event trace dump (trace.cgi, format in source/event_trace.h) into
+# the Chrome trace JSON format, to be opened in chrome://tracing or Perfetto.
+#
+#   curl -o trace.bin http://<board>/trace.cgi
+#   python3 tools/event_trace.py trace.bin > trace.json
+
+import json
+import struct
+import sys
+
+MAGIC = 0x52545645
+NAME_LEN = 16
+RECORD = struct.Struct('<QBBHI')
+
+TASK_IN, QUEUE_SEND, QUEUE_RECEIVE, ISR_ENTER, ISR_EXIT, NET_IN, NET_OUT, MQTT_PUBLISH, MQTT_ACK = range(1, 10)
+
+QUEUE_TYPES = {0: 'queue', 1: 'mutex', 2: 'counting semaphore', 3: 'binary semaphore', 4: 'recursive mutex'}
+MQTT_TYPES = {4: 'PUBACK', 7: 'PUBCOMP', 9: 'SUBACK', 11: 'UNSUBACK'}
+
+# Thread ids of the rows that are not tasks
+TID_ISR = 1000
+TID_NET = 1001
+TID_MQTT = 1002
+
+
+def parse(data):
+    magic, version, record_size, hz, names = struct.unpack_from('<IHHII', data, 0)
+    if magic != MAGIC or version != 1 or record_size != RECORD.size:
+        raise ValueError('not an event trace dump')
+
+    offset = 16
+    tasks = {}
+    for _ in range(names):
+        number, = struct.unpack_from('<I', data, offset)
+        name = data[offset + 4:offset + 4 + NAME_LEN].split(b'\0', 1)[0].decode('ascii', 'replace')
+        tasks[number] = name
+        offset += 4 + NAME_LEN
+
+    records = [RECORD.unpack_from(data, pos) for pos in range(offset, len(data) - RECORD.size + 1, RECORD.size)]
+    return hz, tasks, records
+
+
+def convert(hz, tasks, records):
+    events = []
+    start = records[0][0] if records else 0
+    running = None
+    running_since = 0.0
+    # Exceptions entered and not left yet, innermost last
+    isrs = []
+
+    def us(cycles):
+        return (cycles - start) * 1e6 / hz
+
+    def instant(ts, tid, name, args):
+        events.append({'name': name, 'ph': 'i', 's': 't', 'ts': ts, 'pid': 0, 'tid': tid, 'args': args})
+
+    for time, kind, _, ident, arg in records:
+        ts = us(time)
+        if kind == TASK_IN:
+            # A task runs until the next one is switched in
+            if running is not None:
+                events.append({'name': tasks.get(running, 'task %u' % running), 'ph': 'X', 'ts': running_since,
+                               'dur': ts - running_since, 'pid': 0, 'tid': running})
+            running = ident
+            running_since = ts
+        elif kind in (QUEUE_SEND, QUEUE_RECEIVE):
+            name = ('send ' if kind == QUEUE_SEND else 'receive ') + QUEUE_TYPES.get(ident, 'queue')
+            instant(ts, running if running is not None else TID_ISR, name, {'queue': '0x%08x' % arg})
+        elif kind == ISR_ENTER:
+            events.append({'name': 'exception %u' % ident, 'ph': 'B', 'ts': ts, 'pid': 0, 'tid': TID_ISR})
+            isrs.append(ident)
+        elif kind == ISR_EXIT:
+            # An exit whose enter is not in the dump (overwritten in the ring) is dropped,
+            # exceptions entered after this one and not left are closed with it
+            if ident not in isrs:
+                continue
+            while isrs[-1] != ident:
+                events.append({'name': 'exception %u' % isrs.pop(), 'ph': 'E', 'ts': ts, 'pid': 0, 'tid': TID_ISR})
+            isrs.pop()
+            events.append({'name': 'exception %u' % ident, 'ph': 'E', 'ts': ts, 'pid': 0, 'tid': TID_ISR,
+                           'args': {'switch': arg}})
+        elif kind in (NET_IN, NET_OUT):
+            instant(ts, TID_NET, 'rx' if kind == NET_IN else 'tx', {'len': arg})
+        elif kind == MQTT_PUBLISH:
+            instant(ts, TID_MQTT, 'publish', {'pkt_id': ident, 'len': arg})
+        elif kind == MQTT_ACK:
+            instant(ts, TID_MQTT, MQTT_TYPES.get(arg, 'type %u' % arg), {'pkt_id': ident})
+
+    # Exceptions still running when the dump was taken end with it
+    end = us(records[-1][0]) if records else 0.0
+    for left in reversed(isrs):
+        events.append({'name': 'exception %u' % left, 'ph': 'E', 'ts': end, 'pid': 0, 'tid': TID_ISR})
+
+    rows = dict(tasks)
+    rows.update({TID_ISR: 'interrupts', TID_NET: 'Wi-Fi frames', TID_MQTT: 'MQTT'})
+    for tid, name in rows.items():
+        events.append({'name': 'thread_name', 'ph': 'M', 'pid': 0, 'tid': tid, 'args': {'name': name}})
+    return events
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit('usage: %s <trace dump>' % sys.argv[0])
+    with open(sys.argv[1], 'rb') as f:
+        hz, tasks, records = parse(f.read())
+    json.dump({'traceEvents': convert(hz, tasks, records), 'displayTimeUnit': 'ns'}, sys.stdout)
+
+
+if __name__ == '__main__':
+    main()
@@ -23,13 +23,44 @@
 #endif /* ! CONFIG_DHCP_DEBUG */
 
 #define SERVER_BUFFER_SIZE        1024
-#define MAC_IP_CACHE_SIZE         8
+#define MAC_IP_CACHE_SIZE         CONFIG_DHCP_SERVER_LEASES
+#define MAC_IP_HASH_SIZE          64  /* buckets of each index, power of two */
+#define DHCP_OFFER_TIMEOUT        60U /* seconds an offered address is held */
+#define SERVER_BATCH_SIZE         16  /* datagrams read per socket and select()
+                                       * wakeup */
+#define SERVER_CLOCK_TIMEOUT      3600 /* longest select() wait in seconds */
 #define SEND_RESPONSE(w, x, y, z) dhcp_send_response(w, x, y, z)
 
+#if MAC_IP_CACHE_SIZE > 255
+#error "CONFIG_DHCP_SERVER_LEASES must be at most 255"
+#endif
+
 struct client_mac_cache
 {
     uint8_t client_mac[6]; /* mac address of the connected device */
-    uint32_t client_ip;    /* ip address of the connected device */
+    uint8_t next_mac;      /* next entry of the MAC hash chain or free list
+                            * plus one, 0 ends the chain */
+    uint8_t next_ip;       /* next entry of the IP hash chain plus one */
+    uint32_t client_ip;    /* ip address of the connected device, 0 if
+                            * the entry is free */
+    uint32_t expires;      /* seconds since boot the lease ends at */
+};
+
+/* Format of the lease table handed to the lease store */
+#define DHCP_LEASE_STORE_MAGIC 0x4443484CU /* "DHCL" */
+
+struct dhcp_lease_record
+{
+    uint32_t client_ip; /* network order */
+    uint32_t remaining; /* seconds left of the lease */
+    uint8_t client_mac[6];
+    uint8_t reserved[2];
+};
+
+struct dhcp_lease_store_header
+{
+    uint32_t magic;
+    uint32_t count; /* number of records that follow */
 };
 
 struct dhcp_server_data
@@ -40,6 +71,11 @@ struct dhcp_server_data
     struct sockaddr_in saddr; /* dhcp server address */
     struct sockaddr_in baddr; /* broadcast address */
     struct client_mac_cache ip_mac_mapping[MAC_IP_CACHE_SIZE];
+    uint8_t mac_hash[MAC_IP_HASH_SIZE]; /* first entry of each MAC hash chain
+                                         * plus one */
+    uint8_t ip_hash[MAC_IP_HASH_SIZE];  /* first entry of each IP hash chain
+                                         * plus one */
+    uint8_t free_list;                  /* first free entry plus one */
     uint32_t netmask;         /* network order */
     uint32_t my_ip;           /* network order */
     uint32_t client_ip;       /* last address that was requested, network
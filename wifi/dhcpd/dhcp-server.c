@@ -41,70 +41,204 @@ static void get_broadcast_addr(struct sockaddr_in *addr);
 static int get_ip_addr_from_interface(uint32_t *ip, void *interface_handle);
 static int get_netmask_from_interface(uint32_t *nm, void *interface_handle);
 static int send_gratuitous_arp(uint32_t ip);
-static int ac_add(uint8_t *chaddr, uint32_t client_ip);
+static int ac_add(uint8_t *chaddr, uint32_t client_ip, uint32_t lifetime);
 static uint32_t ac_lookup_mac(uint8_t *chaddr);
-static uint8_t *ac_lookup_ip(uint32_t client_ip);
-static bool ac_not_full(void);
-
-static int ac_add(uint8_t *chaddr, uint32_t client_ip)
-{
-    /* adds ip-mac mapping in cache */
-    if (ac_not_full())
-    {
-        dhcps.ip_mac_mapping[dhcps.count_clients].client_mac[0] = chaddr[0];
-        dhcps.ip_mac_mapping[dhcps.count_clients].client_mac[1] = chaddr[1];
-        dhcps.ip_mac_mapping[dhcps.count_clients].client_mac[2] = chaddr[2];
-        dhcps.ip_mac_mapping[dhcps.count_clients].client_mac[3] = chaddr[3];
-        dhcps.ip_mac_mapping[dhcps.count_clients].client_mac[4] = chaddr[4];
-        dhcps.ip_mac_mapping[dhcps.count_clients].client_mac[5] = chaddr[5];
-        dhcps.ip_mac_mapping[dhcps.count_clients].client_ip     = client_ip;
-        dhcps.count_clients++;
-        return WM_SUCCESS;
+
+/* Lease store registered with dhcp_server_set_lease_store() */
+static int (*lease_store_save)(const void *data, uint32_t len);
+static int (*lease_store_load)(void *data, uint32_t len);
+
+/* Seconds since boot, advanced by millisecond deltas so that it does not jump
+ * back when the 32-bit millisecond time wraps after 49.7 days. Only the server
+ * task advances it, at least every SERVER_CLOCK_TIMEOUT seconds.
+ */
+static uint32_t ac_clock_msec;
+static uint32_t ac_clock_sec;
+
+static uint32_t ac_now(void)
+{
+    uint32_t elapsed = OSA_TimeGetMsec() - ac_clock_msec;
+
+    ac_clock_sec += elapsed / 1000U;
+    /* the part of a second left over counts towards the next call */
+    ac_clock_msec += elapsed - (elapsed % 1000U);
+    return ac_clock_sec;
+}
+
+/* ac_now() for other tasks, without advancing the clock */
+static uint32_t ac_peek(void)
+{
+    return ac_clock_sec + ((OSA_TimeGetMsec() - ac_clock_msec) / 1000U);
+}
+
+static bool ac_expired(const struct client_mac_cache *entry, uint32_t now)
+{
+    return ((int32_t)(entry->expires - now) <= 0);
+}
+
+static unsigned int ac_hash_mac(const uint8_t *chaddr)
+{
+    /* FNV-1a */
+    uint32_t hash = 2166136261U;
+    int i;
+
+    for (i = 0; i < 6; i++)
+    {
+        hash = (hash ^ chaddr[i]) * 16777619U;
     }
-    return -WM_FAIL;
+    return (hash ^ (hash >> 16)) & (MAC_IP_HASH_SIZE - 1U);
 }
 
-static uint32_t ac_lookup_mac(uint8_t *chaddr)
+static unsigned int ac_hash_ip(uint32_t client_ip)
+{
+    /* consecutive host addresses land in consecutive buckets */
+    return ntohl(client_ip) & (MAC_IP_HASH_SIZE - 1U);
+}
+
+static void ac_init(void)
 {
-    /* returns ip address, if mac address is present in cache */
     int i;
-    for (i = 0; i < dhcps.count_clients && i < MAC_IP_CACHE_SIZE; i++)
-    {
-        if ((dhcps.ip_mac_mapping[i].client_mac[0] == chaddr[0]) &&
-            (dhcps.ip_mac_mapping[i].client_mac[1] == chaddr[1]) &&
-            (dhcps.ip_mac_mapping[i].client_mac[2] == chaddr[2]) &&
-            (dhcps.ip_mac_mapping[i].client_mac[3] == chaddr[3]) &&
-            (dhcps.ip_mac_mapping[i].client_mac[4] == chaddr[4]) &&
-            (dhcps.ip_mac_mapping[i].client_mac[5] == chaddr[5]))
+
+    (void)memset(dhcps.ip_mac_mapping, 0, sizeof(dhcps.ip_mac_mapping));
+    (void)memset(dhcps.mac_hash, 0, sizeof(dhcps.mac_hash));
+    (void)memset(dhcps.ip_hash, 0, sizeof(dhcps.ip_hash));
+
+    for (i = 0; i < MAC_IP_CACHE_SIZE - 1; i++)
+    {
+        dhcps.ip_mac_mapping[i].next_mac = (uint8_t)(i + 2);
+    }
+    dhcps.free_list     = 1;
+    dhcps.count_clients = 0;
+}
+
+static struct client_mac_cache *ac_find_mac(const uint8_t *chaddr)
+{
+    struct client_mac_cache *entry;
+    uint8_t index = dhcps.mac_hash[ac_hash_mac(chaddr)];
+
+    while (index != 0U)
+    {
+        entry = &dhcps.ip_mac_mapping[index - 1U];
+        if (memcmp(entry->client_mac, chaddr, sizeof(entry->client_mac)) == 0)
         {
-            return dhcps.ip_mac_mapping[i].client_ip;
+            return entry;
         }
+        index = entry->next_mac;
     }
-    return CLIENT_IP_NOT_FOUND;
+    return NULL;
 }
 
-static uint8_t *ac_lookup_ip(uint32_t client_ip)
+static struct client_mac_cache *ac_find_ip(uint32_t client_ip)
 {
-    /* returns mac address, if ip address is present in cache */
-    int i;
-    for (i = 0; i < dhcps.count_clients && i < MAC_IP_CACHE_SIZE; i++)
+    struct client_mac_cache *entry;
+    uint8_t index = dhcps.ip_hash[ac_hash_ip(client_ip)];
+
+    while (index != 0U)
     {
-        if ((dhcps.ip_mac_mapping[i].client_ip) == client_ip)
+        entry = &dhcps.ip_mac_mapping[index - 1U];
+        if (entry->client_ip == client_ip)
         {
-            return dhcps.ip_mac_mapping[i].client_mac;
+            return entry;
         }
+        index = entry->next_ip;
     }
     return NULL;
 }
 
-static bool ac_not_full(void)
+/* Unlinks an entry from both hash chains and returns it to the free list */
+static void ac_remove(struct client_mac_cache *entry)
 {
-    /* returns true if cache is not full */
-    return (dhcps.count_clients < MAC_IP_CACHE_SIZE);
+    uint8_t index = (uint8_t)(entry - dhcps.ip_mac_mapping + 1);
+    uint8_t *link;
+
+    link = &dhcps.mac_hash[ac_hash_mac(entry->client_mac)];
+    while (*link != index)
+    {
+        link = &dhcps.ip_mac_mapping[*link - 1U].next_mac;
+    }
+    *link = entry->next_mac;
+
+    link = &dhcps.ip_hash[ac_hash_ip(entry->client_ip)];
+    while (*link != index)
+    {
+        link = &dhcps.ip_mac_mapping[*link - 1U].next_ip;
+    }
+    *link = entry->next_ip;
+
+    (void)memset(entry, 0, sizeof(*entry));
+    entry->next_mac = dhcps.free_list;
+    dhcps.free_list = index;
+    dhcps.count_clients--;
+}
+
+/* Frees the entry whose lease ended first, if any lease has ended */
+static bool ac_reclaim(uint32_t now)
+{
+    struct client_mac_cache *oldest = NULL;
+    int i;
+
+    for (i = 0; i < MAC_IP_CACHE_SIZE; i++)
+    {
+        if ((dhcps.ip_mac_mapping[i].client_ip != CLIENT_IP_NOT_FOUND) && ac_expired(&dhcps.ip_mac_mapping[i], now) &&
+            ((oldest == NULL) || ((int32_t)(dhcps.ip_mac_mapping[i].expires - oldest->expires) < 0)))
+        {
+            oldest = &dhcps.ip_mac_mapping[i];
+        }
+    }
+    if (oldest == NULL)
+    {
+        return false;
+    }
+
+    dhcp_d("reclaiming expired lease of %02X:%02X:%02X:%02X:%02X:%02X", oldest->client_mac[0], oldest->client_mac[1],
+           oldest->client_mac[2], oldest->client_mac[3], oldest->client_mac[4], oldest->client_mac[5]);
+    ac_remove(oldest);
+    return true;
+}
+
+static int ac_add(uint8_t *chaddr, uint32_t client_ip, uint32_t lifetime)
+{
+    /* adds ip-mac mapping in cache, reclaiming an expired lease if full */
+    struct client_mac_cache *entry;
+    unsigned int hash;
+    uint32_t now = ac_now();
+
+    if ((dhcps.free_list == 0U) && !ac_reclaim(now))
+    {
+        return -WM_FAIL;
+    }
+
+    entry           = &dhcps.ip_mac_mapping[dhcps.free_list - 1U];
+    dhcps.free_list = entry->next_mac;
+
+    (void)memcpy(entry->client_mac, chaddr, sizeof(entry->client_mac));
+    entry->client_ip = client_ip;
+    entry->expires   = now + lifetime;
+
+    hash                  = ac_hash_mac(chaddr);
+    entry->next_mac       = dhcps.mac_hash[hash];
+    dhcps.mac_hash[hash]  = (uint8_t)(entry - dhcps.ip_mac_mapping + 1);
+    hash                  = ac_hash_ip(client_ip);
+    entry->next_ip        = dhcps.ip_hash[hash];
+    dhcps.ip_hash[hash]   = (uint8_t)(entry - dhcps.ip_mac_mapping + 1);
+    dhcps.count_clients++;
+    return WM_SUCCESS;
+}
+
+static uint32_t ac_lookup_mac(uint8_t *chaddr)
+{
+    /* returns ip address, if mac address is present in cache, a client
+     * keeps its address after its lease ended until it is reclaimed
+     */
+    struct client_mac_cache *entry = ac_find_mac(chaddr);
+
+    return (entry != NULL) ? entry->client_ip : CLIENT_IP_NOT_FOUND;
 }
 
 static bool ac_valid_ip(uint32_t requested_ip)
 {
+    struct client_mac_cache *entry;
+
     /* skip over our own address, the network address or the
      * broadcast address
      */
@@ -113,13 +247,132 @@ static bool ac_valid_ip(uint32_t requested_ip)
     {
         return false;
     }
-    if (ac_lookup_ip(htonl(requested_ip)) != NULL)
+    entry = ac_find_ip(htonl(requested_ip));
+    if (entry != NULL)
     {
-        return false;
+        if (!ac_expired(entry, ac_now()))
+        {
+            return false;
+        }
+        /* the lease has ended, the address can be given to another client */
+        ac_remove(entry);
     }
     return true;
 }
 
+/* Hands the lease table to the lease store */
+static void ac_save(void)
+{
+    struct dhcp_lease_store_header *header;
+    struct dhcp_lease_record *record;
+    uint32_t now = ac_now();
+    uint32_t len;
+    int i;
+
+    if (lease_store_save == NULL)
+    {
+        return;
+    }
+
+    len    = sizeof(*header) + ((uint32_t)dhcps.count_clients * sizeof(*record));
+    header = (struct dhcp_lease_store_header *)OSA_MemoryAllocate(len);
+    if (header == NULL)
+    {
+        dhcp_w("No memory to save leases");
+        return;
+    }
+
+    header->magic = DHCP_LEASE_STORE_MAGIC;
+    header->count = 0;
+    record        = (struct dhcp_lease_record *)(void *)(header + 1);
+    for (i = 0; i < MAC_IP_CACHE_SIZE; i++)
+    {
+        if ((dhcps.ip_mac_mapping[i].client_ip == CLIENT_IP_NOT_FOUND) || ac_expired(&dhcps.ip_mac_mapping[i], now))
+        {
+            continue;
+        }
+        (void)memcpy(record->client_mac, dhcps.ip_mac_mapping[i].client_mac, sizeof(record->client_mac));
+        record->reserved[0] = 0;
+        record->reserved[1] = 0;
+        record->client_ip   = dhcps.ip_mac_mapping[i].client_ip;
+        record->remaining   = dhcps.ip_mac_mapping[i].expires - now;
+        record++;
+        header->count++;
+    }
+
+    if (lease_store_save(header, sizeof(*header) + (header->count * sizeof(*record))) != WM_SUCCESS)
+    {
+        dhcp_w("Failed to save leases");
+    }
+    OSA_MemoryFree(header);
+}
+
+/* Restores the leases of the lease store that are inside our subnet */
+static void ac_load(void)
+{
+    struct dhcp_lease_store_header *header;
+    struct dhcp_lease_record *record;
+    uint32_t len = sizeof(*header) + (MAC_IP_CACHE_SIZE * sizeof(*record));
+    uint32_t i;
+    int ret;
+
+    if (lease_store_load == NULL)
+    {
+        return;
+    }
+
+    header = (struct dhcp_lease_store_header *)OSA_MemoryAllocate(len);
+    if (header == NULL)
+    {
+        dhcp_w("No memory to load leases");
+        return;
+    }
+
+    ret    = lease_store_load(header, len);
+    record = (struct dhcp_lease_record *)(void *)(header + 1);
+    if ((ret >= (int)sizeof(*header)) && (header->magic == DHCP_LEASE_STORE_MAGIC) &&
+        (header->count <= ((uint32_t)ret - sizeof(*header)) / sizeof(*record)))
+    {
+        for (i = 0; i < header->count; i++, record++)
+        {
+            if (((record->client_ip & dhcps.netmask) == (dhcps.my_ip & dhcps.netmask)) &&
+                ac_valid_ip(ntohl(record->client_ip)) && (ac_find_mac(record->client_mac) == NULL))
+            {
+                (void)ac_add(record->client_mac, record->client_ip, record->remaining);
+            }
+        }
+        dhcp_d("restored %d leases", dhcps.count_clients);
+    }
+    OSA_MemoryFree(header);
+}
+
+/* Starts the lease of a client that was sent an ACK */
+static void ac_bind(uint8_t *chaddr, uint32_t client_ip)
+{
+    struct client_mac_cache *entry = ac_find_mac(chaddr);
+    uint32_t now                   = ac_now();
+    bool renewal;
+
+    if ((entry == NULL) || (entry->client_ip != client_ip))
+    {
+        return;
+    }
+
+    /* only new leases are saved, renewals would wear out the flash */
+    renewal        = !ac_expired(entry, now) && ((entry->expires - now) > DHCP_OFFER_TIMEOUT);
+    entry->expires = now + dhcp_address_timeout;
+    if (!renewal)
+    {
+        ac_save();
+    }
+}
+
+void dhcp_server_set_lease_store(int (*save)(const void *data, uint32_t len), int (*load)(void *data, uint32_t len))
+{
+    lease_store_save = save;
+    lease_store_load = load;
+}
+
 static void write_u32(char *dest, uint32_t be_value)
 {
     *dest++ = be_value & 0xFFU;
@@ -152,24 +405,45 @@ static unsigned int next_yiaddr(void)
     struct in_addr ip;
 #endif
     uint32_t new_ip;
+    uint32_t hosts;
+    uint32_t probes;
+    struct client_mac_cache *entry;
     struct bootp_header *hdr = (struct bootp_header *)(void *)dhcps.msg;
 
     /* if device requesting for ip address is already registered,
      * if yes, assign previous ip address to it
      */
-    new_ip = ac_lookup_mac(hdr->chaddr);
-    if (new_ip == (CLIENT_IP_NOT_FOUND))
+    entry = ac_find_mac(hdr->chaddr);
+    if (entry != NULL)
     {
-        /* next IP address in the subnet */
-        dhcps.current_ip = ntohl(dhcps.my_ip & dhcps.netmask) | ((dhcps.current_ip + 1U) & ntohl(~dhcps.netmask));
-        while (!ac_valid_ip(dhcps.current_ip))
+        /* hold an address whose lease ended until the client requests it */
+        if (ac_expired(entry, ac_now()))
         {
-            dhcps.current_ip = ntohl(dhcps.my_ip & dhcps.netmask) | ((dhcps.current_ip + 1) & ntohl(~dhcps.netmask));
+            entry->expires = ac_now() + DHCP_OFFER_TIMEOUT;
+        }
+        new_ip = entry->client_ip;
+    }
+    else
+    {
+        /* next free IP address in the subnet */
+        hosts = ntohl(~dhcps.netmask);
+        for (probes = 0; probes < hosts; probes++)
+        {
+            dhcps.current_ip = ntohl(dhcps.my_ip & dhcps.netmask) | ((dhcps.current_ip + 1U) & hosts);
+            if (ac_valid_ip(dhcps.current_ip))
+            {
+                break;
+            }
+        }
+        if (probes == hosts)
+        {
+            dhcp_w("No free address left in the subnet");
+            return CLIENT_IP_NOT_FOUND;
         }
 
         new_ip = htonl(dhcps.current_ip);
 
-        if (ac_add(hdr->chaddr, new_ip) != WM_SUCCESS)
+        if (ac_add(hdr->chaddr, new_ip, DHCP_OFFER_TIMEOUT) != WM_SUCCESS)
         {
             dhcp_w("No space to store new mapping..");
         }
@@ -198,6 +472,10 @@ static unsigned int make_response(char *msg, enum dhcp_message_type type)
     hdr->ciaddr = 0;
     hdr->yiaddr = (type == DHCP_MESSAGE_ACK) ? dhcps.client_ip : 0U;
     hdr->yiaddr = (type == DHCP_MESSAGE_OFFER) ? next_yiaddr() : hdr->yiaddr;
+    if ((type == DHCP_MESSAGE_OFFER) && (hdr->yiaddr == CLIENT_IP_NOT_FOUND))
+    {
+        return 0;
+    }
     hdr->siaddr = 0;
     hdr->riaddr = 0;
     offset += sizeof(struct bootp_header);
@@ -397,11 +675,7 @@ static int process_dhcp_message(char *msg, int len)
                      * And if IP-MAC cache is not full then
                      * adds this entry in cache.
                      */
-                    if (ac_not_full())
-                    {
-                        (void)ac_add(hdr->chaddr, dhcps.client_ip);
-                    }
-                    else
+                    if (ac_add(hdr->chaddr, dhcps.client_ip, DHCP_OFFER_TIMEOUT) != WM_SUCCESS)
                     {
                         dhcp_w(
                             "No space to store new "
@@ -427,7 +701,16 @@ static int process_dhcp_message(char *msg, int len)
 
     if (response_type != DHCP_NO_RESPONSE)
     {
+        if (response_type == DHCP_MESSAGE_ACK)
+        {
+            ac_bind(hdr->chaddr, dhcps.client_ip);
+        }
         ret = make_response(msg, (enum dhcp_message_type)response_type);
+        if (ret == 0)
+        {
+            dhcp_d("no address to offer");
+            return WM_SUCCESS;
+        }
         ret = SEND_RESPONSE(dhcps.sock, (struct sockaddr *)(void *)&dhcps.baddr, msg, ret);
         if (response_type == DHCP_MESSAGE_ACK)
         {
@@ -496,8 +779,10 @@ void dhcpd_task(void *arg)
 #endif
     int max_sock;
     int len;
+    int batch;
     socklen_t flen = sizeof(caddr);
     fd_set rfds;
+    struct timeval timeout;
 
 #ifndef __ZEPHYR__
 
@@ -557,7 +842,11 @@ void dhcpd_task(void *arg)
         max_sock = (max_sock > ctrl) ? max_sock : ctrl;
 #endif
 
-        ret = net_select(max_sock + 1, &rfds, NULL, NULL, NULL);
+        /* wake up now and then to keep the lease clock ahead of the millisecond wrap */
+        timeout.tv_sec  = SERVER_CLOCK_TIMEOUT;
+        timeout.tv_usec = 0;
+        ret             = net_select(max_sock + 1, &rfds, NULL, NULL, &timeout);
+        (void)ac_now();
 
         /* Error in select? */
         if (ret < 0)
@@ -599,15 +888,21 @@ void dhcpd_task(void *arg)
 
         if (FD_ISSET(dhcps.sock, &rfds) != 0)
         {
-            len = recvfrom(dhcps.sock, dhcps.msg, sizeof(dhcps.msg), 0, (struct sockaddr *)(void *)&caddr, &flen);
-            if (len > 0)
+            /* handle the messages that queued up, the socket does not block */
+            for (batch = 0; batch < SERVER_BATCH_SIZE; batch++)
             {
+                flen = sizeof(caddr);
+                len  = recvfrom(dhcps.sock, dhcps.msg, sizeof(dhcps.msg), 0, (struct sockaddr *)(void *)&caddr, &flen);
+                if (len <= 0)
+                {
+                    break;
+                }
                 dhcp_d("recved msg on dhcp sock len: %d", len);
                 (void)process_dhcp_message(dhcps.msg, len);
             }
         }
 
-        dns_process_packet();
+        dns_process_packet(&rfds);
     }
 
 done:
@@ -711,6 +1006,9 @@ int dhcp_server_init(void *intrfc_handle)
         goto out;
     }
 
+    ac_init();
+    ac_load();
+
     dhcps.saddr.sin_family      = AF_INET;
     dhcps.saddr.sin_addr.s_addr = INADDR_ANY;
     dhcps.saddr.sin_port        = htons(DHCP_SERVER_PORT);
@@ -920,6 +1218,7 @@ void dhcp_stat(void)
 {
     int i = 0;
     struct ip4_addr saddr;
+    uint32_t now = ac_peek();
     (void)PRINTF("DHCP Server Lease Duration : %d seconds\r\n", (int)dhcp_address_timeout);
     if (dhcps.count_clients == 0)
     {
@@ -927,14 +1226,20 @@ void dhcp_stat(void)
     }
     else
     {
-        (void)PRINTF("Client IP\tClient MAC\r\n");
-        for (i = 0; i < dhcps.count_clients && i < MAC_IP_CACHE_SIZE; i++)
+        (void)PRINTF("Client IP\tClient MAC\t\tExpires in\r\n");
+        for (i = 0; i < MAC_IP_CACHE_SIZE; i++)
         {
+            if (dhcps.ip_mac_mapping[i].client_ip == CLIENT_IP_NOT_FOUND)
+            {
+                continue;
+            }
             saddr.addr = dhcps.ip_mac_mapping[i].client_ip;
-            (void)PRINTF("%s\t%02X:%02X:%02X:%02X:%02X:%02X\r\n", inet_ntoa(saddr),
+            (void)PRINTF("%s\t%02X:%02X:%02X:%02X:%02X:%02X\t%d s\r\n", inet_ntoa(saddr),
                          dhcps.ip_mac_mapping[i].client_mac[0], dhcps.ip_mac_mapping[i].client_mac[1],
                          dhcps.ip_mac_mapping[i].client_mac[2], dhcps.ip_mac_mapping[i].client_mac[3],
-                         dhcps.ip_mac_mapping[i].client_mac[4], dhcps.ip_mac_mapping[i].client_mac[5]);
+                         dhcps.ip_mac_mapping[i].client_mac[4], dhcps.ip_mac_mapping[i].client_mac[5],
+                         ac_expired(&dhcps.ip_mac_mapping[i], now) ? 0 :
+                                                                     (int)(dhcps.ip_mac_mapping[i].expires - now));
         }
     }
 }
@@ -58,80 +58,163 @@ static void format_qname(char *domain_name, char *dns_qname)
     dns_qname[0] = (char)i;
 }
 
-static unsigned int make_answer_rr(char *base, char *query, char *dst)
+#define DNS_TYPE_A   1U
+#define DNS_TYPE_ANY 255U
+#define DNS_CLASS_IN 1U
+#define DNS_TTL      (60U * 60U * 1U) /* 1 hour */
+
+#if CONFIG_MEM_POOLS
+/* the names are kept in one buf_1280_MemoryPool block */
+#define DNS_MAX_QNAMES (1280U / sizeof(struct dns_qname))
+#else
+#define DNS_MAX_QNAMES 255U
+#endif
+
+static uint8_t dns_tolower(uint8_t c)
 {
-    struct dns_question *q;
-    struct dns_rr *rr = (struct dns_rr *)(void *)dst;
-    char *query_start = query;
+    return ((c >= (uint8_t)'A') && (c <= (uint8_t)'Z')) ? (uint8_t)(c + ('a' - 'A')) : c;
+}
 
-    rr->name_ptr = htons(((uint16_t)(query - base) | 0xC000U));
+/* Walks the uncompressed QNAME at pos, names are compared without regard to
+ * case. Returns the FNV-1a hash of the name and its length including the
+ * root label in len, len is 0 if the name is malformed or does not end
+ * before end.
+ */
+static uint32_t dns_hash_qname(const uint8_t *pos, const uint8_t *end, unsigned int *len)
+{
+    const uint8_t *p = pos;
+    uint32_t hash    = 2166136261U;
+    unsigned int label;
 
-    /* skip past the qname (label) field */
-    do
+    *len = 0;
+    while ((p < end) && (*p != 0U))
     {
-        if (*query > 0U)
+        label = *p;
+        if ((label > 63U) || (p + label + 1U >= end))
         {
-            query += *query + 1;
+            return 0;
         }
-    } while (*query > 0U);
-    query++;
-
-    q = (struct dns_question *)(void *)query;
-    query += sizeof(struct dns_question);
-
-    rr->type     = q->type;
-    rr->class    = q->class;
-    rr->ttl      = htonl(60U * 60U * 1U); /* 1 hour */
-    rr->rdlength = htons(4);
-    rr->rd       = dhcps.my_ip;
+        hash = (hash ^ label) * 16777619U;
+        for (p++; label > 0U; label--, p++)
+        {
+            hash = (hash ^ dns_tolower(*p)) * 16777619U;
+        }
+    }
+    if (p >= end)
+    {
+        return 0;
+    }
 
-    return (unsigned int)(query - query_start);
+    *len = (unsigned int)(p + 1 - pos);
+    return hash;
 }
 
-static char *parse_questions(unsigned int num_questions, uint8_t *pos, int *found)
+/* Copies the QNAME at pos of msg into name without compression, a name may
+ * end in a pointer to an earlier name of the message (RFC 1035 4.1.4).
+ * Returns the bytes the QNAME takes at pos, 0 if it is malformed. name_len is
+ * the length of the copy including the root label, 0 if it does not fit name,
+ * such a name matches no domain name.
+ */
+static unsigned int dns_read_qname(const uint8_t *msg,
+                                   const uint8_t *pos,
+                                   const uint8_t *end,
+                                   uint8_t *name,
+                                   unsigned int *name_len)
 {
-    uint8_t *base = pos;
-    int i;
-
-    pos += sizeof(struct dns_header);
-
-    for (; num_questions > 0U; num_questions--)
+    const uint8_t *p      = pos;
+    const uint8_t *target = pos;
+    unsigned int size     = 0;
+    unsigned int n        = 0;
+    unsigned int label;
+    bool fits = true;
+
+    while ((p < end) && (*p != 0U))
     {
-        if (!*found)
+        label = *p;
+        if ((label & 0xC0U) == 0xC0U)
         {
-            for (i = 0; i < dnss.count_qnames; i++)
+            if (p + 1 >= end)
+            {
+                return 0;
+            }
+            if (size == 0U)
+            {
+                size = (unsigned int)(p + 2 - pos);
+            }
+            /* every pointer has to go back further than the one before,
+             * so that the walk ends */
+            p = msg + (((label & 0x3FU) << 8) | p[1]);
+            if ((p < msg + sizeof(struct dns_header)) || (p >= target))
             {
-                *found =
-                    (int)(!strncmp(dnss.list_qnames[i].qname, (char *)pos, (size_t)(base + SERVER_BUFFER_SIZE - pos)));
-                if (*found != 0)
-                {
-                    break;
-                }
+                return 0;
             }
+            target = p;
+            continue;
+        }
+        if ((label > 63U) || (p + label + 1U >= end))
+        {
+            return 0;
         }
-        do
+        if (fits && (n + label + 1U < MAX_QNAME_SIZE + 1U))
         {
-            if (*pos > 0U)
+            (void)memcpy(&name[n], p, label + 1U);
+            n += label + 1U;
+        }
+        else
+        {
+            fits = false;
+        }
+        p += label + 1U;
+    }
+    if (p >= end)
+    {
+        return 0;
+    }
+
+    name[n]   = 0;
+    *name_len = fits ? (n + 1U) : 0U;
+    return (size != 0U) ? size : (unsigned int)(p + 1 - pos);
+}
+
+static bool dns_match_qname(const uint8_t *qname, unsigned int len, uint32_t hash)
+{
+    const struct dns_qname *entry;
+    uint8_t index;
+    unsigned int i;
+
+    index = dnss.qname_hash[hash & (DNS_QNAME_HASH_SIZE - 1U)];
+    while (index != 0U)
+    {
+        entry = &dnss.list_qnames[index - 1U];
+        if ((entry->hash == hash) && (entry->len == len))
+        {
+            for (i = 0; (i < len) && (dns_tolower((uint8_t)entry->qname[i]) == dns_tolower(qname[i])); i++)
             {
-                pos += *pos + 1U;
             }
-            if (pos >= base + SERVER_BUFFER_SIZE)
+            if (i == len)
             {
-                return NULL;
+                return true;
             }
-        } while (*pos > 0U);
-        pos += 1U + sizeof(struct dns_question);
+        }
+        index = entry->next;
     }
-    return (char *)pos;
+    return false;
 }
 
 #define ERROR_REFUSED 5
 static int process_dns_message(char *msg, int len, struct sockaddr_in *fromaddr)
 {
     struct dns_header *hdr;
-    char *pos;
-    char *outp = msg + len;
-    int found  = 0, nq, i;
+    struct dns_question q;
+    uint16_t answers[DNS_MAX_ANSWERS]; /* offsets of the questions answered */
+    const uint8_t *end = (uint8_t *)msg + len;
+    const uint8_t *pos;
+    char *outp;
+    uint8_t qname[MAX_QNAME_SIZE + 1];
+    unsigned int qname_len, name_len, hash_len;
+    uint32_t hash;
+    bool matched;
+    int found = 0, nq, na = 0, i;
 
     if (len < sizeof(struct dns_header))
     {
@@ -139,7 +222,8 @@ static int process_dns_message(char *msg, int len, struct sockaddr_in *fromaddr)
         return -WM_E_DHCPD_DNS_IGNORE;
     }
 
-    hdr = (struct dns_header *)(void *)msg;
+    hdr            = (struct dns_header *)(void *)msg;
+    hdr->flags.num = ntohs(hdr->flags.num);
 
     dhcp_d("DNS transaction id: 0x%x", htons(hdr->id));
 
@@ -158,25 +242,65 @@ static int process_dns_message(char *msg, int len, struct sockaddr_in *fromaddr)
         return -WM_E_DHCPD_DNS_IGNORE;
     }
 
-    outp = parse_questions((unsigned int)nq, (uint8_t *)msg, &found);
-    if (found && outp != NULL)
+    /* one pass over the questions, the names are looked up in the
+     * prebuilt index and the A questions to answer are remembered
+     */
+    pos = (uint8_t *)msg + sizeof(struct dns_header);
+    for (i = 0; i < nq; i++)
     {
-        pos = msg + sizeof(struct dns_header);
-        for (i = 0; i < nq; i++)
+        qname_len = dns_read_qname((uint8_t *)msg, pos, end, qname, &name_len);
+        if ((qname_len == 0U) || (pos + qname_len + sizeof(struct dns_question) > end))
+        {
+            dhcp_e("ignoring this dns msg (malformed question)");
+            return -WM_E_DHCPD_DNS_IGNORE;
+        }
+        /* "*" answers every name, also those too long for a domain name */
+        matched = dnss.wildcard;
+        if (!matched && (name_len != 0U))
         {
-            if (outp + sizeof(struct dns_rr) >= msg + SERVER_BUFFER_SIZE)
+            hash    = dns_hash_qname(qname, qname + name_len, &hash_len);
+            matched = dns_match_qname(qname, name_len, hash);
+        }
+        if (matched)
+        {
+            found = 1;
+            (void)memcpy(&q, pos + qname_len, sizeof(q));
+            if (((q.type == htons(DNS_TYPE_A)) || (q.type == htons(DNS_TYPE_ANY))) &&
+                (q.class == htons(DNS_CLASS_IN)) && (na < DNS_MAX_ANSWERS))
             {
-                dhcp_d("no room for more answers, refusing");
-                break;
+                answers[na++] = (uint16_t)((const char *)pos - msg);
             }
-            pos += make_answer_rr(msg, pos, outp);
+        }
+        pos += qname_len + sizeof(struct dns_question);
+    }
+    /* records after the questions, e.g. EDNS options, are dropped */
+    outp = (char *)pos;
+
+    /* make the header represent a response */
+    hdr->flags.fields.qr = 1;
+    hdr->flags.fields.tc = 0;
+    hdr->flags.fields.ra = 0;
+    hdr->authority_rrs   = 0;
+    hdr->additional_rrs  = 0;
+
+    /* a matched name without an A question gets an empty answer */
+    if (found)
+    {
+        if (na > (int)((msg + SERVER_BUFFER_SIZE - outp) / (int)sizeof(struct dns_rr)))
+        {
+            dhcp_d("no room for more answers");
+            na = (int)((msg + SERVER_BUFFER_SIZE - outp) / (int)sizeof(struct dns_rr));
+        }
+        for (i = 0; i < na; i++)
+        {
+            (void)memcpy(outp, &dnss.answer, sizeof(struct dns_rr));
+            ((struct dns_rr *)(void *)outp)->name_ptr = htons(answers[i] | 0xC000U);
             outp += sizeof(struct dns_rr);
         }
-        hdr->flags.fields.qr    = 1;
         hdr->flags.fields.aa    = 1;
         hdr->flags.fields.rcode = 0;
         hdr->flags.num          = htons(hdr->flags.num);
-        hdr->answer_rrs         = htons((uint16_t)i);
+        hdr->answer_rrs         = htons((uint16_t)na);
         /* the response consists of:
          * - 1 x DNS header
          * - num_questions x query fields from the message we're parsing
@@ -185,22 +309,14 @@ static int process_dns_message(char *msg, int len, struct sockaddr_in *fromaddr)
         return SEND_RESPONSE(dnss.dnssock, (struct sockaddr *)(void *)fromaddr, msg, outp - msg);
     }
 
-    /* make the header represent a response */
-    hdr->flags.fields.qr     = 1;
     hdr->flags.fields.opcode = 0;
     /* Errors are never authoritative (unless they are
        NXDOMAINS, which this is not) */
     hdr->flags.fields.aa    = 0;
-    hdr->flags.fields.tc    = 0;
     hdr->flags.fields.rd    = 1;
-    hdr->flags.fields.ra    = 0;
     hdr->flags.fields.rcode = ERROR_REFUSED;
     hdr->flags.num          = htons(hdr->flags.num);
-    /* number of entries in questions section */
-    hdr->num_questions  = htons(0x01);
-    hdr->answer_rrs     = 0; /* number of resource records in answer section */
-    hdr->authority_rrs  = 0;
-    hdr->additional_rrs = 0;
+    hdr->answer_rrs         = 0; /* number of resource records in answer section */
     (void)SEND_RESPONSE(dnss.dnssock, (struct sockaddr *)(void *)fromaddr, msg, outp - msg);
 
     return -WM_E_DHCPD_DNS_IGNORE;
@@ -213,7 +329,9 @@ void dhcp_enable_dns_server(char **domain_names)
         return;
     }
 
-    int i;
+    int i, n = 0;
+    unsigned int len;
+    struct dns_qname *entry;
     /* To reduce footprint impact, dns server support is kept optional */
     dhcp_dns_server_handler = process_dns_message;
     if (domain_names != NULL)
@@ -222,20 +340,47 @@ void dhcp_enable_dns_server(char **domain_names)
         {
             dnss.count_qnames++;
         }
+        if (dnss.count_qnames > (int)DNS_MAX_QNAMES)
+        {
+            dhcp_w("only %d domain names are kept, ignoring the others", (int)DNS_MAX_QNAMES);
+            dnss.count_qnames = (int)DNS_MAX_QNAMES;
+        }
 #if !CONFIG_MEM_POOLS
         dnss.list_qnames = OSA_MemoryAllocate(dnss.count_qnames * sizeof(struct dns_qname));
 #else
-        /*TODO:This function is not called from anywhere .
-         * Please make sure to assign correct memory pool
-         * whenever this function will be used. */
-
         dnss.list_qnames = OSA_MemoryPoolAllocate(buf_1280_MemoryPool);
 #endif
+        if (dnss.list_qnames == NULL)
+        {
+            dhcp_e("no memory for the domain names");
+            dnss.count_qnames = 0;
+            return;
+        }
+        (void)memset(dnss.qname_hash, 0, sizeof(dnss.qname_hash));
         for (i = 0; i < dnss.count_qnames; i++)
         {
-            (void)memset(dnss.list_qnames[i].qname, 0, sizeof(struct dns_qname));
-            format_qname(domain_names[i], dnss.list_qnames[i].qname);
+            if (strcmp(domain_names[i], "*") == 0)
+            {
+                dnss.wildcard = true;
+                continue;
+            }
+            if (strlen(domain_names[i]) >= MAX_QNAME_SIZE)
+            {
+                dhcp_w("domain name %s is too long, ignoring it", domain_names[i]);
+                continue;
+            }
+
+            /* the names are indexed by the hash of their QNAME */
+            entry = &dnss.list_qnames[n];
+            (void)memset(entry, 0, sizeof(struct dns_qname));
+            format_qname(domain_names[i], entry->qname);
+            entry->hash = dns_hash_qname((uint8_t *)entry->qname, (uint8_t *)entry->qname + sizeof(entry->qname), &len);
+            entry->len  = (uint8_t)len;
+            entry->next = dnss.qname_hash[entry->hash & (DNS_QNAME_HASH_SIZE - 1U)];
+            n++;
+            dnss.qname_hash[entry->hash & (DNS_QNAME_HASH_SIZE - 1U)] = (uint8_t)n;
         }
+        dnss.count_qnames = n;
     }
 }
 
@@ -255,24 +400,43 @@ int dns_server_init(void *intrfc_handle)
         return -WM_E_DHCPD_SOCKET;
     }
 
+    /* every answer is an A record of our address */
+    dnss.answer.name_ptr = 0;
+    dnss.answer.type     = htons(DNS_TYPE_A);
+    dnss.answer.class    = htons(DNS_CLASS_IN);
+    dnss.answer.ttl      = htonl(DNS_TTL);
+    dnss.answer.rdlength = htons(4);
+    dnss.answer.rd       = dhcps.my_ip;
+
     return WM_SUCCESS;
 }
 
-void dns_process_packet(void)
+void dns_process_packet(fd_set *rfds)
 {
-    if (dhcp_dns_server_handler == NULL)
+    if ((dhcp_dns_server_handler == NULL) || (FD_ISSET(dnss.dnssock, rfds) == 0))
     {
         return;
     }
 
     struct sockaddr_in caddr;
-    socklen_t flen = sizeof(caddr);
+    socklen_t flen;
     int len;
-    len = recvfrom(dnss.dnssock, dhcps.msg, sizeof(dhcps.msg), 0, (struct sockaddr *)(void *)&caddr, &flen);
-    if (len > 0 && len < SERVER_BUFFER_SIZE)
+    int n;
+
+    /* answer the queries that queued up, the socket does not block */
+    for (n = 0; n < SERVER_BATCH_SIZE; n++)
     {
-        dhcp_d("recved msg on dns sock len: %d", len);
-        (void)dhcp_dns_server_handler(dhcps.msg, len, &caddr);
+        flen = sizeof(caddr);
+        len  = recvfrom(dnss.dnssock, dhcps.msg, sizeof(dhcps.msg), 0, (struct sockaddr *)(void *)&caddr, &flen);
+        if (len <= 0)
+        {
+            break;
+        }
+        if (len < SERVER_BUFFER_SIZE)
+        {
+            dhcp_d("recved msg on dns sock len: %d", len);
+            (void)dhcp_dns_server_handler(dhcps.msg, len, &caddr);
+        }
     }
 }
 
@@ -323,5 +487,7 @@ void dns_free_allocations(void)
         }
         dnss.dnssock = -1;
     }
+    (void)memset(dnss.qname_hash, 0, sizeof(dnss.qname_hash));
+    dnss.wildcard           = false;
     dhcp_dns_server_handler = NULL;
 }
@@ -57,9 +57,15 @@ PACK_START struct dns_rr
                field of length rdlength */
 } PACK_END;
 
+#define DNS_QNAME_HASH_SIZE 16 /* buckets of the name index, power of two */
+#define DNS_MAX_ANSWERS     8  /* answers sent per query */
+
 struct dns_qname
 {
     char qname[MAX_QNAME_SIZE + 1];
+    uint32_t hash; /* hash of qname, see dns_hash_qname() */
+    uint8_t len;   /* length of qname including the root label */
+    uint8_t next;  /* next name of the hash chain plus one, 0 ends it */
 };
 
 struct dns_server_data
@@ -68,10 +74,15 @@ struct dns_server_data
     int dnssock;
     struct sockaddr_in dnsaddr; /* dns server address */
     struct dns_qname *list_qnames;
+    uint8_t qname_hash[DNS_QNAME_HASH_SIZE]; /* first name of each hash
+                                              * chain plus one */
+    bool wildcard;                           /* "*" answers every name */
+    struct dns_rr answer;                    /* answer template, name_ptr is
+                                              * set per question */
 };
 
 int dns_server_init(void *intrfc_handle);
-void dns_process_packet(void);
+void dns_process_packet(fd_set *rfds);
 uint32_t dns_get_nameserver(void);
 int dns_get_maxsock(fd_set *rfds);
 void dns_free_allocations(void);
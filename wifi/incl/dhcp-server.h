@@ -117,6 +117,12 @@ int dhcp_server_start(void *intrfc_handle);
  *
  * dhcp_enable_dns_server(domain_names);
  *
+ * A domain name of "*" resolves every name to the device ip address, as a
+ * captive portal does. Names are matched without regard to case and only
+ * A queries are answered, other queries for a known name get an empty
+ * answer. Up to 255 domain names are kept, or as many as fit a 1280 byte
+ * memory pool block with CONFIG_MEM_POOLS.
+ *
  * However, application can also start dns server without any domain names
  * specified to solve following issue.
  * Some of the client devices do not show Wi-Fi signal strength symbol when
@@ -146,6 +152,31 @@ void dhcp_server_stop(void);
  */
 int dhcp_server_lease_timeout(uint32_t val);
 
+/** Register functions that keep the DHCP leases across restarts
+ *
+ * The DHCP server keeps up to CONFIG_DHCP_SERVER_LEASES leases. Leases
+ * that ended are reclaimed when the table is full or their address is
+ * needed. With a lease store registered, the table is restored from it
+ * when the server starts. It is saved whenever a client is bound to an
+ * address, renewals are not saved. The data is opaque to the store, e.g.
+ * it can be written to a flash file as is.
+ *
+ * This API should be invoked before DHCP server initialization.
+ *
+ * At most DHCP_SERVER_LEASE_STORE_SIZE bytes are saved.
+ *
+ * \param[in] save Function that stores len bytes of data, returns
+ *             WM_SUCCESS on success, or NULL.
+ * \param[in] load Function that reads at most len bytes of the last
+ *             saved data into data, returns the number of bytes read or a
+ *             negative error code, or NULL.
+ */
+void dhcp_server_set_lease_store(int (*save)(const void *data, uint32_t len), int (*load)(void *data, uint32_t len));
+
+/** Largest lease table handed to the lease store: an 8 byte header and
+ *  16 bytes per lease */
+#define DHCP_SERVER_LEASE_STORE_SIZE (8U + (CONFIG_DHCP_SERVER_LEASES * 16U))
+
 /** Get IP address corresponding to MAC address from dhcpd ip-mac mapping
  *
  * This API returns IP address mapping to the MAC address present in cache.
@@ -413,6 +413,34 @@ static inline int net_stack_buffer_copy_partial(void *stack_buffer, void *dst, u
 int net_stack_buffer_copy_partial(void *stack_buffer, void *dst, uint16_t len, uint16_t offset);
 #endif
 
+/** Check whether the data of a stack buffer is in one piece.
+ *
+ * \param[in] buf input stack buffer.
+ *
+ * \return true if the whole payload can be accessed through net_stack_buffer_get_payload().
+ */
+static inline bool net_stack_buffer_is_contiguous(void *buf)
+{
+#if defined(SDK_OS_FREE_RTOS)
+    return (((struct pbuf *)buf)->next == NULL);
+#elif __ZEPHYR__
+    return (((struct net_pkt *)buf)->buffer->frags == NULL);
+#endif
+}
+
+/** Get a free running microsecond time stamp of the network stack.
+ *
+ * \return time in microseconds, wraps around after about 71 minutes.
+ */
+static inline uint32_t net_stack_time_us(void)
+{
+#if defined(SDK_OS_FREE_RTOS)
+    return sys_now_us();
+#elif __ZEPHYR__
+    return k_cyc_to_us_floor32(k_cycle_get_32());
+#endif
+}
+
 /** Get the data payload inside the stack buffer.
  *
  * \param[in] buf input stack buffer.
@@ -801,6 +829,82 @@ void dhcp_stat(void);
  */
 void net_stat(void);
 
+#if defined(SDK_OS_FREE_RTOS) && PBUF_RX_SIZE_CLASSES
+/** RX pbuf size classes, smallest first */
+enum net_rx_pbuf_class
+{
+    NET_RX_PBUF_SMALL = 0,
+    NET_RX_PBUF_MEDIUM,
+    NET_RX_PBUF_POOL,
+    NET_RX_PBUF_CLASSES,
+};
+
+/** Usage of one RX pbuf size class */
+struct net_rx_pbuf_class_stats
+{
+    /** Buffer size of the class */
+    uint16_t bufsize;
+    /** Number of buffers in the class */
+    uint16_t avail;
+    /** Buffers currently in use */
+    uint16_t used;
+    /** Highest number of buffers in use */
+    uint16_t max;
+    /** Frames that fit this class */
+    uint32_t alloc;
+    /** Frames served by a larger class because this one was empty */
+    uint32_t spill;
+    /** Allocation attempts that found this and every larger class empty */
+    uint32_t empty;
+};
+
+/** Get the usage of an RX pbuf size class
+ *
+ * \param[in] rx_class one of \ref net_rx_pbuf_class.
+ * \param[out] stats usage of the class.
+ * \return WM_SUCCESS on success or -WM_FAIL if rx_class is out of range.
+ */
+int net_rx_pbuf_class_stats(unsigned int rx_class, struct net_rx_pbuf_class_stats *stats);
+#endif
+
+#if defined(SDK_OS_FREE_RTOS)
+/** Frames sent on the Wi-Fi interfaces */
+struct net_tx_copy_stats
+{
+    /** Frames handed to the driver in the lwIP buffer, with the driver headers in its headroom */
+    uint32_t zero_copy;
+    /** Frames copied into a driver buffer because they were chained or lacked headroom */
+    uint32_t copied;
+};
+
+/** Get the number of frames sent with and without copying
+ *
+ * \param[out] stats frame counts since boot.
+ */
+void net_tx_copy_stats(struct net_tx_copy_stats *stats);
+
+#if CONFIG_WMM
+/** WMM TX queue back-pressure on the Wi-Fi interfaces */
+struct net_tx_flow_stats
+{
+    /** Frames refused because the TX queues were full, per access category BK, BE, VI, VO */
+    uint32_t full[4];
+    /** Times TCP was resumed after a queue buffer was freed */
+    uint32_t resumes;
+    /** Longest time the queues stayed full, in ms */
+    uint32_t stall_ms_max;
+    /** Longest time from the freed buffer to the resume in the tcpip thread, in us */
+    uint32_t resume_latency_us_max;
+};
+
+/** Get the WMM TX queue back-pressure counters
+ *
+ * \param[out] stats counters since boot.
+ */
+void net_tx_flow_stats(struct net_tx_flow_stats *stats);
+#endif
+#endif
+
 
 #ifdef MGMT_RX
 void rx_mgmt_register_callback(int (*rx_mgmt_cb_fn)(const enum wlan_bss_type bss_type,
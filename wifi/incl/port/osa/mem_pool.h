@@ -20,7 +20,7 @@
 
 #if defined(SDK_OS_FREE_RTOS)
 
-#include "stack_simple.h"
+#include "slist.h"
 
 /**
  *  The actual Memory Pool data structure.
@@ -30,14 +30,10 @@
 typedef struct MemPool_t_
 {
     /**
-     *  We need a lock to make this thread safe.
+     *  Free memory blocks are stored on a stack, updated without a lock
+     *  so the pool can be used from ISRs.
      */
-    OSA_MUTEX_HANDLE_DEFINE(Lock);
-
-    /**
-     *  Memory blocks are stored on a stack.
-     */
-    Stack_t Stack;
+    SlNode_t *volatile Head;
 
     /**
      *  Save the item size for additions.
@@ -49,6 +45,22 @@ typedef struct MemPool_t_
      */
     int Alignment;
 
+    /**
+     *  Number of blocks the pool was created with.
+     */
+    uint32_t ItemCount;
+
+    /**
+     *  Blocks currently allocated, and the most ever allocated at once.
+     */
+    volatile uint32_t InUse;
+    volatile uint32_t HighWater;
+
+    /**
+     *  Allocations that failed because the pool was empty.
+     */
+    volatile uint32_t Failures;
+
     /**
      *  The begining of the actual memory pool itself.
      */
@@ -56,6 +68,18 @@ typedef struct MemPool_t_
 
 } MemPool_t;
 
+/**
+ *  Memory pool usage, see OSA_MemoryPoolGetStats().
+ */
+typedef struct MemPoolStats_t_
+{
+    uint32_t ItemSize;  /**< Size of a block including its overhead */
+    uint32_t ItemCount; /**< Number of blocks in the pool */
+    uint32_t InUse;     /**< Blocks currently allocated */
+    uint32_t HighWater; /**< Most blocks ever allocated at once */
+    uint32_t Failures;  /**< Allocations that found the pool empty */
+} MemPoolStats_t;
+
 #elif defined(FSL_RTOS_THREADX)
 
 typedef TX_BLOCK_POOL MemPool_t;
@@ -77,7 +101,7 @@ MemoryPool_t OSA_MemoryPoolCreate(
     MemPool_t *MemPool, int ItemSize, void *PreallocatedMemory, int PreallocatedMemorySize, int Alignment);
 
 /**Get a memory buffer from the pool.
- * Note that this can block, and cannnot be used from ISR context.
+ * On FreeRTOS this never blocks and can be used from ISR context.
  *
  *\param[in] pool A handle to a MemoryPool.
  *\return A pointer or NULL on failure.
@@ -86,7 +110,7 @@ void *OSA_MemoryPoolAllocate(MemoryPool_t pool);
 
 /**free a memory buffer to the pool.
  *
- *  note This can block, and cannnot be used from ISR context.
+ *  note On FreeRTOS this never blocks and can be used from ISR context.
  *  note There is no check that the memory passed in is valid.
  *
  *\param[in] pool A handle to a MemoryPool.
@@ -94,4 +118,13 @@ void *OSA_MemoryPoolAllocate(MemoryPool_t pool);
  */
 void OSA_MemoryPoolFree(MemoryPool_t pool, void *memory);
 
+#if defined(SDK_OS_FREE_RTOS)
+/**Get the usage counters of a pool.
+ *
+ *\param[in] pool A handle to a MemoryPool.
+ *\param[out] stats the counters since the pool was created.
+ */
+void OSA_MemoryPoolGetStats(MemoryPool_t pool, MemPoolStats_t *stats);
+#endif
+
 #endif
@@ -677,6 +677,60 @@
 #endif
 #endif
 
+/** CONFIG_WLAN_BSS_CACHE keeps the BSSs found by the last scans in RAM,
+ *  with the time they were last seen and their last RSSI values. A connect
+ *  request skips the scan when the last scan saw the network less than
+ *  CONFIG_WLAN_BSS_CACHE_MAX_AGE_MS ago.
+ */
+#if !defined CONFIG_WLAN_BSS_CACHE
+#if CONFIG_WPA_SUPP
+#define CONFIG_WLAN_BSS_CACHE 0
+#else
+#define CONFIG_WLAN_BSS_CACHE 1
+#endif
+#endif
+
+#if !defined CONFIG_WLAN_BSS_CACHE_SIZE
+#define CONFIG_WLAN_BSS_CACHE_SIZE 16
+#endif
+
+#if !defined CONFIG_WLAN_BSS_CACHE_MAX_AGE_MS
+#define CONFIG_WLAN_BSS_CACHE_MAX_AGE_MS 10000
+#endif
+
+/** CONFIG_SCAN_EARLY_STOP lets the connect scan for a known SSID start on
+ *  the channels the SSID was last seen on and end as soon as an AP of it
+ *  with an RSSI of at least -CONFIG_SCAN_EARLY_STOP_RSSI dBm is found.
+ */
+#if !defined CONFIG_SCAN_EARLY_STOP
+#if CONFIG_WPA_SUPP
+#define CONFIG_SCAN_EARLY_STOP 0
+#else
+#define CONFIG_SCAN_EARLY_STOP 1
+#endif
+#endif
+
+#if !defined CONFIG_SCAN_EARLY_STOP_RSSI
+#define CONFIG_SCAN_EARLY_STOP_RSSI 70
+#endif
+
+/** CONFIG_WIFI_TRACE records the round trip time of every firmware command
+ *  and the time every event waits in the connection manager queue in a
+ *  ring of CONFIG_WIFI_TRACE_RECORDS entries.
+ */
+#if !defined CONFIG_WIFI_TRACE
+#define CONFIG_WIFI_TRACE 1
+#endif
+
+#if !defined CONFIG_WIFI_TRACE_RECORDS
+#define CONFIG_WIFI_TRACE_RECORDS 128
+#endif
+
+/** Number of clients the uAP DHCP server keeps leases for, at most 255 */
+#if !defined CONFIG_DHCP_SERVER_LEASES
+#define CONFIG_DHCP_SERVER_LEASES 64
+#endif
+
 #if !defined CONFIG_DRIVER_MBO
 #if defined(RW610) || defined(SD9177)
 #define CONFIG_DRIVER_MBO (CONFIG_11AX && !CONFIG_WPA_SUPP)
@@ -997,6 +1051,35 @@
 #endif
 #endif
 
+/** CONFIG_IMU_RX_ZERO_COPY hands received data frames of at least
+ *  CONFIG_IMU_RX_ZERO_COPY_MIN bytes to lwIP in the IMU rx buffer itself,
+ *  the buffer goes back to the firmware when lwIP frees the pbuf. At most
+ *  CONFIG_IMU_RX_ZERO_COPY_BUFS buffers are held at a time, further frames
+ *  are copied. Not used together with CONFIG_TX_RX_ZERO_COPY.
+ */
+#if !defined CONFIG_IMU_RX_ZERO_COPY
+#if defined(RW610) && !CONFIG_TX_RX_ZERO_COPY
+#define CONFIG_IMU_RX_ZERO_COPY 1
+#else
+#define CONFIG_IMU_RX_ZERO_COPY 0
+#endif
+#endif
+
+#if !defined CONFIG_IMU_RX_ZERO_COPY_BUFS
+#define CONFIG_IMU_RX_ZERO_COPY_BUFS 8
+#endif
+
+#if !defined CONFIG_IMU_RX_ZERO_COPY_MIN
+#define CONFIG_IMU_RX_ZERO_COPY_MIN 512
+#endif
+
+/** Number of A-MSDU subframes that can be held by the network stack as
+ *  views into the A-MSDU buffer, further subframes are copied.
+ */
+#if !defined CONFIG_AMSDU_RX_REF_PBUFS
+#define CONFIG_AMSDU_RX_REF_PBUFS 16
+#endif
+
 #if !defined CONFIG_WIFI_CLOCKSYNC
 #if defined(RW610)
 #define CONFIG_WIFI_CLOCKSYNC 1
@@ -182,8 +182,54 @@ struct wifi_message
     uint16_t event;
     enum wifi_event_reason reason;
     void *data;
+#if CONFIG_WIFI_TRACE
+    /** Time the message was queued, see wifi_trace_queued() */
+    uint32_t time_us;
+#endif
 };
 
+#if CONFIG_WIFI_TRACE
+/** Kinds of records in the trace ring */
+enum wifi_trace_type
+{
+    /** Firmware command, the latency is its round trip time */
+    WIFI_TRACE_CMD = 0,
+    /** Connection manager event, the latency is the time it waited in the queue */
+    WIFI_TRACE_EVENT,
+};
+
+/** One record of the trace ring */
+typedef struct
+{
+    /** Time the command was sent or the event queued, in microseconds */
+    uint32_t start_us;
+    /** Round trip or queue time, in microseconds */
+    uint32_t latency_us;
+    /** Firmware command code or event id */
+    uint16_t id;
+    /** enum wifi_trace_type */
+    uint8_t type;
+    /** 0 on success, 1 if the command timed out, event reason for events */
+    uint8_t status;
+} wifi_trace_record_t;
+
+/** Latency summary of one command code or event id */
+typedef struct
+{
+    /** Firmware command code or event id */
+    uint16_t id;
+    /** enum wifi_trace_type */
+    uint8_t type;
+    /** Number of records in the ring */
+    uint32_t count;
+    /** Latency percentiles, in microseconds */
+    uint32_t p50_us;
+    uint32_t p90_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+} wifi_trace_summary_t;
+#endif
+
 
 /* Wlan Cipher structure */
 typedef struct
@@ -1434,6 +1480,26 @@ typedef PACK_START struct _wifi_scan_channel_list_t
     t_u16 scan_time;
 } PACK_END wifi_scan_channel_list_t;
 
+#if CONFIG_SCAN_EARLY_STOP
+/** Maximum number of channels an early stop scan scans first */
+#define SCAN_EARLY_STOP_MAX_CHANNELS 4U
+
+/** Early stop of a scan, see wifi_set_scan_early_stop() */
+typedef struct _wifi_scan_early_stop_t
+{
+    /** SSID to look for */
+    char ssid[MLAN_MAX_SSID_LENGTH + 1];
+    /** BSSID to look for, all zero for any */
+    t_u8 bssid[MLAN_MAC_ADDR_LENGTH];
+    /** Stop at a match with an RSSI of at least -rssi_threshold dBm */
+    t_u8 rssi_threshold;
+    /** Number of channels in chan_list */
+    t_u8 num_channels;
+    /** Channels to scan before the others, most likely first */
+    t_u8 chan_list[SCAN_EARLY_STOP_MAX_CHANNELS];
+} wifi_scan_early_stop_t;
+#endif
+
 /* Configuration for wireless scanning */
 #if defined(RW610) && (CONFIG_ANT_DETECT)
 #define ANT_DETECT_MAX_CHANNEL_LIST 50U
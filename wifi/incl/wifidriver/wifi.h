@@ -269,7 +269,10 @@ void wifi_deregister_get_rxbuf_desc_callback(void);
  * processed AMSDU DATA from Wi-Fi driver.
  *
  * This callback function is used to send data received from Wi-Fi
- * firmware to the networking stack.
+ * firmware to the networking stack. amsdu_buf is the stack buffer
+ * holding the whole A-MSDU when buffer points into it, the callback may
+ * then keep a reference to amsdu_buf instead of copying the subframe.
+ * It is NULL when the A-MSDU was copied to a driver buffer.
  *
  * @param[in] amsdu_data_input_callback Function that needs to be called
  *
@@ -278,7 +281,8 @@ void wifi_deregister_get_rxbuf_desc_callback(void);
  */
 int wifi_register_amsdu_data_input_callback(void (*amsdu_data_input_callback)(uint8_t interface,
                                                                               uint8_t *buffer,
-                                                                              uint16_t len));
+                                                                              uint16_t len,
+                                                                              void *amsdu_buf));
 
 /** Deregister Data callback function from Wi-Fi Driver */
 void wifi_deregister_amsdu_data_input_callback(void);
@@ -294,9 +298,69 @@ int wifi_register_wrapper_net_is_ip_or_ipv6_callback(bool (*wrapper_net_is_ip_or
 void wifi_deregister_wrapper_net_is_ip_or_ipv6_callback(void);
 
 #if CONFIG_WMM
+/**
+ * Register the function that is called when a WMM TX buffer is freed after
+ * a sender found the WMM TX queues full and wifi_wmm_tx_full() recorded it.
+ *
+ * The callback runs in the context that freed the buffer and must not block.
+ *
+ * @param[in] tx_resume_callback Function called with one bit set per
+ *            interface and access category that was full.
+ *
+ * @return WM_SUCCESS on success, -WM_FAIL if a callback is already registered.
+ */
+int wifi_register_tx_resume_callback(void (*tx_resume_callback)(t_u32 full_mask));
+
+/** Deregister the TX resume callback */
+void wifi_deregister_tx_resume_callback(void);
+
 int wifi_add_to_bypassq(const t_u8 interface, void *pkt, t_u32 len);
 #endif
 
+#if CONFIG_WIFI_TRACE
+/**
+ * Stamp a connection manager message with the time it is queued.
+ *
+ * @param[out] msg Message about to be put into the queue.
+ */
+void wifi_trace_queued(struct wifi_message *msg);
+
+/**
+ * Record the time a connection manager message waited in the queue.
+ *
+ * @param[in] msg Message just taken from the queue.
+ */
+void wifi_trace_dequeued(const struct wifi_message *msg);
+
+/**
+ * Get the number of records written to the trace ring.
+ *
+ * @return Records since boot, the newest has sequence number count - 1.
+ */
+uint32_t wifi_trace_count(void);
+
+/**
+ * Copy one record of the trace ring.
+ *
+ * @param[in] seq Sequence number of the record.
+ * @param[out] record Copy of the record.
+ *
+ * @return WM_SUCCESS on success, -WM_FAIL if the record has been overwritten
+ *         or not written yet.
+ */
+int wifi_trace_read(uint32_t seq, wifi_trace_record_t *record);
+
+/**
+ * Summarize the latencies in the trace ring per command code and event id.
+ *
+ * @param[out] summary Array filled with one entry per command code and event id.
+ * @param[in] max_entries Number of entries in summary.
+ *
+ * @return Number of entries filled, 0 if out of memory.
+ */
+unsigned int wifi_trace_get_summary(wifi_trace_summary_t *summary, unsigned int max_entries);
+#endif
+
 /**
  * Wi-Fi Driver low level output function.
  *
@@ -1830,6 +1894,23 @@ int wifi_send_scan_cmd(t_u8 bss_mode,
 #endif
                        const bool keep_previous_scan,
                        const bool active_scan_triggered);
+
+#if CONFIG_SCAN_EARLY_STOP
+/**
+ * Arm an early stop for the next scan.
+ *
+ * The next scan started with wifi_send_scan_cmd() scans the channels in
+ * \a early_stop first and then the others, one channel per firmware scan
+ * command. After each command the scan table is checked, and the scan ends
+ * once it holds a BSS of the SSID (and BSSID) with an RSSI of at least
+ * -rssi_threshold dBm. The scan result event is then sent with the BSSs
+ * found so far.
+ *
+ * \param[in] early_stop Early stop configuration, NULL to disarm.
+ */
+void wifi_set_scan_early_stop(const wifi_scan_early_stop_t *early_stop);
+#endif
+
 int wifi_deauthenticate(uint8_t *bssid);
 
 #if CONFIG_TURBO_MODE
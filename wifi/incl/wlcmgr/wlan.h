@@ -780,6 +780,24 @@ struct wlan_scan_result
 #endif
 };
 
+#if CONFIG_WLAN_BSS_CACHE
+/** Number of RSSI values kept for each BSS in the BSS cache */
+#define WLAN_BSS_CACHE_RSSI_HISTORY 4U
+
+/** Entry of the BSS cache, see \ref wlan_get_bss_cache() */
+struct wlan_bss_cache_entry
+{
+    /** Scan result of the BSS when it was last seen */
+    struct wlan_scan_result res;
+    /** Milliseconds since the BSS was last seen */
+    uint32_t age_ms;
+    /** Last RSSI values, newest first, 0 where there is no value yet */
+    unsigned char rssi[WLAN_BSS_CACHE_RSSI_HISTORY];
+    /** Average of the RSSI values */
+    unsigned char rssi_avg;
+};
+#endif
+
 typedef enum
 {
     Band_2_4_GHz = 0,
@@ -3029,6 +3047,32 @@ int wlan_scan_with_opt(wlan_scan_params_v2_t t_wlan_scan_param);
  */
 int wlan_get_scan_result(unsigned int index, struct wlan_scan_result *res);
 
+#if CONFIG_WLAN_BSS_CACHE
+/** Retrieve the BSS cache.
+ *
+ *  The Wi-Fi connection manager merges the results of every scan into a
+ *  cache of CONFIG_WLAN_BSS_CACHE_SIZE BSSs keyed by BSSID. An entry keeps
+ *  the last scan result of its BSS, the time since it was seen and its last
+ *  \ref WLAN_BSS_CACHE_RSSI_HISTORY RSSI values. When the cache is full the
+ *  BSS seen the longest time ago is replaced.
+ *
+ *  Connection requests for a network that the last scan saw less than
+ *  CONFIG_WLAN_BSS_CACHE_MAX_AGE_MS ago skip the connect scan, and APs of
+ *  the same network are compared by their average RSSI.
+ *
+ *  \param[out] entries Array that the cache entries are copied to.
+ *  \param[in] max_entries Number of entries in \a entries.
+ *  \param[in] max_age_ms Only BSSs seen less than this many milliseconds
+ *              ago are copied.
+ *
+ *  \return Number of entries copied.
+ */
+unsigned int wlan_get_bss_cache(struct wlan_bss_cache_entry *entries, unsigned int max_entries, uint32_t max_age_ms);
+
+/** Drop all entries of the BSS cache. */
+void wlan_flush_bss_cache(void);
+#endif
+
 #ifdef WLAN_LOW_POWER_ENABLE
 /**
  * Enable low power mode in Wi-Fi Firmware.
@@ -86,9 +86,12 @@ err_t lwip_netif_uap_init(struct netif *netif);
 void *wifi_get_rxbuf_desc(t_u16 rx_len);
 #endif
 void handle_data_packet(const t_u8 interface, const t_u8 *rcvdata, const t_u16 datalen);
-void handle_amsdu_data_packet(t_u8 interface, t_u8 *rcvdata, t_u16 datalen);
+void handle_amsdu_data_packet(t_u8 interface, t_u8 *rcvdata, t_u16 datalen, void *amsdu_buf);
 void handle_deliver_packet_above(t_void *rxpd, t_u8 interface, t_void *lwip_pbuf);
 bool wrapper_net_is_ip_or_ipv6(const t_u8 *buffer);
+#if CONFIG_WMM
+void handle_tx_queue_space(t_u32 full_mask);
+#endif
 
 NETIF_DECLARE_EXT_CALLBACK(netif_ext_callback)
 
@@ -275,6 +278,9 @@ int net_wlan_init(void)
     (void)wifi_register_amsdu_data_input_callback(&handle_amsdu_data_packet);
     (void)wifi_register_deliver_packet_above_callback(&handle_deliver_packet_above);
     (void)wifi_register_wrapper_net_is_ip_or_ipv6_callback(&wrapper_net_is_ip_or_ipv6);
+#if CONFIG_WMM
+    (void)wifi_register_tx_resume_callback(&handle_tx_queue_space);
+#endif
 #endif
     if (!net_wlan_init_done)
     {
@@ -290,6 +296,9 @@ int net_wlan_init(void)
         (void)wifi_register_amsdu_data_input_callback(&handle_amsdu_data_packet);
         (void)wifi_register_deliver_packet_above_callback(&handle_deliver_packet_above);
         (void)wifi_register_wrapper_net_is_ip_or_ipv6_callback(&wrapper_net_is_ip_or_ipv6);
+#if CONFIG_WMM
+        (void)wifi_register_tx_resume_callback(&handle_tx_queue_space);
+#endif
 #endif
         ip_2_ip4(&g_mlan.ipaddr)->addr = INADDR_ANY;
         ret = netifapi_netif_add(&g_mlan.netif, ip_2_ip4(&g_mlan.ipaddr), ip_2_ip4(&g_mlan.ipaddr),
@@ -1178,9 +1187,12 @@ void handle_data_packet(const t_u8 interface, const t_u8 *rcvdata, const t_u16 d
     process_data_packet(rcvdata, datalen);
 }
 
-void handle_amsdu_data_packet(t_u8 interface, t_u8 *rcvdata, t_u16 datalen)
+void handle_amsdu_data_packet(t_u8 interface, t_u8 *rcvdata, t_u16 datalen, void *amsdu_buf)
 {
-    struct net_pkt *p = gen_pkt_from_data(interface, rcvdata, datalen);
+    struct net_pkt *p;
+
+    (void)amsdu_buf;
+    p = gen_pkt_from_data(interface, rcvdata, datalen);
     if (p == NULL)
     {
         w_pkt_e("[amsdu] No pbuf available. Dropping packet");
@@ -41,6 +41,12 @@
 
 /*------------------------------------------------------*/
 #include <netif_decl.h>
+#include "netif_impair.h"
+#include "netif_capture.h"
+#if CONFIG_WMM
+#include "lwip/tcpip.h"
+#include "lwip/priv/tcp_priv.h"
+#endif
 /*------------------------------------------------------*/
 
 #if FSL_USDHC_ENABLE_SCATTER_GATHER_TRANSFER
@@ -86,7 +92,7 @@ static err_t mld_mac_filter(struct netif *netif, const ip6_addr_t *group, enum n
 err_t lwip_netif_uap_init(struct netif *netif);
 err_t lwip_netif_init(struct netif *netif);
 void handle_data_packet(const t_u8 interface, const t_u8 *rcvdata, const t_u16 datalen);
-void handle_amsdu_data_packet(t_u8 interface, t_u8 *rcvdata, t_u16 datalen);
+void handle_amsdu_data_packet(t_u8 interface, t_u8 *rcvdata, t_u16 datalen, void *amsdu_buf);
 void handle_deliver_packet_above(t_void *rxpd, t_u8 interface, t_void *lwip_pbuf);
 bool wrapper_net_is_ip_or_ipv6(const t_u8 *buffer);
 
@@ -204,6 +210,12 @@ static void deliver_packet_above(struct pbuf *p, int recv_interface)
 #endif
         case ETHTYPE_ARP:
             LINK_STATS_INC(link.recv);
+#if LWIP_NETIF_CAPTURE
+            netif_capture(p, NETIF_CAPTURE_IN);
+#endif
+#if LWIP_EVENT_TRACE
+            event_trace_add(EVENT_TRACE_NET_IN, 0U, p->tot_len);
+#endif
 
             if ((unsigned)recv_interface >= MAX_INTERFACES_SUPPORTED)
             {
@@ -310,14 +322,201 @@ void *wifi_get_rxbuf_desc(t_u16 rx_len)
     return (void *)((t_u8 *)p->payload + sizeof(mlan_buffer));
 }
 #endif
+#if PBUF_RX_SIZE_CLASSES
+static const u16_t rx_pbuf_class_size[NET_RX_PBUF_CLASSES] = {PBUF_RX_SMALL_BUFSIZE, PBUF_RX_MEDIUM_BUFSIZE,
+                                                              PBUF_POOL_BUFSIZE};
+static const memp_t rx_pbuf_class_pool[NET_RX_PBUF_CLASSES] = {MEMP_RX_PBUF_SMALL, MEMP_RX_PBUF_MEDIUM, MEMP_PBUF_POOL};
+static struct net_rx_pbuf_class_stats rx_pbuf_class_stats[NET_RX_PBUF_CLASSES];
+
+static void rx_pbuf_small_free(struct pbuf *p)
+{
+    memp_free(MEMP_RX_PBUF_SMALL, p);
+}
+
+static void rx_pbuf_medium_free(struct pbuf *p)
+{
+    memp_free(MEMP_RX_PBUF_MEDIUM, p);
+}
+
+static struct pbuf *rx_pbuf_class_alloc(unsigned int rx_class, t_u16 datalen)
+{
+    struct pbuf_custom *pc;
+
+    if (rx_class == (unsigned int)NET_RX_PBUF_POOL)
+    {
+        /* Also chains pool pbufs for frames larger than PBUF_POOL_BUFSIZE */
+        return pbuf_alloc(PBUF_RAW, datalen, PBUF_POOL);
+    }
+
+    pc = (struct pbuf_custom *)memp_malloc(rx_pbuf_class_pool[rx_class]);
+    if (pc == NULL)
+    {
+        return NULL;
+    }
+
+    pc->custom_free_function = (rx_class == (unsigned int)NET_RX_PBUF_SMALL) ? rx_pbuf_small_free : rx_pbuf_medium_free;
+
+    return pbuf_alloced_custom(PBUF_RAW, datalen, PBUF_POOL, pc,
+                               (t_u8 *)pc + LWIP_MEM_ALIGN_SIZE(sizeof(struct pbuf_custom)),
+                               rx_pbuf_class_size[rx_class]);
+}
+
+/* Allocates from the smallest class the frame fits in, spilling over to larger ones */
+static struct pbuf *rx_pbuf_alloc(t_u16 datalen)
+{
+    unsigned int fit = 0;
+    unsigned int rx_class;
+    struct pbuf *p;
+
+    while ((fit < (unsigned int)NET_RX_PBUF_POOL) && (datalen > rx_pbuf_class_size[fit]))
+    {
+        fit++;
+    }
+
+    for (rx_class = fit; rx_class < (unsigned int)NET_RX_PBUF_CLASSES; rx_class++)
+    {
+        p = rx_pbuf_class_alloc(rx_class, datalen);
+        if (p != NULL)
+        {
+            rx_pbuf_class_stats[fit].alloc++;
+            if (rx_class != fit)
+            {
+                rx_pbuf_class_stats[fit].spill++;
+            }
+            return p;
+        }
+    }
+
+    rx_pbuf_class_stats[fit].empty++;
+    return NULL;
+}
+
+int net_rx_pbuf_class_stats(unsigned int rx_class, struct net_rx_pbuf_class_stats *stats)
+{
+    if (rx_class >= (unsigned int)NET_RX_PBUF_CLASSES)
+    {
+        return -WM_FAIL;
+    }
+
+    *stats         = rx_pbuf_class_stats[rx_class];
+    stats->bufsize = rx_pbuf_class_size[rx_class];
+#if MEMP_STATS
+    stats->avail = lwip_stats.memp[rx_pbuf_class_pool[rx_class]]->avail;
+    stats->used  = lwip_stats.memp[rx_pbuf_class_pool[rx_class]]->used;
+    stats->max   = lwip_stats.memp[rx_pbuf_class_pool[rx_class]]->max;
+#endif
+
+    return WM_SUCCESS;
+}
+#endif /* PBUF_RX_SIZE_CLASSES */
+
+#if CONFIG_IMU_RX_ZERO_COPY
+/* PBUF_REF pbuf pointing into an IMU rx buffer */
+struct rx_ref_pbuf
+{
+    struct pbuf_custom pc;
+    const t_u8 *imu_buf;
+};
+
+LWIP_MEMPOOL_DECLARE(RX_REF_PBUF, CONFIG_IMU_RX_ZERO_COPY_BUFS, sizeof(struct rx_ref_pbuf), "RX_REF_PBUF")
+
+/* Only the IMU rx task allocates, it initializes the pool before its first frame */
+static bool rx_ref_pbuf_pool_ready;
+
+static void rx_ref_pbuf_free(struct pbuf *p)
+{
+    struct rx_ref_pbuf *ref = (struct rx_ref_pbuf *)(void *)p;
+
+    wifi_imu_rx_buf_release(ref->imu_buf);
+    LWIP_MEMPOOL_FREE(RX_REF_PBUF, ref);
+}
+
+/* Wraps the frame in the rx buffer rcvdata without copying it, returns NULL
+   when CONFIG_IMU_RX_ZERO_COPY_BUFS buffers are held already */
+static struct pbuf *rx_ref_pbuf_alloc(const t_u8 *rcvdata, t_u8 *payload, t_u16 datalen)
+{
+    struct rx_ref_pbuf *ref;
+
+    if (!rx_ref_pbuf_pool_ready)
+    {
+        LWIP_MEMPOOL_INIT(RX_REF_PBUF);
+        rx_ref_pbuf_pool_ready = true;
+    }
+
+    ref = (struct rx_ref_pbuf *)LWIP_MEMPOOL_ALLOC(RX_REF_PBUF);
+    if (ref == NULL)
+    {
+        return NULL;
+    }
+
+    ref->pc.custom_free_function = rx_ref_pbuf_free;
+    ref->imu_buf                 = rcvdata;
+    wifi_imu_rx_buf_hold(rcvdata);
+
+    return pbuf_alloced_custom(PBUF_RAW, datalen, PBUF_REF, &ref->pc, payload, datalen);
+}
+#endif /* CONFIG_IMU_RX_ZERO_COPY */
+
+#if !CONFIG_TX_RX_ZERO_COPY
+/* PBUF_REF pbuf pointing at one subframe inside the pbuf of an A-MSDU */
+struct amsdu_ref_pbuf
+{
+    struct pbuf_custom pc;
+    struct pbuf *amsdu;
+};
+
+LWIP_MEMPOOL_DECLARE(AMSDU_REF_PBUF, CONFIG_AMSDU_RX_REF_PBUFS, sizeof(struct amsdu_ref_pbuf), "AMSDU_REF_PBUF")
+
+/* Only the rx task delivers A-MSDU subframes, it initializes the pool before the first one */
+static bool amsdu_ref_pbuf_pool_ready;
+
+static void amsdu_ref_pbuf_free(struct pbuf *p)
+{
+    struct amsdu_ref_pbuf *ref = (struct amsdu_ref_pbuf *)(void *)p;
+
+    (void)pbuf_free(ref->amsdu);
+    LWIP_MEMPOOL_FREE(AMSDU_REF_PBUF, ref);
+}
+
+/* Wraps the subframe at payload without copying it, the A-MSDU pbuf is kept
+   until the subframe is freed. Returns NULL when the pool is exhausted. */
+static struct pbuf *amsdu_ref_pbuf_alloc(struct pbuf *amsdu, t_u8 *payload, t_u16 datalen)
+{
+    struct amsdu_ref_pbuf *ref;
+
+    if (!amsdu_ref_pbuf_pool_ready)
+    {
+        LWIP_MEMPOOL_INIT(AMSDU_REF_PBUF);
+        amsdu_ref_pbuf_pool_ready = true;
+    }
+
+    ref = (struct amsdu_ref_pbuf *)LWIP_MEMPOOL_ALLOC(AMSDU_REF_PBUF);
+    if (ref == NULL)
+    {
+        return NULL;
+    }
+
+    ref->pc.custom_free_function = amsdu_ref_pbuf_free;
+    ref->amsdu                   = amsdu;
+    pbuf_ref(amsdu);
+
+    return pbuf_alloced_custom(PBUF_RAW, datalen, PBUF_REF, &ref->pc, payload, datalen);
+}
+#endif /* !CONFIG_TX_RX_ZERO_COPY */
+
 static struct pbuf *gen_pbuf_from_data(t_u8 *payload, t_u16 datalen)
 {
     t_u8 retry_cnt = 3;
     struct pbuf *p = NULL;
 
 retry:
+#if PBUF_RX_SIZE_CLASSES
+    /* Small frames go to the small buffer classes. */
+    p = rx_pbuf_alloc(datalen);
+#else
     /* We allocate a pbuf chain of pbufs from the pool. */
     p = pbuf_alloc(PBUF_RAW, datalen, PBUF_POOL);
+#endif
     if (p == NULL)
     {
         if (retry_cnt)
@@ -435,6 +634,17 @@ static void process_data_packet(const t_u8 *rcvdata,
 #endif
 #endif
 #else
+#if CONFIG_IMU_RX_ZERO_COPY
+    /* Large data frames stay in the rx buffer, small ones are cheaper to copy
+       than to keep a firmware buffer for. A-MSDUs are split in place and
+       their subframes refer to the same rx buffer. */
+    if ((payload_len >= CONFIG_IMU_RX_ZERO_COPY_MIN) && (rxpd->rx_pkt_type != PKT_TYPE_MGMT_FRAME) &&
+        (rxpd->rx_pkt_type != PKT_TYPE_802DOT11))
+    {
+        p = rx_ref_pbuf_alloc(rcvdata, payload, payload_len);
+    }
+    if (p == NULL)
+#endif
     p = gen_pbuf_from_data(payload, payload_len);
 #endif
 
@@ -694,10 +904,18 @@ void handle_data_packet(const t_u8 interface, const t_u8 *rcvdata, const t_u16 d
 #endif
 }
 
-void handle_amsdu_data_packet(t_u8 interface, t_u8 *rcvdata, t_u16 datalen)
+void handle_amsdu_data_packet(t_u8 interface, t_u8 *rcvdata, t_u16 datalen, void *amsdu_buf)
 {
+    struct pbuf *p = NULL;
 
-    struct pbuf *p = gen_pbuf_from_data(rcvdata, datalen);
+#if !CONFIG_TX_RX_ZERO_COPY
+    if (amsdu_buf != NULL)
+    {
+        p = amsdu_ref_pbuf_alloc((struct pbuf *)amsdu_buf, rcvdata, datalen);
+    }
+    if (p == NULL)
+#endif
+    p = gen_pbuf_from_data(rcvdata, datalen);
     if (p == NULL)
     {
         w_pkt_e("[amsdu] No pbuf available. Dropping packet");
@@ -738,6 +956,11 @@ static void low_level_init(struct netif *netif)
     /* maximum transfer unit */
     netif->mtu = 1500;
 
+#if (CONFIG_WMM) && !(CONFIG_TX_RX_ZERO_COPY)
+    LWIP_ASSERT("PBUF_LINK_ENCAPSULATION_HLEN too small for zero-copy TX",
+                PBUF_LINK_ENCAPSULATION_HLEN >= OUTBUF_WMM_EXT_HEADROOM);
+#endif
+
     /* device capabilities */
     /* don't set NETIF_FLAG_ETHARP if this device is not an ethernet one */
     netif->flags = NETIF_FLAG_BROADCAST | NETIF_FLAG_ETHARP | NETIF_FLAG_LINK_UP;
@@ -762,8 +985,132 @@ static void low_level_init(struct netif *netif)
 #endif
 }
 
+/* Frames sent by low_level_output(), see net_tx_copy_stats() */
+static struct net_tx_copy_stats tx_copy_stats;
+
+void net_tx_copy_stats(struct net_tx_copy_stats *stats)
+{
+    *stats = tx_copy_stats;
+}
+
+#if CONFIG_WMM
+/* WMM queue full events and resumes, see net_tx_flow_stats() */
+static struct net_tx_flow_stats tx_flow_stats;
+/* sys_now() when the queues were first found full, 0 while they are not */
+static volatile u32_t tx_stall_start;
+/* A net_tx_resume() call is posted to the tcpip thread */
+static volatile u8_t tx_resume_pending;
+
+void net_tx_flow_stats(struct net_tx_flow_stats *stats)
+{
+    *stats = tx_flow_stats;
+}
+
+/* Runs in the tcpip thread, sends the TCP segments low_level_output() refused */
+static void net_tx_resume(void *ctx)
+{
+    u32_t latency_us = sys_now_us() - (u32_t)(uintptr_t)ctx;
+    u32_t stall_start = tx_stall_start;
+    u32_t stall_ms;
+
+    tx_resume_pending = 0;
+
+    if (stall_start != 0U)
+    {
+        tx_stall_start = 0;
+        /* The start is tagged with bit 0, tag now as well so that it is never behind */
+        stall_ms       = (sys_now() | 1U) - stall_start;
+        if (stall_ms > tx_flow_stats.stall_ms_max)
+        {
+            tx_flow_stats.stall_ms_max = stall_ms;
+        }
+    }
+    if (latency_us > tx_flow_stats.resume_latency_us_max)
+    {
+        tx_flow_stats.resume_latency_us_max = latency_us;
+    }
+    tx_flow_stats.resumes++;
+
+#if LWIP_TCP
+    tcp_txnow();
+#endif
+}
+
+/* Called by the driver when a WMM buffer is freed after the queues were full */
+void handle_tx_queue_space(t_u32 full_mask)
+{
+    (void)full_mask;
+
+    if (tx_resume_pending != 0U)
+    {
+        return;
+    }
+
+    tx_resume_pending = 1;
+    if (tcpip_try_callback(net_tx_resume, (void *)(uintptr_t)sys_now_us()) != ERR_OK)
+    {
+        /* The mbox is full, the TCP timers retry the segments */
+        tx_resume_pending = 0;
+    }
+}
+#endif
+
+#if CONFIG_WMM
 extern int retry_attempts;
 
+/* TCP segments are resumed by handle_tx_queue_space(), other frames are not */
+static bool low_level_output_is_tcp(struct pbuf *p)
+{
+    u16_t type = (u16_t)((pbuf_get_at(p, 12) << 8) | pbuf_get_at(p, 13));
+
+    if (type == ETHTYPE_IP)
+    {
+        return pbuf_get_at(p, SIZEOF_ETH_HDR + 9U) == IP_PROTO_TCP;
+    }
+#if CONFIG_IPV6
+    if (type == ETHTYPE_IPV6)
+    {
+        return pbuf_get_at(p, SIZEOF_ETH_HDR + 6U) == IP_PROTO_TCP;
+    }
+#endif
+
+    return false;
+}
+#endif
+
+#if (CONFIG_WMM) && !(CONFIG_TX_RX_ZERO_COPY)
+/* Builds the outbuf in the headroom lwIP reserved in front of a single pbuf
+   frame, see PBUF_LINK_ENCAPSULATION_HLEN, so the frame is queued without
+   copying. The queue slot of pool_buf is kept for it. Returns NULL if the
+   frame has to be copied into pool_buf. */
+static t_u8 *wmm_outbuf_in_headroom(struct pbuf *p, t_u8 *pool_buf)
+{
+    t_u8 *outbuf;
+
+    if ((p->len != p->tot_len) || (pbuf_header(p, (s16_t)OUTBUF_WMM_EXT_HEADROOM) != 0))
+    {
+        return NULL;
+    }
+
+    /* The outbuf starts with the queue list entry */
+    if (((uintptr_t)p->payload & (sizeof(void *) - 1U)) != 0U)
+    {
+        (void)pbuf_header(p, -(s16_t)OUTBUF_WMM_EXT_HEADROOM);
+        return NULL;
+    }
+
+    *(struct pbuf **)p->payload = p;
+    outbuf                      = (t_u8 *)p->payload + sizeof(struct pbuf *);
+    (void)pbuf_header(p, -(s16_t)OUTBUF_WMM_EXT_HEADROOM);
+
+    /* Released by wifi_wmm_buf_put() once the frame is sent or dropped */
+    pbuf_ref(p);
+    wifi_wmm_buf_put_mem((outbuf_t *)pool_buf);
+
+    return outbuf;
+}
+#endif
+
 /**
  * This function should do the actual transmission of the packet. The packet is
  * contained in the pbuf that is passed to the function. This pbuf
@@ -774,10 +1121,11 @@ extern int retry_attempts;
  * @return ERR_OK if the packet could be sent
  *         an err_t value if the packet couldn't be sent
  *
- * @note Returning ERR_MEM here if a DMA queue of your MAC is full can lead to
- *       strange results. You might consider waiting for space in the DMA queue
- *       to become availale since the stack doesn't retry to send a packet
- *       dropped because of memory failure (except for the TCP timers).
+ * @note With WMM, ERR_MEM is returned at once for a TCP segment when the TX
+ *       queues are full. TCP keeps the segment unsent and
+ *       handle_tx_queue_space() sends it again as soon as the driver frees a
+ *       queue buffer. Other frames (UDP, DHCP, ARP) have no such resume, they
+ *       wait for a buffer for up to retry_attempts tries as before.
  */
 
 static err_t low_level_output(struct netif *netif, struct pbuf *p)
@@ -792,6 +1140,9 @@ static err_t low_level_output(struct netif *netif, struct pbuf *p)
     t_u8 *wmm_outbuf = NULL;
 
 #if CONFIG_WMM
+#if !CONFIG_TX_RX_ZERO_COPY
+    t_u8 *ext_outbuf;
+#endif
     t_u8 tid                      = 0;
     int retry                     = 0;
     t_u8 ra[MLAN_MAC_ADDR_LENGTH] = {0};
@@ -823,31 +1174,48 @@ static err_t low_level_output(struct netif *netif, struct pbuf *p)
 
     wifi_wmm_da_to_ra(p->payload, ra);
 
-    do
+    wmm_outbuf = wifi_wmm_get_outbuf_enh(&outbuf_len, (mlan_wmm_ac_e)pkt_prio, interface, ra, &is_tx_pause);
+    if (wmm_outbuf == NULL && is_tx_pause == false)
+    {
+        /* Let the driver drain the queues once, it may free a buffer right away */
+        send_wifi_driver_tx_data_event(interface);
+        wmm_outbuf = wifi_wmm_get_outbuf_enh(&outbuf_len, (mlan_wmm_ac_e)pkt_prio, interface, ra, &is_tx_pause);
+    }
+    while (wmm_outbuf == NULL && wifi_wmm_tx_full(interface, (mlan_wmm_ac_e)pkt_prio) == false)
+    {
+        /* A buffer was freed before the full queue was recorded */
+        wmm_outbuf = wifi_wmm_get_outbuf_enh(&outbuf_len, (mlan_wmm_ac_e)pkt_prio, interface, ra, &is_tx_pause);
+    }
+    if (wmm_outbuf == NULL && low_level_output_is_tcp(p) == false)
     {
-        if (retry != 0)
+        /* Nothing sends a refused UDP, DHCP or ARP frame again, let the driver drain the queues */
+        for (retry = retry_attempts; wmm_outbuf == NULL && retry > 0; retry--)
         {
+            if (is_tx_pause == true)
+            {
+                OSA_TimeDelay(1);
+            }
             send_wifi_driver_tx_data_event(interface);
+            wmm_outbuf = wifi_wmm_get_outbuf_enh(&outbuf_len, (mlan_wmm_ac_e)pkt_prio, interface, ra, &is_tx_pause);
         }
-        else
+    }
+
+    if (wmm_outbuf == NULL)
+    {
+        /* TCP does not wait here, handle_tx_queue_space() resumes it once a buffer is freed */
+        tx_flow_stats.full[pkt_prio]++;
+        if (tx_stall_start == 0U)
         {
-            retry = retry_attempts;
+            tx_stall_start = sys_now() | 1U;
         }
-
-        wmm_outbuf = wifi_wmm_get_outbuf_enh(&outbuf_len, (mlan_wmm_ac_e)pkt_prio, interface, ra, &is_tx_pause);
-        ret        = (wmm_outbuf == NULL) ? true : false;
-
-        if (ret == true && is_tx_pause == true)
+        if (is_tx_pause == true)
         {
-            OSA_TimeDelay(1);
+            wifi_wmm_drop_pause_drop(interface);
+        }
+        else
+        {
+            wifi_wmm_drop_retried_drop(interface);
         }
-
-        retry--;
-    } while (ret == true && retry > 0);
-
-    if (ret == true)
-    {
-        wifi_wmm_drop_retried_drop(interface);
         mlan_adap->priv[interface]->tx_overrun_cnt++;
         return ERR_MEM;
     }
@@ -861,6 +1229,14 @@ static err_t low_level_output(struct netif *netif, struct pbuf *p)
     }
 #endif
 
+#if LWIP_NETIF_CAPTURE
+    /* Still the plain Ethernet frame, before the driver headers are added */
+    netif_capture(p, NETIF_CAPTURE_OUT);
+#endif
+#if LWIP_EVENT_TRACE
+    event_trace_add(EVENT_TRACE_NET_OUT, 0U, p->tot_len);
+#endif
+
     pkt_len =
 #if CONFIG_WMM
         sizeof(mlan_linked_list) +
@@ -874,12 +1250,24 @@ static err_t low_level_output(struct netif *netif, struct pbuf *p)
         wmm_outbuf = p->payload;
         memset(wmm_outbuf, 0x00, pkt_len);
         pkt_len = p->tot_len;
+        tx_copy_stats.zero_copy++;
     }
     else
 #endif
+#elif !CONFIG_TX_RX_ZERO_COPY
+    ext_outbuf = wmm_outbuf_in_headroom(p, wmm_outbuf);
+    if (ext_outbuf != NULL)
+    {
+        wmm_outbuf = ext_outbuf;
+        memset(wmm_outbuf, 0x00, pkt_len);
+        pkt_len += p->tot_len;
+        tx_copy_stats.zero_copy++;
+    }
+    else
 #endif
     {
 #if CONFIG_TX_RX_ZERO_COPY
+        tx_copy_stats.zero_copy++;
         pkt_len += ETH_HDR_LEN;
         memset(wmm_outbuf, 0x00, pkt_len);
         /* Save the ethernet header */
@@ -899,6 +1287,7 @@ static err_t low_level_output(struct netif *netif, struct pbuf *p)
 
         LWIP_ASSERT("uCopied != p->tot_len", uCopied == p->tot_len);
         pkt_len += p->tot_len;
+        tx_copy_stats.copied++;
 #endif
     }
 
@@ -1270,6 +1659,11 @@ err_t lwip_netif_init(struct netif *netif)
     /* set sta MAC hardware address */
     (void)wlan_get_mac_address(netif->hwaddr);
 
+#if LWIP_NETIF_IMPAIR
+    /* Runs from netifapi_netif_add(), with the core lock held */
+    (void)netif_impair_attach(netif);
+#endif
+
     register_interface(netif, MLAN_BSS_TYPE_STA);
     return ERR_OK;
 }
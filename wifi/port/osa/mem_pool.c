@@ -12,6 +12,108 @@
 
 #if defined(SDK_OS_FREE_RTOS)
 
+/* clang-format off */
+#if ((defined(__ARM_ARCH_7M__     ) && (__ARM_ARCH_7M__      == 1)) || \
+     (defined(__ARM_ARCH_7EM__    ) && (__ARM_ARCH_7EM__     == 1)) || \
+     (defined(__ARM_ARCH_8M_MAIN__) && (__ARM_ARCH_8M_MAIN__ == 1)) || \
+     (defined(__ARM_ARCH_8M_BASE__) && (__ARM_ARCH_8M_BASE__ == 1)))
+/* clang-format on */
+/**
+ *  The free list is a stack updated with LDREX/STREX. Any exception taken
+ *  between the two clears the exclusive monitor and the STREX fails, so a
+ *  node popped and pushed back meanwhile (ABA) can't corrupt the list.
+ */
+#define MEM_POOL_USE_LDREX 1
+#else
+#define MEM_POOL_USE_LDREX 0
+#endif
+
+static uint32_t MemPoolAtomicAdd(volatile uint32_t *Value, uint32_t Delta)
+{
+    /*********************************/
+    uint32_t NewValue;
+    /*********************************/
+
+#if MEM_POOL_USE_LDREX
+    do
+    {
+        NewValue = __LDREXW(Value) + Delta;
+    } while (__STREXW(NewValue, Value) != 0U);
+#else
+    uint32_t Primask = DisableGlobalIRQ();
+    NewValue         = *Value + Delta;
+    *Value           = NewValue;
+    EnableGlobalIRQ(Primask);
+#endif
+
+    return NewValue;
+}
+
+static void MemPoolAtomicMax(volatile uint32_t *Value, uint32_t NewValue)
+{
+#if MEM_POOL_USE_LDREX
+    do
+    {
+        if (__LDREXW(Value) >= NewValue)
+        {
+            __CLREX();
+            return;
+        }
+    } while (__STREXW(NewValue, Value) != 0U);
+#else
+    uint32_t Primask = DisableGlobalIRQ();
+    if (*Value < NewValue)
+    {
+        *Value = NewValue;
+    }
+    EnableGlobalIRQ(Primask);
+#endif
+}
+
+static SlNode_t *MemPoolPop(MemPool_t *MemPool)
+{
+    /*********************************/
+    SlNode_t *Node;
+    /*********************************/
+
+#if MEM_POOL_USE_LDREX
+    do
+    {
+        Node = (SlNode_t *)(uintptr_t)__LDREXW((volatile uint32_t *)(volatile void *)&MemPool->Head);
+        if (Node == NULL)
+        {
+            __CLREX();
+            break;
+        }
+    } while (__STREXW((uint32_t)(uintptr_t)Node->Next, (volatile uint32_t *)(volatile void *)&MemPool->Head) != 0U);
+#else
+    uint32_t Primask = DisableGlobalIRQ();
+    Node             = MemPool->Head;
+    if (Node != NULL)
+    {
+        MemPool->Head = Node->Next;
+    }
+    EnableGlobalIRQ(Primask);
+#endif
+
+    return Node;
+}
+
+static void MemPoolPush(MemPool_t *MemPool, SlNode_t *Node)
+{
+#if MEM_POOL_USE_LDREX
+    do
+    {
+        Node->Next = (SlNode_t *)(uintptr_t)__LDREXW((volatile uint32_t *)(volatile void *)&MemPool->Head);
+    } while (__STREXW((uint32_t)(uintptr_t)Node, (volatile uint32_t *)(volatile void *)&MemPool->Head) != 0U);
+#else
+    uint32_t Primask = DisableGlobalIRQ();
+    Node->Next       = MemPool->Head;
+    MemPool->Head    = Node;
+    EnableGlobalIRQ(Primask);
+#endif
+}
+
 static int CalculateAndVerifyAlignment(int Alignment)
 {
     /*********************************/
@@ -81,7 +183,6 @@ MemoryPool_t OSA_MemoryPoolCreate(
     /*********************************/
     unsigned char *ptr;
     SlNode_t *Node;
-    osa_status_t status;
     /*********************************/
 
     Alignment = CalculateAndVerifyAlignment(Alignment);
@@ -93,15 +194,13 @@ MemoryPool_t OSA_MemoryPoolCreate(
 
     ItemSize = CalculateItemSize(ItemSize, Alignment);
 
-    status = OSA_MutexCreate((osa_mutex_handle_t)MemPool->Lock);
-    if (status != KOSA_StatusSuccess)
-    {
-        return NULL;
-    }
-
-    InitStack(&MemPool->Stack);
+    MemPool->Head      = NULL;
     MemPool->ItemSize  = ItemSize;
     MemPool->Alignment = Alignment;
+    MemPool->ItemCount = 0;
+    MemPool->InUse     = 0;
+    MemPool->HighWater = 0;
+    MemPool->Failures  = 0;
 
     ptr = (unsigned char *)PreallocatedMemory;
 
@@ -109,7 +208,8 @@ MemoryPool_t OSA_MemoryPoolCreate(
     {
         Node = (SlNode_t *)ptr;
 
-        PushOnStack(&MemPool->Stack, Node);
+        MemPoolPush(MemPool, Node);
+        MemPool->ItemCount++;
         ptr += MemPool->ItemSize;
         PreallocatedMemorySize -= MemPool->ItemSize;
     }
@@ -127,23 +227,16 @@ void *OSA_MemoryPoolAllocate(MemoryPool_t pool)
 
     MemPool = (MemPool_t *)pool;
 
-    OSA_MutexLock((osa_mutex_handle_t)MemPool->Lock, osaWaitForever_c);
-
-    if (MemPool->Stack.Count == 0)
-    {
-        OSA_MutexUnlock((osa_mutex_handle_t)MemPool->Lock);
-        return NULL;
-    }
-
-    Node = PopOffStack(&MemPool->Stack);
-
-    OSA_MutexUnlock((osa_mutex_handle_t)MemPool->Lock);
+    Node = MemPoolPop(MemPool);
 
     if (Node == NULL)
     {
+        (void)MemPoolAtomicAdd(&MemPool->Failures, 1U);
         return NULL;
     }
 
+    MemPoolAtomicMax(&MemPool->HighWater, MemPoolAtomicAdd(&MemPool->InUse, 1U));
+
     ptr = ((unsigned char *)Node) + MemPool->Alignment;
 
     return (void *)ptr;
@@ -165,14 +258,27 @@ void OSA_MemoryPoolFree(MemoryPool_t pool, void *memory)
 
         Node = (SlNode_t *)ptr;
 
-        OSA_MutexLock((osa_mutex_handle_t)MemPool->Lock, osaWaitForever_c);
-
-        PushOnStack(&MemPool->Stack, Node);
+        (void)MemPoolAtomicAdd(&MemPool->InUse, (uint32_t)-1);
 
-        OSA_MutexUnlock((osa_mutex_handle_t)MemPool->Lock);
+        MemPoolPush(MemPool, Node);
     }
 }
 
+void OSA_MemoryPoolGetStats(MemoryPool_t pool, MemPoolStats_t *stats)
+{
+    /*********************************/
+    MemPool_t *MemPool;
+    /*********************************/
+
+    MemPool = (MemPool_t *)pool;
+
+    stats->ItemSize  = (uint32_t)MemPool->ItemSize;
+    stats->ItemCount = MemPool->ItemCount;
+    stats->InUse     = MemPool->InUse;
+    stats->HighWater = MemPool->HighWater;
+    stats->Failures  = MemPool->Failures;
+}
+
 #elif defined(FSL_RTOS_THREADX)
 
 MemoryPool_t OSA_MemoryPoolCreate(
@@ -22,6 +22,13 @@ Change log:
 /** 2^11 = 2048 */
 #define TWOPOW11 2048U
 
+/** Slots in the reorder ring, one per bit of the reorder bitmap */
+#define RX_REORDER_RING_SIZE 64U
+/** Packets taken out of the ring under one lock, then dispatched one by one */
+#define RX_REORDER_DISPATCH_BATCH 8U
+/** Ring slot of the packet at offset off from start_win */
+#define RX_REORDER_SLOT(tbl, off) ((tbl)->rx_reorder_ptr[((tbl)->ring_head + (off)) & (RX_REORDER_RING_SIZE - 1U)])
+
 /** Tid Mask used for extracting TID from BlockAckParamSet */
 #define BLOCKACKPARAM_TID_MASK 0x3CU
 /** Tid position in BlockAckParamSet */
@@ -219,6 +219,21 @@ bool wmsdk_is_11N_enabled(void);
  */
 void wlan_abort_split_scan(void);
 
+#if CONFIG_SCAN_EARLY_STOP
+/*
+ * wmsdk: Called for the last report of every ext scan command, stops an early
+ * stop scan once the scan table holds its BSS. Returns true if the scan result
+ * event should be sent now.
+ */
+bool wlan_ext_scan_report_done(mlan_private *pmpriv);
+
+/*
+ * wmsdk: Returns true once after a scan that stopped early with no report
+ * outstanding, the caller then sends the scan result event.
+ */
+bool wlan_scan_early_stop_completed(void);
+#endif
+
 void wlan_scan_process_results(IN mlan_private *pmpriv);
 bool wlan_use_non_default_ht_vht_cap(IN BSSDescriptor_t *pbss_desc);
 bool check_for_wpa2_entp_ie(bool *wpa2_entp_IE_exist, const void *element_data, unsigned element_len);
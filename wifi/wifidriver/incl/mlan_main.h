@@ -1146,6 +1146,10 @@ typedef struct
 {
     mlan_list_head free_list;
     int free_cnt;
+    /** Pool memory, queued outbufs outside of it are built in network stack buffers */
+    t_u8 *pool;
+    /** Queues senders found without a free slot, see WMM_TX_FULL_BIT */
+    t_u32 full_mask;
 } outbuf_pool_t;
 
 typedef struct
@@ -1629,8 +1633,10 @@ struct _RxReorderTbl
     t_u16 last_seq;
     /** Window size */
     t_u16 win_size;
-    /** Pointer to pointer to RxReorderTbl */
+    /** Ring of RX_REORDER_RING_SIZE buffered packets, see RX_REORDER_SLOT */
     t_void **rx_reorder_ptr;
+    /** Ring slot of start_win */
+    t_u16 ring_head;
     /** Timer context */
     reorder_tmr_cnxt_t timer_context;
     /** BA stream status */
@@ -1642,7 +1648,7 @@ struct _RxReorderTbl
     bool check_start_win;
     /** pkt receive after BA setup */
     t_u8 pkt_count;
-    /** BA window bitmap */
+    /** BA window bitmap, bit n set if the packet at start_win + n is buffered */
     t_u64 bitmap;
 };
 
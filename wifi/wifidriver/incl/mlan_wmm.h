@@ -239,9 +239,28 @@ int wlan_wmm_add_buf_txqueue_enh(const uint8_t interface, const uint8_t *buffer,
 /* wmm enhance buffer pool management */
 outbuf_t *wifi_wmm_buf_get(void);
 void wifi_wmm_buf_put(outbuf_t *buf);
+#if !CONFIG_TX_RX_ZERO_COPY
+/*
+ * An outbuf can also be built in the headroom of a single network stack
+ * buffer, right in front of the frame, with the stack buffer pointer stored
+ * just before it. This is the room such an outbuf needs.
+ */
+#define OUTBUF_WMM_EXT_HEADROOM (sizeof(void *) + sizeof(mlan_linked_list) + INTF_HEADER_LEN + sizeof(TxPD))
+/* give back the memory of a buffer from wifi_wmm_get_outbuf_enh, its queue slot is used by a stack buffer outbuf */
+void wifi_wmm_buf_put_mem(outbuf_t *buf);
+#endif
 int wifi_wmm_buf_pool_init(uint8_t *pool);
 void wifi_wmm_buf_pool_deinit(void);
 
+/*
+ * wmm enhance tx flow control: a sender that finds the pool full records it
+ * with wifi_wmm_tx_full() instead of waiting. The next wifi_wmm_buf_put()
+ * then calls wifi_wmm_tx_resume() with the queues that were full.
+ */
+#define WMM_TX_FULL_BIT(interface, queue) (1UL << (((interface) * MAX_AC_QUEUES) + (queue)))
+bool wifi_wmm_tx_full(const uint8_t interface, mlan_wmm_ac_e queue);
+void wifi_wmm_tx_resume(t_u32 full_mask);
+
 /* wmm enhance ralist operation */
 void wlan_ralist_add_enh(mlan_private *priv, t_u8 *ra);
 int wlan_ralist_update_enh(mlan_private *priv, t_u8 *old_ra, t_u8 *new_ra);
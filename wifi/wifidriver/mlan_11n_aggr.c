@@ -17,6 +17,7 @@ Change log:
 /* Additional WMSDK header files */
 #include <wmerrno.h>
 #include <osa.h>
+#include <wm_net.h>
 
 /* Always keep this include at the end of all include files */
 #include <mlan_remap_mem_operations.h>
@@ -49,10 +50,14 @@ static int wlan_11n_get_num_aggrpkts(t_u8 *data, t_s32 total_pkt_len)
     t_u32 pkt_len, pad;
 
     ENTER();
-    while (total_pkt_len > 0)
+    while (total_pkt_len >= (t_s32)sizeof(Eth803Hdr_t))
     {
         /* Length will be in network format, change it to host */
         pkt_len = mlan_ntohs((*(t_u16 *)(void *)(data + (2 * MLAN_MAC_ADDR_LENGTH))));
+        if ((t_s32)pkt_len + (t_s32)sizeof(Eth803Hdr_t) > total_pkt_len)
+        {
+            break;
+        }
         pad     = (((pkt_len + sizeof(Eth803Hdr_t)) & 3U)) ? (4U - ((pkt_len + sizeof(Eth803Hdr_t)) & 3U)) : 0U;
         data += pkt_len + pad + sizeof(Eth803Hdr_t);
         total_pkt_len -= (t_s32)pkt_len + (t_s32)pad + (t_s32)sizeof(Eth803Hdr_t);
@@ -87,7 +92,14 @@ mlan_status wlan_11n_deaggregate_pkt(mlan_private *priv, pmlan_buffer pmbuf)
 
     ENTER();
 
-    data          = (t_u8 *)(pmbuf->pbuf + pmbuf->data_offset);
+    if ((pmbuf->flags & MLAN_BUF_FLAG_AMSDU_REF) != 0U)
+    {
+        data = (t_u8 *)net_stack_buffer_get_payload(pmbuf->lwip_pbuf);
+    }
+    else
+    {
+        data = (t_u8 *)(pmbuf->pbuf + pmbuf->data_offset);
+    }
     total_pkt_len = (t_s32)pmbuf->data_len;
 
     /* Sanity test */
@@ -102,12 +114,13 @@ mlan_status wlan_11n_deaggregate_pkt(mlan_private *priv, pmlan_buffer pmbuf)
 
     pmbuf->use_count = wlan_11n_get_num_aggrpkts(data, total_pkt_len);
 
-    while (total_pkt_len > 0)
+    /* A subframe shorter than its header ends the A-MSDU: its length field cannot be read */
+    while (total_pkt_len >= (t_s32)sizeof(Eth803Hdr_t))
     {
         prx_pkt = (RxPacketHdr_t *)(void *)data;
         /* Length will be in network format, change it to host */
         pkt_len = mlan_ntohs((*(t_u16 *)(void *)(data + (2 * MLAN_MAC_ADDR_LENGTH))));
-        if ((t_s32)pkt_len > total_pkt_len)
+        if ((t_s32)pkt_len + (t_s32)sizeof(Eth803Hdr_t) > total_pkt_len)
         {
             PRINTM(MERROR, "Error in packet length: total_pkt_len = %d, pkt_len = %d\n", total_pkt_len, pkt_len);
             break;
@@ -117,7 +130,8 @@ mlan_status wlan_11n_deaggregate_pkt(mlan_private *priv, pmlan_buffer pmbuf)
 
         total_pkt_len -= (t_s32)pkt_len + pad + (t_s32)sizeof(Eth803Hdr_t);
 
-        if (__memcmp(pmadapter, &prx_pkt->rfc1042_hdr, rfc1042_eth_hdr, sizeof(rfc1042_eth_hdr)) == 0)
+        if ((pkt_len >= LLC_SNAP_LEN) &&
+            (__memcmp(pmadapter, &prx_pkt->rfc1042_hdr, rfc1042_eth_hdr, sizeof(rfc1042_eth_hdr)) == 0))
         {
             (void)__memmove(pmadapter, data + LLC_SNAP_LEN, data, (2 * MLAN_MAC_ADDR_LENGTH));
             data += LLC_SNAP_LEN;
@@ -52,6 +52,26 @@ static mlan_status wlan_11n_dispatch_amsdu_pkt(mlan_private *priv, pmlan_buffer
         pmbuf->data_len = prx_pd->rx_pkt_length;
         pmbuf->data_offset += prx_pd->rx_pkt_offset;
 
+#if defined(SDK_OS_FREE_RTOS) && !CONFIG_TX_RX_ZERO_COPY
+        if (net_stack_buffer_is_contiguous(pmbuf->lwip_pbuf))
+        {
+            /* The subframes are split in place and handed up as views into
+               the stack buffer, the last one of them to be freed frees it */
+            pmbuf->flags |= MLAN_BUF_FLAG_AMSDU_REF;
+            (void)wlan_11n_deaggregate_pkt(priv, pmbuf);
+            net_stack_buffer_free(pmbuf->lwip_pbuf);
+#if !CONFIG_MEM_POOLS
+            OSA_MemoryFree(pmbuf->pbuf);
+            OSA_MemoryFree(pmbuf);
+#else
+            OSA_MemoryPoolFree(buf_128_MemoryPool, pmbuf->pbuf);
+            OSA_MemoryPoolFree(buf_128_MemoryPool, pmbuf);
+#endif
+            LEAVE();
+            return MLAN_STATUS_SUCCESS;
+        }
+#endif
+
         (void)__memcpy(priv->adapter, amsdu_inbuf, pmbuf->pbuf, sizeof(RxPD));
 #if defined(SDK_OS_FREE_RTOS)
         net_stack_buffer_copy_partial(pmbuf->lwip_pbuf, amsdu_inbuf + pmbuf->data_offset, prx_pd->rx_pkt_length, 0);
@@ -65,6 +85,7 @@ static mlan_status wlan_11n_dispatch_amsdu_pkt(mlan_private *priv, pmlan_buffer
 #endif
 #endif
         pmbuf->pbuf = amsdu_inbuf;
+        pmbuf->flags &= ~MLAN_BUF_FLAG_AMSDU_REF;
 
         (void)wlan_11n_deaggregate_pkt(priv, pmbuf);
 
@@ -142,6 +163,77 @@ static void mlan_11n_rxreorder_timer_restart(pmlan_adapter pmadapter, RxReorderT
     LEAVE();
 }
 
+/**
+ *  @brief This function moves the ring past the first no_pkt slots and
+ *  		dispatches the packets buffered in them, holes are skipped
+ *  		with the bitmap. Packets are taken out in batches so the
+ *  		lock is not held while they are dispatched. Each packet of
+ *  		a batch is still dispatched on its own, the netif input
+ *  		takes one packet per call.
+ *
+ *  @param priv    	        A pointer to mlan_private
+ *  @param rx_reor_tbl_ptr  A pointer to structure RxReorderTbl
+ *  @param no_pkt           Number of slots to move past
+ *
+ *  @return 	   	        N/A
+ */
+static void wlan_11n_rxreorder_flush(t_void *priv, RxReorderTbl *rx_reor_tbl_ptr, t_u16 no_pkt)
+{
+    mlan_private *pmpriv = (mlan_private *)priv;
+    void *batch[RX_REORDER_DISPATCH_BATCH];
+    t_u16 cnt, i, step;
+    t_u16 off = 0;
+    t_u64 pending;
+
+    while (no_pkt > 0U)
+    {
+        (void)pmpriv->adapter->callbacks.moal_spin_lock(pmpriv->adapter->pmoal_handle, pmpriv->rx_pkt_lock);
+
+        pending = rx_reor_tbl_ptr->bitmap;
+        if (no_pkt < RX_REORDER_RING_SIZE)
+        {
+            pending &= (1ULL << no_pkt) - 1ULL;
+        }
+
+        cnt  = 0;
+        step = no_pkt;
+        while (pending != 0U)
+        {
+            if (cnt == RX_REORDER_DISPATCH_BATCH)
+            {
+                /* The rest goes in the next batch */
+                step = off + 1U;
+                break;
+            }
+            off          = (t_u16)__builtin_ctzll(pending);
+            batch[cnt++] = RX_REORDER_SLOT(rx_reor_tbl_ptr, off);
+
+            RX_REORDER_SLOT(rx_reor_tbl_ptr, off) = MNULL;
+            pending &= pending - 1U;
+        }
+
+        if (step < RX_REORDER_RING_SIZE)
+        {
+            rx_reor_tbl_ptr->bitmap >>= step;
+            rx_reor_tbl_ptr->ring_head = (rx_reor_tbl_ptr->ring_head + step) & (RX_REORDER_RING_SIZE - 1U);
+        }
+        else
+        {
+            rx_reor_tbl_ptr->bitmap    = 0;
+            rx_reor_tbl_ptr->ring_head = 0;
+        }
+        no_pkt -= step;
+
+        (void)pmpriv->adapter->callbacks.moal_spin_unlock(pmpriv->adapter->pmoal_handle, pmpriv->rx_pkt_lock);
+
+        /* One by one, the batch only saves lock round trips */
+        for (i = 0; i < cnt; i++)
+        {
+            (void)wlan_11n_dispatch_pkt(priv, batch[i], rx_reor_tbl_ptr);
+        }
+    }
+}
+
 /**
  *  @brief This function dispatches all the packets in the buffer.
  *  		There could be holes in the buffer.
@@ -154,9 +246,8 @@ static void mlan_11n_rxreorder_timer_restart(pmlan_adapter pmadapter, RxReorderT
  */
 static mlan_status wlan_11n_dispatch_pkt_until_start_win(t_void *priv, RxReorderTbl *rx_reor_tbl_ptr, t_u16 start_win)
 {
-    t_u16 no_pkt_to_send, i, xchg;
+    t_u16 no_pkt_to_send;
     mlan_status ret      = MLAN_STATUS_SUCCESS;
-    void *rx_tmp_ptr     = MNULL;
     mlan_private *pmpriv = (mlan_private *)priv;
 
     ENTER();
@@ -165,37 +256,10 @@ static mlan_status wlan_11n_dispatch_pkt_until_start_win(t_void *priv, RxReorder
                          MIN((start_win - rx_reor_tbl_ptr->start_win), rx_reor_tbl_ptr->win_size) :
                          rx_reor_tbl_ptr->win_size;
 
-    for (i = 0; i < no_pkt_to_send; ++i)
-    {
-        (void)pmpriv->adapter->callbacks.moal_spin_lock(pmpriv->adapter->pmoal_handle, pmpriv->rx_pkt_lock);
-        rx_tmp_ptr = MNULL;
-        if (rx_reor_tbl_ptr->rx_reorder_ptr[i] != NULL)
-        {
-            rx_tmp_ptr                         = rx_reor_tbl_ptr->rx_reorder_ptr[i];
-            rx_reor_tbl_ptr->rx_reorder_ptr[i] = MNULL;
-        }
-        (void)pmpriv->adapter->callbacks.moal_spin_unlock(pmpriv->adapter->pmoal_handle, pmpriv->rx_pkt_lock);
-        if (rx_tmp_ptr != NULL)
-        {
-            (void)wlan_11n_dispatch_pkt(priv, rx_tmp_ptr, rx_reor_tbl_ptr);
-        }
-    }
+    wlan_11n_rxreorder_flush(priv, rx_reor_tbl_ptr, no_pkt_to_send);
 
     (void)pmpriv->adapter->callbacks.moal_spin_lock(pmpriv->adapter->pmoal_handle, pmpriv->rx_pkt_lock);
-    /*
-     * We don't have a circular buffer, hence use rotation to simulate
-     * circular buffer
-     */
-    xchg = rx_reor_tbl_ptr->win_size - no_pkt_to_send;
-    for (i = 0; i < xchg; ++i)
-    {
-        rx_reor_tbl_ptr->rx_reorder_ptr[i]                  = rx_reor_tbl_ptr->rx_reorder_ptr[no_pkt_to_send + i];
-        rx_reor_tbl_ptr->rx_reorder_ptr[no_pkt_to_send + i] = MNULL;
-    }
-
     rx_reor_tbl_ptr->start_win = start_win;
-    /* clear the bits of reorder bitmap that has been dispatched */
-    rx_reor_tbl_ptr->bitmap = rx_reor_tbl_ptr->bitmap >> no_pkt_to_send;
     (void)pmpriv->adapter->callbacks.moal_spin_unlock(pmpriv->adapter->pmoal_handle, pmpriv->rx_pkt_lock);
 
     LEAVE();
@@ -218,7 +282,7 @@ static mlan_status wlan_11n_free_rxreorder_pkt(t_void *priv, RxReorderTbl *rx_re
 
     ENTER();
 
-    for (i = 0; i < rx_reor_tbl_ptr->win_size; i++)
+    for (i = 0; i < (int)RX_REORDER_RING_SIZE; i++)
     {
         pmpriv->adapter->callbacks.moal_spin_lock(pmpriv->adapter->pmoal_handle, pmpriv->rx_pkt_lock);
         rx_tmp_ptr = MNULL;
@@ -244,6 +308,7 @@ static mlan_status wlan_11n_free_rxreorder_pkt(t_void *priv, RxReorderTbl *rx_re
 #endif
         }
     }
+    rx_reor_tbl_ptr->bitmap = 0;
 
     LEAVE();
     return ret;
@@ -261,7 +326,7 @@ static t_void wlan_11n_display_tbl_ptr(pmlan_adapter pmadapter, RxReorderTbl *rx
 {
     ENTER();
 
-    DBG_HEXDUMP(MDAT_D, "Reorder ptr", rx_reor_tbl_ptr->rx_reorder_ptr, sizeof(t_void *) * rx_reor_tbl_ptr->win_size);
+    DBG_HEXDUMP(MDAT_D, "Reorder ptr", rx_reor_tbl_ptr->rx_reorder_ptr, sizeof(t_void *) * RX_REORDER_RING_SIZE);
 
     LEAVE();
 }
@@ -278,47 +343,24 @@ static t_void wlan_11n_display_tbl_ptr(pmlan_adapter pmadapter, RxReorderTbl *rx
  */
 static mlan_status wlan_11n_scan_and_dispatch(t_void *priv, RxReorderTbl *rx_reor_tbl_ptr)
 {
-    t_u16 i, j, xchg;
+    t_u16 run;
     mlan_status ret      = MLAN_STATUS_SUCCESS;
-    void *rx_tmp_ptr     = MNULL;
     mlan_private *pmpriv = (mlan_private *)priv;
 
     ENTER();
 
-    for (i = 0; i < rx_reor_tbl_ptr->win_size; ++i)
-    {
-        (void)pmpriv->adapter->callbacks.moal_spin_lock(pmpriv->adapter->pmoal_handle, pmpriv->rx_pkt_lock);
-        if (rx_reor_tbl_ptr->rx_reorder_ptr[i] == MNULL)
-        {
-            (void)pmpriv->adapter->callbacks.moal_spin_unlock(pmpriv->adapter->pmoal_handle, pmpriv->rx_pkt_lock);
-            break;
-        }
-        rx_tmp_ptr                         = rx_reor_tbl_ptr->rx_reorder_ptr[i];
-        rx_reor_tbl_ptr->rx_reorder_ptr[i] = MNULL;
-        (void)pmpriv->adapter->callbacks.moal_spin_unlock(pmpriv->adapter->pmoal_handle, pmpriv->rx_pkt_lock);
-        (void)wlan_11n_dispatch_pkt(priv, rx_tmp_ptr, rx_reor_tbl_ptr);
-    }
-
+    /* Length of the run of buffered packets at start_win, up to the first hole */
     (void)pmpriv->adapter->callbacks.moal_spin_lock(pmpriv->adapter->pmoal_handle, pmpriv->rx_pkt_lock);
-    /*
-     * We don't have a circular buffer, hence use rotation to simulate
-     * circular buffer
-     */
-    if (i > 0U)
-    {
-        xchg = rx_reor_tbl_ptr->win_size - i;
-        for (j = 0; j < xchg; ++j)
-        {
-            rx_reor_tbl_ptr->rx_reorder_ptr[j]     = rx_reor_tbl_ptr->rx_reorder_ptr[i + j];
-            rx_reor_tbl_ptr->rx_reorder_ptr[i + j] = MNULL;
-        }
-    }
-    /* clear the bits of reorder bitmap that has been dispatched */
-    rx_reor_tbl_ptr->bitmap = rx_reor_tbl_ptr->bitmap >> i;
+    run = (~rx_reor_tbl_ptr->bitmap == 0U) ? (t_u16)RX_REORDER_RING_SIZE :
+                                             (t_u16)__builtin_ctzll(~rx_reor_tbl_ptr->bitmap);
+    (void)pmpriv->adapter->callbacks.moal_spin_unlock(pmpriv->adapter->pmoal_handle, pmpriv->rx_pkt_lock);
 
-    rx_reor_tbl_ptr->start_win = (rx_reor_tbl_ptr->start_win + i) & (MAX_TID_VALUE - 1U);
+    wlan_11n_rxreorder_flush(priv, rx_reor_tbl_ptr, run);
 
+    (void)pmpriv->adapter->callbacks.moal_spin_lock(pmpriv->adapter->pmoal_handle, pmpriv->rx_pkt_lock);
+    rx_reor_tbl_ptr->start_win = (rx_reor_tbl_ptr->start_win + run) & (MAX_TID_VALUE - 1U);
     (void)pmpriv->adapter->callbacks.moal_spin_unlock(pmpriv->adapter->pmoal_handle, pmpriv->rx_pkt_lock);
+
     LEAVE();
     return ret;
 }
@@ -397,16 +439,13 @@ static t_void wlan_11n_delete_rxreorder_tbl_entry(mlan_private *priv, RxReorderT
  */
 static t_s16 wlan_11n_find_last_seqnum(RxReorderTbl *rx_reorder_tbl_ptr)
 {
-    t_s16 i;
+    t_u64 bitmap = rx_reorder_tbl_ptr->bitmap;
 
     ENTER();
-    for (i = (t_s16)(rx_reorder_tbl_ptr->win_size) - 1; i >= 0; --i)
+    if (bitmap != 0U)
     {
-        if (rx_reorder_tbl_ptr->rx_reorder_ptr[i] != NULL)
-        {
-            LEAVE();
-            return i;
-        }
+        LEAVE();
+        return (t_s16)(63 - __builtin_clzll(bitmap));
     }
     LEAVE();
     return -1;
@@ -526,15 +565,22 @@ static t_void wlan_11n_create_rxreorder_tbl(mlan_private *priv, t_u8 *ta, int ti
         {
             last_seq = priv->rx_seq[tid];
         }
+        if (win_size > RX_REORDER_RING_SIZE)
+        {
+            /* Packets beyond the ring move the window, as if they were past its end */
+            PRINTM(MINFO, "Rx reorder window %d limited to %d\n", win_size, RX_REORDER_RING_SIZE);
+            win_size = RX_REORDER_RING_SIZE;
+        }
         new_node->last_seq        = last_seq;
         new_node->win_size        = win_size;
+        new_node->ring_head       = 0;
         new_node->force_no_drop   = MFALSE;
         new_node->check_start_win = MTRUE;
         new_node->bitmap          = 0;
 
 #if !CONFIG_MEM_POOLS
-        if ((pmadapter->callbacks.moal_malloc(pmadapter->pmoal_handle, 4U * win_size, MLAN_MEM_DEF,
-                                              (t_u8 **)&new_node->rx_reorder_ptr)) != MLAN_STATUS_SUCCESS)
+        if ((pmadapter->callbacks.moal_malloc(pmadapter->pmoal_handle, sizeof(t_void *) * RX_REORDER_RING_SIZE,
+                                              MLAN_MEM_DEF, (t_u8 **)&new_node->rx_reorder_ptr)) != MLAN_STATUS_SUCCESS)
 #else
         new_node->rx_reorder_ptr = OSA_MemoryPoolAllocate(buf_1024_MemoryPool);
         if (new_node->rx_reorder_ptr == MNULL)
@@ -560,7 +606,7 @@ static t_void wlan_11n_create_rxreorder_tbl(mlan_private *priv, t_u8 *ta, int ti
 
         (void)pmadapter->callbacks.moal_init_timer(pmadapter->pmoal_handle, &new_node->timer_context.timer,
                                                    wlan_flush_data, &new_node->timer_context);
-        for (i = 0; i < win_size; ++i)
+        for (i = 0; i < RX_REORDER_RING_SIZE; ++i)
         {
             new_node->rx_reorder_ptr[i] = MNULL;
         }
@@ -989,24 +1035,24 @@ mlan_status mlan_11n_rxreorder_pkt(void *priv, t_u16 seq_num, t_u16 tid, t_u8 *t
         {
             if (seq_num >= start_win)
             {
-                if (rx_reor_tbl_ptr->rx_reorder_ptr[seq_num - start_win] != NULL)
+                if (RX_REORDER_SLOT(rx_reor_tbl_ptr, seq_num - start_win) != NULL)
                 {
                     PRINTM(MDAT_D, "Drop Duplicate Pkt\n");
                     ret = MLAN_STATUS_FAILURE;
                     goto done;
                 }
-                rx_reor_tbl_ptr->rx_reorder_ptr[seq_num - start_win] = payload;
+                RX_REORDER_SLOT(rx_reor_tbl_ptr, seq_num - start_win) = payload;
                 MLAN_SET_BIT_U64(rx_reor_tbl_ptr->bitmap, seq_num - start_win);
             }
             else
             { /* Wrap condition */
-                if (rx_reor_tbl_ptr->rx_reorder_ptr[(seq_num + (MAX_TID_VALUE)) - start_win] != NULL)
+                if (RX_REORDER_SLOT(rx_reor_tbl_ptr, (seq_num + (MAX_TID_VALUE)) - start_win) != NULL)
                 {
                     PRINTM(MDAT_D, "Drop Duplicate Pkt\n");
                     ret = MLAN_STATUS_FAILURE;
                     goto done;
                 }
-                rx_reor_tbl_ptr->rx_reorder_ptr[(seq_num + (MAX_TID_VALUE)) - start_win] = payload;
+                RX_REORDER_SLOT(rx_reor_tbl_ptr, (seq_num + (MAX_TID_VALUE)) - start_win) = payload;
                 MLAN_SET_BIT_U64(rx_reor_tbl_ptr->bitmap, (seq_num + (MAX_TID_VALUE)) - start_win);
             }
         }
@@ -180,9 +180,10 @@ static void *wifi_11n_save_request(Event_Ext_t *evt)
 
 void wrapper_deliver_amsdu_subframe(pmlan_buffer amsdu_pmbuf, t_u8 *data, t_u16 pkt_len)
 {
-    RxPD *prx_pd = (RxPD *)(void *)amsdu_pmbuf->pbuf;
+    RxPD *prx_pd    = (RxPD *)(void *)amsdu_pmbuf->pbuf;
+    void *amsdu_buf = ((amsdu_pmbuf->flags & MLAN_BUF_FLAG_AMSDU_REF) != 0U) ? amsdu_pmbuf->lwip_pbuf : NULL;
     w_pkt_d("[amsdu] [push]: BSS Type: %d L: %d", prx_pd->bss_type, pkt_len);
-    wm_wifi.amsdu_data_input_callback(prx_pd->bss_type, data, pkt_len);
+    wm_wifi.amsdu_data_input_callback(prx_pd->bss_type, data, pkt_len, amsdu_buf);
 }
 
 static mlan_status wrapper_moal_recv_packet(IN t_void *pmoal_handle, IN pmlan_buffer pmbuf)
@@ -5609,7 +5610,11 @@ int wifi_handle_fw_event(struct bus_message *msg)
                 return -WM_FAIL;
             }
 #ifndef SD8801
+#if CONFIG_SCAN_EARLY_STOP
+            if (!pext_scan_result->more_event && wlan_ext_scan_report_done(pmpriv))
+#else
             if (is_split_scan_complete() && !pext_scan_result->more_event)
+#endif
             {
                 wifi_d("Split scan complete");
                 wifi_user_scan_config_cleanup();
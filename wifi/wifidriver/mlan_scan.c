@@ -64,6 +64,20 @@ Change log:
 /* Global data required for split scan requests */
 static bool abort_split_scan;
 
+#if CONFIG_SCAN_EARLY_STOP
+/* Set by wifi_set_scan_early_stop(), taken by the next scan */
+static wifi_scan_early_stop_t scan_early_stop;
+static bool scan_early_stop_armed;
+/* The scan in progress stops early */
+static bool scan_early_stop_active;
+/* The scan stopped early */
+static bool scan_early_stopped;
+/* Ext scan commands whose last report has not arrived yet */
+static t_u32 ext_scan_reports_pending;
+/* Stopped early with no report outstanding, the scan task sends the result event */
+static bool scan_early_stop_complete;
+#endif
+
 #if CONFIG_MEM_POOLS
 static BSSDescriptor_t s_bss_new_entry;
 static BSSDescriptor_t s2_bss_new_entry;
@@ -127,6 +141,128 @@ void wlan_abort_split_scan(void)
     }
 }
 
+#if CONFIG_SCAN_EARLY_STOP
+void wifi_set_scan_early_stop(const wifi_scan_early_stop_t *early_stop)
+{
+    if (early_stop != MNULL)
+    {
+        scan_early_stop = *early_stop;
+    }
+    scan_early_stop_armed = (early_stop != MNULL);
+}
+
+bool wlan_scan_early_stop_completed(void)
+{
+    bool complete = scan_early_stop_complete;
+
+    scan_early_stop_complete = false;
+    return complete;
+}
+
+/* Moves the early stop channels to the front of the channel list, the
+ * others keep their order */
+static void wlan_scan_early_stop_order(ChanScanParamSet_t *pscan_chan_list)
+{
+    ChanScanParamSet_t chan;
+    t_u32 front = 0;
+    t_u32 i;
+    t_u32 j;
+
+    for (i = 0; i < scan_early_stop.num_channels; i++)
+    {
+        for (j = front; (j < WLAN_USER_SCAN_CHAN_MAX) && (pscan_chan_list[j].chan_number != 0U); j++)
+        {
+            if (pscan_chan_list[j].chan_number == scan_early_stop.chan_list[i])
+            {
+                chan = pscan_chan_list[j];
+                for (; j > front; j--)
+                {
+                    pscan_chan_list[j] = pscan_chan_list[j - 1U];
+                }
+                pscan_chan_list[front] = chan;
+                front++;
+                break;
+            }
+        }
+    }
+}
+
+/* Checks whether the scan table holds a BSS good enough to stop the scan */
+static bool wlan_scan_early_stop_found(mlan_adapter *pmadapter)
+{
+    const t_u8 zero_mac[MLAN_MAC_ADDR_LENGTH] = {0};
+    t_u32 ssid_len = (t_u32)strlen(scan_early_stop.ssid);
+    bool any_bssid = (__memcmp(pmadapter, scan_early_stop.bssid, zero_mac, MLAN_MAC_ADDR_LENGTH) == 0);
+    BSSDescriptor_t *pbss_desc;
+    t_u32 i;
+
+    for (i = 0; i < pmadapter->num_in_scan_table; i++)
+    {
+        pbss_desc = &pmadapter->pscan_table[i];
+        if ((pbss_desc->ssid.ssid_len != ssid_len) ||
+            (__memcmp(pmadapter, pbss_desc->ssid.ssid, scan_early_stop.ssid, ssid_len) != 0))
+        {
+            continue;
+        }
+        if (!any_bssid &&
+            (__memcmp(pmadapter, pbss_desc->mac_address, scan_early_stop.bssid, MLAN_MAC_ADDR_LENGTH) != 0))
+        {
+            continue;
+        }
+        /* The scan table keeps the RSSI in dBm, negative */
+        if (pbss_desc->rssi >= -(t_s32)scan_early_stop.rssi_threshold)
+        {
+            return MTRUE;
+        }
+    }
+
+    return MFALSE;
+}
+
+/* Ends the split scan after the current command */
+static void wlan_scan_early_stop_end(void)
+{
+    OSA_SR_ALLOC();
+
+    OSA_ENTER_CRITICAL();
+    split_scan_in_progress   = false;
+    scan_early_stopped       = true;
+    scan_early_stop_complete = (ext_scan_reports_pending == 0U);
+    OSA_EXIT_CRITICAL();
+}
+
+/*
+ * wmsdk: The BSSs of an ext scan command are in the scan table only once its
+ * last report has been handled, so the early stop is decided here rather than
+ * by the scan task after sending the command. A scan that stops early has no
+ * last command whose report sends the scan result event: the last outstanding
+ * report sends it, decided under the critical section with the scan task,
+ * which sends no further command once the scan has stopped.
+ */
+bool wlan_ext_scan_report_done(mlan_private *pmpriv)
+{
+    bool found = scan_early_stop_active && !scan_early_stopped && wlan_scan_early_stop_found(pmpriv->adapter);
+    bool complete;
+    OSA_SR_ALLOC();
+
+    OSA_ENTER_CRITICAL();
+    if (ext_scan_reports_pending != 0U)
+    {
+        ext_scan_reports_pending--;
+    }
+    if (found && split_scan_in_progress)
+    {
+        wscan_d("Scan: %s found, skipping the remaining channels", scan_early_stop.ssid);
+        split_scan_in_progress = false;
+        scan_early_stopped     = true;
+    }
+    complete = is_split_scan_complete() && (!scan_early_stopped || (ext_scan_reports_pending == 0U));
+    OSA_EXIT_CRITICAL();
+
+    return complete;
+}
+#endif
+
 /**
  *  @brief This function will parse a given IE for a given OUI
  *
@@ -862,6 +998,26 @@ static mlan_status wlan_scan_channel_list(IN mlan_private *pmpriv,
         {
             cmd_no = HostCmd_CMD_802_11_SCAN;
         }
+#if (CONFIG_SCAN_EARLY_STOP) && (CONFIG_EXT_SCAN_SUPPORT)
+        if (cmd_no == HostCmd_CMD_802_11_SCAN_EXT)
+        {
+            bool stopped;
+            OSA_SR_ALLOC();
+
+            /* A report handled since the last command may have stopped the scan */
+            OSA_ENTER_CRITICAL();
+            stopped = scan_early_stopped;
+            if (!stopped)
+            {
+                ext_scan_reports_pending++;
+            }
+            OSA_EXIT_CRITICAL();
+            if (stopped)
+            {
+                break;
+            }
+        }
+#endif
         ret = wlan_prepare_cmd(pmpriv, (t_u16)cmd_no, HostCmd_ACT_GEN_SET, 0, pioctl_buf, pscan_cfg_out);
         if (ret != MLAN_STATUS_SUCCESS)
         {
@@ -873,6 +1029,18 @@ static mlan_status wlan_scan_channel_list(IN mlan_private *pmpriv,
             OSA_TimeDelay((uint32_t)get_split_scan_delay_ms());
         }
 
+#if CONFIG_SCAN_EARLY_STOP
+        /* The scan command response has already filled the scan table, ext
+         * scan reports are checked in wlan_ext_scan_report_done() */
+        if (scan_early_stop_active && (cmd_no == HostCmd_CMD_802_11_SCAN) && (ptmp_chan_list->chan_number != 0U) &&
+            wlan_scan_early_stop_found(pmadapter))
+        {
+            wscan_d("Scan: %s found, skipping the remaining channels", scan_early_stop.ssid);
+            wlan_scan_early_stop_end();
+            break;
+        }
+#endif
+
         if (abort_split_scan)
         {
 #if CONFIG_WPA_SUPP
@@ -2764,6 +2932,20 @@ mlan_status wlan_scan_networks(IN mlan_private *pmpriv,
     pmadapter->idx_chan_stats = 0;
 #endif
 
+#if CONFIG_SCAN_EARLY_STOP
+    scan_early_stop_active   = scan_early_stop_armed;
+    scan_early_stop_armed    = false;
+    scan_early_stopped       = false;
+    scan_early_stop_complete = false;
+    ext_scan_reports_pending = 0;
+    if (scan_early_stop_active)
+    {
+        /* One channel per command so that the scan can end after any of them */
+        wlan_scan_early_stop_order(pscan_chan_list);
+        max_chan_per_scan = 1;
+    }
+#endif
+
     split_scan_in_progress = true;
     ret = wlan_scan_channel_list(pmpriv, pioctl_buf, max_chan_per_scan, filtered_scan, &pscan_cfg_out->config,
                                  pchan_list_out, pscan_chan_list);
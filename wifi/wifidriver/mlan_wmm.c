@@ -18,7 +18,7 @@ Change log:
 /* Additional WMSDK header files */
 #include <wmerrno.h>
 #include <osa.h>
-#if CONFIG_TX_RX_ZERO_COPY
+#if CONFIG_WMM
 #include <wm_net.h>
 #endif
 /* Always keep this include at the end of all include files */
@@ -587,6 +587,38 @@ static uint8_t wifi_wmm_is_tx_pause(const uint8_t interface, mlan_wmm_ac_e queue
     return is_tx_pause;
 }
 
+#if !CONFIG_TX_RX_ZERO_COPY
+/*
+ *  outbufs outside of the pool are built in the headroom of a network stack
+ *  buffer, they hold a slot of the pool but none of its memory
+ */
+static bool wifi_wmm_buf_is_ext(const outbuf_t *buf)
+{
+    const t_u8 *pool = mlan_adap->outbuf_pool.pool;
+
+    return ((const t_u8 *)buf < pool) || ((const t_u8 *)buf >= (pool + (MAX_WMM_BUF_NUM * OUTBUF_WMM_LEN)));
+}
+
+/* the stack buffer pointer is stored just before the outbuf */
+static void *wifi_wmm_buf_ext_stack_buffer(outbuf_t *buf)
+{
+    return *((void **)(void *)buf - 1);
+}
+
+/* take pool memory for a slot that is already taken */
+static outbuf_t *wifi_wmm_buf_get_mem(void)
+{
+    outbuf_t *buf = MNULL;
+
+    mlan_adap->callbacks.moal_semaphore_get(mlan_adap->pmoal_handle, &mlan_adap->outbuf_pool.free_list.plock);
+    buf = (outbuf_t *)util_dequeue_list(mlan_adap->pmoal_handle, &mlan_adap->outbuf_pool.free_list, MNULL, MNULL);
+    assert(buf != MNULL);
+    mlan_adap->callbacks.moal_semaphore_put(mlan_adap->pmoal_handle, &mlan_adap->outbuf_pool.free_list.plock);
+
+    return buf;
+}
+#endif
+
 /*
  *  find the alternative buffer paused in txqueue and replace it,
  *  priv->tx_pause 1: replace any ra node's oldest packet
@@ -640,6 +672,15 @@ SUCC:
     mlan_adap->callbacks.moal_semaphore_put(mlan_adap->pmoal_handle,
                                             &mlan_adap->priv[interface]->wmm.tid_tbl_ptr[queue].ra_list.plock);
 
+#if !CONFIG_TX_RX_ZERO_COPY
+    /* The slot is reused with pool memory, there is some as long as a stack buffer outbuf holds a slot */
+    if (wifi_wmm_buf_is_ext(buf))
+    {
+        net_stack_buffer_free(wifi_wmm_buf_ext_stack_buffer(buf));
+        buf = wifi_wmm_buf_get_mem();
+    }
+#endif
+
     wifi_wmm_drop_pause_replaced(interface);
     return buf;
 }
@@ -788,6 +829,8 @@ outbuf_t *wifi_wmm_buf_get(void)
 
 void wifi_wmm_buf_put(outbuf_t *buf)
 {
+    t_u32 full_mask;
+
     mlan_adap->callbacks.moal_semaphore_get(mlan_adap->pmoal_handle, &mlan_adap->outbuf_pool.free_list.plock);
 
     assert(mlan_adap->outbuf_pool.free_cnt < MAX_WMM_BUF_NUM);
@@ -795,14 +838,62 @@ void wifi_wmm_buf_put(outbuf_t *buf)
 #if CONFIG_TX_RX_ZERO_COPY
     /* Free driver's reference count for network buffer */
     net_stack_buffer_free(buf->buffer);
+#else
+    if (wifi_wmm_buf_is_ext(buf))
+    {
+        /* Only the slot goes back, the memory is the stack's */
+        net_stack_buffer_free(wifi_wmm_buf_ext_stack_buffer(buf));
+    }
+    else
 #endif
-
-    util_enqueue_list_tail(mlan_adap->pmoal_handle, &mlan_adap->outbuf_pool.free_list, &buf->entry, MNULL, MNULL);
+    {
+        util_enqueue_list_tail(mlan_adap->pmoal_handle, &mlan_adap->outbuf_pool.free_list, &buf->entry, MNULL,
+                               MNULL);
+    }
     mlan_adap->outbuf_pool.free_cnt++;
 
+    /* Senders that found the pool full are told once about the free slot */
+    full_mask                        = mlan_adap->outbuf_pool.full_mask;
+    mlan_adap->outbuf_pool.full_mask = 0;
+
+    mlan_adap->callbacks.moal_semaphore_put(mlan_adap->pmoal_handle, &mlan_adap->outbuf_pool.free_list.plock);
+
+    if (full_mask != 0U)
+    {
+        wifi_wmm_tx_resume(full_mask);
+    }
+}
+
+/* record that a sender found no slot for queue, false if one has been freed since */
+bool wifi_wmm_tx_full(const uint8_t interface, mlan_wmm_ac_e queue)
+{
+    bool full;
+
+    mlan_adap->callbacks.moal_semaphore_get(mlan_adap->pmoal_handle, &mlan_adap->outbuf_pool.free_list.plock);
+
+    full = (mlan_adap->outbuf_pool.free_cnt == 0) ? true : false;
+    if (full)
+    {
+        mlan_adap->outbuf_pool.full_mask |= WMM_TX_FULL_BIT(interface, queue);
+    }
+
     mlan_adap->callbacks.moal_semaphore_put(mlan_adap->pmoal_handle, &mlan_adap->outbuf_pool.free_list.plock);
+
+    return full;
 }
 
+#if !CONFIG_TX_RX_ZERO_COPY
+void wifi_wmm_buf_put_mem(outbuf_t *buf)
+{
+    assert(!wifi_wmm_buf_is_ext(buf));
+
+    mlan_adap->callbacks.moal_semaphore_get(mlan_adap->pmoal_handle, &mlan_adap->outbuf_pool.free_list.plock);
+    /* free_cnt stays, the slot is still taken */
+    util_enqueue_list_tail(mlan_adap->pmoal_handle, &mlan_adap->outbuf_pool.free_list, &buf->entry, MNULL, MNULL);
+    mlan_adap->callbacks.moal_semaphore_put(mlan_adap->pmoal_handle, &mlan_adap->outbuf_pool.free_list.plock);
+}
+#endif
+
 /* init free list, insert all buffers to free list */
 int wifi_wmm_buf_pool_init(uint8_t *pool)
 {
@@ -812,6 +903,7 @@ int wifi_wmm_buf_pool_init(uint8_t *pool)
     __memset(mlan_adap, &mlan_adap->outbuf_pool, 0x00, sizeof(outbuf_pool_t));
 
     util_init_list_head(mlan_adap->pmoal_handle, &mlan_adap->outbuf_pool.free_list, MFALSE, MNULL);
+    mlan_adap->outbuf_pool.pool = pool;
 
     if (mlan_adap->callbacks.moal_init_semaphore(mlan_adap->pmoal_handle, "wmm_buf_pool_sem",
                                                  &mlan_adap->outbuf_pool.free_list.plock) != MLAN_STATUS_SUCCESS)
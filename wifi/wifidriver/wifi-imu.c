@@ -109,6 +109,10 @@ SDK_ALIGN(uint8_t inbuf[SDIO_MP_AGGR_DEF_PKT_LIMIT * 2 * DATA_BUFFER_SIZE], 32);
 #if CONFIG_AMSDU_IN_AMPDU
 SDK_ALIGN(uint8_t amsdu_outbuf[MAX_SUPPORT_AMSDU_SIZE], 32);
 #endif
+#if CONFIG_IMU_RX_ZERO_COPY
+/*! @brief Rx buffer the data input path has taken over, only accessed by the IMU rx task */
+static const t_u8 *imu_rx_held_buf;
+#endif
 
 hal_imumc_status_t imumc_cmdrsp_handler(IMU_Msg_t *pImuMsg, uint32_t length);
 hal_imumc_status_t imumc_event_handler(IMU_Msg_t *pImuMsg, uint32_t length);
@@ -1478,7 +1482,7 @@ hal_imumc_status_t imumc_rxpkt_handler(IMU_Msg_t *pImuMsg, uint32_t length)
             return kStatus_HAL_ImumcError;
         }
 
-#if !CONFIG_TX_RX_ZERO_COPY
+#if !CONFIG_TX_RX_ZERO_COPY && !CONFIG_IMU_RX_ZERO_COPY
 #if CONFIG_IMU_GDMA
         HAL_ImuGdmaCopyData(inbuf, inimupkt, size);
 #else
@@ -1490,10 +1494,18 @@ hal_imumc_status_t imumc_rxpkt_handler(IMU_Msg_t *pImuMsg, uint32_t length)
         w_pkt_d("Data RX: FW=>Driver, if %d, len %d", interface, size);
 
         if (bus.wifi_low_level_input != NULL)
-#if CONFIG_TX_RX_ZERO_COPY
+#if (CONFIG_TX_RX_ZERO_COPY) || (CONFIG_IMU_RX_ZERO_COPY)
             bus.wifi_low_level_input(interface, (uint8_t *)inimupkt, size);
 #else
             bus.wifi_low_level_input(interface, inbuf, size);
+#endif
+#if CONFIG_IMU_RX_ZERO_COPY
+        /* A held buffer is left out of the free message sent back when this handler returns */
+        if (imu_rx_held_buf == (t_u8 *)inimupkt)
+        {
+            pImuMsg->PayloadPtr[i] = 0U;
+            imu_rx_held_buf        = NULL;
+        }
 #endif
     }
 #if CONFIG_HOST_SLEEP
@@ -1503,6 +1515,21 @@ hal_imumc_status_t imumc_rxpkt_handler(IMU_Msg_t *pImuMsg, uint32_t length)
     return kStatus_HAL_ImumcSuccess;
 }
 
+#if CONFIG_IMU_RX_ZERO_COPY
+void wifi_imu_rx_buf_hold(const t_u8 *buf)
+{
+    imu_rx_held_buf = buf;
+}
+
+void wifi_imu_rx_buf_release(const t_u8 *buf)
+{
+    if (HAL_ImuFreeWlanRxBuf(kIMU_LinkCpu1Cpu3, (uint8_t *)buf) != kStatus_HAL_ImumcSuccess)
+    {
+        wifi_io_e("Failed to free rx buffer %p", buf);
+    }
+}
+#endif
+
 static bool imu_fw_is_hang(void)
 {
     uint32_t *peer_magic_addr = (uint32_t *)0x41380000;
@@ -96,9 +96,12 @@ typedef struct
 #if FSL_USDHC_ENABLE_SCATTER_GATHER_TRANSFER
     void *(*wifi_get_rxbuf_desc)(t_u16 rx_len);
 #endif
-    void (*amsdu_data_input_callback)(uint8_t interface, uint8_t *buffer, uint16_t len);
+    void (*amsdu_data_input_callback)(uint8_t interface, uint8_t *buffer, uint16_t len, void *amsdu_buf);
     void (*deliver_packet_above_callback)(void *rxpd, t_u8 interface, t_void *lwip_pbuf);
     bool (*wrapper_net_is_ip_or_ipv6_callback)(const t_u8 *buffer);
+#if CONFIG_WMM
+    void (*tx_resume_callback)(t_u32 full_mask);
+#endif
 
     OSA_MUTEX_HANDLE_DEFINE(command_lock);
 
@@ -389,6 +392,12 @@ mlan_status wrapper_moal_mfree(t_void *pmoal_handle, t_u8 *pbuf);
 #if defined(RW610)
 int wifi_imu_lock(void);
 void wifi_imu_unlock(void);
+#if CONFIG_IMU_RX_ZERO_COPY
+/* Keeps the rx buffer being delivered by the rx data handler from being freed when the handler returns */
+void wifi_imu_rx_buf_hold(const t_u8 *buf);
+/* Returns a held rx buffer to the firmware */
+void wifi_imu_rx_buf_release(const t_u8 *buf);
+#endif
 #else
 int wifi_sdio_lock(void);
 void wifi_sdio_unlock(void);
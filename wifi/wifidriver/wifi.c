@@ -1127,10 +1127,155 @@ void wlan_process_hang(uint8_t fw_reload)
 }
 #endif
 
+#if CONFIG_WIFI_TRACE
+#if (CONFIG_WIFI_TRACE_RECORDS & (CONFIG_WIFI_TRACE_RECORDS - 1)) != 0
+#error "CONFIG_WIFI_TRACE_RECORDS must be a power of two"
+#endif
+
+/* Marks the records already summarized */
+#define WIFI_TRACE_DONE 0xFFU
+
+static wifi_trace_record_t wifi_trace_ring[CONFIG_WIFI_TRACE_RECORDS];
+static uint32_t wifi_trace_next;
+
+static void wifi_trace_add(uint8_t type, uint16_t id, uint8_t status, uint32_t start_us)
+{
+    wifi_trace_record_t *record;
+    uint32_t now_us = net_stack_time_us();
+    OSA_SR_ALLOC();
+
+    OSA_ENTER_CRITICAL();
+    record             = &wifi_trace_ring[wifi_trace_next & (CONFIG_WIFI_TRACE_RECORDS - 1U)];
+    record->start_us   = start_us;
+    record->latency_us = now_us - start_us;
+    record->id         = id;
+    record->type       = type;
+    record->status     = status;
+    wifi_trace_next++;
+    OSA_EXIT_CRITICAL();
+}
+
+void wifi_trace_queued(struct wifi_message *msg)
+{
+    msg->time_us = net_stack_time_us();
+}
+
+void wifi_trace_dequeued(const struct wifi_message *msg)
+{
+    wifi_trace_add(WIFI_TRACE_EVENT, msg->event, (uint8_t)msg->reason, msg->time_us);
+}
+
+uint32_t wifi_trace_count(void)
+{
+    return wifi_trace_next;
+}
+
+int wifi_trace_read(uint32_t seq, wifi_trace_record_t *record)
+{
+    int ret = -WM_FAIL;
+    OSA_SR_ALLOC();
+
+    OSA_ENTER_CRITICAL();
+    /* Wraps to a large value for records not written yet */
+    if ((wifi_trace_next - seq - 1U) < CONFIG_WIFI_TRACE_RECORDS)
+    {
+        *record = wifi_trace_ring[seq & (CONFIG_WIFI_TRACE_RECORDS - 1U)];
+        ret     = WM_SUCCESS;
+    }
+    OSA_EXIT_CRITICAL();
+
+    return ret;
+}
+
+/* Nearest rank percentile of count sorted latencies */
+static uint32_t wifi_trace_percentile(const uint32_t *sorted, uint32_t count, uint32_t percent)
+{
+    uint32_t rank = (count * percent + 99U) / 100U;
+
+    return sorted[(rank > 0U) ? (rank - 1U) : 0U];
+}
+
+unsigned int wifi_trace_get_summary(wifi_trace_summary_t *summary, unsigned int max_entries)
+{
+    wifi_trace_record_t *records;
+    uint32_t *sorted;
+    uint32_t count = 0;
+    uint32_t next;
+    uint32_t seq;
+    uint32_t n;
+    uint32_t i;
+    uint32_t j;
+    uint32_t k;
+    unsigned int entries = 0;
+
+    records = (wifi_trace_record_t *)OSA_MemoryAllocate(CONFIG_WIFI_TRACE_RECORDS *
+                                                        (sizeof(wifi_trace_record_t) + sizeof(uint32_t)));
+    if (records == NULL)
+    {
+        return 0;
+    }
+    sorted = (uint32_t *)(void *)&records[CONFIG_WIFI_TRACE_RECORDS];
+
+    next = wifi_trace_next;
+    seq  = (next > CONFIG_WIFI_TRACE_RECORDS) ? (next - CONFIG_WIFI_TRACE_RECORDS) : 0U;
+    for (; seq != next; seq++)
+    {
+        if (wifi_trace_read(seq, &records[count]) == WM_SUCCESS)
+        {
+            count++;
+        }
+    }
+
+    for (i = 0; (i < count) && (entries < max_entries); i++)
+    {
+        if (records[i].type == WIFI_TRACE_DONE)
+        {
+            continue;
+        }
+
+        /* Insertion sort the latencies of all records with this id */
+        n = 0;
+        for (j = i; j < count; j++)
+        {
+            if ((records[j].type != records[i].type) || (records[j].id != records[i].id))
+            {
+                continue;
+            }
+            for (k = n; (k > 0U) && (sorted[k - 1U] > records[j].latency_us); k--)
+            {
+                sorted[k] = sorted[k - 1U];
+            }
+            sorted[k] = records[j].latency_us;
+            n++;
+            if (j != i)
+            {
+                records[j].type = WIFI_TRACE_DONE;
+            }
+        }
+
+        summary[entries].id     = records[i].id;
+        summary[entries].type   = records[i].type;
+        summary[entries].count  = n;
+        summary[entries].p50_us = wifi_trace_percentile(sorted, n, 50U);
+        summary[entries].p90_us = wifi_trace_percentile(sorted, n, 90U);
+        summary[entries].p99_us = wifi_trace_percentile(sorted, n, 99U);
+        summary[entries].max_us = sorted[n - 1U];
+        entries++;
+    }
+
+    OSA_MemoryFree(records);
+
+    return entries;
+}
+#endif
+
 int wifi_wait_for_cmdresp(void *cmd_resp_priv)
 {
     int ret;
     HostCmd_DS_COMMAND *cmd = wifi_get_command_buffer();
+#if CONFIG_WIFI_TRACE
+    uint32_t trace_start_us;
+#endif
 #ifndef RW610
     t_u32 buf_len = MLAN_SDIO_BLOCK_SIZE;
     t_u32 tx_blocks;
@@ -1238,6 +1383,9 @@ int wifi_wait_for_cmdresp(void *cmd_resp_priv)
      * NULL.
      */
     wm_wifi.cmd_resp_priv = cmd_resp_priv;
+#if CONFIG_WIFI_TRACE
+    trace_start_us = net_stack_time_us();
+#endif
 #if defined(RW610)
     (void)wifi_send_cmdbuffer();
 #else
@@ -1256,6 +1404,9 @@ int wifi_wait_for_cmdresp(void *cmd_resp_priv)
 
     /* Wait max 20 sec for the command response */
     ret = wifi_get_command_resp_sem(WIFI_COMMAND_RESPONSE_WAIT_MS);
+#if CONFIG_WIFI_TRACE
+    wifi_trace_add(WIFI_TRACE_CMD, cmd->command, (ret != WM_SUCCESS) ? 1U : 0U, trace_start_us);
+#endif
     if (ret != WM_SUCCESS)
     {
         pmadapter->cmd_sent = MFALSE;
@@ -1325,6 +1476,9 @@ int wifi_event_completion(enum wifi_event event, enum wifi_event_reason result,
     msg.data   = data;
     msg.reason = result;
     msg.event  = (uint16_t)event;
+#if CONFIG_WIFI_TRACE
+    wifi_trace_queued(&msg);
+#endif
     if (OSA_MsgQPut((osa_msgq_handle_t)wm_wifi.wlc_mgr_event_queue, &msg) != KOSA_StatusSuccess)
     {
         wifi_e("Failed to send response on Queue, event %d", event);
@@ -1866,6 +2020,14 @@ static void wifi_scan_task(void *argv)
                 wifi_user_scan_config_cleanup();
                 (void)wifi_event_completion(WIFI_EVENT_SCAN_RESULT, WIFI_EVENT_REASON_FAILURE, NULL);
             }
+#if CONFIG_SCAN_EARLY_STOP
+            else if (wlan_scan_early_stop_completed())
+            {
+                wifi_d("Scan stopped early");
+                wifi_user_scan_config_cleanup();
+                (void)wifi_event_completion(WIFI_EVENT_SCAN_RESULT, WIFI_EVENT_REASON_SUCCESS, NULL);
+            }
+#endif
         }
         scan_thread_in_process = false;
     } /* for ;; */
@@ -2568,7 +2730,8 @@ void wifi_deregister_data_input_callback(void)
 
 int wifi_register_amsdu_data_input_callback(void (*amsdu_data_input_callback)(uint8_t interface,
                                                                               uint8_t *buffer,
-                                                                              uint16_t len))
+                                                                              uint16_t len,
+                                                                              void *amsdu_buf))
 {
     if (wm_wifi.amsdu_data_input_callback != NULL)
     {
@@ -2621,6 +2784,33 @@ void wifi_deregister_wrapper_net_is_ip_or_ipv6_callback(void)
     wm_wifi.wrapper_net_is_ip_or_ipv6_callback = NULL;
 }
 
+#if CONFIG_WMM
+int wifi_register_tx_resume_callback(void (*tx_resume_callback)(t_u32 full_mask))
+{
+    if (wm_wifi.tx_resume_callback != NULL)
+    {
+        return -WM_FAIL;
+    }
+
+    wm_wifi.tx_resume_callback = tx_resume_callback;
+
+    return WM_SUCCESS;
+}
+
+void wifi_deregister_tx_resume_callback(void)
+{
+    wm_wifi.tx_resume_callback = NULL;
+}
+
+void wifi_wmm_tx_resume(t_u32 full_mask)
+{
+    if (wm_wifi.tx_resume_callback != NULL)
+    {
+        wm_wifi.tx_resume_callback(full_mask);
+    }
+}
+#endif
+
 #if CONFIG_WPA_SUPP
 
 void wpa_supp_handle_link_lost(mlan_private *priv)
@@ -1879,6 +1879,252 @@ static bool is_scanning_allowed(void)
     return (is_state(CM_STA_IDLE) || is_state(CM_STA_CONNECTED) || is_state(CM_STA_AUTHENTICATED));
 }
 
+#if CONFIG_WLAN_BSS_CACHE
+/* Number of hash buckets of the BSS cache, a power of two */
+#define BSS_CACHE_BUCKETS 16U
+
+/* Slot and bucket links hold the slot index plus one, 0 ends a chain */
+struct bss_cache_slot
+{
+    struct wlan_scan_result res;
+    uint32_t seen_ms;
+    uint32_t scan_gen;
+    unsigned char rssi[WLAN_BSS_CACHE_RSSI_HISTORY];
+    uint8_t next;
+    bool used;
+};
+
+/* Written by the wlcmgr thread only, read by other tasks in critical sections */
+static struct
+{
+    struct bss_cache_slot slots[CONFIG_WLAN_BSS_CACHE_SIZE];
+    uint8_t buckets[BSS_CACHE_BUCKETS];
+    uint32_t scan_gen;
+} bss_cache;
+
+/* The OUI is shared by the APs of one vendor, hash the device part */
+static unsigned int bss_cache_hash(const char *bssid)
+{
+    return ((unsigned int)(uint8_t)bssid[3] ^ (unsigned int)(uint8_t)bssid[4] ^ (unsigned int)(uint8_t)bssid[5]) &
+           (BSS_CACHE_BUCKETS - 1U);
+}
+
+static struct bss_cache_slot *bss_cache_lookup(const char *bssid)
+{
+    uint8_t link = bss_cache.buckets[bss_cache_hash(bssid)];
+
+    while (link != 0U)
+    {
+        struct bss_cache_slot *slot = &bss_cache.slots[link - 1U];
+
+        if (memcmp(slot->res.bssid, bssid, sizeof(slot->res.bssid)) == 0)
+        {
+            return slot;
+        }
+        link = slot->next;
+    }
+
+    return NULL;
+}
+
+static void bss_cache_unlink(struct bss_cache_slot *slot)
+{
+    uint8_t self  = (uint8_t)(slot - &bss_cache.slots[0]) + 1U;
+    uint8_t *link = &bss_cache.buckets[bss_cache_hash(slot->res.bssid)];
+
+    while (*link != 0U)
+    {
+        if (*link == self)
+        {
+            *link = slot->next;
+            break;
+        }
+        link = &bss_cache.slots[*link - 1U].next;
+    }
+    slot->used = false;
+}
+
+/* Free slot or the one seen the longest time ago */
+static struct bss_cache_slot *bss_cache_victim(uint32_t now)
+{
+    struct bss_cache_slot *victim = &bss_cache.slots[0];
+    unsigned int i;
+
+    for (i = 0; i < CONFIG_WLAN_BSS_CACHE_SIZE; i++)
+    {
+        struct bss_cache_slot *slot = &bss_cache.slots[i];
+
+        if (!slot->used)
+        {
+            return slot;
+        }
+        if ((now - slot->seen_ms) > (now - victim->seen_ms))
+        {
+            victim = slot;
+        }
+    }
+
+    return victim;
+}
+
+/* Merges the results of the scan that just finished into the cache */
+static void bss_cache_update(void)
+{
+    struct wlan_scan_result res;
+    struct bss_cache_slot *slot;
+    unsigned int count;
+    unsigned int i;
+    uint32_t now = OSA_TimeGetMsec();
+    OSA_SR_ALLOC();
+
+    if (wifi_get_scan_result_count(&count) != WM_SUCCESS)
+    {
+        return;
+    }
+
+    bss_cache.scan_gen++;
+
+    for (i = 0; i < count; i++)
+    {
+        if (wlan_get_scan_result(i, &res) != WM_SUCCESS)
+        {
+            continue;
+        }
+
+        OSA_ENTER_CRITICAL();
+        slot = bss_cache_lookup(res.bssid);
+        if (slot == NULL)
+        {
+            slot = bss_cache_victim(now);
+            if (slot->used)
+            {
+                bss_cache_unlink(slot);
+            }
+            (void)memset(slot->rssi, 0, sizeof(slot->rssi));
+            slot->res  = res;
+            slot->next = bss_cache.buckets[bss_cache_hash(res.bssid)];
+            slot->used = true;
+            bss_cache.buckets[bss_cache_hash(res.bssid)] = (uint8_t)(slot - &bss_cache.slots[0]) + 1U;
+        }
+        (void)memmove(&slot->rssi[1], &slot->rssi[0], sizeof(slot->rssi) - 1U);
+        slot->rssi[0]  = res.rssi;
+        slot->res      = res;
+        slot->seen_ms  = now;
+        slot->scan_gen = bss_cache.scan_gen;
+        OSA_EXIT_CRITICAL();
+    }
+}
+
+/* Average of the RSSI samples of a cached BSS, rssi if it is not cached */
+static unsigned char bss_cache_rssi(const char *bssid, unsigned char rssi)
+{
+    const struct bss_cache_slot *slot = bss_cache_lookup(bssid);
+    unsigned int sum                  = 0;
+    unsigned int n                    = 0;
+    unsigned int i;
+
+    if (slot == NULL)
+    {
+        return rssi;
+    }
+
+    for (i = 0; (i < WLAN_BSS_CACHE_RSSI_HISTORY) && (slot->rssi[i] != 0U); i++)
+    {
+        sum += slot->rssi[i];
+        n++;
+    }
+
+    return (n != 0U) ? (unsigned char)(sum / n) : rssi;
+}
+
+/* Checks whether the last scan saw a BSS of network recently enough to
+ * choose from its results without scanning again */
+static bool bss_cache_recent_match(const struct wlan_network *network)
+{
+    uint32_t now = OSA_TimeGetMsec();
+    unsigned int i;
+
+    if ((network->ssid_specific == 0U) && (network->bssid_specific == 0U))
+    {
+        return false;
+    }
+
+    for (i = 0; i < CONFIG_WLAN_BSS_CACHE_SIZE; i++)
+    {
+        const struct bss_cache_slot *slot = &bss_cache.slots[i];
+
+        if (!slot->used || (slot->scan_gen != bss_cache.scan_gen) ||
+            ((now - slot->seen_ms) > (uint32_t)CONFIG_WLAN_BSS_CACHE_MAX_AGE_MS))
+        {
+            continue;
+        }
+        if ((network->ssid_specific != 0U) && ((slot->res.ssid_len != strlen(network->ssid)) ||
+                                               (memcmp(slot->res.ssid, network->ssid, slot->res.ssid_len) != 0)))
+        {
+            continue;
+        }
+        if ((network->bssid_specific != 0U) &&
+            (memcmp(slot->res.bssid, network->bssid, sizeof(slot->res.bssid)) != 0))
+        {
+            continue;
+        }
+        if ((network->channel_specific != 0U) && (slot->res.channel != network->channel))
+        {
+            continue;
+        }
+        return true;
+    }
+
+    return false;
+}
+
+#if CONFIG_SCAN_EARLY_STOP
+/* Channels an SSID was seen on, the most recent first */
+static uint8_t bss_cache_channels(const char *ssid, uint8_t *chan_list, uint8_t max_channels)
+{
+    uint32_t now       = OSA_TimeGetMsec();
+    size_t ssid_len    = strlen(ssid);
+    uint8_t count      = 0;
+    uint32_t last_age  = 0;
+    unsigned int i;
+    unsigned int j;
+
+    while (count < max_channels)
+    {
+        const struct bss_cache_slot *next = NULL;
+
+        /* Next older slot of the SSID on a channel not taken yet */
+        for (i = 0; i < CONFIG_WLAN_BSS_CACHE_SIZE; i++)
+        {
+            const struct bss_cache_slot *slot = &bss_cache.slots[i];
+            uint32_t age                      = now - slot->seen_ms;
+
+            if (!slot->used || (slot->res.ssid_len != ssid_len) || (memcmp(slot->res.ssid, ssid, ssid_len) != 0) ||
+                (age < last_age) || ((next != NULL) && (age >= (now - next->seen_ms))))
+            {
+                continue;
+            }
+            for (j = 0; (j < count) && (chan_list[j] != slot->res.channel); j++)
+            {
+            }
+            if (j == count)
+            {
+                next = slot;
+            }
+        }
+        if (next == NULL)
+        {
+            break;
+        }
+        chan_list[count++] = (uint8_t)next->res.channel;
+        last_age           = now - next->seen_ms;
+    }
+
+    return count;
+}
+#endif
+#endif /* CONFIG_WLAN_BSS_CACHE */
+
 /*
  * Connection Manager actions
  */
@@ -1926,6 +2172,27 @@ static void do_scan(struct wlan_network *network)
 
     wlan.sta_state = CM_STA_SCANNING;
 
+#if CONFIG_SCAN_EARLY_STOP
+    /* The first scan for a known SSID may end at the first good AP, later
+     * ones scan all channels */
+    if ((ssid != NULL) && (channel == 0U) && (wlan.scan_count == 0U))
+    {
+        wifi_scan_early_stop_t early_stop;
+
+        (void)memset(&early_stop, 0, sizeof(early_stop));
+        (void)strncpy(early_stop.ssid, ssid, sizeof(early_stop.ssid) - 1U);
+        if (bssid != NULL)
+        {
+            (void)memcpy(early_stop.bssid, bssid, sizeof(early_stop.bssid));
+        }
+        early_stop.rssi_threshold = CONFIG_SCAN_EARLY_STOP_RSSI;
+#if CONFIG_WLAN_BSS_CACHE
+        early_stop.num_channels = bss_cache_channels(ssid, early_stop.chan_list, SCAN_EARLY_STOP_MAX_CHANNELS);
+#endif
+        wifi_set_scan_early_stop(&early_stop);
+    }
+#endif
+
     /* comment out this, need to check if 11d needs 3 times full channel scan */
     /*
     if (wrapper_wlan_11d_support_is_enabled() && wlan.scan_count < WLAN_11D_SCAN_LIMIT)
@@ -1981,6 +2248,9 @@ static void do_scan(struct wlan_network *network)
     }
     if (ret != 0)
     {
+#if CONFIG_SCAN_EARLY_STOP
+        wifi_set_scan_early_stop(NULL);
+#endif
         (void)wlan_wlcmgr_send_msg(WIFI_EVENT_SCAN_RESULT, WIFI_EVENT_REASON_FAILURE, NULL);
         wlcm_e("error: scan failed");
     }
@@ -2043,6 +2313,10 @@ static void do_hidden_scan(struct wlan_network *network, uint8_t num_channels, w
 static void do_connect_failed(enum wlan_event_reason reason);
 
 #if !CONFIG_WPA_SUPP
+#if CONFIG_WLAN_BSS_CACHE
+static void handle_scan_results(void);
+#endif
+
 /* Start a connection attempt.  To do this we choose a specific network to scan
  * for or the first of our list of known networks. If that network uses WEP
  * security, we first issue the WEP configuration command and enter the
@@ -2065,6 +2339,24 @@ static int do_connect(int netindex)
     wlan.cur_network_idx = netindex;
     wlan.scan_count      = 0;
 
+#if CONFIG_WLAN_BSS_CACHE
+    if ((wlan.roam_reassoc == false) && bss_cache_recent_match(&wlan.networks[netindex]))
+    {
+        /* The scan table still holds the network, choose the AP from it
+         * as if the connect scan had just finished */
+        wlcm_d("using cached scan results for network \"%s\"", wlan.networks[netindex].name);
+        wlan.sta_state = CM_STA_SCANNING;
+        handle_scan_results();
+        if (wlan.is_scan_lock)
+        {
+            wlcm_d("releasing scan lock (connect scan)");
+            (void)OSA_SemaphorePost((osa_semaphore_handle_t)wlan.scan_lock);
+            wlan.is_scan_lock = 0;
+        }
+        return WM_SUCCESS;
+    }
+#endif
+
     do_scan(&wlan.networks[netindex]);
 
     return WM_SUCCESS;
@@ -2654,7 +2946,14 @@ static void handle_scan_results(void)
                 }
 
                 wlcm_d("RSSI: Best AP=%d Result AP=%d", best_ap->RSSI, res->RSSI);
+#if CONFIG_WLAN_BSS_CACHE
+                /* Compare the RSSI averaged over the last scans, a single
+                 * sample may be off by several dB */
+                if (bss_cache_rssi((const char *)best_ap->bssid, best_ap->RSSI) >
+                    bss_cache_rssi((const char *)res->bssid, res->RSSI))
+#else
                 if (best_ap->RSSI > res->RSSI)
+#endif
                 {
                     /*
                      * We found a network better that current
@@ -2990,6 +3289,9 @@ static void wlcm_process_scan_result_event(struct wifi_message *msg, enum cm_sta
     if (msg->reason == WIFI_EVENT_REASON_SUCCESS)
     {
         wifi_scan_process_results();
+#if CONFIG_WLAN_BSS_CACHE
+        bss_cache_update();
+#endif
     }
 
     if (wlan.sta_state == CM_STA_SCANNING)
@@ -6855,6 +7157,9 @@ static void wlcmgr_task(void *data)
 
         if (status == KOSA_StatusSuccess)
         {
+#if CONFIG_WIFI_TRACE
+            wifi_trace_dequeued(&msg);
+#endif
 #if !CONFIG_WIFI_PS_DEBUG
             if (msg.event != WIFI_EVENT_SLEEP && msg.event != WIFI_EVENT_IEEE_PS &&
                     msg.event != WIFI_EVENT_DEEP_SLEEP && msg.event != WIFI_EVENT_IEEE_DEEP_SLEEP)
@@ -7004,6 +7309,9 @@ static int send_user_request(enum user_request_type request, unsigned int data)
     msg.event  = (uint16_t)request;
     msg.reason = WIFI_EVENT_REASON_SUCCESS;
     msg.data   = (void *)data;
+#if CONFIG_WIFI_TRACE
+    wifi_trace_queued(&msg);
+#endif
 
     if (OSA_MsgQPut((osa_msgq_handle_t)wlan.events, &msg) == KOSA_StatusSuccess)
     {
@@ -10218,6 +10526,60 @@ void wlan_register_uap_prov_cleanup_cb(void (*cb)(void))
 }
 #endif
 
+#if CONFIG_WLAN_BSS_CACHE
+unsigned int wlan_get_bss_cache(struct wlan_bss_cache_entry *entries, unsigned int max_entries, uint32_t max_age_ms)
+{
+    uint32_t now       = OSA_TimeGetMsec();
+    unsigned int count = 0;
+    unsigned int i;
+    unsigned int j;
+    OSA_SR_ALLOC();
+
+    if (entries == NULL)
+    {
+        return 0;
+    }
+
+    for (i = 0; (i < CONFIG_WLAN_BSS_CACHE_SIZE) && (count < max_entries); i++)
+    {
+        const struct bss_cache_slot *slot = &bss_cache.slots[i];
+        struct wlan_bss_cache_entry *entry = &entries[count];
+        unsigned int sum = 0;
+        unsigned int n   = 0;
+
+        OSA_ENTER_CRITICAL();
+        if (!slot->used || ((now - slot->seen_ms) > max_age_ms))
+        {
+            OSA_EXIT_CRITICAL();
+            continue;
+        }
+        entry->res    = slot->res;
+        entry->age_ms = now - slot->seen_ms;
+        (void)memcpy(entry->rssi, slot->rssi, sizeof(entry->rssi));
+        OSA_EXIT_CRITICAL();
+
+        for (j = 0; (j < WLAN_BSS_CACHE_RSSI_HISTORY) && (entry->rssi[j] != 0U); j++)
+        {
+            sum += entry->rssi[j];
+            n++;
+        }
+        entry->rssi_avg = (n != 0U) ? (unsigned char)(sum / n) : entry->res.rssi;
+        count++;
+    }
+
+    return count;
+}
+
+void wlan_flush_bss_cache(void)
+{
+    OSA_SR_ALLOC();
+
+    OSA_ENTER_CRITICAL();
+    (void)memset(&bss_cache, 0, sizeof(bss_cache));
+    OSA_EXIT_CRITICAL();
+}
+#endif
+
 int wlan_get_scan_result(unsigned int index, struct wlan_scan_result *res)
 {
     struct wifi_scan_result2 *desc;
@@ -11112,6 +11474,9 @@ int wlan_wlcmgr_send_msg(enum wifi_event event, enum wifi_event_reason reason, v
     msg.event  = (uint16_t)event;
     msg.reason = reason;
     msg.data   = (void *)data;
+#if CONFIG_WIFI_TRACE
+    wifi_trace_queued(&msg);
+#endif
 
     if (OSA_MsgQPut((osa_msgq_handle_t)wlan.events, &msg) == KOSA_StatusSuccess)
     {